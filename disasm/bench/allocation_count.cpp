@@ -0,0 +1,53 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "allocation_count.h"
+
+using namespace std;
+
+namespace{
+    atomic<unsigned long long> g_allocations(0);
+
+    void* allocate(size_t size)
+    {
+        ++g_allocations;
+        if (void* p = malloc(size ? size : 1))
+            return p;
+        throw bad_alloc();
+    }
+}
+
+unsigned long long allocation_count()
+{
+    return g_allocations;
+}
+
+void* operator new(size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](size_t size)
+{
+    return allocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
@@ -0,0 +1,9 @@
+#ifndef ALLOCATION_COUNT_H
+#define ALLOCATION_COUNT_H
+
+// Every allocation made through operator new, so the benchmarks can report
+// allocations per item.  The replacement operators allocate with malloc
+// and free with free, in every form, in their own translation unit.
+unsigned long long allocation_count();
+
+#endif
@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "allocation_count.h"
+#include "disassembler.h"
+#include "driver_file.h"
+#include "instruction.h"
+#include "instruction_handlers.h"
+#include "output_handlers.h"
+#include "request.h"
+#include "synthetic_rom.h"
+#include "utils.h"
+
+using namespace std;
+using namespace Address;
+
+namespace{
+    const char* HELP =
+        "disasm_bench [--seed N] [--banks N] [--iterations N] [--dir DIR] [--only NAME]\n"
+        "  benchmarks: decode labels parse load print macro\n";
+
+    // Discards what is written but counts it.
+    struct CountingBuffer : public streambuf
+    {
+        CountingBuffer() : m_count(0) {}
+
+        unsigned long long count() const { return m_count; }
+
+    protected:
+        virtual int_type overflow(int_type c)
+        {
+            if (c != traits_type::eof())
+                ++m_count;
+            return traits_type::not_eof(c);
+        }
+
+        virtual streamsize xsputn(const char*, streamsize n)
+        {
+            m_count += n;
+            return n;
+        }
+
+    private:
+        unsigned long long m_count;
+    };
+
+    // Keeps the loaders' progress messages out of the report.
+    struct QuietErrors
+    {
+        QuietErrors() : m_saved(cerr.rdbuf(&m_sink)) {}
+        ~QuietErrors() { cerr.rdbuf(m_saved); }
+
+    private:
+        CountingBuffer m_sink;
+        streambuf* m_saved;
+    };
+
+    struct Measurement
+    {
+        Measurement() : m_items(0), m_bytes(0) {}
+
+        double m_items; //instructions, lookups, lines...
+        double m_bytes; //bytes consumed or produced
+    };
+
+    struct Benchmark
+    {
+        const char* m_name;
+        const char* m_items;
+        const char* m_description;
+        function<Measurement()> m_run;
+        function<void()> m_setup; //untimed, before every iteration
+    };
+
+    double cpu_seconds()
+    {
+        return double(clock()) / CLOCKS_PER_SEC;
+    }
+
+    void run_benchmark(const Benchmark& bench, int iterations)
+    {
+        double best = 0, best_cpu = 0;
+        unsigned long long allocations = 0;
+        Measurement measurement;
+        for (int i = 0; i < iterations; ++i){
+            if (bench.m_setup)
+                bench.m_setup();
+
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            double cpu_start = cpu_seconds();
+            unsigned long long allocations_start = allocation_count();
+
+            measurement = bench.m_run();
+
+            allocations = allocation_count() - allocations_start;
+            double cpu = cpu_seconds() - cpu_start;
+            double wall = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (i == 0 || wall < best){
+                best = wall;
+                best_cpu = cpu;
+            }
+        }
+
+        cout << left << setw(8) << bench.m_name << right << fixed
+            << setprecision(2) << setw(11) << best * 1000 << " ms"
+            << setw(11) << best_cpu * 1000 << " ms cpu"
+            << setprecision(0) << setw(13) << measurement.m_items / best << ' '
+            << left << setw(10) << string(bench.m_items) + "/s" << right
+            << setprecision(2) << setw(10) << measurement.m_bytes / best / (1024 * 1024) << " MB/s"
+            << setw(9) << allocations / max(measurement.m_items, 1.0) << " allocs/" << left << setw(8) << bench.m_items << right
+            << bench.m_description << endl;
+    }
+
+    unsigned long long file_bytes(const vector<DriverFile>& files)
+    {
+        unsigned long long total = 0;
+        for (size_t i = 0; i < files.size(); ++i){
+            FILE* f = fopen(files[i].m_filename.c_str(), "rb");
+            if (!f)
+                continue;
+            fseek(f, 0, SEEK_END);
+            total += ftell(f);
+            fclose(f);
+        }
+        return total;
+    }
+
+    Request make_request(const string& line)
+    {
+        istringstream in(line);
+        Request request;
+        request.get(in, false);
+        return request;
+    }
+
+    string range(unsigned int banks, const string& flags)
+    {
+        return "8000 " + to_string(full_address(banks, 0), 6) + flags;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    SyntheticRomOptions options;
+    int iterations = 3;
+    string directory = ".";
+    string only;
+
+    for (int i = 1; i < argc; ++i){
+        string current(argv[i]);
+        if (current == "--seed" && ++i < argc)
+            options.m_seed = atoi(argv[i]);
+        else if (current == "--banks" && ++i < argc)
+            options.m_banks = max(1, min(0x7E, atoi(argv[i])));
+        else if (current == "--iterations" && ++i < argc)
+            iterations = max(1, atoi(argv[i]));
+        else if (current == "--dir" && ++i < argc)
+            directory = argv[i];
+        else if (current == "--only" && ++i < argc)
+            only = argv[i];
+        else{
+            cout << HELP;
+            return -1;
+        }
+    }
+
+    SyntheticRom rom = generate_rom(options);
+    string rom_file;
+    vector<DriverFile> driver_files;
+    if (!write_rom(rom, directory, &rom_file, &driver_files)){
+        cerr << "Could not write the synthetic ROM to " << directory << endl;
+        return -1;
+    }
+    unsigned long long driver_bytes = file_bytes(driver_files);
+
+    cout << "; seed " << options.m_seed << ", " << options.m_banks << " banks: "
+        << rom.m_instructions << " instructions, " << rom.m_code_bytes << " code bytes, "
+        << rom.m_data_bytes << " data bytes, " << rom.m_pointers << " pointers, "
+        << driver_bytes << " bytes of driver files" << endl;
+
+    FILE* rom_handle = fopen(rom_file.c_str(), "rb");
+    if (!rom_handle){
+        cerr << "Could not open " << rom_file << " for reading." << endl;
+        return -1;
+    }
+
+    // loaded once and shared by the benchmarks through sessions
+    Disassembler base(rom_handle);
+    {
+        QuietErrors quiet;
+        vector<DriverFile> files = driver_files;
+        base.load_driver_files(files);
+    }
+    base.quiet(true);
+
+    // every iteration gets a fresh session so that nothing is served
+    // from the range cache
+    CountingBuffer sink;
+    ostream out(&sink);
+    unique_ptr<Disassembler> session;
+
+    vector<Benchmark> benchmarks;
+
+    Benchmark decode = { "decode", "instr", "single pass over the ROM, output discarded", [&](){
+        session->handleRequest(make_request(range(options.m_banks, "")));
+        Measurement m;
+        m.m_items = rom.m_instructions;
+        m.m_bytes = (double)rom.m_image.size();
+        return m;
+    }, [&](){
+        session.reset(new Disassembler(base, rom_handle, out));
+        session->set_output_format("none");
+    } };
+    benchmarks.push_back(decode);
+
+    Benchmark labels = { "labels", "lookups", "operand label resolution", [&](){
+        InstructionMetadata jsr("JSR", 0x20, &InstructionHandler::Absolute);
+        size_t lookups = 0;
+        for (int pass = 0; pass < 4; ++pass){
+            for (size_t i = 0; i < rom.m_label_targets.size(); ++i){
+                unsigned int target = rom.m_label_targets[i];
+                session->get_instr_label(jsr, bank_from_addr24(target), addr16_from_addr24(target), 0);
+            }
+            lookups += rom.m_label_targets.size();
+        }
+        Measurement m;
+        m.m_items = (double)lookups;
+        return m;
+    }, [&](){
+        // sets up the range and extern symbol rules the lookups run under
+        session.reset(new Disassembler(base, rom_handle, out));
+        session->handleRequest(make_request("asm 008000 008001 -e"));
+    } };
+    benchmarks.push_back(labels);
+
+    Benchmark parse = { "parse", "files", "driver file parsing only", [&](){
+        vector<DriverFile> files = driver_files;
+        parse_driver_files(&files, base.memory_map());
+        Measurement m;
+        m.m_items = (double)files.size();
+        m.m_bytes = (double)driver_bytes;
+        return m;
+    }, nullptr };
+    benchmarks.push_back(parse);
+
+    Benchmark load = { "load", "files", "driver files parsed and applied", [&](){
+        unique_ptr<Disassembler> fresh(new Disassembler(rom_handle));
+        vector<DriverFile> files = driver_files;
+        {
+            QuietErrors quiet;
+            fresh->load_driver_files(files);
+        }
+        Measurement m;
+        m.m_items = (double)files.size();
+        m.m_bytes = (double)driver_bytes;
+        return m;
+    }, nullptr };
+    benchmarks.push_back(load);
+
+    Benchmark print = { "print", "lines", "output formatting of .db lines", [&](){
+        CountingBuffer lines_out;
+        ostream formatted(&lines_out);
+        shared_ptr<OutputHandler> output = CreateOutputHandler("", formatted);
+        vector<unsigned char> bytes(8);
+        size_t lines = 0;
+        for (size_t i = 0; i + 8 <= rom.m_image.size(); i += 8, ++lines){
+            copy(rom.m_image.begin() + i, rom.m_image.begin() + i + 8, bytes.begin());
+            output->PrintData(bytes, (i % 256) ? "" : "Data_" + to_string((int)i, 6), "", true, false);
+        }
+        Measurement m;
+        m.m_items = (double)lines;
+        m.m_bytes = (double)lines_out.count();
+        return m;
+    }, nullptr };
+    benchmarks.push_back(print);
+
+    Benchmark macro = { "macro", "instr", "full listing, 8000 <end> -p -e", [&](){
+        unsigned long long before = sink.count();
+        session->handleRequest(make_request(range(options.m_banks, " -p -e")));
+        Measurement m;
+        m.m_items = 2.0 * rom.m_instructions;
+        m.m_bytes = (double)(sink.count() - before);
+        return m;
+    }, [&](){
+        session.reset(new Disassembler(base, rom_handle, out));
+    } };
+    benchmarks.push_back(macro);
+
+    for (size_t i = 0; i < benchmarks.size(); ++i){
+        if (only.empty() || only == benchmarks[i].m_name)
+            run_benchmark(benchmarks[i], iterations);
+    }
+
+    session.reset();
+    fclose(rom_handle);
+    return 0;
+}
@@ -0,0 +1,304 @@
+#include <fstream>
+#include "synthetic_rom.h"
+#include "utils.h"
+
+using namespace std;
+using namespace Address;
+
+namespace{
+    // splitmix64, so that the image doesn't depend on the standard library
+    struct Random
+    {
+        explicit Random(unsigned long long seed) : m_state(seed) {}
+
+        unsigned long long next()
+        {
+            unsigned long long z = (m_state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+
+        unsigned int below(unsigned int n) { return (unsigned int)(next() % n); }
+        bool chance(unsigned int percent) { return below(100) < percent; }
+
+        template<typename T, size_t N>
+        T pick(const T (&values)[N]) { return values[below(N)]; }
+
+    private:
+        unsigned long long m_state;
+    };
+
+    const unsigned char IMPLIED[] = { 0x18, 0x38, 0xE8, 0xC8, 0xCA, 0x88, 0x48, 0x68, 0xAA, 0xA8, 0x8A, 0x98,
+        0x0A, 0x4A, 0xEB, 0x1A, 0x3A, 0x5A, 0x7A, 0xDA, 0xFA, 0x0B, 0x2B, 0x8B, 0xAB, 0x5B, 0x7B };
+    const unsigned char ACCUM_IMMEDIATE[] = { 0xA9, 0xC9, 0x29, 0x09, 0x69, 0xE9, 0x49, 0x89 };
+    const unsigned char INDEX_IMMEDIATE[] = { 0xA2, 0xA0, 0xE0, 0xC0 };
+    const unsigned char DIRECT_PAGE[] = { 0xA5, 0x85, 0x64, 0xA6, 0x86, 0xA4, 0x84, 0xC5, 0x65, 0xE5,
+        0x06, 0xE6, 0xC6, 0xB5, 0x95 };
+    const unsigned char ABSOLUTE[] = { 0xAD, 0x8D, 0x9C, 0xAE, 0x8E, 0xAC, 0x8C, 0xCD, 0x6D, 0xED,
+        0xEE, 0xCE, 0xBD, 0x9D, 0xB9, 0x99 };
+    const unsigned char ABSOLUTE_LONG[] = { 0xAF, 0x8F, 0xBF, 0x9F, 0xCF };
+    const unsigned char BRANCHES[] = { 0x80, 0xD0, 0xF0, 0x90, 0xB0, 0x10, 0x30, 0x50, 0x70 };
+    const unsigned char WIDTH_BITS[] = { 0x10, 0x20, 0x30 };
+
+    struct Generator
+    {
+        Generator(const SyntheticRomOptions& options, SyntheticRom* rom) :
+        m_random(options.m_seed * 0x100000001B3ULL + 1),
+        m_rom(rom),
+        m_banks(options.m_banks)
+        {}
+
+        void run()
+        {
+            m_rom->m_image.reserve(m_banks * BANK_SIZE);
+            m_rom->m_coverage.reset(MAX_FILE_SIZE, false);
+
+            for (unsigned int i = 0; i < 0x2000; i += 0x10){
+                m_rom->m_ram_symbols += to_string(i, 4) + " Var_" + to_string(i, 4) + "\n";
+            }
+
+            for (unsigned int bank = 0; bank < m_banks; ++bank){
+                m_bank_routines.clear();
+                while (here() < (bank + 1) * BANK_SIZE){
+                    unsigned int remaining = remaining_in_bank();
+                    unsigned int choice = m_random.below(100);
+                    if (remaining < 64)
+                        data_run(remaining);
+                    else if (choice < 70 || m_bank_routines.empty())
+                        code_routine();
+                    else if (choice < 85)
+                        data_run(min(remaining, 16 + m_random.below(241)));
+                    else
+                        pointer_table(choice >= 95);
+                }
+            }
+        }
+
+    private:
+        unsigned int here() const { return (unsigned int)m_rom->m_image.size(); }
+        unsigned int remaining_in_bank() const { return BANK_SIZE - here() % BANK_SIZE; }
+
+        static unsigned int address(unsigned int offset)
+        {
+            return full_address(offset / BANK_SIZE, 0x8000 + offset % BANK_SIZE);
+        }
+
+        void emit(unsigned char b) { m_rom->m_image.push_back(b); }
+        void emit_word(unsigned int w) { emit(w & 0xFF); emit((w >> 8) & 0xFF); }
+        void emit_long(unsigned int l) { emit_word(l); emit((l >> 16) & 0xFF); }
+
+        void data_run(unsigned int size)
+        {
+            unsigned int start = address(here());
+            for (unsigned int i = 0; i < size; ++i){
+                emit(m_random.below(256));
+            }
+            m_rom->m_data += to_string(start, 6) + " " + to_string(address(here() - 1) + 1, 6);
+            if (m_random.chance(50))
+                m_rom->m_data += " Data_" + to_string(start, 6);
+            m_rom->m_data += "\n";
+            if (m_random.chance(5))
+                m_rom->m_comments += to_string(start, 6) + " table of " + to_string(size, 4, false) + " bytes\n";
+            m_rom->m_data_bytes += size;
+        }
+
+        void pointer_table(bool long_ptrs)
+        {
+            unsigned int entry_size = long_ptrs ? 3 : 2;
+            unsigned int count = min(4 + m_random.below(29), (remaining_in_bank() - 1) / entry_size);
+            unsigned int start = address(here());
+            for (unsigned int i = 0; i < count; ++i){
+                if (long_ptrs)
+                    emit_long(m_routines[m_random.below((unsigned int)m_routines.size())]);
+                else
+                    emit_word(m_bank_routines[m_random.below((unsigned int)m_bank_routines.size())]);
+            }
+            m_rom->m_pointer_tables += to_string(start, 6) + " " + to_string(address(here() - 1) + 1, 6) + (long_ptrs ? " 3" : " 2");
+            if (m_random.chance(50))
+                m_rom->m_pointer_tables += (long_ptrs ? " LongTable_" : " Table_") + to_string(start, 6);
+            m_rom->m_pointer_tables += "\n";
+            m_rom->m_pointers += count;
+        }
+
+        void code_routine()
+        {
+            unsigned int start_offset = here();
+            unsigned int start = address(start_offset);
+            bool accum_16 = m_random.chance(50);
+            bool index_16 = m_random.chance(50);
+
+            // every routine states its entry widths so the decode stays in step
+            if (accum_16 == index_16){
+                m_rom->m_flags += to_string(start, 6) + " AI " + (accum_16 ? "16" : "8") + "\n";
+            }
+            else{
+                m_rom->m_flags += to_string(start, 6) + " A  " + (accum_16 ? "16" : "8") + "\n";
+                m_rom->m_flags += to_string(start, 6) + " I  " + (index_16 ? "16" : "8") + "\n";
+            }
+            if (m_random.chance(60))
+                m_rom->m_symbols += to_string(start, 6) + " Sub_" + to_string(start, 6) + "\n";
+
+            m_routines.push_back(start);
+            m_bank_routines.push_back(start);
+
+            vector<unsigned int> starts;
+            unsigned int count = 8 + m_random.below(89);
+            for (unsigned int i = 0; i < count && remaining_in_bank() > 16; ++i){
+                starts.push_back(here());
+                if (m_random.chance(30))
+                    m_rom->m_coverage.mark_instruction_start(here());
+                if (m_random.chance(8))
+                    m_rom->m_comments += to_string(address(here()), 6) + " step " + to_string(i, 2, false) + " of routine\n";
+                instruction(&accum_16, &index_16, starts);
+                ++m_rom->m_instructions;
+            }
+
+            unsigned int end = m_random.below(100);
+            if (end < 60){
+                emit(0x60);
+            }
+            else if (end < 85){
+                emit(0x6B);
+            }
+            else{
+                emit(0x4C);
+                emit_word(m_bank_routines[m_random.below((unsigned int)m_bank_routines.size())]);
+            }
+            ++m_rom->m_instructions;
+            m_rom->m_code_bytes += here() - start_offset;
+
+            if (m_random.chance(10))
+                m_rom->m_data_banks += to_string(start, 6) + " " + to_string(address(here() - 1) + 1, 6) + " " + to_string(m_random.below(m_banks), 2) + "\n";
+        }
+
+        void instruction(bool* accum_16, bool* index_16, const vector<unsigned int>& starts)
+        {
+            unsigned int offset = here();
+            unsigned int kind = m_random.below(100);
+
+            if (kind < 8){
+                bool rep = m_random.chance(50);
+                unsigned char bits = m_random.pick(WIDTH_BITS);
+                emit(rep ? 0xC2 : 0xE2);
+                emit(bits);
+                if (bits & 0x20) *accum_16 = rep;
+                if (bits & 0x10) *index_16 = rep;
+            }
+            else if (kind < 18){
+                int relative = 2 + (int)m_random.below(16);
+                if (starts.size() > 1 && m_random.chance(60)){
+                    int back = (int)starts[m_random.below((unsigned int)starts.size() - 1)] - (int)(offset + 2);
+                    if (back >= -128)
+                        relative = back;
+                }
+                emit(m_random.pick(BRANCHES));
+                emit((unsigned char)(signed char)relative);
+                m_rom->m_label_targets.push_back(address(offset + 2 + relative));
+            }
+            else if (kind < 23){
+                unsigned int target = m_bank_routines[m_random.below((unsigned int)m_bank_routines.size())];
+                emit(0x20);
+                emit_word(target);
+                m_rom->m_label_targets.push_back(target);
+            }
+            else if (kind < 26){
+                unsigned int target = m_routines[m_random.below((unsigned int)m_routines.size())];
+                emit(0x22);
+                emit_long(target);
+                m_rom->m_label_targets.push_back(target);
+            }
+            else if (kind < 40){
+                emit(m_random.pick(ACCUM_IMMEDIATE));
+                if (*accum_16) emit_word(m_random.below(0x10000)); else emit(m_random.below(0x100));
+            }
+            else if (kind < 48){
+                emit(m_random.pick(INDEX_IMMEDIATE));
+                if (*index_16) emit_word(m_random.below(0x10000)); else emit(m_random.below(0x100));
+            }
+            else if (kind < 62){
+                emit(m_random.pick(DIRECT_PAGE));
+                emit(m_random.below(0x100));
+            }
+            else if (kind < 80){
+                unsigned int operand = m_random.chance(70) ? m_random.below(0x2000) : 0x8000 + m_random.below(0x8000);
+                emit(m_random.pick(ABSOLUTE));
+                emit_word(operand);
+                if (operand < 0x2000){
+                    m_rom->m_label_targets.push_back(full_address(0x7E, operand));
+                    if (m_random.chance(3))
+                        m_rom->m_offsets += to_string(address(offset), 6) + " 1\n";
+                }
+            }
+            else if (kind < 86){
+                unsigned int operand = m_random.chance(50) ?
+                    full_address(0x7E, m_random.below(0x2000)) :
+                    full_address(m_random.below(m_banks), 0x8000 + m_random.below(0x8000));
+                emit(m_random.pick(ABSOLUTE_LONG));
+                emit_long(operand);
+                m_rom->m_label_targets.push_back(operand);
+            }
+            else{
+                emit(m_random.pick(IMPLIED));
+            }
+        }
+
+        Random m_random;
+        SyntheticRom* m_rom;
+        unsigned int m_banks;
+        vector<unsigned int> m_routines;
+        vector<unsigned int> m_bank_routines;
+    };
+
+    bool write_text(const string& filename, const string& text)
+    {
+        ofstream out(filename.c_str(), ios::binary);
+        out << text;
+        return out.good();
+    }
+}
+
+SyntheticRom generate_rom(const SyntheticRomOptions& options)
+{
+    SyntheticRom rom;
+    Generator(options, &rom).run();
+    return rom;
+}
+
+bool write_rom(const SyntheticRom& rom, const string& directory, string* rom_file, vector<DriverFile>* driver_files)
+{
+    string base = directory + "/synthetic";
+    *rom_file = base + ".smc";
+
+    ofstream image(rom_file->c_str(), ios::binary);
+    string header(512, '\0');
+    image.write(header.data(), header.size());
+    image.write((const char*)rom.m_image.data(), rom.m_image.size());
+    if (!image.good())
+        return false;
+
+    struct { DriverFile::Type type; const char* extension; const string* text; } files[] = {
+        { DriverFile::RamSymbols, ".ram", &rom.m_ram_symbols },
+        { DriverFile::Symbols, ".sym", &rom.m_symbols },
+        { DriverFile::Pointers, ".ptr", &rom.m_pointer_tables },
+        { DriverFile::Data, ".data", &rom.m_data },
+        { DriverFile::Flags, ".flags", &rom.m_flags },
+        { DriverFile::DataBank, ".dbank", &rom.m_data_banks },
+        { DriverFile::Comments, ".comment", &rom.m_comments },
+        { DriverFile::Offsets, ".offsets", &rom.m_offsets },
+    };
+
+    driver_files->clear();
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i){
+        string filename = base + files[i].extension;
+        if (!write_text(filename, *files[i].text))
+            return false;
+        driver_files->push_back(DriverFile(files[i].type, filename));
+    }
+
+    string coverage_file = base + ".cov";
+    if (!rom.m_coverage.save(coverage_file))
+        return false;
+    driver_files->push_back(DriverFile(DriverFile::TraceSymbols, coverage_file));
+    return true;
+}
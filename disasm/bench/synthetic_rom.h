@@ -0,0 +1,58 @@
+#ifndef SYNTHETIC_ROM_H
+#define SYNTHETIC_ROM_H
+
+#include <string>
+#include <vector>
+#include "coverage.h"
+#include "driver_file.h"
+
+struct SyntheticRomOptions
+{
+    SyntheticRomOptions() :
+    m_seed(1),
+    m_banks(16)
+    {}
+
+    unsigned int m_seed;
+    unsigned int m_banks; //32K LoROM banks, starting at bank 00
+};
+
+// A deterministic LoROM image made of code routines (random but valid
+// instruction streams with REP/SEP mixes), data runs and pointer tables,
+// together with the driver files that describe it.  The same options
+// produce the same bytes on every platform.
+struct SyntheticRom
+{
+    SyntheticRom() :
+    m_instructions(0),
+    m_code_bytes(0),
+    m_data_bytes(0),
+    m_pointers(0)
+    {}
+
+    std::vector<unsigned char> m_image; //without a copier header
+    unsigned int m_instructions;
+    unsigned int m_code_bytes;
+    unsigned int m_data_bytes;
+    unsigned int m_pointers;
+    std::vector<unsigned int> m_label_targets; //operand targets, as full addresses
+
+    // driver file contents
+    std::string m_symbols;
+    std::string m_ram_symbols;
+    std::string m_data;
+    std::string m_pointer_tables;
+    std::string m_flags;
+    std::string m_comments;
+    std::string m_data_banks;
+    std::string m_offsets;
+    CoverageMap m_coverage;
+};
+
+SyntheticRom generate_rom(const SyntheticRomOptions& options);
+
+// Writes synthetic.smc (with a 512 byte header) and its driver files to
+// directory, and returns the driver files in command line order.
+bool write_rom(const SyntheticRom& rom, const std::string& directory, std::string* rom_file, std::vector<DriverFile>* driver_files);
+
+#endif
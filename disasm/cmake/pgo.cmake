@@ -0,0 +1,51 @@
+# Profile guided build, run by the pgo target (see CMakeLists.txt).
+#
+# The instrumented and optimized builds share BINARY_DIR, so that GCC finds
+# each object's profile under the same name it was recorded with.
+
+set(profile_dir "${BINARY_DIR}/profile")
+set(training_dir "${BINARY_DIR}/training")
+separate_arguments(TRAINING_ARGS)
+
+function(run)
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "Failed (${result}): ${ARGN}")
+    endif()
+endfunction()
+
+function(build pgo)
+    run(${CMAKE_COMMAND} -S ${SOURCE_DIR} -B ${BINARY_DIR} -G ${GENERATOR}
+        -DCMAKE_BUILD_TYPE=Release
+        -DCMAKE_CXX_COMPILER=${CXX_COMPILER}
+        -DDISASM_LTO=${LTO}
+        -DDISASM_PGO=${pgo}
+        -DDISASM_PGO_DIR=${profile_dir})
+    # the flags changed, so nothing from the other phase can be reused
+    run(${CMAKE_COMMAND} --build ${BINARY_DIR} --clean-first)
+endfunction()
+
+message(STATUS "pgo: instrumented build")
+file(REMOVE_RECURSE ${profile_dir})
+file(MAKE_DIRECTORY ${profile_dir} ${training_dir})
+build(GENERATE)
+
+# decode, two pass labelling and output formatting over the synthetic ROM
+message(STATUS "pgo: training")
+run(${BINARY_DIR}/disasm_bench ${TRAINING_ARGS} --dir ${training_dir})
+
+if(CXX_COMPILER_ID MATCHES "Clang")
+    if(NOT LLVM_PROFDATA)
+        message(FATAL_ERROR "llvm-profdata is needed to merge Clang profiles")
+    endif()
+    file(GLOB raw_profiles ${profile_dir}/*.profraw)
+    run(${LLVM_PROFDATA} merge -output=${profile_dir}/disasm.profdata ${raw_profiles})
+endif()
+
+message(STATUS "pgo: optimized build")
+build(USE)
+
+message(STATUS "pgo: plain release build")
+run(${BASELINE_BENCH} ${TRAINING_ARGS} --dir ${training_dir})
+message(STATUS "pgo: profile guided build")
+run(${BINARY_DIR}/disasm_bench ${TRAINING_ARGS} --dir ${training_dir})
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include "analytics.h"
+#include "stats.h"
+#include "utils.h"
+
+using namespace std;
+using namespace Address;
+
+namespace{
+    const size_t MAX_LISTED_LABELS = 20; //in the table; JSON has all of them
+
+    size_t popcount(uint64_t word)
+    {
+#if defined(_MSC_VER) && defined(_M_X64)
+        return (size_t)__popcnt64(word);
+#elif defined(_MSC_VER)
+        return (size_t)(__popcnt((unsigned int)word) + __popcnt((unsigned int)(word >> 32)));
+#else
+        return (size_t)__builtin_popcountll(word);
+#endif
+    }
+
+    // the bits of a word from bit first up to bit last, which may be 64
+    uint64_t bits_between(size_t first, size_t last)
+    {
+        uint64_t high = last >= 64 ? ~uint64_t(0) : (uint64_t(1) << last) - 1;
+        return high & ~((uint64_t(1) << first) - 1);
+    }
+
+    string percent(size_t part, size_t whole)
+    {
+        ostringstream ss;
+        ss << fixed << setprecision(1) << (whole ? 100.0 * part / whole : 0.0) << "%";
+        return ss.str();
+    }
+
+    void write_row_json(ostream& out, const AnalyticsRow& row)
+    {
+        out << "{ \"bytes\": " << row.m_bytes << ", \"code\": " << row.m_code << ", \"data\": " << row.m_data
+            << ", \"pointers\": " << row.m_pointers << ", \"compressed\": " << row.m_compressed << ", \"tiles\": " << row.m_tiles
+            << ", \"untyped\": " << row.m_untyped << ", \"labels\": " << row.m_labels
+            << ", \"unreferenced_labels\": " << row.m_unreferenced << ", \"comments\": " << row.m_comments << " }";
+    }
+}
+
+void ByteBitmap::set_range(size_t start, size_t end)
+{
+    for (size_t word = start >> 6; start < end; ++word){
+        size_t last = min(end - (word << 6), (size_t)64);
+        m_words[word] |= bits_between(start & 63, last);
+        start = (word + 1) << 6;
+    }
+}
+
+template<class Combine>
+size_t ByteBitmap::count_words(const ByteBitmap* other, size_t start, size_t end, Combine combine) const
+{
+    size_t total = 0;
+    for (size_t word = start >> 6; start < end; ++word){
+        size_t last = min(end - (word << 6), (size_t)64);
+        uint64_t bits = combine(m_words[word], other ? other->m_words[word] : 0);
+        total += popcount(bits & bits_between(start & 63, last));
+        start = (word + 1) << 6;
+    }
+    return total;
+}
+
+size_t ByteBitmap::count(size_t start, size_t end) const
+{
+    return count_words(0, start, end, [](uint64_t a, uint64_t){ return a; });
+}
+
+size_t ByteBitmap::count_and_not(const ByteBitmap& other, size_t start, size_t end) const
+{
+    return count_words(&other, start, end, [](uint64_t a, uint64_t b){ return a & ~b; });
+}
+
+size_t ByteBitmap::count_or(const ByteBitmap& other, size_t start, size_t end) const
+{
+    return count_words(&other, start, end, [](uint64_t a, uint64_t b){ return a | b; });
+}
+
+void AnalyticsRow::add(const AnalyticsRow& other)
+{
+    m_bytes += other.m_bytes;
+    m_code += other.m_code;
+    m_data += other.m_data;
+    m_pointers += other.m_pointers;
+    m_compressed += other.m_compressed;
+    m_tiles += other.m_tiles;
+    m_untyped += other.m_untyped;
+    m_labels += other.m_labels;
+    m_unreferenced += other.m_unreferenced;
+    m_comments += other.m_comments;
+}
+
+void AnalyticsReport::print(ostream& out) const
+{
+    out << "; " << left << setw(6) << "bank" << right << setw(8) << "bytes" << setw(8) << "code" << setw(8) << "data"
+        << setw(8) << "ptrs" << setw(8) << "lz" << setw(8) << "tiles" << setw(9) << "untyped"
+        << setw(8) << "labels" << setw(7) << "unref" << setw(9) << "comments" << endl;
+    for (size_t i = 0; i <= m_banks.size(); ++i){
+        const AnalyticsRow& row = i < m_banks.size() ? m_banks[i] : m_total;
+        out << "; " << left << setw(6) << (i < m_banks.size() ? to_string(row.m_bank, 2) : "total") << right
+            << setw(8) << row.m_bytes << setw(8) << percent(row.m_code, row.m_bytes) << setw(8) << percent(row.m_data, row.m_bytes)
+            << setw(8) << percent(row.m_pointers, row.m_bytes) << setw(8) << percent(row.m_compressed, row.m_bytes)
+            << setw(8) << percent(row.m_tiles, row.m_bytes) << setw(9) << percent(row.m_untyped, row.m_bytes)
+            << setw(8) << row.m_labels << setw(7) << row.m_unreferenced << setw(9) << row.m_comments << endl;
+    }
+
+    out << ";" << endl << "; " << left << setw(28) << "address mode" << right << setw(10) << "decoded" << endl;
+    for (const pair<string, size_t>& mode : m_modes){
+        out << "; " << left << setw(28) << mode.first << right << setw(10) << mode.second << endl;
+    }
+
+    if (!m_unreferenced.empty()){
+        out << ";" << endl << "; unreferenced labels" << endl;
+        for (size_t i = 0; i < m_unreferenced.size() && i < MAX_LISTED_LABELS; ++i){
+            out << "; " << to_string(m_unreferenced[i].first, 6) << " " << m_unreferenced[i].second << endl;
+        }
+        if (m_unreferenced.size() > MAX_LISTED_LABELS)
+            out << "; and " << m_unreferenced.size() - MAX_LISTED_LABELS << " more" << endl;
+    }
+}
+
+void AnalyticsReport::write_json(ostream& out) const
+{
+    out << "{" << endl << "  \"banks\": [";
+    for (size_t i = 0; i < m_banks.size(); ++i){
+        out << (i ? "," : "") << endl << "    { \"bank\": " << json_string(to_string(m_banks[i].m_bank, 2)) << ", \"counts\": ";
+        write_row_json(out, m_banks[i]);
+        out << " }";
+    }
+    out << endl << "  ]," << endl << "  \"total\": ";
+    write_row_json(out, m_total);
+    out << "," << endl << "  \"address_modes\": {";
+    for (size_t i = 0; i < m_modes.size(); ++i){
+        out << (i ? "," : "") << endl << "    " << json_string(m_modes[i].first) << ": " << m_modes[i].second;
+    }
+    out << endl << "  }," << endl << "  \"unreferenced_labels\": [";
+    for (size_t i = 0; i < m_unreferenced.size(); ++i){
+        out << (i ? "," : "") << endl << "    { \"address\": " << json_string(to_string(m_unreferenced[i].first, 6))
+            << ", \"name\": " << json_string(m_unreferenced[i].second) << " }";
+    }
+    out << endl << "  ]" << endl << "}" << endl;
+}
@@ -0,0 +1,68 @@
+#ifndef ANALYTICS_H
+#define ANALYTICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// One bit per ROM byte, by file offset.  Ranges are counted a 64 bit word
+// at a time with popcount, so a count over the whole ROM reads 64KB of
+// bitmap for each 4MB.
+struct ByteBitmap
+{
+    explicit ByteBitmap(size_t size = 0) : m_words((size + 63) / 64) {}
+
+    void set(size_t index) { m_words[index >> 6] |= uint64_t(1) << (index & 63); }
+    void set_range(size_t start, size_t end);
+    bool test(size_t index) const { return ((m_words[index >> 6] >> (index & 63)) & 1) != 0; }
+
+    // bits set from start up to end; the bitmaps must be the same size
+    size_t count(size_t start, size_t end) const;
+    size_t count_and_not(const ByteBitmap& other, size_t start, size_t end) const;
+    size_t count_or(const ByteBitmap& other, size_t start, size_t end) const;
+
+private:
+    template<class Combine> size_t count_words(const ByteBitmap* other, size_t start, size_t end, Combine combine) const;
+
+    std::vector<uint64_t> m_words;
+};
+
+// What the analytics request reports: bytes of a bank, or of the whole
+// range, by what the driver files and traces know about them.
+struct AnalyticsRow
+{
+    AnalyticsRow() :
+    m_bank(0), m_bytes(0), m_code(0), m_data(0), m_pointers(0), m_compressed(0), m_tiles(0), m_untyped(0),
+    m_labels(0), m_unreferenced(0), m_comments(0)
+    {}
+
+    void add(const AnalyticsRow& other);
+
+    unsigned int m_bank;
+    size_t m_bytes;
+    size_t m_code; //bytes of traced or decoded instructions, see Disassembler::analyze
+    size_t m_data;
+    size_t m_pointers;
+    size_t m_compressed;
+    size_t m_tiles;
+    size_t m_untyped; //neither code nor typed by a data file
+    size_t m_labels;
+    size_t m_unreferenced; //labels no instruction or pointer table names
+    size_t m_comments;
+};
+
+struct AnalyticsReport
+{
+    std::vector<AnalyticsRow> m_banks;
+    AnalyticsRow m_total;
+    std::vector<std::pair<std::string, size_t> > m_modes; //instructions by address mode, most used first
+    std::vector<std::pair<unsigned int, std::string> > m_unreferenced; //address and name
+
+    void print(std::ostream& out) const;
+    void write_json(std::ostream& out) const;
+};
+
+#endif
@@ -1,29 +1,185 @@
+#ifndef ANNOTATION_HANDLERS_H
+#define ANNOTATION_HANDLERS_H
+
 #include <string>
-#include <map>
-#include <memory>
 
-struct AnnotationProvider
+// Operand size suffixes (".W", ".B", ".L") that follow an instruction name.
+//
+// Each dialect is a policy type: a constexpr table of string literals, one
+// row of four per opcode, and a column() that picks the entry for the
+// processor state.  The code loop in Disassembler is instantiated once per
+// dialect, so looking a suffix up is an index into the table and never
+// allocates.
+namespace Annotations
 {
-    virtual std::string get_annotation(int opcode, bool is_accum_16, bool is_index_16, bool is_symbolic_address) = 0;
-    virtual ~AnnotationProvider() = 0;
-};
+    enum Dialect { Default, Smas };
+
+    enum Kind { Word, AccumDependentWord, IndexDependentWord, Long, SymbolicWord, SymbolicLong };
+
+    struct SuffixTable
+    {
+        const char* m_text[256][4];
+    };
+
+    // The column bits mean what the dialect's column() says they mean:
+    // accum and index size for the size kinds, a symbolic operand for the
+    // symbolic ones.
+    constexpr void set(SuffixTable& table, int opcode, Kind kind)
+    {
+        for (int column = 0; column < 4; ++column){
+            const char* text = "";
+            switch (kind){
+            case Word: text = ".W"; break;
+            case AccumDependentWord: text = (column & 1) ? ".W" : ".B"; break;
+            case IndexDependentWord: text = (column & 2) ? ".W" : ".B"; break;
+            case Long: text = ".L"; break;
+            case SymbolicWord: text = (column & 1) ? ".w" : ""; break;
+            case SymbolicLong: text = (column & 1) ? ".l" : ""; break;
+            }
+            table.m_text[opcode][column] = text;
+        }
+    }
+
+    constexpr SuffixTable empty_table()
+    {
+        SuffixTable table = {};
+        for (int opcode = 0; opcode < 256; ++opcode){
+            for (int column = 0; column < 4; ++column){
+                table.m_text[opcode][column] = "";
+            }
+        }
+        return table;
+    }
+
+    constexpr SuffixTable default_table()
+    {
+        SuffixTable t = empty_table();
+        set(t, 0x69, AccumDependentWord);
+        set(t, 0x6D, Word);
+        set(t, 0x6F, Long);
+        set(t, 0x7D, Word);
+        set(t, 0x7F, Long);
+        set(t, 0x79, Word);
+        set(t, 0x29, AccumDependentWord);
+        set(t, 0x2D, Word);
+        set(t, 0x2F, Long);
+        set(t, 0x3D, Word);
+        set(t, 0x3F, Long);
+        set(t, 0x39, Word);
+        set(t, 0x0E, Word);
+        set(t, 0x1E, Word);
+        set(t, 0x89, AccumDependentWord);
+        set(t, 0x2C, Word);
+        set(t, 0x3C, Word);
+        set(t, 0xC9, AccumDependentWord);
+        set(t, 0xCD, Word);
+        set(t, 0xCF, Long);
+        set(t, 0xDD, Word);
+        set(t, 0xDF, Long);
+        set(t, 0xD9, Word);
+        set(t, 0xE0, IndexDependentWord);
+        set(t, 0xEC, Word);
+        set(t, 0xC0, IndexDependentWord);
+        set(t, 0xCC, Word);
+        set(t, 0xCE, Word);
+        set(t, 0xDE, Word);
+        set(t, 0x49, AccumDependentWord);
+        set(t, 0x4D, Word);
+        set(t, 0x4F, Long);
+        set(t, 0x5D, Word);
+        set(t, 0x5F, Long);
+        set(t, 0x59, Word);
+        set(t, 0xEE, Word);
+        set(t, 0xFE, Word);
+        set(t, 0x5C, Long);
+        set(t, 0x4C, Word);
+        set(t, 0x22, Long);
+        set(t, 0x20, Word);
+        set(t, 0xA9, AccumDependentWord);
+        set(t, 0xAD, Word);
+        set(t, 0xAF, Long);
+        set(t, 0xBD, Word);
+        set(t, 0xBF, Long);
+        set(t, 0xB9, Word);
+        set(t, 0xA2, IndexDependentWord);
+        set(t, 0xAE, Word);
+        set(t, 0xBE, Word);
+        set(t, 0xA0, IndexDependentWord);
+        set(t, 0xAC, Word);
+        set(t, 0xBC, Word);
+        set(t, 0x4E, Word);
+        set(t, 0x5E, Word);
+        set(t, 0x09, AccumDependentWord);
+        set(t, 0x0D, Word);
+        set(t, 0x0F, Long);
+        set(t, 0x1D, Word);
+        set(t, 0x1F, Long);
+        set(t, 0x19, Word);
+        set(t, 0x2E, AccumDependentWord);
+        set(t, 0x3E, Word);
+        set(t, 0x6E, Word);
+        set(t, 0x7E, Word);
+        set(t, 0xE9, AccumDependentWord);
+        set(t, 0xED, Word);
+        set(t, 0xEF, Long);
+        set(t, 0xFD, Word);
+        set(t, 0xFF, Long);
+        set(t, 0xF9, Word);
+        set(t, 0x8D, Word);
+        set(t, 0x8F, Long);
+        set(t, 0x9D, Word);
+        set(t, 0x9F, Long);
+        set(t, 0x99, Word);
+        set(t, 0x8E, Word);
+        set(t, 0x8C, Word);
+        set(t, 0x9C, Word);
+        set(t, 0x9E, Word);
+        set(t, 0x1C, Word);
+        set(t, 0x0C, Word);
+        return t;
+    }
 
-struct DefaultAnnotations : public AnnotationProvider
+    constexpr SuffixTable smas_table()
+    {
+        SuffixTable t = empty_table();
+        set(t, 0xB9, SymbolicWord);
+        set(t, 0xBD, SymbolicWord);
+        set(t, 0xBF, SymbolicLong);
+        return t;
+    }
+
+    Dialect dialect(const std::string& type); //--annotate
+}
+
+struct DefaultAnnotations
 {
-    DefaultAnnotations();
-    virtual std::string get_annotation(int opcode, bool is_accum_16, bool is_index_16, bool is_symbolic_address);
-private:
-    typedef std::string(*HandlerPtr)(bool, bool, bool);
-    std::map<int, HandlerPtr> m_handlers;
+    static constexpr Annotations::SuffixTable s_table = Annotations::default_table();
+
+    static int column(bool is_accum_16, bool is_index_16, bool is_symbolic_address)
+    {
+        return (is_accum_16 ? 1 : 0) | (is_index_16 ? 2 : 0);
+    }
+
+    // opcodes past 0xFF are the pointer pseudo instructions, which have none
+    static const char* get_annotation(unsigned int opcode, bool is_accum_16, bool is_index_16, bool is_symbolic_address)
+    {
+        return opcode < 0x100 ? s_table.m_text[opcode][column(is_accum_16, is_index_16, is_symbolic_address)] : "";
+    }
 };
 
-struct SmasAnnotations : public AnnotationProvider
+struct SmasAnnotations
 {
-    SmasAnnotations();
-    virtual std::string get_annotation(int opcode, bool is_accum_16, bool is_index_16, bool is_symbolic_address);
-private:
-    typedef std::string(*HandlerPtr)(bool, bool, bool);
-    std::map<int, HandlerPtr> m_handlers;
+    static constexpr Annotations::SuffixTable s_table = Annotations::smas_table();
+
+    static int column(bool is_accum_16, bool is_index_16, bool is_symbolic_address)
+    {
+        return is_symbolic_address ? 1 : 0;
+    }
+
+    static const char* get_annotation(unsigned int opcode, bool is_accum_16, bool is_index_16, bool is_symbolic_address)
+    {
+        return opcode < 0x100 ? s_table.m_text[opcode][column(is_accum_16, is_index_16, is_symbolic_address)] : "";
+    }
 };
 
-std::shared_ptr<AnnotationProvider> CreateAnnotationProvider(const std::string& type);
+#endif
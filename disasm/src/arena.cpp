@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include "arena.h"
+
+using namespace std;
+
+Arena::Arena(size_t block_size) :
+m_block_size(block_size),
+m_offset(0),
+m_reserved(0),
+m_blocks_allocated(0)
+{ }
+
+Arena::Arena(const Arena& other) :
+m_block_size(other.m_block_size),
+m_offset(0),
+m_reserved(0),
+m_blocks_allocated(0)
+{ }
+
+Arena& Arena::operator=(const Arena& other)
+{
+    m_blocks.clear();
+    m_block_size = other.m_block_size;
+    m_offset = 0;
+    m_reserved = 0;
+    return *this;
+}
+
+void Arena::add_block(size_t bytes)
+{
+    Block block;
+    block.m_size = max(bytes, m_block_size);
+    block.m_data.reset(new char[block.m_size]);
+    m_reserved += block.m_size;
+    ++m_blocks_allocated;
+    m_blocks.push_back(move(block));
+    m_offset = 0;
+}
+
+void* Arena::allocate(size_t bytes, size_t alignment)
+{
+    if (!m_blocks.empty()){
+        Block& block = m_blocks.back();
+        size_t start = (m_offset + alignment - 1) & ~(alignment - 1);
+        if (start + bytes <= block.m_size){
+            m_offset = start + bytes;
+            return block.m_data.get() + start;
+        }
+    }
+
+    // blocks from new char[] are aligned for any fundamental type
+    add_block(bytes);
+    m_offset = bytes;
+    return m_blocks.back().m_data.get();
+}
+
+string_view Arena::join(initializer_list<string_view> parts)
+{
+    size_t length = 0;
+    for (const string_view& part : parts){
+        length += part.size();
+    }
+
+    char* text = (char*)allocate(length + 1, 1);
+    char* out = text;
+    for (const string_view& part : parts){
+        memcpy(out, part.data(), part.size());
+        out += part.size();
+    }
+    *out = 0;
+    return string_view(text, length);
+}
+
+void Arena::reset()
+{
+    if (m_blocks.size() > 1){
+        // one block of the combined size, so that the next request of the
+        // same shape fits without growing
+        size_t total = m_reserved;
+        m_blocks.clear();
+        m_reserved = 0;
+        add_block(total);
+    }
+    m_offset = 0;
+}
+
+size_t Arena::used() const
+{
+    size_t used = m_offset;
+    for (size_t i = 0; i + 1 < m_blocks.size(); ++i){
+        used += m_blocks[i].m_size;
+    }
+    return used;
+}
@@ -0,0 +1,51 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Monotonic allocator for text that only has to live as long as a request
+// (or a range cache entry): generated labels, joined comments and the
+// formatted operands of an instruction.  Allocation bumps a pointer inside
+// the current block, nothing is freed on its own, and reset() gives all of
+// it back at once while keeping the largest block for the next request.
+struct Arena
+{
+    explicit Arena(size_t block_size = 64 * 1024);
+
+    // copies start out empty (sessions get their own arena)
+    Arena(const Arena& other);
+    Arena& operator=(const Arena& other);
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    // The text is NUL terminated, so data() can be handed to printf.
+    std::string_view copy(std::string_view text) { return join({ text }); }
+    std::string_view join(std::initializer_list<std::string_view> parts);
+
+    void reset();
+
+    size_t used() const; //handed out since the last reset
+    size_t size_in_bytes() const { return m_reserved; }
+    unsigned long long blocks_allocated() const { return m_blocks_allocated; }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<char[]> m_data;
+        size_t m_size;
+    };
+
+    void add_block(size_t bytes);
+
+    std::vector<Block> m_blocks;
+    size_t m_block_size;
+    size_t m_offset; //into the last block
+    size_t m_reserved;
+    unsigned long long m_blocks_allocated;
+};
+
+#endif
@@ -0,0 +1,282 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <vector>
+#include "batch.h"
+#include "disassembler.h"
+#include "instruction.h"
+#include "options.h"
+#include "output_cache.h"
+#include "request.h"
+#include "stats.h"
+#include "thread_pool.h"
+#include "utils.h"
+
+using namespace std;
+
+namespace{
+    struct BatchJob
+    {
+        string m_name;
+        string m_rom;
+        string m_dir;
+        string m_output;
+        string m_cache;
+        vector<string> m_options;
+        vector<string> m_ranges;
+    };
+
+    struct JobResult
+    {
+        JobResult() : m_ok(false), m_seconds(0) {}
+
+        bool m_ok;
+        string m_message;
+        double m_seconds;
+    };
+
+    typedef map<string, shared_ptr<InstructionNameProvider> > NameTables;
+
+    string directory_of(const string& filename)
+    {
+        size_t slash = filename.find_last_of("/\\");
+        return slash == string::npos ? "" : filename.substr(0, slash + 1);
+    }
+
+    bool load_jobs(const string& filename, vector<BatchJob>* jobs)
+    {
+        ifstream in(filename.c_str());
+        if (!in){
+            cerr << "Could not open " << filename << " for reading." << endl;
+            return false;
+        }
+
+        string base = directory_of(filename);
+        string line;
+        int line_number = 0;
+        while (getline(in, line)){
+            ++line_number;
+            if (!line.empty() && line[line.size() - 1] == '\r')
+                line.erase(line.size() - 1);
+            if (Input::is_comment(line)) continue;
+
+            istringstream ss(line);
+            string key;
+            if (!(ss >> key)) continue;
+
+            if (key[0] == '['){
+                BatchJob job;
+                job.m_name = key.substr(1, key.find(']') - 1);
+                job.m_dir = base;
+                job.m_output = base;
+                jobs->push_back(job);
+                continue;
+            }
+            if (jobs->empty()){
+                cerr << filename << ":" << line_number << ": expected [job name] before " << key << endl;
+                return false;
+            }
+
+            BatchJob& job = jobs->back();
+            ss >> ws;
+            string value;
+            getline(ss, value);
+
+            if (key == "rom")
+                job.m_rom = join_path(base, value);
+            else if (key == "dir")
+                job.m_dir = join_path(base, value);
+            else if (key == "output")
+                job.m_output = join_path(base, value);
+            else if (key == "cache")
+                job.m_cache = join_path(base, value);
+            else if (key == "range")
+                job.m_ranges.push_back(value);
+            else if (key == "options"){
+                istringstream options(value);
+                string option;
+                while (options >> option){
+                    job.m_options.push_back(option);
+                }
+            }
+            else{
+                cerr << filename << ":" << line_number << ": unknown key " << key << endl;
+                return false;
+            }
+        }
+
+        for (size_t i = 0; i < jobs->size(); ++i){
+            if ((*jobs)[i].m_rom.empty()){
+                cerr << filename << ": job " << (*jobs)[i].m_name << " has no rom" << endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    string file_contents(const string& filename)
+    {
+        ifstream in(filename.c_str(), ios::binary);
+        ostringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+
+    // --instr files are read once, however many jobs name them
+    NameTables load_name_tables(const vector<BatchJob>& jobs)
+    {
+        NameTables tables;
+        for (const BatchJob& job : jobs){
+            for (size_t i = 0; i + 1 < job.m_options.size(); ++i){
+                if (job.m_options[i] != "--instr")
+                    continue;
+                string filename = join_path(job.m_dir, job.m_options[++i]);
+                if (tables.count(filename))
+                    continue;
+                cerr << "; Reading instruction names from " << filename << endl;
+                ifstream in(filename.c_str());
+                tables[filename] = make_shared<InstructionNameProvider>(in);
+            }
+        }
+        return tables;
+    }
+
+    JobResult run_job(const BatchJob& job, const NameTables& names)
+    {
+        JobResult result;
+        double start = Stats::wall_time();
+
+        FILE* rom = fopen(job.m_rom.c_str(), "rb");
+        if (!rom){
+            result.m_message = "could not open " + job.m_rom;
+            return result;
+        }
+
+        error_code error;
+        filesystem::create_directories(job.m_output, error);
+        string listing = join_path(job.m_output, job.m_name + ".asm");
+
+        ostringstream out, log;
+        Disassembler disasm(rom, out, log);
+        vector<DriverFile> driver_files;
+        string option_error;
+        ContentHash key;
+        key.add(OutputCache::tool_version());
+        for (size_t i = 0; i < job.m_options.size(); ++i){
+            key.add(job.m_options[i]);
+            if (job.m_options[i] == "--instr" && i + 1 < job.m_options.size()){
+                disasm.set_instruction_names(names.at(join_path(job.m_dir, job.m_options[++i])));
+                key.add(file_contents(join_path(job.m_dir, job.m_options[i])));
+                continue;
+            }
+            // registers apply to every bank, the other driver files are
+            // hashed by the byte properties of the ranges
+            if (job.m_options[i] == "--registers" && i + 1 < job.m_options.size())
+                key.add(file_contents(join_path(job.m_dir, job.m_options[i + 1])));
+            if (!parse_disassembler_option(disasm, job.m_options, &i, &driver_files, &option_error, job.m_dir))
+                log << "Ignoring unknown option " << job.m_options[i] << endl;
+            if (!option_error.empty()){
+                log << option_error << endl;
+                break;
+            }
+        }
+
+        // the other jobs go on; what went wrong is in this one's log
+        if (!option_error.empty() || !disasm.load_driver_files(driver_files)){
+            fclose(rom);
+            string log_file = join_path(job.m_output, job.m_name + ".log");
+            result.m_message = write_if_changed(log_file, log.str()) ? "failed, see " + log_file : "could not write " + log_file;
+            return result;
+        }
+
+        vector<Request> requests;
+        for (const string& range : job.m_ranges){
+            istringstream in(range);
+            Request request;
+            if (!request.get(in, disasm.hirom(), log, &disasm.label_index()) || request.m_quit)
+                continue;
+            disasm.hash_request_inputs(request, &key);
+            requests.push_back(request);
+        }
+
+        string text;
+        bool cached = false;
+        if (!job.m_cache.empty())
+            cached = OutputCache(job.m_cache).lookup(key.value(), disasm, &text);
+        if (!cached){
+            vector<unsigned int> extern_labels;
+            disasm.record_extern_labels(&extern_labels);
+            for (const Request& request : requests){
+                disasm.handleRequest(request);
+                out << endl;
+            }
+            disasm.record_extern_labels(0);
+            text = out.str();
+            if (!job.m_cache.empty() && !OutputCache(job.m_cache).store(key.value(), disasm, extern_labels, text))
+                log << "Could not write to the cache in " << job.m_cache << endl;
+        }
+
+        bool changed = false;
+        if (!write_if_changed(listing, text, &changed) ||
+            !write_if_changed(join_path(job.m_output, job.m_name + ".log"), log.str())){
+            fclose(rom);
+            result.m_message = "could not write " + listing;
+            return result;
+        }
+
+        fclose(rom);
+        result.m_ok = true;
+        result.m_message = listing + (cached ? " (cached)" : "") + (changed ? "" : " (unchanged)");
+        result.m_seconds = Stats::wall_time() - start;
+        return result;
+    }
+}
+
+int run_batch(const string& job_file, unsigned int threads)
+{
+    vector<BatchJob> jobs;
+    if (!load_jobs(job_file, &jobs))
+        return -1;
+    if (jobs.empty())
+        return 0;
+
+    NameTables names = load_name_tables(jobs);
+
+    if (threads == 0)
+        threads = thread::hardware_concurrency();
+    if (threads == 0 || threads > jobs.size())
+        threads = (unsigned int)jobs.size();
+
+    double start = Stats::wall_time();
+    vector<future<JobResult> > results;
+    {
+        ThreadPool pool(threads);
+        for (size_t i = 0; i < jobs.size(); ++i){
+            const BatchJob* job = &jobs[i];
+            results.push_back(pool.submit([job, &names](){ return run_job(*job, names); }));
+        }
+    }
+
+    int failed = 0;
+    for (size_t i = 0; i < jobs.size(); ++i){
+        JobResult result = results[i].get();
+        if (result.m_ok){
+            cerr << "; " << jobs[i].m_name << ": " << jobs[i].m_ranges.size() << " ranges in "
+                << fixed << setprecision(2) << result.m_seconds << " s, " << result.m_message << endl;
+        }
+        else{
+            cerr << "; " << jobs[i].m_name << ": " << result.m_message << endl;
+            ++failed;
+        }
+    }
+    cerr << "; " << jobs.size() << " jobs on " << threads << " threads in "
+        << fixed << setprecision(2) << Stats::wall_time() - start << " s" << endl;
+
+    return failed ? -1 : 0;
+}
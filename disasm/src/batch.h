@@ -0,0 +1,39 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <string>
+
+// Runs the jobs of a job file concurrently in one process, one
+// Disassembler each.  The opcode table, the built in register database
+// and instruction name files loaded with --instr are shared read only.
+//
+//   ; comment
+//   [smw]
+//   rom smw.smc
+//   dir driver_files/smw
+//   options --ram all.ram --sym all.sym --data all.data
+//   range 8000 40000 -p
+//   range asm 00D0F0 00D200
+//   output listings
+//   cache listings/cache
+//
+// A job starts with its name in brackets.  "options" takes the command
+// line options and may be repeated, "range" is a request line as typed at
+// the prompt.  rom, dir, output and cache are relative to the job file;
+// driver files to dir, which defaults to the job file's directory, as does
+// output.  The listing goes to <output>/<name>.asm and the load
+// diagnostics to <output>/<name>.log.  Neither is rewritten if it hasn't
+// changed, so an assembler that goes by timestamps only rebuilds the
+// banks that did.
+//
+// With a cache directory a job whose inputs are unchanged reuses its
+// listing instead of disassembling again (see OutputCache).  One job per
+// bank keeps an edit to the driver files from invalidating more than the
+// banks it touches.
+//
+// Each job holds a full set of byte properties (see --stats), so threads
+// defaults to the hardware threads or the number of jobs, whichever is
+// smaller.
+int run_batch(const std::string& job_file, unsigned int threads = 0);
+
+#endif
@@ -1,8 +1,8 @@
 #include "byte_properties.h"
 
 ByteProperties::ByteProperties()
-: m_type(0),
-m_load_offset(0),
+: reset_index_to(0),
 reset_accum_to(0),
-reset_index_to(0)
+m_type(0),
+m_load_offset(0)
 { }
@@ -1,4 +1,5 @@
 #include <string>
+#include "memory_usage.h"
 
 //todo: make POD for fast initialization
 struct ByteProperties
@@ -11,15 +12,20 @@ struct ByteProperties
     unsigned char data_bank() const { return m_data_bank; }
     void data_bank(unsigned char d) { m_data_bank = d; }
 
-    std::string comment() const { return m_comment; }
+    const std::string& comment() const { return m_comment; }
     void comment(const std::string& c) { m_comment = c; }
 
-    std::string label() const { return m_label; }
+    const std::string& label() const { return m_label; }
     void label(const std::string& l) { m_label = l; }
 
     int load_offset() const { return m_load_offset; }
     void load_offset(int o) { m_load_offset = o; }
 
+    bool has_comment() const { return !m_comment.empty(); }
+    bool has_label() const { return !m_label.empty(); }
+    size_t comment_bytes() const { return Memory::heap_bytes(m_comment); }
+    size_t label_bytes() const { return Memory::heap_bytes(m_label); }
+
     int reset_index_to;
     int reset_accum_to;
 
@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "compression.h"
+
+using namespace std;
+
+namespace{
+    const size_t MAX_OUTPUT = 0x10000; //as far as a back reference reaches
+    const size_t SLACK = 8; //room for the last 8 byte store of a copy or fill
+
+    struct ReversedBits
+    {
+        ReversedBits()
+        {
+            for (int i = 0; i < 256; ++i){
+                unsigned char reversed = 0;
+                for (int bit = 0; bit < 8; ++bit){
+                    if (i & (1 << bit))
+                        reversed |= 0x80 >> bit;
+                }
+                m_bytes[i] = reversed;
+            }
+        }
+
+        unsigned char m_bytes[256];
+    };
+
+    const ReversedBits REVERSED_BITS;
+
+    // stores pattern over length bytes, up to 7 more into the slack
+    void fill(unsigned char* out, uint64_t pattern, size_t length)
+    {
+        for (size_t i = 0; i < length; i += 8){
+            memcpy(out + i, &pattern, 8);
+        }
+    }
+
+    // copies length bytes to the end of out from earlier in it; the copy
+    // may read bytes it writes, which repeats the ones in between
+    void copy_back(unsigned char* out, size_t from, size_t to, size_t length)
+    {
+        const unsigned char* src = out + from;
+        unsigned char* dst = out + to;
+        size_t distance = to - from;
+        if (distance >= length){
+            memcpy(dst, src, length);
+        }
+        else if (distance == 1){
+            memset(dst, *src, length);
+        }
+        else if (distance >= 8){
+            // each 8 bytes read were stored by an earlier step, if by any
+            for (size_t i = 0; i < length; i += 8){
+                uint64_t x;
+                memcpy(&x, src + i, 8);
+                memcpy(dst + i, &x, 8);
+            }
+        }
+        else{
+            for (size_t i = 0; i < length; ++i){
+                dst[i] = src[i];
+            }
+        }
+    }
+}
+
+bool decompress(CompressionFormat format, const unsigned char* in, size_t size, Decompressed* out)
+{
+    vector<unsigned char>& data = out->m_data;
+    out->m_consumed = 0;
+    out->m_commands = 0;
+    out->m_copied = 0;
+    out->m_error = 0;
+
+    size_t pos = 0;
+    size_t written = 0;
+    const char* error = 0;
+    for (;;){
+        if (pos >= size){
+            error = "runs past the end of the ROM";
+            break;
+        }
+        unsigned char header = in[pos++];
+        if (header == 0xFF)
+            break;
+
+        unsigned int command = header >> 5;
+        size_t length = (header & 0x1F) + 1;
+        if (command == 7){
+            command = (header >> 2) & 7;
+            if (command == 7 || pos >= size){
+                error = command == 7 ? "has a bad long command" : "runs past the end of the ROM";
+                break;
+            }
+            length = ((header & 3) << 8 | in[pos++]) + 1;
+        }
+
+        if (written + length > MAX_OUTPUT){
+            error = "decompresses to more than 64KB";
+            break;
+        }
+        if (data.size() < written + length + SLACK)
+            data.resize(max(written + length + SLACK, data.size() * 2));
+        unsigned char* dst = data.data() + written;
+
+        size_t operand = command == 0 ? length : command == 1 ? 1 : command == 2 ? 2 :
+            command == 3 ? (format == LC_LZ2 ? 1 : 0) : 2;
+        if (command >= 4 && format == LC_LZ3 && pos < size && (in[pos] & 0x80))
+            operand = 1;
+        if (size - pos < operand){
+            error = "runs past the end of the ROM";
+            break;
+        }
+
+        switch (command)
+        {
+        case 0:
+            memcpy(dst, in + pos, length);
+            break;
+
+        case 1:
+            memset(dst, in[pos], length);
+            break;
+
+        case 2:
+            fill(dst, 0x0001000100010001ull * (in[pos] | in[pos + 1] << 8), length);
+            break;
+
+        case 3:
+            if (format == LC_LZ2){
+                for (size_t i = 0; i < length; ++i){
+                    dst[i] = (unsigned char)(in[pos] + i);
+                }
+            }
+            else{
+                memset(dst, 0, length);
+            }
+            break;
+
+        default:
+        {
+            if (format == LC_LZ2 && command != 4){
+                error = "uses a command LC_LZ2 doesn't have";
+                break;
+            }
+            // LC_LZ3 can give the source as a distance back instead
+            size_t from = operand == 1 ? written - min(written, (size_t)(in[pos] & 0x7F) + 1) : in[pos] << 8 | in[pos + 1];
+            if (from >= written || (operand == 1 && (in[pos] & 0x7F) >= written) || (command == 6 && from + 1 < length)){
+                error = "refers to bytes it hasn't decoded";
+                break;
+            }
+            if (command == 4){
+                copy_back(data.data(), from, written, length);
+            }
+            else if (command == 5){
+                for (size_t i = 0; i < length; ++i){
+                    dst[i] = REVERSED_BITS.m_bytes[data[from + i]];
+                }
+            }
+            else{
+                for (size_t i = 0; i < length; ++i){
+                    dst[i] = data[from - i];
+                }
+            }
+            out->m_copied += (unsigned int)length;
+            break;
+        }
+        }
+        if (error)
+            break;
+
+        pos += operand;
+        written += length;
+        ++out->m_commands;
+    }
+
+    data.resize(written);
+    out->m_consumed = (unsigned int)pos;
+    out->m_error = error;
+    return error == 0;
+}
+
+bool is_compressed_type(int type)
+{
+    return type == LC_LZ2 || type == LC_LZ3;
+}
+
+const char* compression_format_name(CompressionFormat format)
+{
+    return format == LC_LZ2 ? "LC_LZ2" : "LC_LZ3";
+}
+
+bool parse_compression_format(const string& name, CompressionFormat* format)
+{
+    if (name == "LZ2" || name == "LC_LZ2")
+        *format = LC_LZ2;
+    else if (name == "LZ3" || name == "LC_LZ3")
+        *format = LC_LZ3;
+    else
+        return false;
+    return true;
+}
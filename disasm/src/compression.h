@@ -0,0 +1,36 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// The Nintendo LZ formats that SNES games keep graphics and tables in, by
+// their Lunar Compress names.  The values are the ByteProperties::type a
+// data file gives a compressed block, after data (1), pointers (2) and
+// long pointers (3).
+enum CompressionFormat { LC_LZ2 = 4, LC_LZ3 = 5 };
+
+struct Decompressed
+{
+    std::vector<unsigned char> m_data;
+    unsigned int m_consumed; //compressed bytes, up to and including the end mark
+    unsigned int m_commands;
+    unsigned int m_copied; //output bytes that came from back references
+    const char* m_error; //0 if the block decoded
+};
+
+// Decodes the block at the start of in, which may run on past its end.
+//
+// Both formats are a series of commands, each a 3 bit code and a length of
+// up to 1024, ended by $FF.  Literal runs are copied with memcpy and fills
+// with memset or 8 byte stores, and a back reference at least 8 bytes
+// behind the output is copied 8 bytes at a time even where it overlaps
+// what it writes, so the work is mostly per command rather than per byte.
+bool decompress(CompressionFormat format, const unsigned char* in, size_t size, Decompressed* out);
+
+bool is_compressed_type(int type);
+const char* compression_format_name(CompressionFormat format);
+bool parse_compression_format(const std::string& name, CompressionFormat* format); //"LZ2" or "LC_LZ2", and LZ3
+
+#endif
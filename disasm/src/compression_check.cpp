@@ -0,0 +1,70 @@
+#include <iostream>
+#include <vector>
+#include "compression.h"
+
+using namespace std;
+
+// Known blocks and what they decode to, one or two commands each, run by
+// ctest.  m_consumed decides how many bytes a compressed block marks, so
+// it is checked as closely as the output.
+namespace{
+    struct Vector
+    {
+        const char* m_name;
+        CompressionFormat m_format;
+        vector<unsigned char> m_in;
+        vector<unsigned char> m_out; //empty if the block doesn't decode
+        unsigned int m_consumed;
+    };
+
+    const Vector VECTORS[] = {
+        { "direct", LC_LZ2, { 0x02, 'A', 'B', 'C', 0xFF, 0x99 }, { 'A', 'B', 'C' }, 5 },
+        { "byte fill", LC_LZ2, { 0x23, 0x7E, 0xFF }, { 0x7E, 0x7E, 0x7E, 0x7E }, 3 },
+        { "word fill", LC_LZ2, { 0x44, 0x12, 0x34, 0xFF }, { 0x12, 0x34, 0x12, 0x34, 0x12 }, 4 },
+        { "increasing fill", LC_LZ2, { 0x63, 0x10, 0xFF }, { 0x10, 0x11, 0x12, 0x13 }, 3 },
+        { "long fill", LC_LZ2, { 0xE4, 0x27, 0x55, 0xFF }, vector<unsigned char>(40, 0x55), 4 },
+        { "back reference", LC_LZ2, { 0x01, 0xAA, 0xBB, 0x81, 0x00, 0x00, 0xFF }, { 0xAA, 0xBB, 0xAA, 0xBB }, 7 },
+        { "overlapping copy", LC_LZ2, { 0x01, 0x01, 0x02, 0x85, 0x00, 0x00, 0xFF },
+            { 0x01, 0x02, 0x01, 0x02, 0x01, 0x02, 0x01, 0x02 }, 7 },
+        { "overlapping copy 8 back", LC_LZ2, { 0x07, 0, 1, 2, 3, 4, 5, 6, 7, 0x93, 0x00, 0x00, 0xFF },
+            { 0, 1, 2, 3, 4, 5, 6, 7, 0, 1, 2, 3, 4, 5, 6, 7, 0, 1, 2, 3, 4, 5, 6, 7, 0, 1, 2, 3 }, 13 },
+        { "LZ3 command in LZ2", LC_LZ2, { 0x00, 0x01, 0xA0, 0x00, 0x00, 0xFF }, {}, 3 },
+        { "past the end", LC_LZ2, { 0x02, 'A' }, {}, 1 },
+        { "zero fill", LC_LZ3, { 0x62, 0xFF }, { 0x00, 0x00, 0x00 }, 2 },
+        { "bit reversed", LC_LZ3, { 0x01, 0x01, 0x80, 0xA1, 0x00, 0x00, 0xFF }, { 0x01, 0x80, 0x80, 0x01 }, 7 },
+        { "backwards", LC_LZ3, { 0x02, 0x01, 0x02, 0x03, 0xC2, 0x80, 0xFF }, { 0x01, 0x02, 0x03, 0x03, 0x02, 0x01 }, 7 },
+        { "relative repeat", LC_LZ3, { 0x01, 0xAA, 0xBB, 0x83, 0x81, 0xFF }, { 0xAA, 0xBB, 0xAA, 0xBB, 0xAA, 0xBB }, 6 },
+    };
+
+    void print(ostream& out, const vector<unsigned char>& bytes)
+    {
+        static const char digits[] = "0123456789ABCDEF";
+        for (unsigned char byte : bytes){
+            out << ' ' << digits[byte >> 4] << digits[byte & 0x0F];
+        }
+    }
+}
+
+int main()
+{
+    int failures = 0;
+    for (const Vector& vector : VECTORS){
+        Decompressed result;
+        bool decoded = decompress(vector.m_format, vector.m_in.data(), vector.m_in.size(), &result);
+        bool expected = !vector.m_out.empty();
+        if (decoded == expected && result.m_data == (expected ? vector.m_out : result.m_data) && result.m_consumed == vector.m_consumed)
+            continue;
+
+        ++failures;
+        cerr << compression_format_name(vector.m_format) << " " << vector.m_name << ": "
+            << (decoded ? "decoded" : result.m_error) << ", " << result.m_consumed << " bytes consumed, expected "
+            << vector.m_consumed << endl << " got     ";
+        print(cerr, result.m_data);
+        cerr << endl << " expected";
+        print(cerr, vector.m_out);
+        cerr << endl;
+    }
+    cerr << "; " << sizeof(VECTORS) / sizeof(VECTORS[0]) - failures << " of " << sizeof(VECTORS) / sizeof(VECTORS[0])
+        << " compression vectors" << endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,202 @@
+#include <cstring>
+#include <fstream>
+#include "coverage.h"
+#include "mapped_file.h"
+#include "memory_map.h"
+
+using namespace std;
+
+namespace{
+    const char MAGIC[8] = { 'S', 'N', 'E', 'S', 'C', 'O', 'V', '1' };
+    const unsigned int HEADER_SIZE = 16;
+
+    unsigned int read_u32(const unsigned char* p)
+    {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+    }
+
+    void write_u32(ostream& out, unsigned int value)
+    {
+        char bytes[4] = { char(value), char(value >> 8), char(value >> 16), char(value >> 24) };
+        out.write(bytes, 4);
+    }
+}
+
+CoverageMap::CoverageMap() :
+m_size(0),
+m_flags(0),
+m_starts(0),
+m_accum_16(0),
+m_index_16(0)
+{ }
+
+CoverageMap::CoverageMap(const CoverageMap& other) :
+m_size(other.m_size),
+m_flags(other.m_flags),
+m_file(other.m_file),
+m_bits(other.m_bits)
+{
+    set_pointers(m_file ? m_file->data() + HEADER_SIZE : m_bits.data());
+}
+
+CoverageMap& CoverageMap::operator=(const CoverageMap& other)
+{
+    m_size = other.m_size;
+    m_flags = other.m_flags;
+    m_file = other.m_file;
+    m_bits = other.m_bits;
+    set_pointers(m_file ? m_file->data() + HEADER_SIZE : m_bits.data());
+    return *this;
+}
+
+void CoverageMap::set_pointers(const unsigned char* base)
+{
+    m_starts = base;
+    m_accum_16 = has_register_widths() ? base + bitmap_bytes() : 0;
+    m_index_16 = has_register_widths() ? base + 2 * bitmap_bytes() : 0;
+}
+
+void CoverageMap::reset(unsigned int size, bool register_widths)
+{
+    m_file.reset();
+    m_size = size;
+    m_flags = register_widths ? HasRegisterWidths : 0;
+    m_bits.assign(bitmap_bytes() * (register_widths ? 3 : 1), 0);
+    set_pointers(m_bits.data());
+}
+
+void CoverageMap::make_writable()
+{
+    if (!m_file)
+        return;
+
+    const unsigned char* base = m_file->data() + HEADER_SIZE;
+    m_bits.assign(base, base + bitmap_bytes() * (has_register_widths() ? 3 : 1));
+    m_file.reset();
+    set_pointers(m_bits.data());
+}
+
+bool CoverageMap::is_binary(const string& filename)
+{
+    ifstream in(filename.c_str(), ios::binary);
+    char magic[sizeof(MAGIC)];
+    return in.read(magic, sizeof(magic)) && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+bool CoverageMap::load(const string& filename, const MemoryMap& map)
+{
+    if (!is_binary(filename)){
+        ifstream in(filename.c_str());
+        return in && load_text(in, map);
+    }
+
+    shared_ptr<MappedFile> file = make_shared<MappedFile>();
+    if (!file->open(filename) || file->size() < HEADER_SIZE)
+        return false;
+
+    const unsigned char* header = file->data();
+    unsigned int size = read_u32(header + 8);
+    unsigned int flags = read_u32(header + 12);
+    unsigned int bitmaps = (flags & HasRegisterWidths) ? 3 : 1;
+    if (file->size() < HEADER_SIZE + (size_t)bitmaps * ((size + 7) / 8)){
+        cerr << "Truncated coverage file: " << filename << endl;
+        return false;
+    }
+
+    m_bits.clear();
+    m_file = file;
+    m_size = size;
+    m_flags = flags;
+    set_pointers(m_file->data() + HEADER_SIZE);
+    return true;
+}
+
+bool CoverageMap::load_text(istream& in, const MemoryMap& map)
+{
+    reset(map.rom_capacity(), false);
+
+    unsigned int fulladdr;
+    while (in >> hex >> fulladdr){
+        if (map.is_rom(fulladdr))
+            mark_instruction_start(map.rom_index(fulladdr));
+    }
+    return true;
+}
+
+bool CoverageMap::save(const string& filename) const
+{
+    ofstream out(filename.c_str(), ios::binary);
+    if (!out)
+        return false;
+
+    out.write(MAGIC, sizeof(MAGIC));
+    write_u32(out, m_size);
+    write_u32(out, m_flags);
+    out.write((const char*)m_starts, bitmap_bytes());
+    if (has_register_widths()){
+        out.write((const char*)m_accum_16, bitmap_bytes());
+        out.write((const char*)m_index_16, bitmap_bytes());
+    }
+    return out.good();
+}
+
+void CoverageMap::merge(const CoverageMap& other)
+{
+    if (other.empty())
+        return;
+    if (empty()){
+        *this = other;
+        return;
+    }
+
+    if (other.m_size > m_size || (other.has_register_widths() && !has_register_widths())){
+        CoverageMap grown;
+        grown.reset(max(m_size, other.m_size), has_register_widths() || other.has_register_widths());
+        grown.merge(*this);
+        *this = grown;
+    }
+    make_writable();
+
+    unsigned int bytes = other.bitmap_bytes();
+    unsigned char* starts = &m_bits[0];
+    for (unsigned int i = 0; i < bytes; ++i){
+        starts[i] |= other.m_starts[i];
+    }
+    if (other.has_register_widths()){
+        unsigned char* accum = starts + bitmap_bytes();
+        unsigned char* index = accum + bitmap_bytes();
+        for (unsigned int i = 0; i < bytes; ++i){
+            accum[i] |= other.m_accum_16[i];
+            index[i] |= other.m_index_16[i];
+        }
+    }
+}
+
+void CoverageMap::mark_instruction_start(unsigned int index)
+{
+    if (index >= m_size)
+        return;
+    make_writable();
+    m_bits[index >> 3] |= (1 << (index & 7));
+}
+
+void CoverageMap::mark_register_widths(unsigned int index, bool accum_16, bool index_16)
+{
+    if (index >= m_size || !has_register_widths())
+        return;
+    make_writable();
+    unsigned char bit = (unsigned char)(1 << (index & 7));
+    if (accum_16) m_bits[bitmap_bytes() + (index >> 3)] |= bit;
+    if (index_16) m_bits[2 * bitmap_bytes() + (index >> 3)] |= bit;
+}
+
+unsigned int CoverageMap::count() const
+{
+    unsigned int total = 0;
+    for (unsigned int i = 0; i < bitmap_bytes(); ++i){
+        for (unsigned char b = m_starts[i]; b; b &= b - 1){
+            ++total;
+        }
+    }
+    return total;
+}
@@ -0,0 +1,89 @@
+#ifndef COVERAGE_H
+#define COVERAGE_H
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct MappedFile;
+struct MemoryMap;
+
+// Execution coverage of a ROM: one bit per ROM byte (by file index) that
+// is set where an executed instruction starts.  Optionally records the
+// accumulator/index width each instruction was executed with.
+//
+// Binary layout, little endian:
+//   char[8]  "SNESCOV1"
+//   uint32   number of ROM bytes covered
+//   uint32   flags (bit 0: register widths present)
+//   start bitmap, then the accum_16 and index_16 bitmaps if flagged
+struct CoverageMap
+{
+    enum { HasRegisterWidths = 0x01 };
+
+    CoverageMap();
+    CoverageMap(const CoverageMap& other);
+    CoverageMap& operator=(const CoverageMap& other);
+
+    void reset(unsigned int size, bool register_widths);
+
+    // Accepts either the binary format or a text trace of 24 bit addresses,
+    // which map places in the ROM; addresses outside it are skipped.
+    bool load(const std::string& filename, const MemoryMap& map);
+    bool load_text(std::istream& in, const MemoryMap& map);
+    bool save(const std::string& filename) const;
+
+    void merge(const CoverageMap& other);
+
+    bool empty() const { return m_size == 0; }
+    unsigned int size() const { return m_size; }
+    bool has_register_widths() const { return (m_flags & HasRegisterWidths) != 0; }
+
+    bool is_instruction_start(unsigned int index) const
+    {
+        return index < m_size && test(m_starts, index);
+    }
+    bool is_accum_16(unsigned int index) const
+    {
+        return has_register_widths() && index < m_size && test(m_accum_16, index);
+    }
+    bool is_index_16(unsigned int index) const
+    {
+        return has_register_widths() && index < m_size && test(m_index_16, index);
+    }
+
+    void mark_instruction_start(unsigned int index);
+    void mark_register_widths(unsigned int index, bool accum_16, bool index_16);
+
+    unsigned int count() const;
+
+    // mapped bitmaps are counted too, although they are backed by the file
+    size_t size_in_bytes() const
+    {
+        size_t mapped = m_file ? bitmap_bytes() * (has_register_widths() ? 3 : 1) : 0;
+        return m_bits.capacity() + mapped;
+    }
+
+    static bool is_binary(const std::string& filename);
+
+private:
+    static bool test(const unsigned char* bits, unsigned int index)
+    {
+        return ((bits[index >> 3] >> (index & 7)) & 1) != 0;
+    }
+
+    unsigned int bitmap_bytes() const { return (m_size + 7) / 8; }
+    void set_pointers(const unsigned char* base);
+    void make_writable();
+
+    unsigned int m_size;
+    unsigned int m_flags;
+    const unsigned char* m_starts;
+    const unsigned char* m_accum_16;
+    const unsigned char* m_index_16;
+    std::shared_ptr<MappedFile> m_file; //set when the bitmaps live in a mapping
+    std::vector<unsigned char> m_bits;
+};
+
+#endif
@@ -0,0 +1,654 @@
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <queue>
+#include <sstream>
+#include <utility>
+#include "byte_properties.h"
+#include "cycles.h"
+#include "instruction.h"
+#include "memory_map.h"
+#include "utils.h"
+
+using namespace std;
+using namespace Address;
+
+namespace{
+    const unsigned int MAP_MODE = 0x00FFD5; //the header byte whose bit 4 is set for FastROM
+    const unsigned int UNSET = UINT_MAX;
+
+    // the shifts, INC/DEC and TSB/TRB of memory read and write back their operand
+    const char* const READ_MODIFY_WRITE[] = { "ASL", "LSR", "ROL", "ROR", "INC", "DEC", "TSB", "TRB" };
+    const char* const INDEX_OPERAND[] = { "LDX", "LDY", "STX", "STY", "CPX", "CPY" };
+    const char* const STORES[] = { "STA", "STX", "STY", "STZ" };
+
+    enum { CODE_TYPE = 0, POINTER_TYPE = 2 }; //ByteProperties::type
+
+    template<size_t N>
+    bool is_one_of(const string& name, const char* const (&names)[N])
+    {
+        for (const char* candidate : names){
+            if (name == candidate)
+                return true;
+        }
+        return false;
+    }
+
+    string range_text(unsigned int min, unsigned int max)
+    {
+        ostringstream ss;
+        ss << min;
+        if (max != min)
+            ss << "-" << max;
+        return ss.str();
+    }
+
+    string percent_of_frame(unsigned int clocks)
+    {
+        ostringstream ss;
+        ss << fixed << setprecision(1) << 100.0 * clocks / CycleTimer::FRAME_CLOCKS << "%";
+        return ss.str();
+    }
+}
+
+void CycleCost::widen(const CycleCost& other)
+{
+    m_min_cycles = min(m_min_cycles, other.m_min_cycles);
+    m_max_cycles = max(m_max_cycles, other.m_max_cycles);
+    m_min_clocks = min(m_min_clocks, other.m_min_clocks);
+    m_max_clocks = max(m_max_clocks, other.m_max_clocks);
+}
+
+string CycleCost::text() const
+{
+    return range_text(m_min_cycles, m_max_cycles) + "/" + range_text(m_min_clocks, m_max_clocks);
+}
+
+CycleTimer::CycleTimer(const MemoryMap& map, const vector<InstructionMetadata>& instructions, vector<unsigned char> rom) :
+m_map(map),
+m_rom(move(rom)),
+m_timings(0x100),
+m_fast_rom(false)
+{
+    for (unsigned int opcode = 0; opcode < 0x100 && opcode < instructions.size(); ++opcode){
+        m_timings[opcode] = timing(instructions[opcode]);
+    }
+    int map_mode = read(MAP_MODE);
+    m_fast_rom = map_mode >= 0 && (map_mode & 0x10);
+}
+
+int CycleTimer::read(unsigned int address) const
+{
+    unsigned int index = m_map.rom_index(address);
+    return index < m_rom.size() ? m_rom[index] : -1;
+}
+
+unsigned int CycleTimer::access_clocks(unsigned int address) const
+{
+    switch (m_map.resolve(address).m_region)
+    {
+    case MemoryMap::Rom:
+        return m_fast_rom && (address & 0x800000) ? 6 : 8;
+    case MemoryMap::Io:
+        return addr16_from_addr24(address) >= 0x4000 && addr16_from_addr24(address) < 0x4200 ? 12 : 6;
+    default:
+        return 8;
+    }
+}
+
+CycleCost CycleTimer::taken()
+{
+    CycleCost cost;
+    cost.m_min_cycles = cost.m_max_cycles = 1;
+    cost.m_min_clocks = cost.m_max_clocks = INTERNAL_CLOCKS;
+    return cost;
+}
+
+CycleTimer::Timing CycleTimer::timing(const InstructionMetadata& instr)
+{
+    const AddressMode& mode = instr.address_mode();
+    const string& name = instr.internal_name();
+    Timing t = { (unsigned char)(1 + mode.m_operand_bytes), 0, 0, 0, 0, AddressMode::Fixed, 0 };
+
+    switch (instr.opcode())
+    {
+    case 0x00: case 0x02: //BRK, COP: the signature byte, then the return and P pushed and the vector read
+        t.m_fetch = 2; t.m_stack = 6; return t;
+    case 0x42: //WDM
+        t.m_fetch = 2; return t;
+    case 0x20: //JSR abs
+        t.m_internal = 1; t.m_stack = 2; return t;
+    case 0x22: //JSL
+        t.m_internal = 1; t.m_stack = 3; return t;
+    case 0xFC: //JSR (abs,X)
+        t.m_internal = 1; t.m_stack = 2; t.m_pointer = 2; t.m_flags = ProgramBankPointer; return t;
+    case 0x4C: case 0x5C: //JMP, JML
+        return t;
+    case 0x6C: //JMP (abs)
+        t.m_pointer = 2; t.m_flags = BankZeroPointer; return t;
+    case 0xDC: //JML [abs]
+        t.m_pointer = 3; t.m_flags = BankZeroPointer; return t;
+    case 0x7C: //JMP (abs,X)
+        t.m_internal = 1; t.m_pointer = 2; t.m_flags = ProgramBankPointer; return t;
+    case 0x60: //RTS
+        t.m_internal = 3; t.m_stack = 2; return t;
+    case 0x6B: //RTL
+        t.m_internal = 2; t.m_stack = 3; return t;
+    case 0x40: //RTI
+        t.m_internal = 2; t.m_stack = 4; return t;
+    case 0x80: case 0x82: //BRA, BRL
+        t.m_internal = 1; return t;
+    case 0xF4: //PEA
+        t.m_stack = 2; return t;
+    case 0x62: //PER
+        t.m_internal = 1; t.m_stack = 2; return t;
+    case 0xD4: //PEI
+        t.m_pointer = 2; t.m_stack = 2; t.m_flags = Direct; return t;
+    case 0x48: //PHA
+        t.m_internal = 1; t.m_stack = 1; t.m_width = AddressMode::Accum; return t;
+    case 0xDA: case 0x5A: //PHX, PHY
+        t.m_internal = 1; t.m_stack = 1; t.m_width = AddressMode::Index; return t;
+    case 0x08: case 0x4B: case 0x8B: //PHP, PHK, PHB
+        t.m_internal = 1; t.m_stack = 1; return t;
+    case 0x0B: //PHD
+        t.m_internal = 1; t.m_stack = 2; return t;
+    case 0x68: //PLA
+        t.m_internal = 2; t.m_stack = 1; t.m_width = AddressMode::Accum; return t;
+    case 0xFA: case 0x7A: //PLX, PLY
+        t.m_internal = 2; t.m_stack = 1; t.m_width = AddressMode::Index; return t;
+    case 0x28: case 0xAB: //PLP, PLB
+        t.m_internal = 2; t.m_stack = 1; return t;
+    case 0x2B: //PLD
+        t.m_internal = 2; t.m_stack = 2; return t;
+    case 0xEB: case 0xCB: case 0xDB: //XBA, WAI, STP
+        t.m_internal = 2; return t;
+    case 0xC2: case 0xE2: //REP, SEP
+        t.m_internal = 1; return t;
+    case 0x44: case 0x54: //MVP, MVN: for each byte
+        t.m_data = 2; t.m_internal = 2; t.m_flags = BlockMove; return t;
+    }
+
+    string mode_name = mode.m_name;
+    if (mode_name == "implied" || mode_name == "accumulator"){
+        t.m_internal = 1;
+        return t;
+    }
+    if (mode_name == "immediate"){
+        t.m_width = mode.m_width;
+        t.m_flags = WideFetch;
+        return t;
+    }
+    if (mode.m_target == AddressMode::Relative) //the branches; a taken one adds a cycle
+        return t;
+
+    bool modifies = is_one_of(name, READ_MODIFY_WRITE);
+    bool stores = is_one_of(name, STORES);
+    t.m_width = is_one_of(name, INDEX_OPERAND) ? AddressMode::Index : AddressMode::Accum;
+    t.m_data = modifies ? 2 : 1;
+    t.m_internal = modifies ? 1 : 0;
+
+    // writes always take the cycle that reads may skip when indexing
+    // doesn't cross a page
+    unsigned char indexed = (stores || modifies) ? 0 : IndexedRead;
+    if (mode_name == "absolute")
+        t.m_flags = AbsoluteOperand;
+    else if (mode_name == "absolute,x" || mode_name == "absolute,y"){
+        t.m_flags = AbsoluteOperand | indexed;
+        t.m_internal += indexed ? 0 : 1;
+    }
+    else if (mode_name == "long" || mode_name == "long,x")
+        t.m_flags = LongOperand;
+    else if (mode_name == "direct")
+        t.m_flags = Direct;
+    else if (mode_name == "direct,x" || mode_name == "direct,y"){
+        t.m_flags = Direct;
+        t.m_internal += 1;
+    }
+    else if (mode_name == "(direct)" || mode_name == "[direct]"){
+        t.m_flags = Direct;
+        t.m_pointer = mode_name[0] == '[' ? 3 : 2;
+    }
+    else if (mode_name == "(direct,x)"){
+        t.m_flags = Direct;
+        t.m_internal += 1;
+        t.m_pointer = 2;
+    }
+    else if (mode_name == "(direct),y"){
+        t.m_flags = Direct | indexed;
+        t.m_internal += indexed ? 0 : 1;
+        t.m_pointer = 2;
+    }
+    else if (mode_name == "[direct],y"){
+        t.m_flags = Direct;
+        t.m_pointer = 3;
+    }
+    else if (mode_name == "stack,s")
+        t.m_internal += 1;
+    else if (mode_name == "(stack,s),y"){
+        t.m_internal += 2;
+        t.m_pointer = 2;
+    }
+    return t;
+}
+
+CycleCost CycleTimer::cost(unsigned int address, bool accum_16, bool index_16, unsigned char data_bank) const
+{
+    CycleCost cost;
+    int opcode = read(address);
+    if (opcode < 0)
+        return cost;
+    Timing t = m_timings[opcode];
+
+    // the operand, which stays in the program bank
+    unsigned char bank = bank_from_addr24(address);
+    unsigned int pc = addr16_from_addr24(address);
+    unsigned int operand = 0;
+    for (unsigned int i = 1; i < t.m_fetch && i <= 3; ++i){
+        int byte = read(full_address(bank, (pc + i) & 0xFFFF));
+        operand |= (unsigned int)(byte < 0 ? 0 : byte) << (8 * (i - 1));
+    }
+
+    bool wide = (t.m_width == AddressMode::Accum && accum_16) || (t.m_width == AddressMode::Index && index_16);
+    if (wide && (t.m_flags & WideFetch))
+        ++t.m_fetch;
+    else if (wide){
+        t.m_data *= 2;
+        t.m_stack *= 2;
+    }
+
+    // an index crosses a page unless it is 8 bit and added to a page start
+    unsigned int cross_min = 0, cross_max = 0;
+    if (t.m_flags & IndexedRead){
+        cross_max = 1;
+        if (index_16)
+            cross_min = 1;
+        else if ((t.m_flags & AbsoluteOperand) && (operand & 0xFF) == 0)
+            cross_max = 0;
+    }
+
+    unsigned int data_min, data_max;
+    if ((t.m_flags & BlockMove) || t.m_pointer){
+        data_min = 6;
+        data_max = 8;
+    }
+    else if (t.m_flags & AbsoluteOperand)
+        data_min = data_max = access_clocks(full_address(data_bank, operand & 0xFFFF));
+    else if (t.m_flags & LongOperand)
+        data_min = data_max = access_clocks(operand);
+    else
+        data_min = data_max = 8; //the direct page and the stack are in WRAM
+
+    unsigned int pointer = 8;
+    if (t.m_flags & BankZeroPointer)
+        pointer = access_clocks(operand & 0xFFFF);
+    else if (t.m_flags & ProgramBankPointer)
+        pointer = access_clocks(full_address(bank, operand & 0xFFFF));
+
+    unsigned int cycles = t.m_fetch + t.m_internal + t.m_pointer + t.m_data + t.m_stack;
+    unsigned int clocks = t.m_fetch * access_clocks(address) + t.m_internal * INTERNAL_CLOCKS
+        + t.m_pointer * pointer + t.m_stack * 8;
+    cost.m_min_cycles = cycles + cross_min;
+    cost.m_max_cycles = cycles + cross_max;
+    cost.m_min_clocks = clocks + t.m_data * data_min + cross_min * INTERNAL_CLOCKS;
+    cost.m_max_clocks = clocks + t.m_data * data_max + cross_max * INTERNAL_CLOCKS;
+    return cost;
+}
+
+bool RoutineGraph::solve(CycleCost* cost, unsigned int* loops) const
+{
+    *cost = CycleCost();
+    *loops = 0;
+    if (m_nodes.empty())
+        return false;
+
+    // depth first from the entry: an edge to a node still on the stack
+    // closes a loop
+    size_t size = m_nodes.size();
+    vector<unsigned char> color(size, 0); //unseen, on the stack, done
+    vector<vector<bool> > back(size);
+    vector<unsigned int> postorder;
+    vector<pair<unsigned int, size_t> > stack;
+    stack.push_back(make_pair(0u, (size_t)0));
+    color[0] = 1;
+    while (!stack.empty()){
+        unsigned int node = stack.back().first;
+        size_t edge = stack.back().second++;
+        const vector<Edge>& edges = m_nodes[node].m_edges;
+        back[node].resize(edges.size());
+        if (edge == edges.size()){
+            color[node] = 2;
+            postorder.push_back(node);
+            stack.pop_back();
+            continue;
+        }
+        unsigned int to = edges[edge].m_to;
+        if (color[to] == 1){
+            back[node][edge] = true;
+            ++*loops;
+        }
+        else if (color[to] == 0){
+            color[to] = 1;
+            stack.push_back(make_pair(to, (size_t)0));
+        }
+    }
+    reverse(postorder.begin(), postorder.end());
+
+    cost->m_min_cycles = shortest(&CycleCost::m_min_cycles);
+    if (cost->m_min_cycles == UNSET)
+        return false;
+    cost->m_min_clocks = shortest(&CycleCost::m_min_clocks);
+    cost->m_max_cycles = longest(&CycleCost::m_max_cycles, postorder, back);
+    cost->m_max_clocks = longest(&CycleCost::m_max_clocks, postorder, back);
+    return true;
+}
+
+unsigned int RoutineGraph::shortest(unsigned int CycleCost::* field) const
+{
+    typedef pair<unsigned long long, unsigned int> Entry;
+    vector<unsigned long long> distance(m_nodes.size(), ULLONG_MAX);
+    priority_queue<Entry, vector<Entry>, greater<Entry> > queue;
+    distance[0] = m_nodes[0].m_cost.*field;
+    queue.push(Entry(distance[0], 0));
+    while (!queue.empty()){
+        Entry entry = queue.top();
+        queue.pop();
+        const Node& node = m_nodes[entry.second];
+        if (entry.first != distance[entry.second])
+            continue;
+        if (node.m_exit)
+            return (unsigned int)min(entry.first, (unsigned long long)UNSET - 1);
+        for (const Edge& edge : node.m_edges){
+            unsigned long long next = entry.first + edge.m_cost.*field + m_nodes[edge.m_to].m_cost.*field;
+            if (next < distance[edge.m_to]){
+                distance[edge.m_to] = next;
+                queue.push(Entry(next, edge.m_to));
+            }
+        }
+    }
+    return UNSET;
+}
+
+unsigned int RoutineGraph::longest(unsigned int CycleCost::* field, const vector<unsigned int>& order,
+    const vector<vector<bool> >& back) const
+{
+    vector<unsigned long long> distance(m_nodes.size(), 0);
+    vector<bool> reached(m_nodes.size(), false);
+    distance[0] = m_nodes[0].m_cost.*field;
+    reached[0] = true;
+    unsigned long long result = 0;
+    for (unsigned int node : order){
+        if (!reached[node])
+            continue;
+        if (m_nodes[node].m_exit)
+            result = max(result, distance[node]);
+        const vector<Edge>& edges = m_nodes[node].m_edges;
+        for (size_t i = 0; i < edges.size(); ++i){
+            if (back[node][i])
+                continue;
+            unsigned int to = edges[i].m_to;
+            unsigned long long next = distance[node] + edges[i].m_cost.*field + m_nodes[to].m_cost.*field;
+            if (!reached[to] || next > distance[to]){
+                distance[to] = next;
+                reached[to] = true;
+            }
+        }
+    }
+    return (unsigned int)min(result, (unsigned long long)UNSET - 1);
+}
+
+void CostReport::print(ostream& out) const
+{
+    out << "; " << (m_name.empty() ? to_string(m_address, 6) : m_name + " (" + to_string(m_address, 6) + ")")
+        << ", " << (m_accum_16 ? 16 : 8) << " bit accum, " << (m_index_16 ? 16 : 8) << " bit index, "
+        << (m_fast_rom ? "FastROM" : "SlowROM") << endl;
+    if (m_returns){
+        out << "; " << left << setw(10) << "" << right << setw(10) << "cycles" << setw(16) << "master clocks"
+            << setw(12) << "of a frame" << endl;
+        out << "; " << left << setw(10) << "shortest" << right << setw(10) << m_cost.m_min_cycles
+            << setw(16) << m_cost.m_min_clocks << setw(12) << percent_of_frame(m_cost.m_min_clocks) << endl;
+        out << "; " << left << setw(10) << "longest" << right << setw(10) << m_cost.m_max_cycles
+            << setw(16) << m_cost.m_max_clocks << setw(12) << percent_of_frame(m_cost.m_max_clocks) << endl;
+    }
+    else
+        out << "; no path returns" << endl;
+
+    out << "; instructions " << m_instructions << ", branches " << m_branches << ", loops " << m_loops
+        << " (each taken once), indirect jumps not followed " << m_unresolved << ", paths into data "
+        << m_into_data << endl;
+    if (m_recursive)
+        out << "; " << m_recursive << " recursive calls counted as free" << endl;
+    if (m_block_moves)
+        out << "; " << m_block_moves << " block moves counted for one byte, 7 cycles each" << endl;
+    if (m_truncated)
+        out << "; a routine has more than " << MAX_NODES << " instructions, the rest is not counted" << endl;
+
+    if (!m_calls.empty()){
+        out << ";" << endl << "; " << left << setw(40) << "calls" << right << setw(12) << "cycles"
+            << setw(16) << "master clocks" << endl;
+        for (const Call& call : m_calls){
+            out << "; " << to_string(call.m_address, 6) << " " << left << setw(33) << call.m_name << right;
+            if (call.m_returns){
+                out << setw(12) << range_text(call.m_cost.m_min_cycles, call.m_cost.m_max_cycles)
+                    << setw(16) << range_text(call.m_cost.m_min_clocks, call.m_cost.m_max_clocks) << endl;
+            }
+            else
+                out << setw(28) << "doesn't return" << endl;
+        }
+    }
+}
+
+RoutineWalk::RoutineWalk(const CycleTimer& timer, const vector<InstructionMetadata>& instructions,
+    const ByteProperties* data, unsigned int data_size) :
+m_timer(timer),
+m_instructions(instructions),
+m_data(data),
+m_data_size(data_size),
+m_report(0)
+{
+}
+
+void RoutineWalk::run(unsigned int address, bool accum_16, bool index_16, CostReport* report)
+{
+    m_report = report;
+    report->m_address = address;
+    report->m_accum_16 = accum_16;
+    report->m_index_16 = index_16;
+    report->m_fast_rom = m_timer.fast_rom();
+    Summary summary = walk(address, accum_16, index_16, true);
+    report->m_cost = summary.m_cost;
+    report->m_returns = summary.m_returns;
+}
+
+bool RoutineWalk::table(unsigned int address, vector<unsigned int>* targets) const
+{
+    const MemoryMap& map = m_timer.memory_map();
+    unsigned char bank = bank_from_addr24(address);
+    unsigned int pc = addr16_from_addr24(address);
+    targets->clear();
+    for (size_t i = 0; i < MAX_TABLE_ENTRIES; ++i, pc = (pc + 2) & 0xFFFF){
+        unsigned int index = map.rom_index(full_address(bank, pc));
+        if (index + 1 >= m_data_size || m_data[index].type() != POINTER_TYPE || m_data[index + 1].type() != POINTER_TYPE)
+            break;
+        int low = m_timer.read(full_address(bank, pc));
+        int high = m_timer.read(full_address(bank, (pc + 1) & 0xFFFF));
+        targets->push_back(full_address(bank, address_16bit((unsigned char)low, (unsigned char)high)));
+    }
+    return !targets->empty();
+}
+
+void RoutineWalk::add_call(unsigned int address, const Summary& callee)
+{
+    vector<CostReport::Call>& calls = m_report->m_calls;
+    vector<CostReport::Call>::iterator it = lower_bound(calls.begin(), calls.end(), address,
+        [](const CostReport::Call& call, unsigned int value){ return call.m_address < value; });
+    if (it == calls.end() || it->m_address != address){
+        CostReport::Call call = { address, "", callee.m_cost, callee.m_returns };
+        calls.insert(it, call);
+        return;
+    }
+    if (!callee.m_returns)
+        return;
+    if (it->m_returns)
+        it->m_cost.widen(callee.m_cost);
+    else
+        it->m_cost = callee.m_cost;
+    it->m_returns = true;
+}
+
+RoutineWalk::Summary RoutineWalk::walk(unsigned int address, bool accum_16, bool index_16, bool top)
+{
+    uint64_t key = (uint64_t)address << 2 | (uint64_t)accum_16 << 1 | (uint64_t)index_16;
+    map<uint64_t, Summary>::const_iterator done = m_summaries.find(key);
+    if (done != m_summaries.end())
+        return done->second;
+    Summary summary = { CycleCost(), true };
+    if (!m_walking.insert(key).second){
+        ++m_report->m_recursive;
+        return summary;
+    }
+
+    // an instruction once for each pair of widths it is reached with
+    RoutineGraph graph;
+    map<uint64_t, unsigned int> ids;
+    vector<uint64_t> keys;
+    auto node = [&](unsigned int to, bool accum, bool index) -> unsigned int {
+        uint64_t to_key = (uint64_t)to << 2 | (uint64_t)accum << 1 | (uint64_t)index;
+        pair<map<uint64_t, unsigned int>::iterator, bool> inserted = ids.insert(make_pair(to_key, (unsigned int)keys.size()));
+        if (inserted.second){
+            keys.push_back(to_key);
+            graph.m_nodes.push_back(RoutineGraph::Node());
+        }
+        return inserted.first->second;
+    };
+    auto edge = [&](unsigned int from, unsigned int to, bool accum, bool index, const CycleCost& cost){
+        RoutineGraph::Edge added = { node(to, accum, index), cost };
+        graph.m_nodes[from].m_edges.push_back(added);
+    };
+
+    const MemoryMap& map = m_timer.memory_map();
+    node(address, accum_16, index_16);
+    vector<unsigned int> targets;
+    for (unsigned int id = 0; id < keys.size(); ++id){
+        unsigned int pc_address = (unsigned int)(keys[id] >> 2);
+        bool accum = (keys[id] & 2) != 0;
+        bool index = (keys[id] & 1) != 0;
+        if (id >= CostReport::MAX_NODES){
+            m_report->m_truncated = true;
+            graph.m_nodes[id].m_exit = true;
+            continue;
+        }
+
+        unsigned int offset = map.rom_index(pc_address);
+        if (offset >= m_data_size || m_data[offset].type() != CODE_TYPE){
+            ++m_report->m_into_data;
+            graph.m_nodes[id].m_exit = true;
+            continue;
+        }
+        const ByteProperties& properties = m_data[offset];
+        if (properties.reset_accum_to)
+            accum = properties.reset_accum_to == 16;
+        if (properties.reset_index_to)
+            index = properties.reset_index_to == 16;
+
+        unsigned char opcode = (unsigned char)m_timer.read(pc_address);
+        const InstructionMetadata& instr = m_instructions[opcode];
+        graph.m_nodes[id].m_cost = m_timer.cost(pc_address, accum, index, properties.data_bank());
+        ++m_report->m_instructions;
+
+        unsigned char bank = bank_from_addr24(pc_address);
+        unsigned int pc = addr16_from_addr24(pc_address);
+        auto operand = [&](unsigned int i){
+            int byte = m_timer.read(full_address(bank, (pc + i) & 0xFFFF));
+            return (unsigned int)(byte < 0 ? 0 : byte);
+        };
+        unsigned int word = operand(1) | operand(2) << 8;
+        unsigned int next = full_address(bank, (pc + instr.length(accum, index)) & 0xFFFF);
+
+        switch (opcode)
+        {
+        case 0xC2: //REP
+            edge(id, next, accum || (operand(1) & 0x20), index || (operand(1) & 0x10), CycleCost());
+            break;
+        case 0xE2: //SEP
+            edge(id, next, accum && !(operand(1) & 0x20), index && !(operand(1) & 0x10), CycleCost());
+            break;
+        case 0x60: case 0x6B: case 0x40: //RTS, RTL, RTI
+            graph.m_nodes[id].m_exit = true;
+            break;
+        case 0xDB: //STP
+            break;
+        case 0x00: case 0x02: case 0x6C: case 0xDC: //BRK, COP, JMP (abs), JML [abs]
+            ++m_report->m_unresolved;
+            graph.m_nodes[id].m_exit = true;
+            break;
+        case 0x80: //BRA
+            edge(id, full_address(bank, (pc + 2 + (signed char)operand(1)) & 0xFFFF), accum, index, CycleCost());
+            break;
+        case 0x82: //BRL
+            edge(id, full_address(bank, (pc + 3 + word) & 0xFFFF), accum, index, CycleCost());
+            break;
+        case 0x4C: //JMP abs
+            edge(id, full_address(bank, word), accum, index, CycleCost());
+            break;
+        case 0x5C: //JML
+            edge(id, word | operand(3) << 16, accum, index, CycleCost());
+            break;
+        case 0x7C: //JMP (abs,X)
+            if (!table(full_address(bank, word), &targets)){
+                ++m_report->m_unresolved;
+                graph.m_nodes[id].m_exit = true;
+            }
+            for (unsigned int target : targets){
+                edge(id, target, accum, index, CycleCost());
+            }
+            break;
+        case 0x20: case 0x22: case 0xFC:{ //JSR, JSL, JSR (abs,X)
+            targets.clear();
+            if (opcode == 0x20)
+                targets.push_back(full_address(bank, word));
+            else if (opcode == 0x22)
+                targets.push_back(word | operand(3) << 16);
+            else if (!table(full_address(bank, word), &targets))
+                ++m_report->m_unresolved;
+
+            // any one of a table's entries may be called
+            Summary call = { CycleCost(), targets.empty() };
+            for (size_t i = 0; i < targets.size(); ++i){
+                Summary callee = walk(targets[i], accum, index, false);
+                if (top)
+                    add_call(targets[i], callee);
+                if (!callee.m_returns)
+                    continue;
+                if (call.m_returns)
+                    call.m_cost.widen(callee.m_cost);
+                else
+                    call.m_cost = callee.m_cost;
+                call.m_returns = true;
+            }
+            if (call.m_returns)
+                edge(id, next, accum, index, call.m_cost);
+            break;
+        }
+        case 0x44: case 0x54: //MVP, MVN
+            ++m_report->m_block_moves;
+            edge(id, next, accum, index, CycleCost());
+            break;
+        default:
+            if ((opcode & 0x1F) == 0x10){
+                ++m_report->m_branches;
+                edge(id, full_address(bank, (pc + 2 + (signed char)operand(1)) & 0xFFFF), accum, index, CycleTimer::taken());
+            }
+            edge(id, next, accum, index, CycleCost());
+            break;
+        }
+    }
+
+    unsigned int loops;
+    summary.m_returns = graph.solve(&summary.m_cost, &loops);
+    m_report->m_loops += loops;
+    m_walking.erase(key);
+    m_summaries[key] = summary;
+    return summary;
+}
@@ -0,0 +1,208 @@
+#ifndef CYCLES_H
+#define CYCLES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+class InstructionMetadata;
+struct ByteProperties;
+struct MemoryMap;
+
+// CPU cycles and master clocks, each as a range.  A cycle takes 6, 8 or
+// 12 master clocks by what the bus reads or writes in it, see
+// CycleTimer::access_clocks.
+struct CycleCost
+{
+    CycleCost() : m_min_cycles(0), m_max_cycles(0), m_min_clocks(0), m_max_clocks(0) {}
+
+    void widen(const CycleCost& other); //to cover other's range as well
+    // "4/32", or "4-5/32-38" for a range
+    std::string text() const;
+
+    unsigned int m_min_cycles;
+    unsigned int m_max_cycles;
+    unsigned int m_min_clocks;
+    unsigned int m_max_clocks;
+};
+
+// 65816 instruction timing in native mode, from the cycle by cycle tables
+// of the WDC datasheet: the opcode and operand fetches, the indirect
+// address, the data and the stack bytes each take the speed of the
+// region they are on the bus for, and internal operations 6 clocks.
+//
+//   - 16 bit accumulator or index registers add a cycle for each byte
+//     they read or write, two for a read-modify-write
+//   - indexing across a page adds a cycle to reads, which is always
+//     taken with 16 bit index registers and never from a page start with
+//     8 bit ones
+//   - a taken branch adds a cycle, see taken
+//
+// D is taken to be page aligned, as it is for nearly all code; otherwise
+// every direct page access would take a cycle more.  What the data bank
+// and an operand name is timed by its region; anything read through a
+// pointer is somewhere between FastROM and WRAM speed.  DMA, HDMA and
+// DRAM refresh, which stall the CPU, aren't counted.
+struct CycleTimer
+{
+    // the ROM by file offset, which is FastROM if the header's map mode
+    // says so; it is then read at 6 clocks from $80-$FF
+    CycleTimer(const MemoryMap& map, const std::vector<InstructionMetadata>& instructions, std::vector<unsigned char> rom);
+
+    // The instruction at address with the given register widths, where
+    // absolute operands are in data_bank.  A conditional branch is costed
+    // as not taken.
+    CycleCost cost(unsigned int address, bool accum_16, bool index_16, unsigned char data_bank) const;
+    static CycleCost taken();
+
+    bool fast_rom() const { return m_fast_rom; }
+    const MemoryMap& memory_map() const { return m_map; }
+    int read(unsigned int address) const; //the ROM byte at an address, -1 outside ROM
+    const std::vector<unsigned char>& rom() const { return m_rom; }
+    // master clocks of a bus cycle at address
+    unsigned int access_clocks(unsigned int address) const;
+
+    enum { INTERNAL_CLOCKS = 6, FRAME_CLOCKS = 1364 * 262 }; //NTSC, 60 frames a second
+
+private:
+    // bus cycles of an instruction with 8 bit registers, the branch not taken
+    struct Timing
+    {
+        unsigned char m_fetch; //opcode and operand bytes
+        unsigned char m_internal;
+        unsigned char m_pointer; //bytes of an indirect address
+        unsigned char m_data; //bytes read and written
+        unsigned char m_stack; //bytes pushed and pulled, and vector bytes
+        unsigned char m_width; //AddressMode::Width of the data, stack or immediate bytes
+        unsigned char m_flags; //Flag
+    };
+
+    enum Flag { WideFetch = 0x01, IndexedRead = 0x02, Direct = 0x04, BankZeroPointer = 0x08,
+        ProgramBankPointer = 0x10, LongOperand = 0x20, AbsoluteOperand = 0x40, BlockMove = 0x80 };
+
+    static Timing timing(const InstructionMetadata& instr);
+
+    const MemoryMap& m_map;
+    std::vector<unsigned char> m_rom;
+    std::vector<Timing> m_timings; //by opcode
+    bool m_fast_rom;
+};
+
+// The instructions of a routine and the ways between them, for the
+// shortest and the longest path from its entry to where it returns.
+struct RoutineGraph
+{
+    struct Edge
+    {
+        unsigned int m_to;
+        CycleCost m_cost; //what taking it adds: a taken branch, or a call
+    };
+
+    struct Node
+    {
+        Node() : m_exit(false) {}
+
+        CycleCost m_cost;
+        std::vector<Edge> m_edges;
+        bool m_exit; //returns, or ends where the walk can't follow
+    };
+
+    // Node 0 is the entry.  The shortest path takes the minimum of every
+    // cost, the longest the maximum, and follows no edge back into a loop
+    // it is in, so that each loop counts once.  False if no exit is
+    // reached.
+    bool solve(CycleCost* cost, unsigned int* loops) const;
+
+    std::vector<Node> m_nodes;
+
+private:
+    unsigned int shortest(unsigned int CycleCost::* field) const;
+    unsigned int longest(unsigned int CycleCost::* field, const std::vector<unsigned int>& order,
+        const std::vector<std::vector<bool> >& back) const;
+};
+
+// Request::m_cost: the cycles a routine takes from its entry to a
+// return, for the shortest and the longest path, calls included.  The
+// counts are over the routine and everything it calls.
+struct CostReport
+{
+    struct Call
+    {
+        unsigned int m_address;
+        std::string m_name;
+        CycleCost m_cost;
+        bool m_returns;
+    };
+
+    CostReport() :
+    m_address(0), m_accum_16(false), m_index_16(false), m_fast_rom(false), m_returns(false),
+    m_instructions(0), m_branches(0), m_loops(0), m_unresolved(0), m_into_data(0), m_recursive(0),
+    m_block_moves(0), m_truncated(false)
+    {}
+
+    unsigned int m_address;
+    std::string m_name;
+    bool m_accum_16;
+    bool m_index_16;
+    bool m_fast_rom;
+    CycleCost m_cost;
+    bool m_returns; //some path reaches an RTS, RTL or RTI
+    std::vector<Call> m_calls; //each callee once, by address
+
+    size_t m_instructions; //walked, counting each register width they're reached with
+    size_t m_branches;
+    size_t m_loops;
+    size_t m_unresolved; //indirect jumps and calls not followed
+    size_t m_into_data; //paths that ran into typed data or out of ROM
+    size_t m_recursive; //calls back into a routine still being walked, counted as free
+    size_t m_block_moves; //counted for one byte
+    bool m_truncated; //a routine had more than MAX_NODES instructions
+
+    enum { MAX_NODES = 0x10000 };
+
+    void print(std::ostream& out) const;
+};
+
+// Builds a RoutineGraph of a routine for a CostReport, and one of each
+// routine it calls, which the call then costs as.  Register widths follow
+// REP, SEP and the flag resets as the listing's do, and are taken to be
+// the same after a call; callees are walked once for each width they are
+// called with.  JMP ($xxxx,X) and JSR ($xxxx,X) follow the --ptr table at
+// $xxxx, taking any of its entries.
+struct RoutineWalk
+{
+    // data is by file offset, as Disassembler keeps it
+    RoutineWalk(const CycleTimer& timer, const std::vector<InstructionMetadata>& instructions,
+        const ByteProperties* data, unsigned int data_size);
+
+    void run(unsigned int address, bool accum_16, bool index_16, CostReport* report);
+
+    enum { MAX_TABLE_ENTRIES = 256 };
+
+private:
+    struct Summary
+    {
+        CycleCost m_cost;
+        bool m_returns;
+    };
+
+    Summary walk(unsigned int address, bool accum_16, bool index_16, bool top);
+    void add_call(unsigned int address, const Summary& callee); //to the report, merging widths
+    // the targets of a jump table in the program bank, if the data files
+    // type it as pointers
+    bool table(unsigned int address, std::vector<unsigned int>* targets) const;
+
+    const CycleTimer& m_timer;
+    const std::vector<InstructionMetadata>& m_instructions;
+    const ByteProperties* m_data;
+    unsigned int m_data_size;
+    std::map<uint64_t, Summary> m_summaries; //by address and widths
+    std::set<uint64_t> m_walking;
+    CostReport* m_report;
+};
+
+#endif
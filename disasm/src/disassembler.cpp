@@ -1,86 +1,80 @@
+#include <algorithm>
+#include <filesystem>
 #include <iostream>
 #include <iomanip>
+#include <iterator>
 #include <sstream>
 #include <fstream>
+#include <tuple>
 #include "byte_properties.h"
 #include "disassembler.h"
 #include "disassembler_context.h"
 #include "request.h"
 #include "instruction.h"
 #include "instruction_handlers.h"
+#include "interpreter.h"
+#include "analytics.h"
 #include "annotation_handlers.h"
+#include "compression.h"
+#include "cycles.h"
+#include "output_cache.h"
 #include "output_handlers.h"
+#include "tiles.h"
+#include "trace_events.h"
 #include "utils.h"
 
 using namespace std;
 using namespace Address;
-using Input::is_comment;
 
 namespace{
-    istream& get_full_address(istream& in, unsigned int* full)
-    {
-        in >> hex >> *full;
-        return in;
-    }
-
-    unsigned int index_from_full_address(unsigned int full_address)
-    {
-        unsigned char bank = bank_from_addr24(full_address);
-        unsigned int addr = addr16_from_addr24(full_address);
-        return get_index(bank, addr);
-    }
-
-    istream& get_raw_address(istream& in, unsigned char* bank, unsigned int* addr)
-    {
-        unsigned int full;
-        if (!(in >> hex >> full))
-            return in;
-
-        *addr = addr16_from_addr24(full);
-        *bank = bank_from_addr24(full);
-
-        return in;
-    }
-
-    istream& get_data_address(istream& in, unsigned char* bank, unsigned int* addr)
-    {
-        get_raw_address(in, bank, addr);
+    const unsigned int TILES_PER_ROW = 16; //of an extracted tile sheet
 
-        if (*addr < 0x8000)
-            *addr += 0x8000;
-
-        return in;
-    }
-
-    void increment_address(unsigned char* bank, unsigned int* pc, bool hirom)
+    // immediate loads and the stores they feed, see DisassemblerState::stored_value
+    bool keeps_known_values(unsigned int opcode)
     {
-        ++(*pc);
-        if (*pc > 0x0ffff){
-            ++(*bank);
-            *pc -= (hirom ? 0x10000 : 0x8000);
+        switch (opcode)
+        {
+        case 0xA9: case 0xA2: case 0xA0:
+        case 0x8D: case 0x8E: case 0x8C: case 0x9C:
+            return true;
         }
+        return false;
     }
 }
 
 DisassemblerState::DisassemblerState() :
-m_hirom(false),
+m_map(&MemoryMap::get(MemoryMap::LoRom)),
 m_accum_16(false),
 m_index_16(false)
-{}
+{
+    forget_values();
+}
 
-unsigned int DisassemblerState::get_current_index() const
+void DisassemblerState::immediate_loaded(unsigned int opcode, int value)
 {
-    return get_index(m_current_bank, m_current_addr);
+    switch (opcode)
+    {
+    case 0xA9: m_known[0] = value; break; //LDA
+    case 0xA2: m_known[1] = value; break; //LDX
+    case 0xA0: m_known[2] = value; break; //LDY
+    }
 }
 
-unsigned int DisassemblerState::get_current_address() const
+int DisassemblerState::stored_value(unsigned int opcode) const
 {
-    return full_address(m_current_bank, m_current_addr);
+    switch (opcode)
+    {
+    case 0x8D: return m_known[0]; //STA
+    case 0x8E: return m_known[1]; //STX
+    case 0x8C: return m_known[2]; //STY
+    case 0x9C: return 0;          //STZ
+    }
+    return -1;
 }
 
-void DisassemblerState::increment_address()
+void DisassemblerState::forget_values()
 {
-    ::increment_address(&m_current_bank, &m_current_addr, m_hirom);
+    m_known[0] = m_known[1] = m_known[2] = -1;
 }
 
 void DisassemblerState::set_address(unsigned char bank, unsigned int pc)
@@ -90,41 +84,452 @@ void DisassemblerState::set_address(unsigned char bank, unsigned int pc)
 }
 
 
-Disassembler::Disassembler(FILE* rom_file) :
-m_hirom(false),
+const vector<InstructionMetadata>& Disassembler::instruction_table()
+{
+    // built once, then shared read only by every instance and thread
+    static const vector<InstructionMetadata> table = build_instruction_table();
+    return table;
+}
+
+Disassembler::Disassembler(FILE* rom_file, ostream& out, ostream& log) :
+m_instruction_lookup(&instruction_table()),
+m_labels(make_shared<LabelIndex>()),
+m_registers(RegisterDatabase::builtin()),
+m_data_size(0),
+m_recording(0),
+m_extern_labels(0),
+m_trace_bank(-1),
+m_trace_bank_begin(0),
+m_quiet(false),
+m_cycles(false),
 m_current_pass(1),
 m_passes_to_make(1),
 m_flag(0),
-m_output_handler(new DefaultOutput()),
+m_map(&MemoryMap::get(MemoryMap::LoRom)),
+m_out(&out),
+m_log(&log),
 m_noop_handler(new NoOutput()),
+m_output_handler(new DefaultOutput(out)),
+m_annotations(Annotations::Default),
 m_rom_file(rom_file),
-m_quiet(false),
 m_header_size(512),
-m_annotation_provider(new DefaultAnnotations)
+m_rom_size(0)
 { 
-    initialize_instruction_lookup(); 
+    allocate_properties();
+    measure_rom();
+}
+
+Disassembler::Disassembler(const Disassembler& base, FILE* rom_file, ostream& out) :
+Disassembler(base)
+{
+    m_rom_file = rom_file;
+    measure_rom();
+    m_out = &out;
+    m_output_handler = CreateOutputHandler(m_output_format, out);
+    m_unresolved_symbol_lookup.clear();
+    m_current_pass = 1;
+    m_stats.reset(); //sessions may run on other threads
+}
 
-    //todo: move to class, use actual file size
-    m_data = new ByteProperties[MAX_FILE_SIZE];
-    for (int bank = 0; bank < MAX_FILE_SIZE / BANK_SIZE; ++bank)
+Disassembler::~Disassembler()
+{
+}
+
+void Disassembler::memory_map(MemoryMap::Mapper mapper)
+{
+    m_map = &MemoryMap::get(mapper);
+    m_state.memory_map(m_map);
+    allocate_properties();
+    measure_rom();
+    m_range_cache.clear();
+    m_timer.reset();
+}
+
+// one entry per byte the mapper can address, plus the one that addresses
+// outside ROM resolve to, so that any rom_index is in bounds; what the
+// file holds is m_rom_size
+void Disassembler::allocate_properties()
+{
+    //todo: move to class
+    if (!m_data_storage || m_data_size != m_map->rom_capacity()){
+        m_data_size = m_map->rom_capacity();
+        m_data = new ByteProperties[m_data_size + 1];
+        m_data_storage.reset(m_data, default_delete<ByteProperties[]>());
+    }
+    for (unsigned int i = 0; i < m_data_size; ++i){
+        m_data[i].data_bank(bank_from_addr24(m_map->rom_address(i)));
+    }
+    index_segments();
+}
+
+void Disassembler::remap_properties(const function<unsigned int(unsigned int)>& source)
+{
+    shared_ptr<ByteProperties> from_storage = m_data_storage;
+    const ByteProperties* from = from_storage.get();
+    CoverageMap coverage;
+    if (!m_coverage.empty())
+        coverage.reset(m_coverage.size(), m_coverage.has_register_widths());
+
+    m_data = new ByteProperties[m_data_size + 1];
+    m_data_storage.reset(m_data, default_delete<ByteProperties[]>());
+    for (unsigned int i = 0; i < m_data_size; ++i){
+        unsigned int index = source(i);
+        if (index >= m_data_size){
+            m_data[i].data_bank(bank_from_addr24(m_map->rom_address(i)));
+            continue;
+        }
+        m_data[i] = from[index];
+        if (m_coverage.is_instruction_start(index)){
+            coverage.mark_instruction_start(i);
+            coverage.mark_register_widths(i, m_coverage.is_accum_16(index), m_coverage.is_index_16(index));
+        }
+    }
+    m_data[m_data_size] = from[m_data_size];
+    m_coverage = coverage;
+    m_range_cache.clear();
+    index_segments();
+}
+
+void Disassembler::index_segments()
+{
+    ScopedPhase timer(m_stats.get(), "index segments");
+    m_segments = make_shared<SegmentIndex>(m_data, m_data_size);
+}
+
+const ByteProperties* Disassembler::properties(unsigned int index) const
+{
+    return index < m_data_size ? &m_data[index] : 0;
+}
+
+namespace{
+    // the range a request is decoded over, see MemoryMap::contiguous_range
+    DisassemblerProperties rom_range(const DisassemblerProperties& properties, const MemoryMap& map)
     {
-        for (int i = 0; i < BANK_SIZE; ++i)
-        {
-            m_data[bank*BANK_SIZE + i].data_bank(bank);
+        unsigned int start = full_address(properties.m_start_bank, properties.m_start_addr);
+        unsigned int end = properties.full_end_address();
+        map.contiguous_range(&start, &end);
+
+        DisassemblerProperties range = properties;
+        range.m_start_bank = bank_from_addr24(start);
+        range.m_start_addr = start & 0xFFFF;
+        range.m_end_bank = bank_from_addr24(end);
+        range.m_end_addr = end & 0xFFFF;
+        return range;
+    }
+}
+
+void Disassembler::hash_request_inputs(const Request& request, ContentHash* hash)
+{
+    const DisassemblerProperties p = rom_range(request.m_properties, *m_map);
+    unsigned int start = full_address(p.m_start_bank, p.m_start_addr);
+    unsigned int end = p.full_end_address();
+    hash->add((uint64_t)request.m_type);
+    hash->add((uint64_t)p.m_comment_level);
+    hash->add((uint64_t)p.m_passes);
+    hash->add((uint64_t)(p.m_quiet | p.m_start_w_accum_16 << 1 | p.m_start_w_index_16 << 2 |
+        p.m_stop_at_rts << 3 | p.m_use_extern_symbols << 4));
+    hash->add((uint64_t)start);
+    hash->add((uint64_t)end);
+    hash->add((uint64_t)(m_map->mapper() | m_quiet << 2));
+    hash->add((uint64_t)m_header_size);
+    hash->add((uint64_t)m_annotations);
+    hash->add(m_output_format);
+    hash->add(m_asset_dir);
+    hash->add(request.m_find);
+    hash->add((uint64_t)(request.m_analytics | request.m_json << 1 | request.m_cost << 2 | m_cycles << 3));
+    if (!request.m_find.empty()){
+        vector<const LabelIndex::Entry*> matches;
+        find_labels(request.m_find, &matches);
+        for (const LabelIndex::Entry* entry : matches){
+            hash->add(entry->first);
+            hash->add((uint64_t)entry->second);
+        }
+    }
+
+    auto hash_byte = [&](unsigned int index){
+        const ByteProperties& properties = m_data[index];
+        hash->add((uint64_t)properties.type() | (uint64_t)properties.data_bank() << 8 |
+            (uint64_t)(unsigned int)properties.load_offset() << 16 | (uint64_t)m_coverage.is_instruction_start(index) << 48 |
+            (uint64_t)m_coverage.is_accum_16(index) << 49 | (uint64_t)m_coverage.is_index_16(index) << 50);
+        hash->add((uint64_t)(unsigned int)properties.reset_accum_to << 32 | (unsigned int)properties.reset_index_to);
+        hash->add(properties.comment());
+        hash->add(properties.label());
+    };
+
+    // analytics and cost read the whole ROM whatever the range; a listing
+    // reads up to 3 operand bytes past its end for its last instruction
+    unsigned int first = m_map->rom_index(start);
+    size_t bytes = 0;
+    if (request.m_analytics || request.m_cost){
+        for (first = 0; bytes < m_data_size; ++bytes){
+            hash_byte((unsigned int)bytes);
+        }
+    }
+    else{
+        unsigned char bank = p.m_start_bank;
+        unsigned int pc = p.m_start_addr;
+        for (unsigned int past_end = 0; past_end < 3; m_map->increment(&bank, &pc), ++bytes){
+            if (full_address(bank, pc) >= end)
+                ++past_end;
+            unsigned int index = m_map->rom_index(full_address(bank, pc));
+            if (index >= m_data_size)
+                break;
+            hash_byte(index);
         }
     }
+
+    vector<unsigned char> rom;
+    read_rom(first, (unsigned int)bytes, &rom);
+    hash->add((uint64_t)rom.size());
+    hash->add(rom.data(), rom.size());
 }
 
-Disassembler::~Disassembler()
+void Disassembler::analyze(const DisassemblerProperties& range, AnalyticsReport* report)
+{
+    ScopedPhase timer(m_stats.get(), "analytics");
+    Trace::Scope trace("analytics", "request");
+
+    vector<unsigned char> rom;
+    read_rom(0, m_data_size, &rom);
+    unsigned int size = (unsigned int)rom.size();
+
+    // the range as file offsets, all of them for 000000-FFFFFF
+    unsigned int start = full_address(range.m_start_bank, range.m_start_addr);
+    unsigned int end = range.full_end_address();
+    unsigned int first = 0, last = size;
+    if (start != 0 || end != 0xFFFFFF){
+        if (!m_map->is_rom(start))
+            start = full_address(range.m_start_bank, m_map->bank_start(range.m_start_bank));
+        first = min(m_map->rom_index(start), size);
+        if (end > start && m_map->is_rom(end - 1))
+            last = min(m_map->rom_index(end - 1) + 1, size);
+        last = max(first, last);
+    }
+
+    ByteBitmap code(size), data(size), pointers(size), compressed(size), tiles(size), typed(size);
+    ByteBitmap labels(size), comments(size), referenced(size);
+    auto reference = [&](unsigned int address){
+        unsigned int index = m_map->rom_index(address);
+        if (index < size)
+            referenced.set(index);
+    };
+
+    for (unsigned int offset = 0; offset < size;){
+        const SegmentIndex::Run* run = m_segments->find(offset);
+        if (!run)
+            break;
+        unsigned int run_end = min(run->m_end, size);
+        int type = run->m_type;
+        ByteBitmap* kind = type == 1 ? &data : type == 2 || type == 3 ? &pointers :
+            is_compressed_type(type) ? &compressed : is_tile_type(type) ? &tiles : 0;
+        if (kind){
+            kind->set_range(run->m_start, run_end);
+            typed.set_range(run->m_start, run_end);
+        }
+        // as doPtr reads them: short pointers are into the data bank
+        if (type == 2 || type == 3){
+            for (unsigned int i = run->m_start; i + type <= run_end; i += type){
+                unsigned int bank = type == 3 ? rom[i + 2] : m_data[i].data_bank();
+                reference(full_address(bank, address_16bit(rom[i], rom[i + 1])));
+            }
+        }
+        offset = run_end;
+    }
+
+    for (unsigned int i = 0; i < size; ++i){
+        if (m_data[i].has_label())
+            labels.set(i);
+        if (m_data[i].has_comment())
+            comments.set(i);
+    }
+
+    // Instructions: the traced ones, and what a static decode reaches from
+    // them and from the labels of untyped bytes.  It follows branches,
+    // jumps and calls into untyped bytes and runs on to the next return
+    // or jump, with the traced register widths where there are some and
+    // the flag resets, REP and SEP otherwise.  Their operands name what
+    // is referenced.
+    struct Entry
+    {
+        unsigned int m_offset;
+        bool m_accum_16;
+        bool m_index_16;
+    };
+    vector<Entry> pending;
+    for (unsigned int i = 0; i < size; ++i){
+        if (labels.test(i) && !typed.test(i))
+            pending.push_back(Entry{ i, false, false });
+    }
+    // taken first, so that the trace decides where instructions start
+    for (unsigned int i = 0; i < size && i < m_coverage.size(); ++i){
+        if (m_coverage.is_instruction_start(i))
+            pending.push_back(Entry{ i, false, false });
+    }
+
+    ByteBitmap decoded(size);
+    vector<size_t> modes(m_instruction_lookup->size());
+    while (!pending.empty()){
+        Entry entry = pending.back();
+        pending.pop_back();
+        bool accum_16 = entry.m_accum_16;
+        bool index_16 = entry.m_index_16;
+        for (unsigned int i = entry.m_offset; i < size && !decoded.test(i);){
+            if (m_data[i].reset_accum_to)
+                accum_16 = m_data[i].reset_accum_to == 16;
+            if (m_data[i].reset_index_to)
+                index_16 = m_data[i].reset_index_to == 16;
+            if (m_coverage.has_register_widths() && m_coverage.is_instruction_start(i)){
+                accum_16 = m_coverage.is_accum_16(i);
+                index_16 = m_coverage.is_index_16(i);
+            }
+
+            decoded.set(i);
+            const InstructionMetadata& instr = (*m_instruction_lookup)[rom[i]];
+            unsigned int length = min(instr.length(accum_16, index_16), size - i);
+            code.set_range(i, i + length);
+            if (i >= first && i < last)
+                ++modes[rom[i]];
+            if (length < 1 + instr.address_mode().m_operand_bytes)
+                break;
+
+            unsigned int address = m_map->rom_address(i);
+            unsigned int operand = length > 2 ? address_16bit(rom[i + 1], rom[i + 2]) : length > 1 ? rom[i + 1] : 0;
+            unsigned int target = 0;
+            bool follow = false;
+            switch (instr.address_mode().m_target)
+            {
+            case AddressMode::Absolute:
+                target = full_address(instr.isJump() || instr.isCall() ? bank_from_addr24(address) : m_data[i].data_bank(), operand);
+                follow = rom[i] == 0x20 || rom[i] == 0x4C; //JSR, JMP
+                break;
+            case AddressMode::Long:
+                target = address_24bit(rom[i + 1], rom[i + 2], rom[i + 3]);
+                follow = rom[i] == 0x22 || rom[i] == 0x5C; //JSL, JML
+                break;
+            case AddressMode::Relative:
+                {
+                    int displacement = length == 2 ? (int)(signed char)operand : (int)(short)operand;
+                    target = full_address(bank_from_addr24(address), (addr16_from_addr24(address) + length + displacement) & 0xFFFF);
+                    follow = instr.isBranch();
+                }
+                break;
+            default:
+                break;
+            }
+            if (instr.address_mode().m_target != AddressMode::NoTarget)
+                reference(target);
+            unsigned int target_index = m_map->rom_index(target);
+            if (follow && target_index < size && !typed.test(target_index) && !decoded.test(target_index))
+                pending.push_back(Entry{ target_index, accum_16, index_16 });
+
+            if (rom[i] == 0xC2 || rom[i] == 0xE2){ //REP, SEP
+                if (rom[i + 1] & 0x20)
+                    accum_16 = rom[i] == 0xC2;
+                if (rom[i + 1] & 0x10)
+                    index_16 = rom[i] == 0xC2;
+            }
+            if (instr.isCodeBreak() || rom[i] == 0x82) //BRL
+                break;
+            i += length;
+            if (i < size && typed.test(i))
+                break;
+        }
+    }
+
+    unsigned int bank_size = m_map->rom_bank_size();
+    for (unsigned int bank_first = first / bank_size * bank_size; bank_first < last; bank_first += bank_size){
+        unsigned int from = max(bank_first, first);
+        unsigned int to = min(bank_first + bank_size, last);
+        AnalyticsRow row;
+        row.m_bank = bank_from_addr24(m_map->rom_address(bank_first));
+        row.m_bytes = to - from;
+        row.m_code = code.count(from, to);
+        row.m_data = data.count(from, to);
+        row.m_pointers = pointers.count(from, to);
+        row.m_compressed = compressed.count(from, to);
+        row.m_tiles = tiles.count(from, to);
+        row.m_untyped = row.m_bytes - code.count_or(typed, from, to);
+        row.m_labels = labels.count(from, to);
+        row.m_unreferenced = labels.count_and_not(referenced, from, to);
+        row.m_comments = comments.count(from, to);
+        report->m_banks.push_back(row);
+        report->m_total.add(row);
+    }
+
+    map<string, size_t> by_mode;
+    for (size_t opcode = 0; opcode < modes.size(); ++opcode){
+        if (modes[opcode])
+            by_mode[(*m_instruction_lookup)[opcode].address_mode().m_name] += modes[opcode];
+    }
+    report->m_modes.assign(by_mode.begin(), by_mode.end());
+    stable_sort(report->m_modes.begin(), report->m_modes.end(),
+        [](const pair<string, size_t>& a, const pair<string, size_t>& b){ return a.second > b.second; });
+
+    for (unsigned int i = first; i < last; ++i){
+        if (labels.test(i) && !referenced.test(i))
+            report->m_unreferenced.push_back(make_pair(m_map->rom_address(i), m_data[i].label()));
+    }
+}
+
+void Disassembler::cost(const DisassemblerProperties& range, CostReport* report)
 {
-    delete [] m_data;
+    ScopedPhase phase(m_stats.get(), "cost");
+    Trace::Scope trace("cost", "request");
+    unsigned int address = full_address(range.m_start_bank, range.m_start_addr);
+    RoutineWalk walk(timer(), *m_instruction_lookup, m_data, m_data_size);
+    walk.run(address, range.m_start_w_accum_16, range.m_start_w_index_16, report);
+    report->m_name = symbol_at(address);
+    for (CostReport::Call& call : report->m_calls){
+        call.m_name = symbol_at(call.m_address);
+    }
 }
 
-//todo: move hirom to state and test
-void Disassembler::hirom(bool hirom) 
-{ 
-    m_state.hirom(hirom);
-    m_hirom = hirom; 
+const CycleTimer& Disassembler::timer()
+{
+    if (!m_timer){
+        vector<unsigned char> rom;
+        read_rom(0, m_data_size, &rom);
+        m_timer = make_shared<CycleTimer>(*m_map, *m_instruction_lookup, move(rom));
+    }
+    return *m_timer;
+}
+
+void Disassembler::header_size(int size)
+{
+    m_header_size = size;
+    measure_rom();
+    m_range_cache.clear();
+    m_timer.reset();
+}
+
+void Disassembler::measure_rom()
+{
+    m_rom_size = m_map->rom_capacity();
+    if (m_rom_file && fseek(m_rom_file, 0, SEEK_END) == 0){
+        long size = ftell(m_rom_file);
+        m_rom_size = size > m_header_size ? (unsigned int)(size - m_header_size) : 0;
+    }
+}
+
+void Disassembler::read_rom(unsigned int index, unsigned int size, vector<unsigned char>* bytes)
+{
+    bytes->resize(size);
+    fseek(m_rom_file, header_size() + index, SEEK_SET);
+    bytes->resize(fread(bytes->data(), 1, bytes->size(), m_rom_file));
+}
+
+string Disassembler::symbol_at(unsigned int key) const
+{
+    MemoryMap::Location location = m_map->resolve(key);
+    if (in_rom(location)){
+        if (m_data[location.m_offset].has_label())
+            return m_data[location.m_offset].label();
+        if (m_coverage.is_instruction_start(location.m_offset))
+            return "CODE_" + to_string(location.m_canonical, 6);
+        return "";
+    }
+    map<int, string>::const_iterator it = m_ram_lookup.find(location.m_canonical);
+    return it != m_ram_lookup.end() ? it->second : "";
 }
 
 int Disassembler::get_offset()
@@ -133,7 +538,7 @@ int Disassembler::get_offset()
     return m_data[index].load_offset();
 }
 
-std::string Disassembler::get_comment()
+string_view Disassembler::get_comment()
 {
     if (m_range_properties.m_comment_level == 0)
         return "";
@@ -142,6 +547,29 @@ std::string Disassembler::get_comment()
     return m_data[i].comment();
 }
 
+// The register's comment, and at comment level 4 the bit fields of a
+// value that the instruction is known to store there.
+string_view Disassembler::get_register_comment(const InstructionMetadata& instr, unsigned int address, int comment_level)
+{
+    string_view comment = m_registers->comment(address, comment_level);
+    int value = m_state.stored_value(instr.opcode());
+    if (comment.empty() || comment_level <= 3 || value < 0)
+        return comment;
+
+    const Register* reg = m_registers->find(address);
+    if (!reg->m_fields.empty()){
+        comment = m_arena.join({ comment, "\n          ;#$", to_string(value & 0xFF, 2), ": ", reg->decode(value & 0xFF) });
+    }
+
+    // a 16 bit store writes the next register too
+    bool is_16 = (instr.opcode() == 0x8D || instr.opcode() == 0x9C) ? m_state.is_accum_16bit() : m_state.is_index_16bit();
+    const Register* high = is_16 ? m_registers->find(address + 1) : 0;
+    if (high && !high->m_fields.empty()){
+        comment = m_arena.join({ comment, "\n          ;$", to_string(address + 1, 4), " #$", to_string(value >> 8, 2), ": ", high->decode(value >> 8) });
+    }
+    return comment;
+}
+
 int Disassembler::get_data_bank() const
 {
     int i = m_state.get_current_index();
@@ -152,34 +580,95 @@ char Disassembler::read_next_byte()
 {
     char c = read_char(m_rom_file);
     m_state.increment_address();
+    // the next bank needn't follow in the file (HiROM $00-$3F, mirrors)
+    if (m_state.is_bank_start())
+        fseek(m_rom_file, header_size() + m_state.get_current_index(), SEEK_SET);
     return c;
 }
 
-void Disassembler::handleRequest(const Request& request)
+void Disassembler::handleRequest(const Request& original)
 {
+    Request request = original;
+    request.m_properties = rom_range(original.m_properties, *m_map);
+
+    if (request.m_memstats){
+        MemoryUsage usage;
+        memory_usage(&usage);
+        usage.print(*m_out);
+        return;
+    }
+
+    if (request.m_analytics){
+        AnalyticsReport report;
+        analyze(request.m_properties, &report);
+        if (request.m_json)
+            report.write_json(*m_out);
+        else
+            report.print(*m_out);
+        return;
+    }
+
+    if (request.m_cost){
+        CostReport report;
+        cost(request.m_properties, &report);
+        report.print(*m_out);
+        return;
+    }
+
+    if (!request.m_find.empty()){
+        vector<const LabelIndex::Entry*> matches;
+        find_labels(request.m_find, &matches);
+        for (const LabelIndex::Entry* entry : matches){
+            *m_out << to_string(entry->second, 6) << " " << entry->first << endl;
+        }
+        if (matches.empty())
+            *m_out << "no labels match " << request.m_find << endl;
+        return;
+    }
+
     m_passes_to_make = request.m_properties.m_passes;
+    // read before the listing starts, as it moves the ROM file's position
+    if (m_cycles)
+        timer();
 
-    m_start = full_address(request.m_properties.m_start_bank,
-        request.m_properties.m_start_addr);
+    // labels are kept by canonical address, so the range is compared in
+    // those terms (the end by its last byte, which is in the range's bank)
+    m_start = m_map->canonical(full_address(request.m_properties.m_start_bank,
+        request.m_properties.m_start_addr));
 
-    m_end = full_address(request.m_properties.m_end_bank,
-        request.m_properties.m_end_addr);
+    m_end = m_map->canonical(full_address(request.m_properties.m_end_bank,
+        request.m_properties.m_end_addr) - 1) + 1;
 
     m_state.is_accum_16bit(request.m_properties.m_start_w_accum_16);
     m_state.is_index_16bit(request.m_properties.m_start_w_index_16);
 
-    disassembleRange(request);
+    ScopedPhase timer(m_stats.get(), "requests");
+    if (m_stats)
+        m_stats->count(Stats::Requests);
+
+    Trace::Scope trace("request", "request", "start", m_start);
+    if (Trace::enabled())
+        trace_bank(request.m_properties.m_start_bank);
+
+    if (!RangeCache::is_cacheable(request))
+        disassembleRange(request);
+    else if (!replayRange(request))
+        recordRange(request);
+
+    if (Trace::enabled())
+        trace_bank(-1);
 
     if (!m_unresolved_symbol_lookup.empty() && !quiet()){
-        cout << "Unresolved symbols: " << endl;
+        *m_out << "Unresolved symbols: " << endl;
         for (map<int, string>::iterator it = m_unresolved_symbol_lookup.begin(),
             end_it = m_unresolved_symbol_lookup.end(); it != end_it; ++it){
-            cout << to_string(it->first, 6) << " " << it->second << endl;
+            *m_out << to_string(it->first, 6) << " " << it->second << endl;
         }
         m_unresolved_symbol_lookup.clear();
     }
 
     m_current_pass = 1;
+    m_arena.reset();
 }
 
 void Disassembler::disassembleRange(const Request& request)
@@ -189,14 +678,12 @@ void Disassembler::disassembleRange(const Request& request)
 
         m_state.set_address(m_range_properties.m_start_bank, m_range_properties.m_start_addr);
 
-        fseek(m_rom_file, header_size(), 0);
-        if (m_hirom)
-            fseek(m_rom_file, m_state.get_current_address(), 1);
-        else
-            fseek(m_rom_file, m_state.get_current_index(), 1);
+        fseek(m_rom_file, header_size() + m_state.get_current_index(), SEEK_SET);
 
         if (request.m_type == Request::Dcb)
             doDcb();
+        else if (request.m_type == Request::Incbin)
+            doIncbin();
         else if (request.m_type == Request::Ptr)
             doPtr();
         else if (request.m_type == Request::PtrLong)
@@ -204,8 +691,16 @@ void Disassembler::disassembleRange(const Request& request)
         else if (request.m_type == Request::Asm)
             doDisasm();
         else{
-            output_handler()->PassStart();
-            doSmart();
+            {
+                ScopedPhase timer(m_stats.get(), m_current_pass == 1 ? "pass 1" : "pass 2");
+                Trace::Scope trace("pass", "pass", "pass", m_current_pass);
+                if (Trace::enabled() && m_current_pass > 1){
+                    trace_bank(-1);
+                    trace_bank(m_range_properties.m_start_bank);
+                }
+                output_handler()->PassStart();
+                doSmart();
+            }
             m_current_pass++;
             if (m_current_pass > m_passes_to_make)               
                 break;
@@ -213,25 +708,59 @@ void Disassembler::disassembleRange(const Request& request)
     } while(request.m_type == Request::Smart);    
 }
 
-void Disassembler::load_accum_bytes(char *fname, bool accum)
+void Disassembler::recordRange(const Request& request)
+{
+    shared_ptr<RangeCacheEntry> entry = make_shared<RangeCacheEntry>(request);
+    shared_ptr<RecordingOutput> recorder = make_shared<RecordingOutput>(m_output_format, &m_state, entry.get());
+
+    shared_ptr<OutputHandler> output_handler = m_output_handler;
+    ostream* out = m_out;
+    m_output_handler = timed(recorder);
+    m_out = &recorder->stream();
+    m_recording = entry.get();
+
+    disassembleRange(request);
+
+    m_output_handler = output_handler;
+    m_out = out;
+    m_recording = 0;
+
+    Trace::Scope trace("flush", "writer");
+    for (size_t i = 0; i < entry->m_units.size(); ++i){
+        *m_out << entry->m_units[i].m_text;
+    }
+    *m_out << recorder->pending_text();
+
+    // running off the end of the ROM writes straight to the stream, so
+    // those results are not kept
+    if (!feof(m_rom_file))
+        m_range_cache.insert(entry);
+}
+
+bool Disassembler::replayRange(const Request& request)
 {
-    fstream in(fname);
-    string line;
-    while (getline(in, line)){
-        if (is_comment(line)) continue;
-        istringstream line_stream(line);
+    vector<const RangeCacheEntry::Unit*> units;
+    if (!m_range_cache.lookup(request, &units))
+        return false;
 
-        string type;
-        int fulladdr, bytes;
-        if(!(line_stream >> hex >> fulladdr >> type >> dec >> bytes)) continue;
+    ScopedPhase timer(m_stats.get(), "cache replay");
+    Trace::Scope trace("replay", "writer");
+    if (m_stats)
+        m_stats->count(Stats::CacheReplays);
 
-        int index = index_from_full_address(fulladdr);
-        
-        if(type == "A" || type == "AI" || type == "IA")
-            m_data[index].reset_accum_to = bytes;
-        if(type == "I" || type == "AI" || type == "IA")
-            m_data[index].reset_index_to = bytes;
+    for (size_t i = 0; i < units.size(); ++i){
+        const RangeCacheEntry::Unit& unit = *units[i];
+        for (size_t l = 0; l < unit.m_used.size(); ++l){
+            m_used_label_lookup.try_emplace(unit.m_used[l].first, unit.m_used[l].second);
+        }
+        for (size_t l = 0; l < unit.m_labels.size(); ++l){
+            int key = unit.m_labels[l].first;
+            if ((key < m_start || key > m_end) && m_unresolved_symbol_lookup.try_emplace(key, unit.m_labels[l].second).second && m_stats)
+                m_stats->count(Stats::ExternSymbols);
+        }
+        *m_out << unit.m_text;
     }
+    return true;
 }
 
 void Disassembler::setProcessFlags()
@@ -253,292 +782,773 @@ void Disassembler::setProcessFlags()
     }
 }
 
-void Disassembler::load_comments(const char* fname)
+bool Disassembler::load_driver_files(vector<DriverFile>& files)
 {
-    cerr << "; Reading comments" << endl;
-    ifstream in(fname);
-    string line;
-    while(getline(in, line)){
-        if (is_comment(line)) continue;
+    Trace::Scope trace("driver files", "load");
+    {
+        ScopedPhase timer(m_stats.get(), "parse driver files");
+        parse_driver_files(&files, *m_map);
+    }
+    m_range_cache.clear();
+    for (size_t i = 0; i < files.size(); ++i){
+        if (!apply_driver_file(files[i]))
+            return false;
+    }
+    return true;
+}
 
-        istringstream ss(line);
-        unsigned char bank;
-        unsigned int addr;
-        if (!get_data_address(ss, &bank, &addr))
-            continue;
-        
-        ss.get(); //consume space delimiter
+bool Disassembler::load_driver_file(DriverFile::Type type, const char* filename)
+{
+    DriverFile file(type, filename);
+    parse_driver_file(&file, *m_map);
+    m_range_cache.clear();
+    return apply_driver_file(file);
+}
 
-        string comment;
-        if(!getline(ss, comment)) continue;
+namespace{
+    bool entry_less(const DriverFileEntry& a, const DriverFileEntry& b)
+    {
+        return tie(a.m_kind, a.m_bank, a.m_addr, a.m_size, a.m_value, a.m_text, a.m_error) <
+            tie(b.m_kind, b.m_bank, b.m_addr, b.m_size, b.m_value, b.m_text, b.m_error);
+    }
+}
 
-        unsigned int index = get_index(bank, addr);
-        if (!m_data[index].comment().empty()){
-            cerr << "failed to add comment >" << comment << "<" << endl;
-            continue;
+void Disassembler::reload_driver_file(const DriverFile& previous, const DriverFile& current)
+{
+    Trace::Scope trace(driver_file_type_name(current.m_type), "reload");
+
+    // merged in again; what they add can't be told apart from other files
+    if (current.m_type == DriverFile::TraceSymbols || current.m_type == DriverFile::Registers){
+        apply_driver_file(current);
+        m_range_cache.clear();
+        m_used_label_lookup.clear();
+        *m_log << "; Reloaded " << current.m_filename << endl;
+        return;
+    }
+
+    vector<DriverFileEntry> before = previous.m_entries;
+    vector<DriverFileEntry> after = current.m_entries;
+    sort(before.begin(), before.end(), entry_less);
+    sort(after.begin(), after.end(), entry_less);
+
+    DriverFile removed(previous.m_type, previous.m_filename);
+    DriverFile added(current.m_type, current.m_filename);
+    set_difference(before.begin(), before.end(), after.begin(), after.end(), back_inserter(removed.m_entries), entry_less);
+    set_difference(after.begin(), after.end(), before.begin(), before.end(), back_inserter(added.m_entries), entry_less);
+
+    // messages were shown when the file was first read, and a bad line
+    // shouldn't end the session
+    added.m_entries.erase(remove_if(added.m_entries.begin(), added.m_entries.end(), [&](const DriverFileEntry& entry){
+        if (entry.m_kind == DriverFileEntry::Fatal || !entry.m_error.empty())
+            *m_log << (entry.m_error.empty() ? entry.m_text : entry.m_error) << endl;
+        return entry.m_kind == DriverFileEntry::Message || entry.m_kind == DriverFileEntry::Fatal || !entry.m_error.empty();
+    }), added.m_entries.end());
+
+    // canonical address ranges that changed, and labels that went away
+    vector<pair<unsigned int, unsigned int> > changes;
+    vector<unsigned int> labels;
+    for (const DriverFile* file : { &removed, &added }){
+        for (const DriverFileEntry& entry : file->m_entries){
+            unsigned int start = m_map->canonical(full_address(entry.m_bank, entry.m_addr));
+            unsigned int end = start + 1;
+            unsigned int size = entry.m_kind == DriverFileEntry::Data ? data_size(entry) : entry.m_size;
+            if (size > 0 && m_map->is_rom(start))
+                end = m_map->rom_address(m_map->rom_index(start) + size - 1) + 1;
+            changes.push_back(make_pair(start, end));
+            if (entry.m_kind == DriverFileEntry::Label || entry.m_kind == DriverFileEntry::Data)
+                labels.push_back(start);
         }
+    }
+
+    for (const DriverFileEntry& entry : removed.m_entries){
+        revert_driver_entry(entry);
+    }
+    apply_driver_file(added);
 
-        m_data[index].comment(comment);
+    for (unsigned int label : labels){
+        m_used_label_lookup.erase(label);
     }
-    cerr << "; Reading comments... done." << endl;
+    sort(labels.begin(), labels.end());
+    m_range_cache.remove_if([&](const RangeCacheEntry& entry){
+        const DisassemblerProperties& p = entry.m_request.m_properties;
+        unsigned int start = m_map->canonical(full_address(p.m_start_bank, p.m_start_addr));
+        unsigned int end = m_map->canonical(entry.m_end - 1) + 1;
+        for (const pair<unsigned int, unsigned int>& change : changes){
+            if (change.first < end && start < change.second)
+                return true;
+        }
+        for (const RangeCacheEntry::Unit& unit : entry.m_units){
+            for (size_t l = 0; l < unit.m_labels.size(); ++l){
+                if (binary_search(labels.begin(), labels.end(), (unsigned int)unit.m_labels[l].first))
+                    return true;
+            }
+        }
+        return false;
+    });
+
+    *m_log << "; Reloaded " << current.m_filename << ": " << removed.m_entries.size() << " removed, "
+        << added.m_entries.size() << " added" << endl;
 }
 
-void Disassembler::load_offsets(const char* fname)
+void Disassembler::revert_driver_entry(const DriverFileEntry& entry)
 {
-    fstream in(fname);
-    string line;
-    while (getline(in, line)){
-        if (is_comment(line)) continue;
-
-        istringstream ss(line);
-        unsigned int hex_addr;
-        if (!get_full_address(ss, &hex_addr)) continue;
+    unsigned int index = m_map->rom_index(full_address(entry.m_bank, entry.m_addr));
+    unsigned int size = entry.m_kind == DriverFileEntry::Data ? data_size(entry) : entry.m_size;
+    size = min(size, m_data_size - min(index, m_data_size));
 
-        int offset = 1;
-        if (!(ss >> dec >> offset)){
-            cerr << "couldn't read offset size in: " << line << endl;
-            exit(-1);
+    // only what the entry itself set; another file may have set it since
+    switch (entry.m_kind)
+    {
+    case DriverFileEntry::Comment:
+        if (m_data[index].comment() == entry.m_text)
+            m_data[index].comment("");
+        break;
+
+    case DriverFileEntry::Label:
+        remove_label(entry.m_bank, entry.m_addr, entry.m_text);
+        break;
+
+    case DriverFileEntry::Data:
+        for (unsigned int i = 0; i < size; ++i){
+            if (m_data[index + i].type() == entry.m_value)
+                m_data[index + i].type(0);
         }
+        remove_label(entry.m_bank, entry.m_addr, entry.m_text);
+        break;
 
-        int index = index_from_full_address(hex_addr);
-        if (m_data[index].load_offset() != 0){
-            cerr << "failed to add load offset >" << line << "<" << endl;
-            continue;
+    case DriverFileEntry::DataBank:
+        for (unsigned int i = 0; i < size; ++i){
+            if (m_data[index + i].data_bank() == entry.m_value)
+                m_data[index + i].data_bank(bank_from_addr24(m_map->rom_address(index + i)));
         }
-        m_data[index].load_offset(offset);
+        break;
+
+    case DriverFileEntry::Offset:
+        if (m_data[index].load_offset() == entry.m_value)
+            m_data[index].load_offset(0);
+        break;
+
+    case DriverFileEntry::AccumFlag:
+        if (m_data[index].reset_accum_to == entry.m_value)
+            m_data[index].reset_accum_to = 0;
+        break;
+
+    case DriverFileEntry::IndexFlag:
+        if (m_data[index].reset_index_to == entry.m_value)
+            m_data[index].reset_index_to = 0;
+        break;
+
+    default:
+        break;
     }
 }
 
-void Disassembler::load_symbols(const char *fname, bool ram)
+unsigned int Disassembler::data_size(const DriverFileEntry& entry, const char** error)
 {
-    cerr << "; Reading symbols" << endl;
-    fstream in(fname);
-    string line;
-    while (getline(in, line)){
-        if (is_comment(line)) continue;
+    if (entry.m_size > 0 || !is_compressed_type(entry.m_value))
+        return entry.m_size;
+
+    unsigned int index = m_map->rom_index(full_address(entry.m_bank, entry.m_addr));
+    if (index >= m_data_size)
+        return 0;
+    vector<unsigned char> rom;
+    read_rom(index, m_data_size - index, &rom);
+    Decompressed block;
+    if (!decompress((CompressionFormat)entry.m_value, rom.data(), rom.size(), &block)){
+        if (error)
+            *error = block.m_error;
+        return 0;
+    }
+    return block.m_consumed;
+}
+
+string Disassembler::asset_name(unsigned int index) const
+{
+    return m_data[index].has_label() ? m_data[index].label() : "DATA_" + to_string(m_map->rom_address(index), 6);
+}
 
-        string label;
-        istringstream line_stream(line);
+string Disassembler::asset_filename(const string& name, const char* extension) const
+{
+    return (filesystem::path(m_asset_dir) / (name + extension)).generic_string();
+}
 
-        unsigned int addr;
-        unsigned char bank;
-        if (!get_raw_address(line_stream, &bank, &addr))
+void Disassembler::extract_assets(const string& directory)
+{
+    ScopedPhase timer(m_stats.get(), "extract assets");
+    Trace::Scope trace("assets", "extract");
+
+    m_asset_dir = directory;
+    m_range_cache.clear();
+    error_code error;
+    filesystem::create_directories(directory, error);
+    vector<unsigned char> rom;
+    read_rom(0, m_data_size, &rom);
+
+    Decompressed block;
+    vector<unsigned char> pixels;
+    size_t blocks = 0, compressed_bytes = 0, decompressed_bytes = 0, sheets = 0, tiles = 0;
+    for (unsigned int offset = 0; offset < rom.size();){
+        const SegmentIndex::Run* run = m_segments->find(offset);
+        if (!run)
+            break;
+        unsigned int run_end = min(run->m_end, (unsigned int)rom.size());
+        offset = run_end;
+        if (!is_compressed_type(run->m_type) && !is_tile_type(run->m_type))
             continue;
-        
-        if (addr < 0x8000 && bank != 0x7F) bank = 0x7e;
 
-        if(!(line_stream >> label)){
-            if (ram) label = "RAM_" + to_string(addr, 4);
-            else label = "CODE_" + to_string(bank, 2) + to_string(addr, 4);
-        }
+        for (unsigned int start = run->m_start; start < run_end;){
+            string name = asset_name(start);
+            *m_log << "; " << name << " " << to_string(m_map->rom_address(start), 6) << " ";
+
+            unsigned int size;
+            if (is_compressed_type(run->m_type)){
+                CompressionFormat format = (CompressionFormat)run->m_type;
+                *m_log << compression_format_name(format);
+                if (decompress(format, rom.data() + start, rom.size() - start, &block)){
+                    string filename = asset_filename(name, ".bin");
+                    ofstream out(filename, ios::binary);
+                    out.write((const char*)block.m_data.data(), block.m_data.size());
+                    if (!out)
+                        *m_log << " could not write " << filename << endl;
+                    else
+                        *m_log << " " << block.m_consumed << " -> " << block.m_data.size() << " bytes, "
+                            << block.m_commands << " commands, " << block.m_copied << " bytes copied" << endl;
+                    ++blocks;
+                    compressed_bytes += block.m_consumed;
+                    decompressed_bytes += block.m_data.size();
+                }
+                else{
+                    *m_log << " " << block.m_error << endl;
+                }
+                // padding or a bad block runs up to the next label
+                size = max(block.m_consumed, 1u);
+            }
+            else{
+                // the tiles from one label to the next, as they are and as a sheet
+                TileFormat format = (TileFormat)run->m_type;
+                size = 1;
+                while (start + size < run_end && !m_data[start + size].has_label())
+                    ++size;
+                size_t count = size / tile_bytes(format);
+                unsigned int width = TILES_PER_ROW * 8;
+                unsigned int height = (unsigned int)(count + TILES_PER_ROW - 1) / TILES_PER_ROW * 8;
+                pixels.assign((size_t)width * height, 0);
+                decode_tiles(format, rom.data() + start, count, pixels.data(), TILES_PER_ROW);
+
+                ofstream out(asset_filename(name, ".bin"), ios::binary);
+                out.write((const char*)rom.data() + start, size);
+                *m_log << tile_format_name(format);
+                if (!out || !write_pgm(asset_filename(name, ".pgm"), pixels.data(), width, height, format))
+                    *m_log << " could not write " << asset_filename(name, "");
+                else
+                    *m_log << " " << count << " tiles, " << width << "x" << height << " pixels";
+                if (size % tile_bytes(format))
+                    *m_log << ", " << size % tile_bytes(format) << " bytes past the last tile";
+                *m_log << endl;
+                ++sheets;
+                tiles += count;
+            }
 
-        add_label(bank, addr, label);
+            start += size;
+            while (start < run_end && !m_data[start].has_label())
+                ++start;
+        }
     }
-    cerr << "; Reading symbols... done." << endl;
-}
 
-void Disassembler::load_symbols2(const char *fname)
-{
-    cerr << "using method 2" << endl;
-    cerr << "; Reading symbols" << endl;
-    fstream in(fname);
-    unsigned int fulladdr;
-    while (get_full_address(in, &fulladdr)){
-        string label = "CODE_" + to_string(fulladdr, 6);
-        if (m_data[index_from_full_address(fulladdr)].label().empty())
-            m_data[index_from_full_address(fulladdr)].label(label);
-    }
-    cerr << "; Reading symbols... done." << endl;
+    *m_log << "; Extracted " << blocks << " compressed blocks, " << compressed_bytes << " -> " << decompressed_bytes
+        << " bytes, and " << sheets << " tile sheets, " << tiles << " tiles, to " << directory << endl;
 }
 
-void Disassembler::load_data_bank(const char *filename)
+void Disassembler::interpret()
 {
-    fstream in(filename);
-    string line;
-    while (getline(in, line)){
-        if (is_comment(line)) continue;
+    ScopedPhase timer(m_stats.get(), "interpret");
+    Trace::Scope trace("interpret", "load");
+    *m_log << "; Interpreting code" << endl;
+    double begin = Stats::wall_time();
+
+    vector<unsigned char> rom;
+    read_rom(0, m_data_size, &rom);
+    unsigned int size = (unsigned int)rom.size();
+
+    // from the vectors, then from what the traces saw that they don't
+    // lead to; nothing the data files type is walked into
+    Interpreter interpreter(*m_map, rom, *m_instruction_lookup, *m_segments);
+    interpreter.add_vectors();
+    for (unsigned int i = 0; i < size && i < m_coverage.size(); ++i){
+        if (!m_coverage.is_instruction_start(i))
+            continue;
+        bool widths = m_coverage.has_register_widths();
+        interpreter.add_entry(m_map->rom_address(i),
+            widths ? (m_coverage.is_accum_16(i) ? 16 : 8) : m_data[i].reset_accum_to,
+            widths ? (m_coverage.is_index_16(i) ? 16 : 8) : m_data[i].reset_index_to);
+    }
+    for (unsigned int offset = 0; offset < size;){
+        const SegmentIndex::Run* run = m_segments->find(offset);
+        if (!run)
+            break;
+        if (run->m_type != 0)
+            interpreter.block(run->m_start, run->m_end);
+        offset = run->m_end;
+    }
+    interpreter.run();
+    const Interpreter::Result& result = interpreter.result();
+
+    // Every instruction the walk reached is code.  A width is only kept
+    // where the walk saw one, and a reset only added where the listing
+    // would carry another: from the last instruction, through its REP or
+    // SEP, or from 8 bit at the start of a bank.  Resets and data banks
+    // the driver files give are left alone.
+    //
+    // The coverage only takes widths if it has them already, as then every
+    // start in it must have one; it then leaves out the starts where the
+    // walk didn't determine both, rather than record them as 8 bit.
+    bool widths = m_coverage.has_register_widths();
+    CoverageMap found;
+    found.reset(m_data_size, widths);
+    unsigned int bank_size = m_map->rom_bank_size();
+    unsigned int starts = 0, untraced = 0, accum_resets = 0, index_resets = 0, data_banks = 0;
+    int accum = 8, index = 8;
+    unsigned int expected = 0;
+    for (unsigned int i = 0; i < size; ++i){
+        if (i % bank_size == 0){
+            accum = index = 8;
+            expected = i;
+        }
+        unsigned char observed = result.m_observed[i];
+        if (!(observed & Interpreter::Start))
+            continue;
 
-        string label;
-        istringstream line_stream(line);
+        ++starts;
+        if (!m_coverage.is_instruction_start(i))
+            ++untraced;
+        unsigned char accum_seen = observed & (Interpreter::Accum8 | Interpreter::Accum16);
+        unsigned char index_seen = observed & (Interpreter::Index8 | Interpreter::Index16);
+        int new_accum = accum_seen == Interpreter::Accum16 ? 16 : accum_seen == Interpreter::Accum8 ? 8 : 0;
+        int new_index = index_seen == Interpreter::Index16 ? 16 : index_seen == Interpreter::Index8 ? 8 : 0;
+        if (!widths || (new_accum && new_index)){
+            found.mark_instruction_start(i);
+            found.mark_register_widths(i, new_accum == 16, new_index == 16);
+        }
 
-        unsigned char bank, end_bank;
-        unsigned int addr, end_addr;
-        int data_bank;
-        if (!get_data_address(line_stream, &bank, &addr) ||
-            !get_data_address(line_stream, &end_bank, &end_addr) ||
-            !(line_stream >> hex >> data_bank)){
-            cerr << "Couldn't read data bank line: " << line << endl;
-            continue;
+        ByteProperties& properties = m_data[i];
+        if (new_accum && (new_accum != accum || i != expected) && !properties.reset_accum_to){
+            properties.reset_accum_to = new_accum;
+            ++accum_resets;
+        }
+        if (new_index && (new_index != index || i != expected) && !properties.reset_index_to){
+            properties.reset_index_to = new_index;
+            ++index_resets;
+        }
+        accum = properties.reset_accum_to ? properties.reset_accum_to : new_accum;
+        index = properties.reset_index_to ? properties.reset_index_to : new_index;
+
+        const InstructionMetadata& instr = (*m_instruction_lookup)[rom[i]];
+        expected = i + instr.length(accum == 16, index == 16);
+        if ((instr.opcode() == 0xC2 || instr.opcode() == 0xE2) && i + 1 < size){
+            int width = instr.opcode() == 0xC2 ? 16 : 8;
+            if (rom[i + 1] & 0x20)
+                accum = width;
+            if (rom[i + 1] & 0x10)
+                index = width;
         }
 
-        unsigned int index = get_index(bank, addr);
-        unsigned int size = get_index(end_bank, end_addr) - index;
-        for (int i = 0; i < size; ++i){
-            m_data[index + i].data_bank(data_bank);
+        unsigned char program_bank = bank_from_addr24(m_map->rom_address(i));
+        if ((observed & (Interpreter::DataBank | Interpreter::DataBankConflict)) == Interpreter::DataBank &&
+            properties.data_bank() == program_bank && result.m_data_bank[i] != program_bank){
+            properties.data_bank(result.m_data_bank[i]);
+            ++data_banks;
         }
     }
+    m_coverage.merge(found);
+    m_range_cache.clear();
+
+    double seconds = Stats::wall_time() - begin;
+    *m_log << "; " << result.m_instructions << " instructions from " << result.m_entries << " entry points in "
+        << (int)(seconds * 1000) << " ms, " << (int)(result.m_instructions / max(seconds, 1e-6) / 1e6 * 10) / 10.0
+        << " million a second" << (result.m_exhausted ? ", stopped at the limit" : "") << endl;
+    *m_log << "; " << starts << " instruction starts, " << untraced << " not traced; "
+        << result.m_resolved << " indirect targets followed, " << result.m_unresolved << " not" << endl;
+    *m_log << "; paths stopped: " << result.m_unknown_width << " at an unknown width, " << result.m_truncated
+        << " at the state limit, " << result.m_into_data << " at data; " << result.m_assumed_returns
+        << " returns assumed" << endl;
+    *m_log << "; " << accum_resets << " accum and " << index_resets << " index flag resets, "
+        << data_banks << " data banks added" << endl;
+    *m_log << "; Interpreting code... done." << endl;
 }
 
-void Disassembler::load_data(const char *fname, bool is_ptr_data)
+bool Disassembler::load_accum_bytes(char *fname, bool accum)
 {
-    fstream in(fname);
-    string line;
-    while (getline(in, line)){
-        if (is_comment(line)) continue;
+    return load_driver_file(DriverFile::Flags, fname);
+}
 
-        string label;
-        istringstream line_stream(line);
+bool Disassembler::load_comments(const char* fname)
+{
+    return load_driver_file(DriverFile::Comments, fname);
+}
 
-        unsigned char bank, end_bank;
-        unsigned int addr, end_addr;
-        if(!get_data_address(line_stream, &bank, &addr))
-            continue;
-        if (!get_data_address(line_stream, &end_bank, &end_addr)){
-            end_addr = addr + 1;
-            end_bank = bank;            
-        }
+bool Disassembler::load_offsets(const char* fname)
+{
+    return load_driver_file(DriverFile::Offsets, fname);
+}
+
+bool Disassembler::load_symbols(const char *fname, bool ram)
+{
+    return load_driver_file(ram ? DriverFile::RamSymbols : DriverFile::Symbols, fname);
+}
 
-        unsigned int index = get_index(bank, addr);
-        unsigned int size = get_index(end_bank, end_addr) - index;
+bool Disassembler::load_symbols2(const char *fname)
+{
+    return load_driver_file(DriverFile::TraceSymbols, fname);
+}
 
-        if(size > 0x80000){
-            cerr << "Error in data: " << line << endl;
-            cerr << hex << size << " data bytes" << endl;
-            exit(-1);
-        }        
+bool Disassembler::load_registers(const char *filename)
+{
+    return load_driver_file(DriverFile::Registers, filename);
+}
 
-        if (m_data[index].type() != 0){
-            cerr << "Address " << to_string(bank,2) << to_string(addr,4) 
-                << " already flagged as data.  Type: " << int(m_data[index].type()) << endl;
-            continue;
-        }
+bool Disassembler::load_data_bank(const char *filename)
+{
+    return load_driver_file(DriverFile::DataBank, filename);
+}
+
+bool Disassembler::load_data(const char *fname, bool is_ptr_data)
+{
+    return load_driver_file(is_ptr_data ? DriverFile::Pointers : DriverFile::Data, fname);
+}
+
+bool Disassembler::apply_driver_file(const DriverFile& file)
+{
+    // parsing may have run concurrently, so only its wall time is known
+    size_t phase = 0;
+    if (m_stats){
+        string type = driver_file_type_name(file.m_type);
+        m_stats->add_time(m_stats->phase("parse " + type, false), file.m_parse_time, 0);
+        phase = m_stats->phase("apply " + type);
+    }
+    ScopedPhase timer(m_stats.get(), phase);
+    Trace::Scope trace(driver_file_type_name(file.m_type), "apply");
+
+    bool ok = true;
+    for (size_t e = 0; ok && e < file.m_entries.size(); ++e){
+        const DriverFileEntry& entry = file.m_entries[e];
+        // anything but a label is a property of a ROM byte; the rest land
+        // on the entry past the ROM, which is never read
+        unsigned int index = m_map->rom_index(full_address(entry.m_bank, entry.m_addr));
+
+        switch (entry.m_kind)
+        {
+        case DriverFileEntry::Message:
+            *m_log << entry.m_text << endl;
+            break;
 
-        int flag_byte = 1;
-        if (is_ptr_data){
-            if (!(line_stream >> flag_byte)){
-                cerr << "couldn't read pointer size in: " << line << endl;
-                exit(-1);
+        case DriverFileEntry::Fatal:
+            *m_log << entry.m_text << endl;
+            ok = false;
+            break;
+
+        case DriverFileEntry::Comment:
+            if (!m_data[index].comment().empty()){
+                *m_log << "failed to add comment >" << entry.m_text << "<" << endl;
+                break;
             }
-        }
+            m_data[index].comment(entry.m_text);
+            break;
 
-        for (int i = 0; i < size; ++i){
-            m_data[index + i].type(flag_byte);
-        }
+        case DriverFileEntry::Label:
+            add_label(entry.m_bank, entry.m_addr, entry.m_text);
+            break;
 
-        //no label, create one
-        if(!(line_stream >> label)){
-            string prefix = "DATA_";
-            if (flag_byte == 2) prefix = "Ptrs";
-            else if (flag_byte == 3) prefix = "PtrsLong";
-            label = prefix + to_string(bank,2) + to_string(addr,4);
-        }
+        case DriverFileEntry::Coverage:
+            m_coverage.merge(*file.m_coverage);
+            break;
 
-        add_label(bank, addr, label);
+        case DriverFileEntry::Data:
+            if (m_data[index].type() != 0){
+                *m_log << "Address " << to_string(entry.m_bank, 2) << to_string(entry.m_addr, 4)
+                    << " already flagged as data.  Type: " << int(m_data[index].type()) << endl;
+                break;
+            }
+            if (!entry.m_error.empty()){
+                *m_log << entry.m_error << endl;
+                ok = false;
+                break;
+            }
+            {
+                const char* error = 0;
+                unsigned int size = data_size(entry, &error);
+                if (error){
+                    *m_log << compression_format_name((CompressionFormat)entry.m_value) << " block at "
+                        << to_string(entry.m_bank, 2) << to_string(entry.m_addr, 4) << " " << error << endl;
+                }
+                for (unsigned int i = 0; i < size; ++i){
+                    m_data[index + i].type(entry.m_value);
+                }
+            }
+            add_label(entry.m_bank, entry.m_addr, entry.m_text);
+            break;
+
+        case DriverFileEntry::DataBank:
+            for (unsigned int i = 0; i < entry.m_size; ++i){
+                m_data[index + i].data_bank(entry.m_value);
+            }
+            break;
+
+        case DriverFileEntry::Offset:
+            if (m_data[index].load_offset() != 0){
+                *m_log << "failed to add load offset >" << entry.m_text << "<" << endl;
+                break;
+            }
+            m_data[index].load_offset(entry.m_value);
+            break;
+
+        case DriverFileEntry::AccumFlag:
+            m_data[index].reset_accum_to = entry.m_value;
+            break;
+
+        case DriverFileEntry::IndexFlag:
+            m_data[index].reset_index_to = entry.m_value;
+            break;
+
+        case DriverFileEntry::Register:
+            // the built in database is shared, so extend a copy
+            if (m_registers == RegisterDatabase::builtin())
+                m_registers = make_shared<RegisterDatabase>(*m_registers);
+            const_pointer_cast<RegisterDatabase>(m_registers)->add(entry.m_addr, entry.m_text);
+            break;
+        }
     }
+
+    if (file.m_type == DriverFile::Data || file.m_type == DriverFile::Pointers)
+        index_segments();
+    m_labels->sort();
+    return ok;
 }
 
 void Disassembler::load_instruction_names(const char* filename)
 {
-    cerr << "; Reading instruction names from " << filename << endl;
+    ScopedPhase timer(m_stats.get(), "load instruction names");
+    Trace::Scope trace("instruction names", "load");
+    *m_log << "; Reading instruction names from " << filename << endl;
     ifstream in(filename);
     m_instruction_name_provider.reset(new InstructionNameProvider(in));
-    cerr << "; Reading instrucions... done." << endl;
+    m_range_cache.clear();
+    *m_log << "; Reading instrucions... done." << endl;
+}
+
+void Disassembler::set_instruction_names(const shared_ptr<InstructionNameProvider>& names)
+{
+    m_instruction_name_provider = names;
+    m_range_cache.clear();
 }
 
 void Disassembler::set_output_format(const char* output_format)
 {
-    m_output_handler = CreateOutputHandler(output_format);
+    m_output_format = output_format;
+    m_output_handler = timed(CreateOutputHandler(m_output_format, *m_out));
+    m_range_cache.clear();
+}
+
+void Disassembler::collect_stats()
+{
+    m_stats = make_shared<Stats>();
+    m_out = &m_stats->counted(*m_out);
+    m_output_handler = timed(CreateOutputHandler(m_output_format, *m_out));
+}
+
+void Disassembler::memory_usage(MemoryUsage* usage) const
+{
+    size_t comments = 0, comment_bytes = 0, labels = 0, label_bytes = 0;
+    for (unsigned int i = 0; i < m_data_size; ++i){
+        const ByteProperties& p = m_data[i];
+        comments += p.has_comment();
+        comment_bytes += p.comment_bytes();
+        labels += p.has_label();
+        label_bytes += p.label_bytes();
+    }
+
+    // the byte properties are shared with --serve sessions, not copied
+    usage->add("byte properties", (m_data_size + 1) * sizeof(ByteProperties), m_data_size);
+    usage->add("comments", comment_bytes, comments);
+    usage->add("labels", label_bytes, labels);
+    usage->add("ram symbols", Memory::heap_bytes(m_ram_lookup), m_ram_lookup.size());
+    usage->add("label names", m_labels->size_in_bytes(), m_labels->size());
+    usage->add("registers", m_registers->size_in_bytes(), m_registers->size());
+    usage->add("used labels", Memory::heap_bytes(m_used_label_lookup), m_used_label_lookup.size());
+    usage->add("unresolved symbols", Memory::heap_bytes(m_unresolved_symbol_lookup), m_unresolved_symbol_lookup.size());
+    usage->add("segments", m_segments->size_in_bytes(), m_segments->size());
+    usage->add("coverage", m_coverage.size_in_bytes(), m_coverage.count());
+    usage->add("instruction table", m_instruction_lookup->capacity() * sizeof(InstructionMetadata), m_instruction_lookup->size());
+    usage->add("instruction names", m_instruction_name_provider ? m_instruction_name_provider->size_in_bytes() : 0);
+    usage->add("range cache", m_range_cache.size_in_bytes(), m_range_cache.entries());
+    usage->add("request arena", m_arena.size_in_bytes());
+    usage->add("rom image", m_timer ? m_timer->rom().capacity() : 0);
+}
+
+void Disassembler::trace_bank(int bank)
+{
+    if (bank == m_trace_bank && bank >= 0)
+        return;
+    if (m_trace_bank >= 0)
+        Trace::record("bank", "emit", m_trace_bank_begin, "bank", m_trace_bank);
+    m_trace_bank = bank;
+    m_trace_bank_begin = Trace::now();
+}
+
+shared_ptr<OutputHandler> Disassembler::timed(const shared_ptr<OutputHandler>& handler)
+{
+    if (!m_stats)
+        return handler;
+    return make_shared<TimedOutput>(handler, m_stats.get());
 }
 
 void Disassembler::set_annotation_format(const char* output_format)
 {
-    m_annotation_provider = CreateAnnotationProvider(output_format);
+    m_annotations = Annotations::dialect(output_format);
+    m_range_cache.clear();
 }
 
 bool Disassembler::add_label(int bank, int pc, const string& label)
 {
-    int index = get_index(bank, pc);
-    if (!m_data[index].label().empty()){
-        cerr << "failed to add symbol >" << label << "<" << endl;
+    MemoryMap::Location location = m_map->resolve(full_address(bank, pc));
+    bool added = in_rom(location) ?
+        !m_data[location.m_offset].has_label() : m_ram_lookup.try_emplace(location.m_canonical, label).second;
+    if (!added){
+        *m_log << "failed to add symbol >" << label << "<" << endl;
         return false;
     }
-    m_data[index].label(label);
+    if (in_rom(location))
+        m_data[location.m_offset].label(label);
+    m_labels->add(label, location.m_canonical);
+    m_range_cache.clear();
     return true;
 }
 
-void Disassembler::mark_label_used(int bank, int pc, const string& label)
+void Disassembler::remove_label(int bank, int pc, const string& label)
+{
+    MemoryMap::Location location = m_map->resolve(full_address(bank, pc));
+    if (in_rom(location)){
+        if (m_data[location.m_offset].label() != label)
+            return;
+        m_data[location.m_offset].label("");
+    }
+    else{
+        map<int, string>::iterator it = m_ram_lookup.find(location.m_canonical);
+        if (it == m_ram_lookup.end() || it->second != label)
+            return;
+        m_ram_lookup.erase(it);
+    }
+    m_labels->remove(label, location.m_canonical);
+}
+
+void Disassembler::find_labels(const string& pattern, vector<const LabelIndex::Entry*>* matches) const
+{
+    bool is_prefix = pattern[pattern.size() - 1] == '*';
+    m_labels->complete(is_prefix ? pattern.substr(0, pattern.size() - 1) : pattern, matches);
+    if (!is_prefix){
+        matches->erase(remove_if(matches->begin(), matches->end(),
+            [&](const LabelIndex::Entry* entry){ return entry->first != pattern; }), matches->end());
+    }
+}
+
+void Disassembler::mark_label_used(int bank, int pc, string_view label)
 {
     int full_addr = full_address(bank, pc);
-    m_used_label_lookup.insert(make_pair(full_addr, label));
+    m_used_label_lookup.try_emplace(full_addr, label);
+    if (m_recording)
+        m_recording->note_used(full_addr, label);
 }
 
-string Disassembler::get_instr_label(const InstructionMetadata& instr, unsigned char bank, int pc, int offset)
+string_view Disassembler::get_instr_label(const InstructionMetadata& instr, unsigned char bank, int pc, int offset)
 {
     //todo:remove
     //if (!instr.isBranch() && !instr.isJump() && !instr.isCall()) return "";
 
-    if (pc < 0x8000 && bank != 0x7f) bank = 0x7e;
-
     pc -= offset;
     bool is_branch = instr.isBranch();
 
-    string label = get_label_helper(full_address(bank, pc), true, true, is_branch);
+    // a ROM label named through a FastROM mirror would reassemble to the
+    // other bank, so such operands stay numbers
+    unsigned int address = full_address(bank, pc);
+    if (m_map->is_rom(address) && bank_from_addr24(m_map->canonical(address)) != bank)
+        return "";
+
+    string_view label = get_label_helper(address, true, true, is_branch);
 
-    if (offset != 0){
-        stringstream ss;
-        ss << label;
-        if (offset > 0){
-            ss << "+";
-        }
-        ss << offset;
-        label = ss.str();
-    }
+    if (offset != 0)
+        label = m_arena.join({ label, offset > 0 ? "+" : "", std::to_string(offset) });
     return label;
 }
 
-string Disassembler::get_line_label(bool use_addr_label)
+string_view Disassembler::get_line_label(bool use_addr_label)
 {
     return get_label_helper(m_state.get_current_address(), use_addr_label, false, false);
 }
 
-string Disassembler::get_label_helper(unsigned int key, bool use_addr_label, bool mark_instruction_used, bool is_branch)
+string_view Disassembler::get_label_helper(unsigned int address, bool use_addr_label, bool mark_instruction_used, bool is_branch)
 {
+    MemoryMap::Location location = m_map->resolve(address);
+    unsigned int key = location.m_canonical;
     unsigned char bank = bank_from_addr24(key);
     unsigned int pc = addr16_from_addr24(key);
 
     // does the symbol lie outside of the range we are disassembling?
     bool is_extern = (key < m_start || key > m_end);
-    if(is_extern && !m_range_properties.m_use_extern_symbols)
+    if(is_extern && !m_range_properties.m_use_extern_symbols){
+        if (m_stats)
+            m_stats->count(Stats::ExternSkipped);
         return "";
+    }
+    if (is_extern && m_extern_labels)
+        m_extern_labels->push_back(key);
 
-    string label;
+    string_view label;
     if (m_current_pass == 2){
         map<int, string>::iterator it = m_used_label_lookup.find(key);
         if (it != m_used_label_lookup.end())
             label = it->second;
+        if (m_stats)
+            m_stats->lookup(Stats::UsedLabels, !label.empty());
     }
     else{
-        label = m_data[index_from_full_address(key)].label();
+        if (in_rom(location)){
+            label = m_data[location.m_offset].label();
+            if (m_stats)
+                m_stats->lookup(Stats::Symbols, !label.empty());
+            if (label.empty()){
+                if (m_coverage.is_instruction_start(location.m_offset))
+                    label = m_arena.join({ "CODE_", to_string(key, 6) });
+                if (m_stats)
+                    m_stats->lookup(Stats::Coverage, !label.empty());
+            }
+        }
+        else{
+            map<int, string>::iterator it2 = m_ram_lookup.find(key);
+            if (it2 != m_ram_lookup.end())
+                label = it2->second;
+            if (m_stats)
+                m_stats->lookup(Stats::RamSymbols, !label.empty());
+        }
+
         if (!label.empty()){
             mark_label_used(bank, pc, label); // always include user-provided labels
         }
 
-        else if (((pc >= 0x8000 && use_addr_label) ||
-            (pc < 0x8000 && is_branch) ) && bank < 0x7E){
-                label = "ADDR_" + to_string(bank, 2) + /*"_" +*/ to_string(pc, 4);
+        else if ((use_addr_label || is_branch) && in_rom(location)){
+                label = m_arena.join({ "ADDR_", to_string(bank, 2), /*"_",*/ to_string(pc, 4) });
                 if (mark_instruction_used)
                     mark_label_used(bank, pc, label);
+                if (m_stats)
+                    m_stats->count(Stats::GeneratedLabels);
             }
-        
-        else if(pc < 0x8000){
-            map<int, string>::iterator it2 = m_ram_lookup.find(key);
-            if (it2 != m_ram_lookup.end())
-                label = it2->second;
-        }
     }
     
-    if (label.size() > 0 && finalPass() && is_extern)
-        m_unresolved_symbol_lookup.insert(make_pair(key, label));
+    if (label.size() > 0 && finalPass() && is_extern){
+        if (m_unresolved_symbol_lookup.try_emplace(key, label).second && m_stats)
+            m_stats->count(Stats::ExternSymbols);
+    }
+
+    if (m_recording && !label.empty())
+        m_recording->note_label(key, label);
 
     return label;
 }
@@ -550,62 +1560,63 @@ void Disassembler::doSmart()
 
     unsigned int end_full_address = m_range_properties.full_end_address();
 
-    for (int i = get_index(bank, pc); i >= 0 && i < MAX_FILE_SIZE &&
-        full_address(bank, pc) < end_full_address;){
+    Request request(m_range_properties);
+    int type = -1;
+    while (full_address(bank, pc) < end_full_address){
+        // runs are by file offset, which needn't follow on from one bank
+        // to the next, so they are taken a bank at a time
+        const SegmentIndex::Run* run = m_segments->find(m_map->rom_index(full_address(bank, pc)));
+        if (!run)
+            break;
 
-            Request request(m_range_properties);
+        if (run->m_type != type){
+            if (type >= 0){
+                request.m_properties.m_end_bank = bank;
+                request.m_properties.m_end_addr = pc;
+                disassembleRange(request);
+            }
+            type = run->m_type;
+            request.m_type = type == 1 || is_compressed_type(type) ? Request::Dcb : type == 2 ? Request::Ptr :
+                type == 3 ? Request::PtrLong : is_tile_type(type) ? (m_asset_dir.empty() ? Request::Dcb : Request::Incbin) :
+                Request::Asm;
             request.m_properties.m_start_bank = bank;
             request.m_properties.m_start_addr = pc;
- 
-            if (m_data[i].type() == 1){
-                request.m_type = Request::Dcb;
-                do{
-                    ++i;
-                    increment_address(&bank, &pc, m_hirom);
-                } while ((m_data[i].type() == 1) && (full_address(bank, pc) < end_full_address));
-            }
-            else if (m_data[i].type() == 2){
-                request.m_type = Request::Ptr;
-                do{
-                    ++i;
-                    increment_address(&bank, &pc, m_hirom);
-                } while ((m_data[i].type() == 2) && (full_address(bank, pc) < end_full_address));
-            }
-            else if (m_data[i].type() == 3){
-                request.m_type = Request::PtrLong;
-                do{
-                    ++i;
-                    increment_address(&bank, &pc, m_hirom);
-                } while ((m_data[i].type() == 3) && (full_address(bank, pc) < end_full_address));
-            }
-            else{
-                request.m_type = Request::Asm;
-                do{
-                    ++i;
-                    increment_address(&bank, &pc, m_hirom);
-                } while ((m_data[i].type() == 0) && (full_address(bank, pc) < end_full_address));
-            }
+        }
 
-            request.m_properties.m_end_bank = bank;
-            request.m_properties.m_end_addr = pc;
-            disassembleRange(request);
+        unsigned int length = run->m_end - m_map->rom_index(full_address(bank, pc));
+        length = min(length, 0x10000 - pc);
+        length = min(length, end_full_address - full_address(bank, pc));
+        pc += length;
+        if (pc > 0xFFFF){
+            ++bank;
+            pc = m_map->bank_start(bank);
         }
+    }
+
+    if (type >= 0){
+        request.m_properties.m_end_bank = bank;
+        request.m_properties.m_end_addr = pc;
+        disassembleRange(request);
+    }
 }
 
 void Disassembler::doDcb(int bytes_per_line)
 {
+    ScopedPhase timer(m_stats.get(), "data segments");
+    Trace::Scope trace("data", "segment", "address", m_state.get_current_address());
     output_handler()->DataBlockStart();
 
     unsigned int end_full_address = m_range_properties.full_end_address();
 
+    vector<unsigned char> bytes;
     while (m_state.get_current_address() < end_full_address){
-        vector<unsigned char> bytes;
-        string comment;
-        string label;
+        bytes.clear();
+        string_view comment;
+        string_view label;
         bool end_of_chunk = false;
 
         for (int j = 0; j < bytes_per_line && m_state.get_current_address() < end_full_address; ++j){
-            string current_label = get_line_label(false);
+            string_view current_label = get_line_label(false);
             if (!current_label.empty()){
                 if (j == 0){
                     label = current_label;
@@ -616,18 +1627,20 @@ void Disassembler::doDcb(int bytes_per_line)
                 }
             }
 
-            string current_comment = get_comment();
+            string_view current_comment = get_comment();
             if (!current_comment.empty()) {
                 if (comment.empty()){
                     comment = current_comment;
                 }
                 else{
-                    comment += (" ; " + current_comment);
+                    comment = m_arena.join({ comment, " ; ", current_comment });
                 }
             }
 
             if (m_state.is_bank_start()){
                 output_handler()->BankStart(m_state.get_current_bank());
+                if (Trace::enabled())
+                    trace_bank(m_state.get_current_bank());
             }
 
             unsigned char c = read_next_byte();
@@ -639,6 +1652,55 @@ void Disassembler::doDcb(int bytes_per_line)
         }
 
         output_handler()->PrintData(bytes, label, comment, !m_range_properties.m_quiet, end_of_chunk);
+        if (m_stats)
+            m_stats->count(Stats::DataBytes, bytes.size());
+    }
+
+    output_handler()->DataBlockEnd();
+}
+
+void Disassembler::doIncbin()
+{
+    ScopedPhase timer(m_stats.get(), "data segments");
+    Trace::Scope trace("incbin", "segment", "address", m_state.get_current_address());
+    output_handler()->DataBlockStart();
+
+    unsigned int end_full_address = m_range_properties.full_end_address();
+    while (m_state.get_current_address() < end_full_address){
+        if (m_state.is_bank_start()){
+            output_handler()->BankStart(m_state.get_current_bank());
+            if (Trace::enabled())
+                trace_bank(m_state.get_current_bank());
+        }
+
+        // the file extract_assets wrote for the tiles from the label at or
+        // before here; a line ends at the next label or bank
+        unsigned int index = m_state.get_current_index();
+        const SegmentIndex::Run* run = m_segments->find(index);
+        unsigned int start = index;
+        while (start > run->m_start && !m_data[start].has_label())
+            --start;
+        unsigned int end = index + 1;
+        while (end < run->m_end && !m_data[end].has_label())
+            ++end;
+
+        string_view label = get_line_label(false);
+        string_view comment;
+        unsigned int length = 0;
+        do{
+            string_view current_comment = get_comment();
+            if (!current_comment.empty())
+                comment = comment.empty() ? current_comment : m_arena.join({ comment, " ; ", current_comment });
+            read_next_byte();
+            ++length;
+        } while (m_state.get_current_address() < end_full_address && !m_state.is_bank_start() &&
+            m_state.get_current_index() < end && m_state.get_current_index() == index + length);
+
+        string filename = asset_filename(asset_name(start), ".bin");
+        output_handler()->PrintIncbin(filename, index - start, index + length == end ? 0 : length, label, comment,
+            !m_range_properties.m_quiet);
+        if (m_stats)
+            m_stats->count(Stats::DataBytes, length);
     }
 
     output_handler()->DataBlockEnd();
@@ -646,6 +1708,17 @@ void Disassembler::doDcb(int bytes_per_line)
 
 void Disassembler::doPtr(bool long_ptrs)
 {
+    if (m_annotations == Annotations::Smas)
+        disassemblePointers<SmasAnnotations>(long_ptrs);
+    else
+        disassemblePointers<DefaultAnnotations>(long_ptrs);
+}
+
+template<class Dialect>
+void Disassembler::disassemblePointers(bool long_ptrs)
+{
+    ScopedPhase timer(m_stats.get(), long_ptrs ? "long pointer segments" : "pointer segments");
+    Trace::Scope trace(long_ptrs ? "long pointers" : "pointers", "segment", "address", m_state.get_current_address());
     output_handler()->PtrBlockStart();
 
     unsigned int end_full_address = m_range_properties.full_end_address();
@@ -654,14 +1727,18 @@ void Disassembler::doPtr(bool long_ptrs)
 
         if (m_state.is_bank_start()){
             output_handler()->BankStart(m_state.get_current_bank());
+            if (Trace::enabled())
+                trace_bank(m_state.get_current_bank());
         }
 
-        string label = get_line_label(false);
-        string comment = get_comment();
+        string_view label = get_line_label(false);
+        string_view comment = get_comment();
         int data_bank = get_data_bank();
         setProcessFlags();
 
-        disassembleInstruction(m_instruction_lookup[long_ptrs ? 0x101 : 0x100], label, comment, 0, data_bank);
+        disassembleInstruction<Dialect>((*m_instruction_lookup)[long_ptrs ? 0x101 : 0x100], label, comment, 0, data_bank, m_state.get_current_address());
+        if (m_stats)
+            m_stats->count(Stats::Pointers);
     }
 
     output_handler()->PtrBlockEnd();
@@ -669,29 +1746,46 @@ void Disassembler::doPtr(bool long_ptrs)
 
 void Disassembler::doDisasm()
 {
+    if (m_annotations == Annotations::Smas)
+        disassembleCode<SmasAnnotations>();
+    else
+        disassembleCode<DefaultAnnotations>();
+}
+
+template<class Dialect>
+void Disassembler::disassembleCode()
+{
+    ScopedPhase timer(m_stats.get(), "code segments");
+    Trace::Scope trace("code", "segment", "address", m_state.get_current_address());
     output_handler()->CodeBlockStart();
     unsigned int end_full_address = m_range_properties.full_end_address();
+    m_state.forget_values();
 
     while (m_state.get_current_address() < end_full_address){
 
         if (m_state.is_bank_start()){
             output_handler()->BankStart(m_state.get_current_bank());
+            if (Trace::enabled())
+                trace_bank(m_state.get_current_bank());
         }
 
-        string label = get_line_label(true); //todo: make function
-        string comment = get_comment();
+        string_view label = get_line_label(true); //todo: make function
+        string_view comment = get_comment();
         int offset = get_offset();
         int data_bank = get_data_bank();
         setProcessFlags();
 
+        unsigned int address = m_state.get_current_address();
         unsigned char code = read_next_byte();
         if (feof(m_rom_file)){
-            cout << "; End of file." << endl;
+            *m_out << "; End of file." << endl;
             break;
         }
 
-        InstructionMetadata instr = m_instruction_lookup[code];
-        disassembleInstruction(instr, label, comment, offset, data_bank);
+        const InstructionMetadata& instr = (*m_instruction_lookup)[code];
+        disassembleInstruction<Dialect>(instr, label, comment, offset, data_bank, address);
+        if (m_stats)
+            m_stats->count(Stats::Instructions);
         if (m_range_properties.m_stop_at_rts && instr.isReturn()){
             break;
         }
@@ -699,276 +1793,299 @@ void Disassembler::doDisasm()
     output_handler()->CodeBlockEnd();
 }
 
-void Disassembler::disassembleInstruction(const InstructionMetadata& instr, const string& label, const string& comment, int offset, int data_bank)
+template<class Dialect>
+void Disassembler::disassembleInstruction(const InstructionMetadata& instr, string_view label, string_view comment, int offset, int data_bank, unsigned int address)
 {
     DisassemblerContext context((Disassembler*)this, instr, &m_state, &m_flag, data_bank, offset);
-    Instruction output(instr, m_instruction_name_provider, m_annotation_provider, m_state, m_range_properties.m_comment_level);
+    Instruction output(instr, m_instruction_name_provider, m_state, m_range_properties.m_comment_level, &m_arena);
+
+    if (!keeps_known_values(instr.opcode()))
+        m_state.forget_values();
 
     auto instruction_handler = instr.handler();
     instruction_handler(&context, &output);
+    output.setAnnotation(Dialect::get_annotation(instr.opcode(), output.initialAccum16(), output.initialIndex16(), output.isAddressSymbolic()));
+
+    // a conditional branch from not taken to taken
+    if (m_cycles && finalPass() && instr.is_snes_instruction()){
+        CycleCost cost = m_timer->cost(address, output.initialAccum16(), output.initialIndex16(), (unsigned char)data_bank);
+        if ((instr.opcode() & 0x1F) == 0x10){
+            cost.m_max_cycles += CycleTimer::taken().m_max_cycles;
+            cost.m_max_clocks += CycleTimer::taken().m_max_clocks;
+        }
+        output.set_cycles(m_arena.copy(cost.text()));
+    }
 
     output_handler()->PrintInstruction(output, label, comment, !m_range_properties.m_quiet, m_flag);
 }
 
-void Disassembler::initialize_instruction_lookup()
-{
-    m_instruction_lookup.insert(make_pair(0x69, InstructionMetadata("ADC", 0x69, &InstructionHandler::Immediate)));
-    m_instruction_lookup.insert(make_pair(0x6D, InstructionMetadata("ADC", 0x6D, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0x6F, InstructionMetadata("ADC", 0x6F, &InstructionHandler::AbsoluteLong)));
-    m_instruction_lookup.insert(make_pair(0x65, InstructionMetadata("ADC", 0x65, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0x71, InstructionMetadata("ADC", 0x71, &InstructionHandler::DPIndirectIndexedY)));
-    m_instruction_lookup.insert(make_pair(0x77, InstructionMetadata("ADC", 0x77, &InstructionHandler::DPIndirectLongIndexedY)));
-    m_instruction_lookup.insert(make_pair(0x61, InstructionMetadata("ADC", 0x61, &InstructionHandler::DPIndexedIndirectX)));
-    m_instruction_lookup.insert(make_pair(0x75, InstructionMetadata("ADC", 0x75, &InstructionHandler::DPIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x7D, InstructionMetadata("ADC", 0x7D, &InstructionHandler::AbsoluteIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x7F, InstructionMetadata("ADC", 0x7F, &InstructionHandler::AbsoluteLongIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x79, InstructionMetadata("ADC", 0x79, &InstructionHandler::AbsoluteIndexedY)));
-    m_instruction_lookup.insert(make_pair(0x72, InstructionMetadata("ADC", 0x72, &InstructionHandler::DPIndirect)));
-    m_instruction_lookup.insert(make_pair(0x67, InstructionMetadata("ADC", 0x67, &InstructionHandler::DPIndirectLong)));
-    m_instruction_lookup.insert(make_pair(0x63, InstructionMetadata("ADC", 0x63, &InstructionHandler::StackRelative)));
-    m_instruction_lookup.insert(make_pair(0x73, InstructionMetadata("ADC", 0x73, &InstructionHandler::SRIndirectIndexedY)));
-    m_instruction_lookup.insert(make_pair(0x29, InstructionMetadata("AND", 0x29, &InstructionHandler::Immediate)));
-    m_instruction_lookup.insert(make_pair(0x2D, InstructionMetadata("AND", 0x2D, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0x2F, InstructionMetadata("AND", 0x2F, &InstructionHandler::AbsoluteLong)));
-    m_instruction_lookup.insert(make_pair(0x25, InstructionMetadata("AND", 0x25, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0x31, InstructionMetadata("AND", 0x31, &InstructionHandler::DPIndirectIndexedY)));
-    m_instruction_lookup.insert(make_pair(0x37, InstructionMetadata("AND", 0x37, &InstructionHandler::DPIndirectLongIndexedY)));
-    m_instruction_lookup.insert(make_pair(0x21, InstructionMetadata("AND", 0x21, &InstructionHandler::DPIndexedIndirectX)));
-    m_instruction_lookup.insert(make_pair(0x35, InstructionMetadata("AND", 0x35, &InstructionHandler::DPIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x3D, InstructionMetadata("AND", 0x3D, &InstructionHandler::AbsoluteIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x3F, InstructionMetadata("AND", 0x3F, &InstructionHandler::AbsoluteLongIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x39, InstructionMetadata("AND", 0x39, &InstructionHandler::AbsoluteIndexedY)));
-    m_instruction_lookup.insert(make_pair(0x32, InstructionMetadata("AND", 0x32, &InstructionHandler::DPIndirect)));
-    m_instruction_lookup.insert(make_pair(0x27, InstructionMetadata("AND", 0x27, &InstructionHandler::DPIndirectLong)));
-    m_instruction_lookup.insert(make_pair(0x23, InstructionMetadata("AND", 0x23, &InstructionHandler::StackRelative)));
-    m_instruction_lookup.insert(make_pair(0x33, InstructionMetadata("AND", 0x33, &InstructionHandler::SRIndirectIndexedY)));
-    m_instruction_lookup.insert(make_pair(0x0E, InstructionMetadata("ASL", 0x0E, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0x06, InstructionMetadata("ASL", 0x06, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0x0A, InstructionMetadata("ASL", 0x0A, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x16, InstructionMetadata("ASL", 0x16, &InstructionHandler::DPIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x1E, InstructionMetadata("ASL", 0x1E, &InstructionHandler::AbsoluteIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x90, InstructionMetadata("BCC", 0x90, &InstructionHandler::ProgramCounterRelative)));
-    m_instruction_lookup.insert(make_pair(0xB0, InstructionMetadata("BCS", 0xB0, &InstructionHandler::ProgramCounterRelative)));
-    m_instruction_lookup.insert(make_pair(0xF0, InstructionMetadata("BEQ", 0xF0, &InstructionHandler::ProgramCounterRelative)));
-    m_instruction_lookup.insert(make_pair(0x30, InstructionMetadata("BMI", 0x30, &InstructionHandler::ProgramCounterRelative)));
-    m_instruction_lookup.insert(make_pair(0xD0, InstructionMetadata("BNE", 0xD0, &InstructionHandler::ProgramCounterRelative)));
-    m_instruction_lookup.insert(make_pair(0x10, InstructionMetadata("BPL", 0x10, &InstructionHandler::ProgramCounterRelative)));
-    m_instruction_lookup.insert(make_pair(0x80, InstructionMetadata("BRA", 0x80, &InstructionHandler::ProgramCounterRelative)));
-    m_instruction_lookup.insert(make_pair(0x82, InstructionMetadata("BRL", 0x82, &InstructionHandler::ProgramCounterRelativeLong)));
-    m_instruction_lookup.insert(make_pair(0x50, InstructionMetadata("BVC", 0x50, &InstructionHandler::ProgramCounterRelative)));
-    m_instruction_lookup.insert(make_pair(0x70, InstructionMetadata("BVS", 0x70, &InstructionHandler::ProgramCounterRelative)));
-    m_instruction_lookup.insert(make_pair(0x89, InstructionMetadata("BIT", 0x89, &InstructionHandler::Immediate)));
-    m_instruction_lookup.insert(make_pair(0x2C, InstructionMetadata("BIT", 0x2C, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0x24, InstructionMetadata("BIT", 0x24, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0x34, InstructionMetadata("BIT", 0x34, &InstructionHandler::DPIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x3C, InstructionMetadata("BIT", 0x3C, &InstructionHandler::AbsoluteIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x00, InstructionMetadata("BRK", 0x00, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x18, InstructionMetadata("CLC", 0x18, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0xD8, InstructionMetadata("CLD", 0xD8, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x58, InstructionMetadata("CLI", 0x58, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0xB8, InstructionMetadata("CLV", 0xB8, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0xC9, InstructionMetadata("CMP", 0xC9, &InstructionHandler::Immediate)));
-    m_instruction_lookup.insert(make_pair(0xCD, InstructionMetadata("CMP", 0xCD, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0xCF, InstructionMetadata("CMP", 0xCF, &InstructionHandler::AbsoluteLong)));
-    m_instruction_lookup.insert(make_pair(0xC5, InstructionMetadata("CMP", 0xC5, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0xD1, InstructionMetadata("CMP", 0xD1, &InstructionHandler::DPIndirectIndexedY)));
-    m_instruction_lookup.insert(make_pair(0xD7, InstructionMetadata("CMP", 0xD7, &InstructionHandler::DPIndirectLongIndexedY)));
-    m_instruction_lookup.insert(make_pair(0xC1, InstructionMetadata("CMP", 0xC1, &InstructionHandler::DPIndexedIndirectX)));
-    m_instruction_lookup.insert(make_pair(0xD5, InstructionMetadata("CMP", 0xD5, &InstructionHandler::DPIndexedX)));
-    m_instruction_lookup.insert(make_pair(0xDD, InstructionMetadata("CMP", 0xDD, &InstructionHandler::AbsoluteIndexedX)));
-    m_instruction_lookup.insert(make_pair(0xDF, InstructionMetadata("CMP", 0xDF, &InstructionHandler::AbsoluteLongIndexedX)));
-    m_instruction_lookup.insert(make_pair(0xD9, InstructionMetadata("CMP", 0xD9, &InstructionHandler::AbsoluteIndexedY)));
-    m_instruction_lookup.insert(make_pair(0xD2, InstructionMetadata("CMP", 0xD2, &InstructionHandler::DPIndirect)));
-    m_instruction_lookup.insert(make_pair(0xC7, InstructionMetadata("CMP", 0xC7, &InstructionHandler::DPIndirectLong)));
-    m_instruction_lookup.insert(make_pair(0xC3, InstructionMetadata("CMP", 0xC3, &InstructionHandler::StackRelative)));
-    m_instruction_lookup.insert(make_pair(0xD3, InstructionMetadata("CMP", 0xD3, &InstructionHandler::SRIndirectIndexedY)));
-    m_instruction_lookup.insert(make_pair(0xE0, InstructionMetadata("CPX", 0xE0, &InstructionHandler::ImmediateXY)));
-    m_instruction_lookup.insert(make_pair(0xEC, InstructionMetadata("CPX", 0xEC, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0xE4, InstructionMetadata("CPX", 0xE4, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0xC0, InstructionMetadata("CPY", 0xC0, &InstructionHandler::ImmediateXY)));
-    m_instruction_lookup.insert(make_pair(0xCC, InstructionMetadata("CPY", 0xCC, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0xC4, InstructionMetadata("CPY", 0xC4, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0xCE, InstructionMetadata("DEC", 0xCE, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0xC6, InstructionMetadata("DEC", 0xC6, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0x3A, InstructionMetadata("DEC", 0x3A, &InstructionHandler::Accumulator)));
-    m_instruction_lookup.insert(make_pair(0xD6, InstructionMetadata("DEC", 0xD6, &InstructionHandler::DPIndexedX)));
-    m_instruction_lookup.insert(make_pair(0xDE, InstructionMetadata("DEC", 0xDE, &InstructionHandler::AbsoluteIndexedX)));
-    m_instruction_lookup.insert(make_pair(0xCA, InstructionMetadata("DEX", 0xCA, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x88, InstructionMetadata("DEY", 0x88, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x49, InstructionMetadata("EOR", 0x49, &InstructionHandler::Immediate)));
-    m_instruction_lookup.insert(make_pair(0x4D, InstructionMetadata("EOR", 0x4D, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0x4F, InstructionMetadata("EOR", 0x4F, &InstructionHandler::AbsoluteLong)));
-    m_instruction_lookup.insert(make_pair(0x45, InstructionMetadata("EOR", 0x45, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0x51, InstructionMetadata("EOR", 0x51, &InstructionHandler::DPIndirectIndexedY)));
-    m_instruction_lookup.insert(make_pair(0x57, InstructionMetadata("EOR", 0x57, &InstructionHandler::DPIndirectLongIndexedY)));
-    m_instruction_lookup.insert(make_pair(0x41, InstructionMetadata("EOR", 0x41, &InstructionHandler::DPIndexedIndirectX)));
-    m_instruction_lookup.insert(make_pair(0x55, InstructionMetadata("EOR", 0x55, &InstructionHandler::DPIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x5D, InstructionMetadata("EOR", 0x5D, &InstructionHandler::AbsoluteIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x5F, InstructionMetadata("EOR", 0x5F, &InstructionHandler::AbsoluteLongIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x59, InstructionMetadata("EOR", 0x59, &InstructionHandler::AbsoluteIndexedY)));
-    m_instruction_lookup.insert(make_pair(0x52, InstructionMetadata("EOR", 0x52, &InstructionHandler::DPIndirect)));
-    m_instruction_lookup.insert(make_pair(0x47, InstructionMetadata("EOR", 0x47, &InstructionHandler::DPIndirectLong)));
-    m_instruction_lookup.insert(make_pair(0x43, InstructionMetadata("EOR", 0x43, &InstructionHandler::StackRelative)));
-    m_instruction_lookup.insert(make_pair(0x53, InstructionMetadata("EOR", 0x53, &InstructionHandler::SRIndirectIndexedY)));
-    m_instruction_lookup.insert(make_pair(0xEE, InstructionMetadata("INC", 0xEE, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0xE6, InstructionMetadata("INC", 0xE6, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0x1A, InstructionMetadata("INC", 0x1A, &InstructionHandler::Accumulator)));
-    m_instruction_lookup.insert(make_pair(0xF6, InstructionMetadata("INC", 0xF6, &InstructionHandler::DPIndexedX)));
-    m_instruction_lookup.insert(make_pair(0xFE, InstructionMetadata("INC", 0xFE, &InstructionHandler::AbsoluteIndexedX)));
-    m_instruction_lookup.insert(make_pair(0xE8, InstructionMetadata("INX", 0xE8, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0xC8, InstructionMetadata("INY", 0xC8, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x5C, InstructionMetadata("JMP", 0x5C, &InstructionHandler::AbsoluteLong)));
-    m_instruction_lookup.insert(make_pair(0xDC, InstructionMetadata("JMP", 0xDC, &InstructionHandler::AbsoluteIndirectLong)));
-    m_instruction_lookup.insert(make_pair(0x4C, InstructionMetadata("JMP", 0x4C, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0x6C, InstructionMetadata("JMP", 0x6C, &InstructionHandler::AbsoluteIndirect)));
-    m_instruction_lookup.insert(make_pair(0x7C, InstructionMetadata("JMP", 0x7C, &InstructionHandler::AbsoluteIndexedIndirect)));
-    m_instruction_lookup.insert(make_pair(0x22, InstructionMetadata("JSL", 0x22, &InstructionHandler::AbsoluteLong)));
-    m_instruction_lookup.insert(make_pair(0x20, InstructionMetadata("JSR", 0x20, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0xFC, InstructionMetadata("JSR", 0xFC, &InstructionHandler::AbsoluteIndexedIndirect)));
-    m_instruction_lookup.insert(make_pair(0xA9, InstructionMetadata("LDA", 0xA9, &InstructionHandler::Immediate)));
-    m_instruction_lookup.insert(make_pair(0xAD, InstructionMetadata("LDA", 0xAD, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0xAF, InstructionMetadata("LDA", 0xAF, &InstructionHandler::AbsoluteLong)));
-    m_instruction_lookup.insert(make_pair(0xA5, InstructionMetadata("LDA", 0xA5, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0xB1, InstructionMetadata("LDA", 0xB1, &InstructionHandler::DPIndirectIndexedY)));
-    m_instruction_lookup.insert(make_pair(0xB7, InstructionMetadata("LDA", 0xB7, &InstructionHandler::DPIndirectLongIndexedY)));
-    m_instruction_lookup.insert(make_pair(0xA1, InstructionMetadata("LDA", 0xA1, &InstructionHandler::DPIndexedIndirectX)));
-    m_instruction_lookup.insert(make_pair(0xB5, InstructionMetadata("LDA", 0xB5, &InstructionHandler::DPIndexedX)));
-    m_instruction_lookup.insert(make_pair(0xBD, InstructionMetadata("LDA", 0xBD, &InstructionHandler::AbsoluteIndexedX)));
-    m_instruction_lookup.insert(make_pair(0xBF, InstructionMetadata("LDA", 0xBF, &InstructionHandler::AbsoluteLongIndexedX)));
-    m_instruction_lookup.insert(make_pair(0xB9, InstructionMetadata("LDA", 0xB9, &InstructionHandler::AbsoluteIndexedY)));
-    m_instruction_lookup.insert(make_pair(0xB2, InstructionMetadata("LDA", 0xB2, &InstructionHandler::DPIndirect)));
-    m_instruction_lookup.insert(make_pair(0xA7, InstructionMetadata("LDA", 0xA7, &InstructionHandler::DPIndirectLong)));
-    m_instruction_lookup.insert(make_pair(0xA3, InstructionMetadata("LDA", 0xA3, &InstructionHandler::StackRelative)));
-    m_instruction_lookup.insert(make_pair(0xB3, InstructionMetadata("LDA", 0xB3, &InstructionHandler::SRIndirectIndexedY)));
-    m_instruction_lookup.insert(make_pair(0xA2, InstructionMetadata("LDX", 0xA2, &InstructionHandler::ImmediateXY)));
-    m_instruction_lookup.insert(make_pair(0xAE, InstructionMetadata("LDX", 0xAE, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0xA6, InstructionMetadata("LDX", 0xA6, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0xB6, InstructionMetadata("LDX", 0xB6, &InstructionHandler::DPIndexedY)));
-    m_instruction_lookup.insert(make_pair(0xBE, InstructionMetadata("LDX", 0xBE, &InstructionHandler::AbsoluteIndexedY)));
-    m_instruction_lookup.insert(make_pair(0xA0, InstructionMetadata("LDY", 0xA0, &InstructionHandler::ImmediateXY)));
-    m_instruction_lookup.insert(make_pair(0xAC, InstructionMetadata("LDY", 0xAC, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0xA4, InstructionMetadata("LDY", 0xA4, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0xB4, InstructionMetadata("LDY", 0xB4, &InstructionHandler::DPIndexedX)));
-    m_instruction_lookup.insert(make_pair(0xBC, InstructionMetadata("LDY", 0xBC, &InstructionHandler::AbsoluteIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x4E, InstructionMetadata("LSR", 0x4E, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0x46, InstructionMetadata("LSR", 0x46, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0x4A, InstructionMetadata("LSR", 0x4A, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x56, InstructionMetadata("LSR", 0x56, &InstructionHandler::DPIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x5E, InstructionMetadata("LSR", 0x5E, &InstructionHandler::AbsoluteIndexedX)));
-    m_instruction_lookup.insert(make_pair(0xEA, InstructionMetadata("NOP", 0xEA, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x09, InstructionMetadata("ORA", 0x09, &InstructionHandler::Immediate)));
-    m_instruction_lookup.insert(make_pair(0x0D, InstructionMetadata("ORA", 0x0D, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0x0F, InstructionMetadata("ORA", 0x0F, &InstructionHandler::AbsoluteLong)));
-    m_instruction_lookup.insert(make_pair(0x05, InstructionMetadata("ORA", 0x05, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0x11, InstructionMetadata("ORA", 0x11, &InstructionHandler::DPIndirectIndexedY)));
-    m_instruction_lookup.insert(make_pair(0x17, InstructionMetadata("ORA", 0x17, &InstructionHandler::DPIndirectLongIndexedY)));
-    m_instruction_lookup.insert(make_pair(0x01, InstructionMetadata("ORA", 0x01, &InstructionHandler::DPIndexedIndirectX)));
-    m_instruction_lookup.insert(make_pair(0x15, InstructionMetadata("ORA", 0x15, &InstructionHandler::DPIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x1D, InstructionMetadata("ORA", 0x1D, &InstructionHandler::AbsoluteIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x1F, InstructionMetadata("ORA", 0x1F, &InstructionHandler::AbsoluteLongIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x19, InstructionMetadata("ORA", 0x19, &InstructionHandler::AbsoluteIndexedY)));
-    m_instruction_lookup.insert(make_pair(0x12, InstructionMetadata("ORA", 0x12, &InstructionHandler::DPIndirect)));
-    m_instruction_lookup.insert(make_pair(0x07, InstructionMetadata("ORA", 0x07, &InstructionHandler::DPIndirectLong)));
-    m_instruction_lookup.insert(make_pair(0x03, InstructionMetadata("ORA", 0x03, &InstructionHandler::StackRelative)));
-    m_instruction_lookup.insert(make_pair(0x13, InstructionMetadata("ORA", 0x13, &InstructionHandler::SRIndirectIndexedY)));
-    m_instruction_lookup.insert(make_pair(0xF4, InstructionMetadata("PEA", 0xF4, &InstructionHandler::StackPCRelativeLong)));
-    m_instruction_lookup.insert(make_pair(0xD4, InstructionMetadata("PEI", 0xD4, &InstructionHandler::StackDPIndirect)));
-    m_instruction_lookup.insert(make_pair(0x62, InstructionMetadata("PER", 0x62, &InstructionHandler::StackPCRelativeLong)));
-    m_instruction_lookup.insert(make_pair(0x48, InstructionMetadata("PHA", 0x48, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x8B, InstructionMetadata("PHB", 0x8B, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x0B, InstructionMetadata("PHD", 0x0B, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x4B, InstructionMetadata("PHK", 0x4B, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x08, InstructionMetadata("PHP", 0x08, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0xDA, InstructionMetadata("PHX", 0xDA, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x5A, InstructionMetadata("PHY", 0x5A, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x68, InstructionMetadata("PLA", 0x68, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0xAB, InstructionMetadata("PLB", 0xAB, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x2B, InstructionMetadata("PLD", 0x2B, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x28, InstructionMetadata("PLP", 0x28, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0xFA, InstructionMetadata("PLX", 0xFA, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x7A, InstructionMetadata("PLY", 0x7A, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0xC2, InstructionMetadata("REP", 0xC2, &InstructionHandler::ImmediateREP)));
-    m_instruction_lookup.insert(make_pair(0x2E, InstructionMetadata("ROL", 0x2E, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0x26, InstructionMetadata("ROL", 0x26, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0x2A, InstructionMetadata("ROL", 0x2A, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x36, InstructionMetadata("ROL", 0x36, &InstructionHandler::DPIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x3E, InstructionMetadata("ROL", 0x3E, &InstructionHandler::AbsoluteIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x6E, InstructionMetadata("ROR", 0x6E, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0x66, InstructionMetadata("ROR", 0x66, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0x6A, InstructionMetadata("ROR", 0x6A, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x76, InstructionMetadata("ROR", 0x76, &InstructionHandler::DPIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x7E, InstructionMetadata("ROR", 0x7E, &InstructionHandler::AbsoluteIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x40, InstructionMetadata("RTI", 0x40, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x6B, InstructionMetadata("RTL", 0x6B, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x60, InstructionMetadata("RTS", 0x60, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0xE9, InstructionMetadata("SBC", 0xE9, &InstructionHandler::Immediate)));
-    m_instruction_lookup.insert(make_pair(0xED, InstructionMetadata("SBC", 0xED, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0xEF, InstructionMetadata("SBC", 0xEF, &InstructionHandler::AbsoluteLong)));
-    m_instruction_lookup.insert(make_pair(0xE5, InstructionMetadata("SBC", 0xE5, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0xF1, InstructionMetadata("SBC", 0xF1, &InstructionHandler::DPIndirectIndexedY)));
-    m_instruction_lookup.insert(make_pair(0xF7, InstructionMetadata("SBC", 0xF7, &InstructionHandler::DPIndirectLongIndexedY)));
-    m_instruction_lookup.insert(make_pair(0xE1, InstructionMetadata("SBC", 0xE1, &InstructionHandler::DPIndexedIndirectX)));
-    m_instruction_lookup.insert(make_pair(0xF5, InstructionMetadata("SBC", 0xF5, &InstructionHandler::DPIndexedX)));
-    m_instruction_lookup.insert(make_pair(0xFD, InstructionMetadata("SBC", 0xFD, &InstructionHandler::AbsoluteIndexedX)));
-    m_instruction_lookup.insert(make_pair(0xFF, InstructionMetadata("SBC", 0xFF, &InstructionHandler::AbsoluteLongIndexedX)));
-    m_instruction_lookup.insert(make_pair(0xF9, InstructionMetadata("SBC", 0xF9, &InstructionHandler::AbsoluteIndexedY)));
-    m_instruction_lookup.insert(make_pair(0xF2, InstructionMetadata("SBC", 0xF2, &InstructionHandler::DPIndirect)));
-    m_instruction_lookup.insert(make_pair(0xE7, InstructionMetadata("SBC", 0xE7, &InstructionHandler::DPIndirectLong)));
-    m_instruction_lookup.insert(make_pair(0xE3, InstructionMetadata("SBC", 0xE3, &InstructionHandler::StackRelative)));
-    m_instruction_lookup.insert(make_pair(0xF3, InstructionMetadata("SBC", 0xF3, &InstructionHandler::SRIndirectIndexedY)));
-    m_instruction_lookup.insert(make_pair(0x38, InstructionMetadata("SEC", 0x38, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0xF8, InstructionMetadata("SED", 0xF8, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x78, InstructionMetadata("SEI", 0x78, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0xE2, InstructionMetadata("SEP", 0xE2, &InstructionHandler::ImmediateSEP)));
-    m_instruction_lookup.insert(make_pair(0x8D, InstructionMetadata("STA", 0x8D, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0x8F, InstructionMetadata("STA", 0x8F, &InstructionHandler::AbsoluteLong)));
-    m_instruction_lookup.insert(make_pair(0x85, InstructionMetadata("STA", 0x85, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0x91, InstructionMetadata("STA", 0x91, &InstructionHandler::DPIndirectIndexedY)));
-    m_instruction_lookup.insert(make_pair(0x97, InstructionMetadata("STA", 0x97, &InstructionHandler::DPIndirectLongIndexedY)));
-    m_instruction_lookup.insert(make_pair(0x81, InstructionMetadata("STA", 0x81, &InstructionHandler::DPIndexedIndirectX)));
-    m_instruction_lookup.insert(make_pair(0x95, InstructionMetadata("STA", 0x95, &InstructionHandler::DPIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x9D, InstructionMetadata("STA", 0x9D, &InstructionHandler::AbsoluteIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x9F, InstructionMetadata("STA", 0x9F, &InstructionHandler::AbsoluteLongIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x99, InstructionMetadata("STA", 0x99, &InstructionHandler::AbsoluteIndexedY)));
-    m_instruction_lookup.insert(make_pair(0x92, InstructionMetadata("STA", 0x92, &InstructionHandler::DPIndirect)));
-    m_instruction_lookup.insert(make_pair(0x87, InstructionMetadata("STA", 0x87, &InstructionHandler::DPIndirectLong)));
-    m_instruction_lookup.insert(make_pair(0x83, InstructionMetadata("STA", 0x83, &InstructionHandler::StackRelative)));
-    m_instruction_lookup.insert(make_pair(0x93, InstructionMetadata("STA", 0x93, &InstructionHandler::SRIndirectIndexedY)));
-    m_instruction_lookup.insert(make_pair(0xDB, InstructionMetadata("STP", 0xDB, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x8E, InstructionMetadata("STX", 0x8E, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0x86, InstructionMetadata("STX", 0x86, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0x96, InstructionMetadata("STX", 0x96, &InstructionHandler::DPIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x8C, InstructionMetadata("STY", 0x8C, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0x84, InstructionMetadata("STY", 0x84, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0x94, InstructionMetadata("STY", 0x94, &InstructionHandler::DPIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x9C, InstructionMetadata("STZ", 0x9C, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0x64, InstructionMetadata("STZ", 0x64, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0x74, InstructionMetadata("STZ", 0x74, &InstructionHandler::DPIndexedX)));
-    m_instruction_lookup.insert(make_pair(0x9E, InstructionMetadata("STZ", 0x9E, &InstructionHandler::AbsoluteIndexedX)));
-    m_instruction_lookup.insert(make_pair(0xAA, InstructionMetadata("TAX", 0xAA, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0xA8, InstructionMetadata("TAY", 0xA8, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x5B, InstructionMetadata("TCD", 0x5B, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x1B, InstructionMetadata("TCS", 0x1B, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x7B, InstructionMetadata("TDC", 0x7B, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x1C, InstructionMetadata("TRB", 0x1C, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0x14, InstructionMetadata("TRB", 0x14, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0x0C, InstructionMetadata("TSB", 0x0C, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0x04, InstructionMetadata("TSB", 0x04, &InstructionHandler::DirectPage)));
-    m_instruction_lookup.insert(make_pair(0x3B, InstructionMetadata("TSC", 0x3B, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0xBA, InstructionMetadata("TSX", 0xBA, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x8A, InstructionMetadata("TXA", 0x8A, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x9A, InstructionMetadata("TXS", 0x9A, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x9B, InstructionMetadata("TXY", 0x9B, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x98, InstructionMetadata("TYA", 0x98, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0xBB, InstructionMetadata("TYX", 0xBB, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0xCB, InstructionMetadata("WAI", 0xCB, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0xEB, InstructionMetadata("XBA", 0xEB, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0xFB, InstructionMetadata("XCE", 0xFB, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x02, InstructionMetadata("COP", 0x02, &InstructionHandler::Implied)));
-    m_instruction_lookup.insert(make_pair(0x54, InstructionMetadata("MVN", 0x54, &InstructionHandler::BlockMove)));
-    m_instruction_lookup.insert(make_pair(0x44, InstructionMetadata("MVP", 0x44, &InstructionHandler::BlockMove)));
-    m_instruction_lookup.insert(make_pair(0x42, InstructionMetadata("???", 0x42, &InstructionHandler::Implied)));
-
-    m_instruction_lookup.insert(make_pair(0x100, InstructionMetadata(".dw", 0x100, &InstructionHandler::Absolute)));
-    m_instruction_lookup.insert(make_pair(0x101, InstructionMetadata(".dw", 0x101, &InstructionHandler::LongPointer)));
+vector<InstructionMetadata> Disassembler::build_instruction_table()
+{
+    map<int, InstructionMetadata> lookup;
+    lookup.insert(make_pair(0x69, InstructionMetadata("ADC", 0x69, &InstructionHandler::Immediate)));
+    lookup.insert(make_pair(0x6D, InstructionMetadata("ADC", 0x6D, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0x6F, InstructionMetadata("ADC", 0x6F, &InstructionHandler::AbsoluteLong)));
+    lookup.insert(make_pair(0x65, InstructionMetadata("ADC", 0x65, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0x71, InstructionMetadata("ADC", 0x71, &InstructionHandler::DPIndirectIndexedY)));
+    lookup.insert(make_pair(0x77, InstructionMetadata("ADC", 0x77, &InstructionHandler::DPIndirectLongIndexedY)));
+    lookup.insert(make_pair(0x61, InstructionMetadata("ADC", 0x61, &InstructionHandler::DPIndexedIndirectX)));
+    lookup.insert(make_pair(0x75, InstructionMetadata("ADC", 0x75, &InstructionHandler::DPIndexedX)));
+    lookup.insert(make_pair(0x7D, InstructionMetadata("ADC", 0x7D, &InstructionHandler::AbsoluteIndexedX)));
+    lookup.insert(make_pair(0x7F, InstructionMetadata("ADC", 0x7F, &InstructionHandler::AbsoluteLongIndexedX)));
+    lookup.insert(make_pair(0x79, InstructionMetadata("ADC", 0x79, &InstructionHandler::AbsoluteIndexedY)));
+    lookup.insert(make_pair(0x72, InstructionMetadata("ADC", 0x72, &InstructionHandler::DPIndirect)));
+    lookup.insert(make_pair(0x67, InstructionMetadata("ADC", 0x67, &InstructionHandler::DPIndirectLong)));
+    lookup.insert(make_pair(0x63, InstructionMetadata("ADC", 0x63, &InstructionHandler::StackRelative)));
+    lookup.insert(make_pair(0x73, InstructionMetadata("ADC", 0x73, &InstructionHandler::SRIndirectIndexedY)));
+    lookup.insert(make_pair(0x29, InstructionMetadata("AND", 0x29, &InstructionHandler::Immediate)));
+    lookup.insert(make_pair(0x2D, InstructionMetadata("AND", 0x2D, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0x2F, InstructionMetadata("AND", 0x2F, &InstructionHandler::AbsoluteLong)));
+    lookup.insert(make_pair(0x25, InstructionMetadata("AND", 0x25, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0x31, InstructionMetadata("AND", 0x31, &InstructionHandler::DPIndirectIndexedY)));
+    lookup.insert(make_pair(0x37, InstructionMetadata("AND", 0x37, &InstructionHandler::DPIndirectLongIndexedY)));
+    lookup.insert(make_pair(0x21, InstructionMetadata("AND", 0x21, &InstructionHandler::DPIndexedIndirectX)));
+    lookup.insert(make_pair(0x35, InstructionMetadata("AND", 0x35, &InstructionHandler::DPIndexedX)));
+    lookup.insert(make_pair(0x3D, InstructionMetadata("AND", 0x3D, &InstructionHandler::AbsoluteIndexedX)));
+    lookup.insert(make_pair(0x3F, InstructionMetadata("AND", 0x3F, &InstructionHandler::AbsoluteLongIndexedX)));
+    lookup.insert(make_pair(0x39, InstructionMetadata("AND", 0x39, &InstructionHandler::AbsoluteIndexedY)));
+    lookup.insert(make_pair(0x32, InstructionMetadata("AND", 0x32, &InstructionHandler::DPIndirect)));
+    lookup.insert(make_pair(0x27, InstructionMetadata("AND", 0x27, &InstructionHandler::DPIndirectLong)));
+    lookup.insert(make_pair(0x23, InstructionMetadata("AND", 0x23, &InstructionHandler::StackRelative)));
+    lookup.insert(make_pair(0x33, InstructionMetadata("AND", 0x33, &InstructionHandler::SRIndirectIndexedY)));
+    lookup.insert(make_pair(0x0E, InstructionMetadata("ASL", 0x0E, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0x06, InstructionMetadata("ASL", 0x06, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0x0A, InstructionMetadata("ASL", 0x0A, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x16, InstructionMetadata("ASL", 0x16, &InstructionHandler::DPIndexedX)));
+    lookup.insert(make_pair(0x1E, InstructionMetadata("ASL", 0x1E, &InstructionHandler::AbsoluteIndexedX)));
+    lookup.insert(make_pair(0x90, InstructionMetadata("BCC", 0x90, &InstructionHandler::ProgramCounterRelative)));
+    lookup.insert(make_pair(0xB0, InstructionMetadata("BCS", 0xB0, &InstructionHandler::ProgramCounterRelative)));
+    lookup.insert(make_pair(0xF0, InstructionMetadata("BEQ", 0xF0, &InstructionHandler::ProgramCounterRelative)));
+    lookup.insert(make_pair(0x30, InstructionMetadata("BMI", 0x30, &InstructionHandler::ProgramCounterRelative)));
+    lookup.insert(make_pair(0xD0, InstructionMetadata("BNE", 0xD0, &InstructionHandler::ProgramCounterRelative)));
+    lookup.insert(make_pair(0x10, InstructionMetadata("BPL", 0x10, &InstructionHandler::ProgramCounterRelative)));
+    lookup.insert(make_pair(0x80, InstructionMetadata("BRA", 0x80, &InstructionHandler::ProgramCounterRelative)));
+    lookup.insert(make_pair(0x82, InstructionMetadata("BRL", 0x82, &InstructionHandler::ProgramCounterRelativeLong)));
+    lookup.insert(make_pair(0x50, InstructionMetadata("BVC", 0x50, &InstructionHandler::ProgramCounterRelative)));
+    lookup.insert(make_pair(0x70, InstructionMetadata("BVS", 0x70, &InstructionHandler::ProgramCounterRelative)));
+    lookup.insert(make_pair(0x89, InstructionMetadata("BIT", 0x89, &InstructionHandler::Immediate)));
+    lookup.insert(make_pair(0x2C, InstructionMetadata("BIT", 0x2C, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0x24, InstructionMetadata("BIT", 0x24, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0x34, InstructionMetadata("BIT", 0x34, &InstructionHandler::DPIndexedX)));
+    lookup.insert(make_pair(0x3C, InstructionMetadata("BIT", 0x3C, &InstructionHandler::AbsoluteIndexedX)));
+    lookup.insert(make_pair(0x00, InstructionMetadata("BRK", 0x00, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x18, InstructionMetadata("CLC", 0x18, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0xD8, InstructionMetadata("CLD", 0xD8, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x58, InstructionMetadata("CLI", 0x58, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0xB8, InstructionMetadata("CLV", 0xB8, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0xC9, InstructionMetadata("CMP", 0xC9, &InstructionHandler::Immediate)));
+    lookup.insert(make_pair(0xCD, InstructionMetadata("CMP", 0xCD, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0xCF, InstructionMetadata("CMP", 0xCF, &InstructionHandler::AbsoluteLong)));
+    lookup.insert(make_pair(0xC5, InstructionMetadata("CMP", 0xC5, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0xD1, InstructionMetadata("CMP", 0xD1, &InstructionHandler::DPIndirectIndexedY)));
+    lookup.insert(make_pair(0xD7, InstructionMetadata("CMP", 0xD7, &InstructionHandler::DPIndirectLongIndexedY)));
+    lookup.insert(make_pair(0xC1, InstructionMetadata("CMP", 0xC1, &InstructionHandler::DPIndexedIndirectX)));
+    lookup.insert(make_pair(0xD5, InstructionMetadata("CMP", 0xD5, &InstructionHandler::DPIndexedX)));
+    lookup.insert(make_pair(0xDD, InstructionMetadata("CMP", 0xDD, &InstructionHandler::AbsoluteIndexedX)));
+    lookup.insert(make_pair(0xDF, InstructionMetadata("CMP", 0xDF, &InstructionHandler::AbsoluteLongIndexedX)));
+    lookup.insert(make_pair(0xD9, InstructionMetadata("CMP", 0xD9, &InstructionHandler::AbsoluteIndexedY)));
+    lookup.insert(make_pair(0xD2, InstructionMetadata("CMP", 0xD2, &InstructionHandler::DPIndirect)));
+    lookup.insert(make_pair(0xC7, InstructionMetadata("CMP", 0xC7, &InstructionHandler::DPIndirectLong)));
+    lookup.insert(make_pair(0xC3, InstructionMetadata("CMP", 0xC3, &InstructionHandler::StackRelative)));
+    lookup.insert(make_pair(0xD3, InstructionMetadata("CMP", 0xD3, &InstructionHandler::SRIndirectIndexedY)));
+    lookup.insert(make_pair(0xE0, InstructionMetadata("CPX", 0xE0, &InstructionHandler::ImmediateXY)));
+    lookup.insert(make_pair(0xEC, InstructionMetadata("CPX", 0xEC, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0xE4, InstructionMetadata("CPX", 0xE4, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0xC0, InstructionMetadata("CPY", 0xC0, &InstructionHandler::ImmediateXY)));
+    lookup.insert(make_pair(0xCC, InstructionMetadata("CPY", 0xCC, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0xC4, InstructionMetadata("CPY", 0xC4, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0xCE, InstructionMetadata("DEC", 0xCE, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0xC6, InstructionMetadata("DEC", 0xC6, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0x3A, InstructionMetadata("DEC", 0x3A, &InstructionHandler::Accumulator)));
+    lookup.insert(make_pair(0xD6, InstructionMetadata("DEC", 0xD6, &InstructionHandler::DPIndexedX)));
+    lookup.insert(make_pair(0xDE, InstructionMetadata("DEC", 0xDE, &InstructionHandler::AbsoluteIndexedX)));
+    lookup.insert(make_pair(0xCA, InstructionMetadata("DEX", 0xCA, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x88, InstructionMetadata("DEY", 0x88, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x49, InstructionMetadata("EOR", 0x49, &InstructionHandler::Immediate)));
+    lookup.insert(make_pair(0x4D, InstructionMetadata("EOR", 0x4D, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0x4F, InstructionMetadata("EOR", 0x4F, &InstructionHandler::AbsoluteLong)));
+    lookup.insert(make_pair(0x45, InstructionMetadata("EOR", 0x45, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0x51, InstructionMetadata("EOR", 0x51, &InstructionHandler::DPIndirectIndexedY)));
+    lookup.insert(make_pair(0x57, InstructionMetadata("EOR", 0x57, &InstructionHandler::DPIndirectLongIndexedY)));
+    lookup.insert(make_pair(0x41, InstructionMetadata("EOR", 0x41, &InstructionHandler::DPIndexedIndirectX)));
+    lookup.insert(make_pair(0x55, InstructionMetadata("EOR", 0x55, &InstructionHandler::DPIndexedX)));
+    lookup.insert(make_pair(0x5D, InstructionMetadata("EOR", 0x5D, &InstructionHandler::AbsoluteIndexedX)));
+    lookup.insert(make_pair(0x5F, InstructionMetadata("EOR", 0x5F, &InstructionHandler::AbsoluteLongIndexedX)));
+    lookup.insert(make_pair(0x59, InstructionMetadata("EOR", 0x59, &InstructionHandler::AbsoluteIndexedY)));
+    lookup.insert(make_pair(0x52, InstructionMetadata("EOR", 0x52, &InstructionHandler::DPIndirect)));
+    lookup.insert(make_pair(0x47, InstructionMetadata("EOR", 0x47, &InstructionHandler::DPIndirectLong)));
+    lookup.insert(make_pair(0x43, InstructionMetadata("EOR", 0x43, &InstructionHandler::StackRelative)));
+    lookup.insert(make_pair(0x53, InstructionMetadata("EOR", 0x53, &InstructionHandler::SRIndirectIndexedY)));
+    lookup.insert(make_pair(0xEE, InstructionMetadata("INC", 0xEE, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0xE6, InstructionMetadata("INC", 0xE6, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0x1A, InstructionMetadata("INC", 0x1A, &InstructionHandler::Accumulator)));
+    lookup.insert(make_pair(0xF6, InstructionMetadata("INC", 0xF6, &InstructionHandler::DPIndexedX)));
+    lookup.insert(make_pair(0xFE, InstructionMetadata("INC", 0xFE, &InstructionHandler::AbsoluteIndexedX)));
+    lookup.insert(make_pair(0xE8, InstructionMetadata("INX", 0xE8, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0xC8, InstructionMetadata("INY", 0xC8, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x5C, InstructionMetadata("JMP", 0x5C, &InstructionHandler::AbsoluteLong)));
+    lookup.insert(make_pair(0xDC, InstructionMetadata("JMP", 0xDC, &InstructionHandler::AbsoluteIndirectLong)));
+    lookup.insert(make_pair(0x4C, InstructionMetadata("JMP", 0x4C, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0x6C, InstructionMetadata("JMP", 0x6C, &InstructionHandler::AbsoluteIndirect)));
+    lookup.insert(make_pair(0x7C, InstructionMetadata("JMP", 0x7C, &InstructionHandler::AbsoluteIndexedIndirect)));
+    lookup.insert(make_pair(0x22, InstructionMetadata("JSL", 0x22, &InstructionHandler::AbsoluteLong)));
+    lookup.insert(make_pair(0x20, InstructionMetadata("JSR", 0x20, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0xFC, InstructionMetadata("JSR", 0xFC, &InstructionHandler::AbsoluteIndexedIndirect)));
+    lookup.insert(make_pair(0xA9, InstructionMetadata("LDA", 0xA9, &InstructionHandler::Immediate)));
+    lookup.insert(make_pair(0xAD, InstructionMetadata("LDA", 0xAD, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0xAF, InstructionMetadata("LDA", 0xAF, &InstructionHandler::AbsoluteLong)));
+    lookup.insert(make_pair(0xA5, InstructionMetadata("LDA", 0xA5, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0xB1, InstructionMetadata("LDA", 0xB1, &InstructionHandler::DPIndirectIndexedY)));
+    lookup.insert(make_pair(0xB7, InstructionMetadata("LDA", 0xB7, &InstructionHandler::DPIndirectLongIndexedY)));
+    lookup.insert(make_pair(0xA1, InstructionMetadata("LDA", 0xA1, &InstructionHandler::DPIndexedIndirectX)));
+    lookup.insert(make_pair(0xB5, InstructionMetadata("LDA", 0xB5, &InstructionHandler::DPIndexedX)));
+    lookup.insert(make_pair(0xBD, InstructionMetadata("LDA", 0xBD, &InstructionHandler::AbsoluteIndexedX)));
+    lookup.insert(make_pair(0xBF, InstructionMetadata("LDA", 0xBF, &InstructionHandler::AbsoluteLongIndexedX)));
+    lookup.insert(make_pair(0xB9, InstructionMetadata("LDA", 0xB9, &InstructionHandler::AbsoluteIndexedY)));
+    lookup.insert(make_pair(0xB2, InstructionMetadata("LDA", 0xB2, &InstructionHandler::DPIndirect)));
+    lookup.insert(make_pair(0xA7, InstructionMetadata("LDA", 0xA7, &InstructionHandler::DPIndirectLong)));
+    lookup.insert(make_pair(0xA3, InstructionMetadata("LDA", 0xA3, &InstructionHandler::StackRelative)));
+    lookup.insert(make_pair(0xB3, InstructionMetadata("LDA", 0xB3, &InstructionHandler::SRIndirectIndexedY)));
+    lookup.insert(make_pair(0xA2, InstructionMetadata("LDX", 0xA2, &InstructionHandler::ImmediateXY)));
+    lookup.insert(make_pair(0xAE, InstructionMetadata("LDX", 0xAE, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0xA6, InstructionMetadata("LDX", 0xA6, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0xB6, InstructionMetadata("LDX", 0xB6, &InstructionHandler::DPIndexedY)));
+    lookup.insert(make_pair(0xBE, InstructionMetadata("LDX", 0xBE, &InstructionHandler::AbsoluteIndexedY)));
+    lookup.insert(make_pair(0xA0, InstructionMetadata("LDY", 0xA0, &InstructionHandler::ImmediateXY)));
+    lookup.insert(make_pair(0xAC, InstructionMetadata("LDY", 0xAC, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0xA4, InstructionMetadata("LDY", 0xA4, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0xB4, InstructionMetadata("LDY", 0xB4, &InstructionHandler::DPIndexedX)));
+    lookup.insert(make_pair(0xBC, InstructionMetadata("LDY", 0xBC, &InstructionHandler::AbsoluteIndexedX)));
+    lookup.insert(make_pair(0x4E, InstructionMetadata("LSR", 0x4E, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0x46, InstructionMetadata("LSR", 0x46, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0x4A, InstructionMetadata("LSR", 0x4A, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x56, InstructionMetadata("LSR", 0x56, &InstructionHandler::DPIndexedX)));
+    lookup.insert(make_pair(0x5E, InstructionMetadata("LSR", 0x5E, &InstructionHandler::AbsoluteIndexedX)));
+    lookup.insert(make_pair(0xEA, InstructionMetadata("NOP", 0xEA, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x09, InstructionMetadata("ORA", 0x09, &InstructionHandler::Immediate)));
+    lookup.insert(make_pair(0x0D, InstructionMetadata("ORA", 0x0D, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0x0F, InstructionMetadata("ORA", 0x0F, &InstructionHandler::AbsoluteLong)));
+    lookup.insert(make_pair(0x05, InstructionMetadata("ORA", 0x05, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0x11, InstructionMetadata("ORA", 0x11, &InstructionHandler::DPIndirectIndexedY)));
+    lookup.insert(make_pair(0x17, InstructionMetadata("ORA", 0x17, &InstructionHandler::DPIndirectLongIndexedY)));
+    lookup.insert(make_pair(0x01, InstructionMetadata("ORA", 0x01, &InstructionHandler::DPIndexedIndirectX)));
+    lookup.insert(make_pair(0x15, InstructionMetadata("ORA", 0x15, &InstructionHandler::DPIndexedX)));
+    lookup.insert(make_pair(0x1D, InstructionMetadata("ORA", 0x1D, &InstructionHandler::AbsoluteIndexedX)));
+    lookup.insert(make_pair(0x1F, InstructionMetadata("ORA", 0x1F, &InstructionHandler::AbsoluteLongIndexedX)));
+    lookup.insert(make_pair(0x19, InstructionMetadata("ORA", 0x19, &InstructionHandler::AbsoluteIndexedY)));
+    lookup.insert(make_pair(0x12, InstructionMetadata("ORA", 0x12, &InstructionHandler::DPIndirect)));
+    lookup.insert(make_pair(0x07, InstructionMetadata("ORA", 0x07, &InstructionHandler::DPIndirectLong)));
+    lookup.insert(make_pair(0x03, InstructionMetadata("ORA", 0x03, &InstructionHandler::StackRelative)));
+    lookup.insert(make_pair(0x13, InstructionMetadata("ORA", 0x13, &InstructionHandler::SRIndirectIndexedY)));
+    lookup.insert(make_pair(0xF4, InstructionMetadata("PEA", 0xF4, &InstructionHandler::StackPCRelativeLong)));
+    lookup.insert(make_pair(0xD4, InstructionMetadata("PEI", 0xD4, &InstructionHandler::StackDPIndirect)));
+    lookup.insert(make_pair(0x62, InstructionMetadata("PER", 0x62, &InstructionHandler::StackPCRelativeLong)));
+    lookup.insert(make_pair(0x48, InstructionMetadata("PHA", 0x48, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x8B, InstructionMetadata("PHB", 0x8B, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x0B, InstructionMetadata("PHD", 0x0B, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x4B, InstructionMetadata("PHK", 0x4B, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x08, InstructionMetadata("PHP", 0x08, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0xDA, InstructionMetadata("PHX", 0xDA, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x5A, InstructionMetadata("PHY", 0x5A, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x68, InstructionMetadata("PLA", 0x68, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0xAB, InstructionMetadata("PLB", 0xAB, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x2B, InstructionMetadata("PLD", 0x2B, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x28, InstructionMetadata("PLP", 0x28, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0xFA, InstructionMetadata("PLX", 0xFA, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x7A, InstructionMetadata("PLY", 0x7A, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0xC2, InstructionMetadata("REP", 0xC2, &InstructionHandler::ImmediateREP)));
+    lookup.insert(make_pair(0x2E, InstructionMetadata("ROL", 0x2E, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0x26, InstructionMetadata("ROL", 0x26, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0x2A, InstructionMetadata("ROL", 0x2A, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x36, InstructionMetadata("ROL", 0x36, &InstructionHandler::DPIndexedX)));
+    lookup.insert(make_pair(0x3E, InstructionMetadata("ROL", 0x3E, &InstructionHandler::AbsoluteIndexedX)));
+    lookup.insert(make_pair(0x6E, InstructionMetadata("ROR", 0x6E, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0x66, InstructionMetadata("ROR", 0x66, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0x6A, InstructionMetadata("ROR", 0x6A, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x76, InstructionMetadata("ROR", 0x76, &InstructionHandler::DPIndexedX)));
+    lookup.insert(make_pair(0x7E, InstructionMetadata("ROR", 0x7E, &InstructionHandler::AbsoluteIndexedX)));
+    lookup.insert(make_pair(0x40, InstructionMetadata("RTI", 0x40, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x6B, InstructionMetadata("RTL", 0x6B, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x60, InstructionMetadata("RTS", 0x60, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0xE9, InstructionMetadata("SBC", 0xE9, &InstructionHandler::Immediate)));
+    lookup.insert(make_pair(0xED, InstructionMetadata("SBC", 0xED, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0xEF, InstructionMetadata("SBC", 0xEF, &InstructionHandler::AbsoluteLong)));
+    lookup.insert(make_pair(0xE5, InstructionMetadata("SBC", 0xE5, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0xF1, InstructionMetadata("SBC", 0xF1, &InstructionHandler::DPIndirectIndexedY)));
+    lookup.insert(make_pair(0xF7, InstructionMetadata("SBC", 0xF7, &InstructionHandler::DPIndirectLongIndexedY)));
+    lookup.insert(make_pair(0xE1, InstructionMetadata("SBC", 0xE1, &InstructionHandler::DPIndexedIndirectX)));
+    lookup.insert(make_pair(0xF5, InstructionMetadata("SBC", 0xF5, &InstructionHandler::DPIndexedX)));
+    lookup.insert(make_pair(0xFD, InstructionMetadata("SBC", 0xFD, &InstructionHandler::AbsoluteIndexedX)));
+    lookup.insert(make_pair(0xFF, InstructionMetadata("SBC", 0xFF, &InstructionHandler::AbsoluteLongIndexedX)));
+    lookup.insert(make_pair(0xF9, InstructionMetadata("SBC", 0xF9, &InstructionHandler::AbsoluteIndexedY)));
+    lookup.insert(make_pair(0xF2, InstructionMetadata("SBC", 0xF2, &InstructionHandler::DPIndirect)));
+    lookup.insert(make_pair(0xE7, InstructionMetadata("SBC", 0xE7, &InstructionHandler::DPIndirectLong)));
+    lookup.insert(make_pair(0xE3, InstructionMetadata("SBC", 0xE3, &InstructionHandler::StackRelative)));
+    lookup.insert(make_pair(0xF3, InstructionMetadata("SBC", 0xF3, &InstructionHandler::SRIndirectIndexedY)));
+    lookup.insert(make_pair(0x38, InstructionMetadata("SEC", 0x38, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0xF8, InstructionMetadata("SED", 0xF8, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x78, InstructionMetadata("SEI", 0x78, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0xE2, InstructionMetadata("SEP", 0xE2, &InstructionHandler::ImmediateSEP)));
+    lookup.insert(make_pair(0x8D, InstructionMetadata("STA", 0x8D, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0x8F, InstructionMetadata("STA", 0x8F, &InstructionHandler::AbsoluteLong)));
+    lookup.insert(make_pair(0x85, InstructionMetadata("STA", 0x85, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0x91, InstructionMetadata("STA", 0x91, &InstructionHandler::DPIndirectIndexedY)));
+    lookup.insert(make_pair(0x97, InstructionMetadata("STA", 0x97, &InstructionHandler::DPIndirectLongIndexedY)));
+    lookup.insert(make_pair(0x81, InstructionMetadata("STA", 0x81, &InstructionHandler::DPIndexedIndirectX)));
+    lookup.insert(make_pair(0x95, InstructionMetadata("STA", 0x95, &InstructionHandler::DPIndexedX)));
+    lookup.insert(make_pair(0x9D, InstructionMetadata("STA", 0x9D, &InstructionHandler::AbsoluteIndexedX)));
+    lookup.insert(make_pair(0x9F, InstructionMetadata("STA", 0x9F, &InstructionHandler::AbsoluteLongIndexedX)));
+    lookup.insert(make_pair(0x99, InstructionMetadata("STA", 0x99, &InstructionHandler::AbsoluteIndexedY)));
+    lookup.insert(make_pair(0x92, InstructionMetadata("STA", 0x92, &InstructionHandler::DPIndirect)));
+    lookup.insert(make_pair(0x87, InstructionMetadata("STA", 0x87, &InstructionHandler::DPIndirectLong)));
+    lookup.insert(make_pair(0x83, InstructionMetadata("STA", 0x83, &InstructionHandler::StackRelative)));
+    lookup.insert(make_pair(0x93, InstructionMetadata("STA", 0x93, &InstructionHandler::SRIndirectIndexedY)));
+    lookup.insert(make_pair(0xDB, InstructionMetadata("STP", 0xDB, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x8E, InstructionMetadata("STX", 0x8E, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0x86, InstructionMetadata("STX", 0x86, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0x96, InstructionMetadata("STX", 0x96, &InstructionHandler::DPIndexedX)));
+    lookup.insert(make_pair(0x8C, InstructionMetadata("STY", 0x8C, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0x84, InstructionMetadata("STY", 0x84, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0x94, InstructionMetadata("STY", 0x94, &InstructionHandler::DPIndexedX)));
+    lookup.insert(make_pair(0x9C, InstructionMetadata("STZ", 0x9C, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0x64, InstructionMetadata("STZ", 0x64, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0x74, InstructionMetadata("STZ", 0x74, &InstructionHandler::DPIndexedX)));
+    lookup.insert(make_pair(0x9E, InstructionMetadata("STZ", 0x9E, &InstructionHandler::AbsoluteIndexedX)));
+    lookup.insert(make_pair(0xAA, InstructionMetadata("TAX", 0xAA, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0xA8, InstructionMetadata("TAY", 0xA8, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x5B, InstructionMetadata("TCD", 0x5B, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x1B, InstructionMetadata("TCS", 0x1B, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x7B, InstructionMetadata("TDC", 0x7B, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x1C, InstructionMetadata("TRB", 0x1C, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0x14, InstructionMetadata("TRB", 0x14, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0x0C, InstructionMetadata("TSB", 0x0C, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0x04, InstructionMetadata("TSB", 0x04, &InstructionHandler::DirectPage)));
+    lookup.insert(make_pair(0x3B, InstructionMetadata("TSC", 0x3B, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0xBA, InstructionMetadata("TSX", 0xBA, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x8A, InstructionMetadata("TXA", 0x8A, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x9A, InstructionMetadata("TXS", 0x9A, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x9B, InstructionMetadata("TXY", 0x9B, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x98, InstructionMetadata("TYA", 0x98, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0xBB, InstructionMetadata("TYX", 0xBB, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0xCB, InstructionMetadata("WAI", 0xCB, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0xEB, InstructionMetadata("XBA", 0xEB, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0xFB, InstructionMetadata("XCE", 0xFB, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x02, InstructionMetadata("COP", 0x02, &InstructionHandler::Implied)));
+    lookup.insert(make_pair(0x54, InstructionMetadata("MVN", 0x54, &InstructionHandler::BlockMove)));
+    lookup.insert(make_pair(0x44, InstructionMetadata("MVP", 0x44, &InstructionHandler::BlockMove)));
+    lookup.insert(make_pair(0x42, InstructionMetadata("???", 0x42, &InstructionHandler::Implied)));
+
+    lookup.insert(make_pair(0x100, InstructionMetadata(".dw", 0x100, &InstructionHandler::Absolute)));
+    lookup.insert(make_pair(0x101, InstructionMetadata(".dw", 0x101, &InstructionHandler::LongPointer)));
+
+    // indexed by opcode, with the pointer pseudo instructions at 0x100 and 0x101
+    vector<InstructionMetadata> table(0x102);
+    for (auto it = lookup.begin(); it != lookup.end(); ++it){
+        table[it->first] = it->second;
+    }
+    return table;
 }
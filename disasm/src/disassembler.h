@@ -1,28 +1,47 @@
 #ifndef DISASSEMBLER_H
 #define DISASSEMBLER_H
 
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <map>
+#include <vector>
 #include "request.h"
+#include "annotation_handlers.h"
+#include "arena.h"
+#include "coverage.h"
+#include "driver_file.h"
+#include "label_index.h"
+#include "memory_map.h"
+#include "range_cache.h"
+#include "registers.h"
+#include "segment_index.h"
+#include "memory_usage.h"
+#include "stats.h"
 
 class InstructionMetadata;
 struct OutputHandler;
 struct InstructionNameProvider;
-struct AnnotationProvider;
+struct AnalyticsReport;
+struct CostReport;
+struct CycleTimer;
 struct ByteProperties;
+struct ContentHash;
 
 struct DisassemblerState
 {
     DisassemblerState();
 
-    void hirom(bool hi) { m_hirom = hi; } //todo: move to ctor
+    void memory_map(const MemoryMap* map) { m_map = map; }
 
-    void increment_address();
+    void increment_address() { m_map->increment(&m_current_bank, &m_current_addr); }
     void set_address(unsigned char bank, unsigned int pc);
-    unsigned int get_current_index() const;
-    unsigned int get_current_address() const;
+    // the byte's entry in the byte properties, the sentinel past the ROM
+    // if it isn't in ROM
+    unsigned int get_current_index() const { return m_map->rom_index(get_current_address()); }
+    unsigned int get_current_address() const { return m_current_bank * 65536 + m_current_addr; }
 
     unsigned int get_current_bank() const { return m_current_bank; }
     unsigned int get_current_pc() const { return m_current_addr; }
@@ -33,106 +52,244 @@ struct DisassemblerState
     bool is_index_16bit() const { return m_index_16; }
     void is_index_16bit(bool is_16bit) { m_index_16 = is_16bit; }
 
-    bool is_bank_start() const { return m_current_addr == 0x8000; }
+    bool is_bank_start() const { return m_current_addr == m_map->bank_start(m_current_bank); }
 
-    bool m_hirom;
+    // What LDA, LDX and LDY #imm put in A, X and Y, so that a following
+    // STA, STX, STY or STZ to a register can show the value's bit fields.
+    // Any other instruction forgets them (see disassembleInstruction), so
+    // this is the value stored when the code is entered from above.
+    void immediate_loaded(unsigned int opcode, int value);
+    int stored_value(unsigned int opcode) const; //-1 if unknown
+    void forget_values();
+
+    const MemoryMap* m_map;
     unsigned char m_current_bank;
     unsigned int m_current_addr;
     bool m_accum_16;
     bool m_index_16;
+    int m_known[3]; //A, X, Y, or -1
     //unsigned char m_data_bank; //todo: move this here
 };
 
 
 struct Disassembler{
 private:    
-    void initialize_instruction_lookup();
+    static std::vector<InstructionMetadata> build_instruction_table();
+    static const std::vector<InstructionMetadata>& instruction_table();
 
 public:
-    Disassembler(FILE* rom_file);
+    // Listings go to out and load diagnostics to log, so that instances
+    // can run side by side (--batch).
+    Disassembler(FILE* rom_file, std::ostream& out = std::cout, std::ostream& log = std::cerr);
+    // A session that shares the loaded driver data with base but has its
+    // own ROM handle, output stream and label bookkeeping.
+    Disassembler(const Disassembler& base, FILE* rom_file, std::ostream& out);
     ~Disassembler();
  
-    void handleRequest(const Request& request);
+    void handleRequest(const Request& request); //HiROM ranges are taken as MemoryMap::contiguous_range gives them
+    // Request::m_analytics: per bank counts of code, each data type,
+    // untyped bytes, labels and comments over the range, from bitmaps of
+    // the whole ROM.  Code is what the traces, and a static decode from
+    // them and from labels, reach.  A label is referenced if one of those
+    // instructions or a pointer table names its address.
+    void analyze(const DisassemblerProperties& range, AnalyticsReport* report);
+    // Request::m_cost: walks the routine at the range's start, and what it
+    // calls, with the register widths the request starts with; see
+    // RoutineWalk.
+    void cost(const DisassemblerProperties& range, CostReport* report);
 
     void doDcb(int bytes_per_line = 8);
+    void doIncbin();
     void doPtr(bool long_ptrs = false);
     void doDisasm();
     void doSmart();
 
     void setProcessFlags();
 
-    void load_data_bank(const char *filename);
-    void load_data(const char *filename, bool is_ptr_data = false); //todo: separate
-    void load_comments(const char *filename);
-    void load_symbols(const char *filename, bool ram = false); //todo: separate
-    void load_symbols2(const char *filename); //todo: rename
-    void load_accum_bytes(char *fname, bool accum);//todo: rename
-    void load_offsets(const char *filename); //load instructions whose targets need to be adjusted 
+    // Parsed concurrently, applied in order.  False once a file has a
+    // fatal error, which is logged; what follows it isn't applied.
+    bool load_driver_files(std::vector<DriverFile>& files);
+    // Applies what changed between two parses of a driver file, for
+    // --watch: entries that went away are undone and new ones applied.
+    // Only the cached ranges and used labels that involve a changed
+    // address are dropped.  Trace and register files are merged in again,
+    // so what is removed from them stays until a restart.
+    void reload_driver_file(const DriverFile& previous, const DriverFile& current);
+    // --extract-dir: writes the assets the data files mark to directory
+    // and logs their sizes.  A compressed block is decompressed to
+    // LABEL.bin; it starts at the start of its run, or at the first label
+    // past the end of the one before it.  Tiles are copied to LABEL.bin
+    // and drawn to LABEL.pgm from one label to the next, and from then on
+    // listings .INCBIN the copies instead of printing .db lines.
+    void extract_assets(const std::string& directory);
+    // --interpret: walks the code from the vectors and the traces with an
+    // Interpreter, then adds what it reached to the coverage, and the
+    // register widths and data banks it worked out as flag resets and
+    // data banks where the driver files give none.
+    void interpret();
+    bool load_data_bank(const char *filename);
+    bool load_data(const char *filename, bool is_ptr_data = false); //todo: separate
+    bool load_comments(const char *filename);
+    bool load_symbols(const char *filename, bool ram = false); //todo: separate
+    bool load_symbols2(const char *filename); //todo: rename
+    bool load_accum_bytes(char *fname, bool accum);//todo: rename
+    bool load_offsets(const char *filename); //load instructions whose targets need to be adjusted 
+    bool load_registers(const char *filename);
     void load_instruction_names(const char *filename);
+    void set_instruction_names(const std::shared_ptr<InstructionNameProvider>& names);
     void set_output_format(const char* output_format);
     void set_annotation_format(const char* output_format);
 
+    // Labels and comments are views of NUL terminated text that stays
+    // valid until the end of the current request.
     bool add_label(int bank, int pc, const std::string& label);
-    void mark_label_used(int bank, int pc, const std::string& label);
-    std::string get_instr_label(const InstructionMetadata& instr, unsigned char bank, int pc, int offset);
-    std::string get_line_label(bool use_addr_label);
+    void remove_label(int bank, int pc, const std::string& label); //if it is still there
+    void mark_label_used(int bank, int pc, std::string_view label);
+    std::string_view get_instr_label(const InstructionMetadata& instr, unsigned char bank, int pc, int offset);
+    std::string_view get_line_label(bool use_addr_label);
 
     int get_offset();
-    std::string get_comment();
+    std::string_view get_comment();
+    std::string_view get_register_comment(const InstructionMetadata& instr, unsigned int address, int comment_level);
     int get_data_bank() const;
 
-    void hirom(bool hirom);
-    bool hirom() const { return m_hirom; }
+    // Picks the mapper.  Switching to one with more ROM reallocates the
+    // byte properties, so it has to happen before the driver files load.
+    void memory_map(MemoryMap::Mapper mapper);
+    const MemoryMap& memory_map() const { return *m_map; }
+    void hirom(bool hirom) { memory_map(hirom ? MemoryMap::HiRom : MemoryMap::LoRom); } //--hirom
+    bool hirom() const { return m_map->mapper() != MemoryMap::LoRom; }
 
     inline void quiet(bool q) { m_quiet = q; }
     inline bool quiet() const { return m_quiet; }
 
     inline void passes(int passes) { m_passes_to_make = passes; }
+
+    // --cycles: listings show the cycles and master clocks of each
+    // instruction, see CycleTimer
+    void cycles(bool cycles) { m_cycles = cycles; m_range_cache.clear(); }
+    bool cycles() const { return m_cycles; }
     bool finalPass() const { return (m_current_pass == m_passes_to_make); }
     bool printInstructionBytes() const { return (!m_range_properties.m_quiet && finalPass()); }
 
+    const CoverageMap& coverage() const { return m_coverage; }
+    const ByteProperties* properties(unsigned int index) const; //by file offset, 0 past the end of the ROM
+    // For a session on an image with bytes inserted or deleted (--diff):
+    // the byte properties and coverage at each file offset become a copy
+    // of those at source(offset), or are left empty where that is past
+    // the end of the ROM.  The session no longer shares them.
+    void remap_properties(const std::function<unsigned int(unsigned int)>& source);
+
+    // Adds what the listing of request depends on, other than labels
+    // outside its range: the request, the output settings, and the ROM
+    // bytes, byte properties and coverage of the range.  For OutputCache.
+    void hash_request_inputs(const Request& request, ContentHash* hash);
+    // full addresses of the labels looked up outside the requested range
+    // are added to keys until this is called with 0
+    void record_extern_labels(std::vector<unsigned int>* keys) { m_extern_labels = keys; }
+    // the driver file, trace or RAM symbol at an address, as the first
+    // pass looks it up
+    std::string symbol_at(unsigned int full_address) const;
+    // the loaded labels by name, for Request::get
+    const LabelIndex& label_index() const { return *m_labels; }
+    // labels named pattern, or starting with it if it ends in *
+    void find_labels(const std::string& pattern, std::vector<const LabelIndex::Entry*>* matches) const;
+
     int header_size() const { return m_header_size; }
-    void header_size(int size) { m_header_size = size; }
+    void header_size(int size);
+
+    const RangeCache& range_cache() const { return m_range_cache; }
+
+    void collect_stats(); //--stats
+    const Stats* stats() const { return m_stats.get(); }
+    void memory_usage(MemoryUsage* usage) const;
 
     char read_next_byte();
 
 private:
-    std::string get_label_helper(unsigned int full_address, bool use_addr_label, bool mark_instruction_used, bool is_branch);
+    bool load_driver_file(DriverFile::Type type, const char* filename);
+    bool apply_driver_file(const DriverFile& file); //false at a fatal error, see load_driver_files
+    void revert_driver_entry(const DriverFileEntry& entry);
+    // ROM bytes a Data entry marks, decompressing a compressed block that
+    // gives no end; error is set if it doesn't decode
+    unsigned int data_size(const DriverFileEntry& entry, const char** error = 0);
+    void read_rom(unsigned int index, unsigned int size, std::vector<unsigned char>* bytes); //by file offset, as much as there is
+    void measure_rom(); //sets m_rom_size
+    // ROM the file has; the rest of what the mapper addresses as ROM is
+    // named and labelled like RAM
+    bool in_rom(const MemoryMap::Location& location) const
+    {
+        return location.m_region == MemoryMap::Rom && location.m_offset < m_rom_size;
+    }
+    std::string asset_name(unsigned int index) const; //the label of the asset at a file offset
+    std::string asset_filename(const std::string& name, const char* extension) const;
+    std::string_view get_label_helper(unsigned int full_address, bool use_addr_label, bool mark_instruction_used, bool is_branch);
     void disassembleRange(const Request& request);
-    void disassembleInstruction(const InstructionMetadata& instr, const std::string& label, const std::string& comment, int offset, int data_bank);
-    std::shared_ptr<OutputHandler> output_handler() const
+    void recordRange(const Request& request);
+    bool replayRange(const Request& request);
+    // instantiated for each annotation dialect, which doPtr and doDisasm
+    // pick once per segment
+    template<class Dialect> void disassemblePointers(bool long_ptrs);
+    template<class Dialect> void disassembleCode();
+    template<class Dialect> void disassembleInstruction(const InstructionMetadata& instr, std::string_view label, std::string_view comment, int offset, int data_bank, unsigned int address);
+    const std::shared_ptr<OutputHandler>& output_handler() const
     {
         return finalPass() ? m_output_handler : m_noop_handler;
     }
-
-    std::map<int, InstructionMetadata> m_instruction_lookup;
-    std::map<int, std::string> m_ram_lookup;
+    std::shared_ptr<OutputHandler> timed(const std::shared_ptr<OutputHandler>& handler);
+    void trace_bank(int bank); //ends the current bank event and starts one for bank, if it's a new one
+    void allocate_properties();
+    void index_segments(); //after the types in m_data change
+    const CycleTimer& timer(); //reads the ROM on first use, which moves the file position
+
+    const std::vector<InstructionMetadata>* m_instruction_lookup; //shared, see instruction_table
+    std::map<int, std::string> m_ram_lookup; //labels outside ROM, by canonical address
+    std::shared_ptr<LabelIndex> m_labels; //both of the above by name, shared by sessions
+    std::shared_ptr<const RegisterDatabase> m_registers; //the shared built in one until a --registers file is applied
     std::map<int, std::string> m_used_label_lookup;
     std::map<int, std::string> m_unresolved_symbol_lookup;
     
     // todo: make this a class
-    ByteProperties *m_data; 
+    ByteProperties *m_data; //by file offset, and one more entry for anything outside ROM
+    unsigned int m_data_size; //ROM bytes covered, the mapper's capacity
+    std::shared_ptr<ByteProperties> m_data_storage; //shared by sessions, read only once loaded
+    std::shared_ptr<const SegmentIndex> m_segments; //runs of m_data by type, shared like it
+    CoverageMap m_coverage; //instruction starts from --sym2 traces
+    RangeCache m_range_cache; //recent single pass requests
+    RangeCacheEntry* m_recording; //set while a cacheable request is decoded
+    std::vector<unsigned int>* m_extern_labels; //see record_extern_labels
+    Arena m_arena; //temporaries of the current request, reset when it ends
+    std::shared_ptr<Stats> m_stats; //null unless --stats
+    int m_trace_bank; //bank of the open --trace-out event, or -1
+    long long m_trace_bank_begin;
 
     DisassemblerProperties m_range_properties;
 
     bool m_quiet;
+    bool m_cycles;
+    std::shared_ptr<const CycleTimer> m_timer; //for --cycles and cost requests, shared by sessions once read
     int m_current_pass;
     int m_passes_to_make;
     int m_flag; //indicates whether accum/index have changed size during the current instruction
 
     DisassemblerState m_state;
 
-    bool m_hirom;
-    int m_start;
+    const MemoryMap* m_map; //shared, see MemoryMap::get
+    int m_start; //canonical
     int m_end;
 
+    std::ostream* m_out;
+    std::ostream* m_log;
+    std::string m_output_format;
+    std::string m_asset_dir; //where extract_assets wrote, for .INCBIN
     std::shared_ptr<OutputHandler> m_noop_handler;
     std::shared_ptr<OutputHandler> m_output_handler;
     std::shared_ptr<InstructionNameProvider> m_instruction_name_provider;
-    std::shared_ptr<AnnotationProvider> m_annotation_provider;
+    Annotations::Dialect m_annotations;
 
     FILE* m_rom_file;
     int m_header_size;
+    unsigned int m_rom_size; //bytes of the file past the header
 };
 
 #endif
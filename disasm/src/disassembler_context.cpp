@@ -1,11 +1,12 @@
 #include "disassembler_context.h"
 #include "disassembler.h"
+#include "instruction.h"
 #include "utils.h"
 
 using namespace Address;
 
 DisassemblerContext::DisassemblerContext(Disassembler* disasm, const InstructionMetadata& instr, DisassemblerState* s, int* flag, int data_bank, int offset)
-    : d(*disasm), state(*s), i(instr), m_flag(*flag), m_data_bank(data_bank), m_offset(offset)
+    : m_flag(*flag), m_data_bank(data_bank), m_offset(offset), d(*disasm), state(*s), i(instr)
 { }
 
 unsigned char DisassemblerContext::read_next_byte(int* pc)
@@ -43,7 +44,17 @@ void DisassemblerContext::set_index_16(bool is_16)
     state.is_index_16bit(is_16);
 }
 
-std::string DisassemblerContext::get_label(unsigned char data_bank, unsigned int pc)
+std::string_view DisassemblerContext::get_label(unsigned char data_bank, unsigned int pc)
 {
     return d.get_instr_label(i, data_bank, pc, m_offset);
 }
+
+std::string_view DisassemblerContext::get_register_comment(unsigned int address, int comment_level)
+{
+    return d.get_register_comment(i, address, comment_level);
+}
+
+void DisassemblerContext::immediate_loaded(int value)
+{
+    state.immediate_loaded(i.opcode(), value);
+}
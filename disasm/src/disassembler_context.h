@@ -1,4 +1,4 @@
-#include <string>
+#include <string_view>
 
 struct Disassembler;
 struct DisassemblerState;
@@ -21,7 +21,9 @@ struct DisassemblerContext
     bool is_accum_16() const;
     bool is_index_16() const;
     
-    std::string get_label(unsigned char data_bank, unsigned int pc);
+    std::string_view get_label(unsigned char data_bank, unsigned int pc); //NUL terminated, see Disassembler
+    std::string_view get_register_comment(unsigned int address, int comment_level);
+    void immediate_loaded(int value);
 
 private:
     int& m_flag; //todo: move to disasmstate?
@@ -0,0 +1,394 @@
+#include <fstream>
+#include <future>
+#include <sstream>
+#include "driver_file.h"
+#include "compression.h"
+#include "stats.h"
+#include "thread_pool.h"
+#include "tiles.h"
+#include "trace_events.h"
+#include "utils.h"
+
+using namespace std;
+using namespace Address;
+using Input::is_comment;
+
+namespace{
+    istream& get_full_address(istream& in, unsigned int* full)
+    {
+        in >> hex >> *full;
+        return in;
+    }
+
+    istream& get_raw_address(istream& in, unsigned char* bank, unsigned int* addr)
+    {
+        unsigned int full;
+        if (!(in >> hex >> full))
+            return in;
+
+        *addr = addr16_from_addr24(full);
+        *bank = bank_from_addr24(full);
+
+        return in;
+    }
+
+    // data files may give a LoROM address as its file offset within the bank
+    istream& get_data_address(istream& in, const MemoryMap& map, unsigned char* bank, unsigned int* addr)
+    {
+        if (get_raw_address(in, bank, addr) && *addr < 0x8000 && !map.is_rom(full_address(*bank, *addr)))
+            *addr += 0x8000;
+
+        return in;
+    }
+
+    // takes the next word if it names a compression or tile format, and
+    // gives the type it marks the data with
+    bool get_data_format(istream& in, int* type)
+    {
+        streampos position = in.tellg();
+        string name;
+        CompressionFormat compression;
+        TileFormat tiles;
+        if (in >> name){
+            if (parse_compression_format(name, &compression)){
+                *type = compression;
+                return true;
+            }
+            if (parse_tile_format(name, &tiles)){
+                *type = tiles;
+                return true;
+            }
+        }
+        in.clear();
+        in.seekg(position);
+        return false;
+    }
+
+    // bytes of ROM from one address up to another, 0 unless both are ROM
+    // or the end is just past it
+    unsigned int rom_size(const MemoryMap& map, unsigned char bank, unsigned int addr, unsigned char end_bank, unsigned int end_addr)
+    {
+        unsigned int start = full_address(bank, addr);
+        unsigned int end = full_address(end_bank, end_addr);
+        if (end <= start || !map.is_rom(start))
+            return 0;
+        unsigned int first = map.rom_index(start);
+        unsigned int last;
+        if (map.is_rom(end))
+            last = map.rom_index(end);
+        else if (map.is_rom(end - 1))
+            last = map.rom_index(end - 1) + 1;
+        else
+            return 0;
+        return last >= first ? last - first : 0;
+    }
+
+    DriverFileEntry make_entry(DriverFileEntry::Kind kind, unsigned char bank, unsigned int addr)
+    {
+        DriverFileEntry entry(kind);
+        entry.m_bank = bank;
+        entry.m_addr = addr;
+        return entry;
+    }
+
+    void parse_data_bank(istream& in, const MemoryMap& map, vector<DriverFileEntry>& entries)
+    {
+        string line;
+        while (getline(in, line)){
+            if (is_comment(line)) continue;
+
+            istringstream line_stream(line);
+
+            unsigned char bank = 0, end_bank = 0;
+            unsigned int addr = 0, end_addr = 0;
+            int data_bank = 0;
+            if (!get_data_address(line_stream, map, &bank, &addr) ||
+                !get_data_address(line_stream, map, &end_bank, &end_addr) ||
+                !(line_stream >> hex >> data_bank)){
+                entries.push_back(DriverFileEntry(DriverFileEntry::Message, "Couldn't read data bank line: " + line));
+                continue;
+            }
+
+            DriverFileEntry entry = make_entry(DriverFileEntry::DataBank, bank, addr);
+            entry.m_size = rom_size(map, bank, addr, end_bank, end_addr);
+            entry.m_value = data_bank;
+            entries.push_back(entry);
+        }
+    }
+
+    void parse_data(istream& in, bool is_ptr_data, const MemoryMap& map, vector<DriverFileEntry>& entries)
+    {
+        string line;
+        while (getline(in, line)){
+            if (is_comment(line)) continue;
+
+            string label;
+            istringstream line_stream(line);
+
+            unsigned char bank = 0, end_bank = 0;
+            unsigned int addr = 0, end_addr = 0;
+            if (!get_data_address(line_stream, map, &bank, &addr))
+                continue;
+
+            // a compressed block may leave its end to the decompressor
+            int format = 0;
+            bool formatted = !is_ptr_data && get_data_format(line_stream, &format);
+            unsigned int size = 0;
+            if (!formatted){
+                if (!get_data_address(line_stream, map, &end_bank, &end_addr)){
+                    end_addr = addr + 1;
+                    end_bank = bank;
+                }
+                else if (!is_ptr_data){
+                    formatted = get_data_format(line_stream, &format);
+                }
+                size = rom_size(map, bank, addr, end_bank, end_addr);
+            }
+
+            if (size > 0x80000){
+                ostringstream error;
+                error << "Error in data: " << line << endl
+                    << hex << size << " data bytes";
+                entries.push_back(DriverFileEntry(DriverFileEntry::Fatal, error.str()));
+                return;
+            }
+
+            DriverFileEntry entry = make_entry(DriverFileEntry::Data, bank, addr);
+            entry.m_size = size;
+
+            int flag_byte = 1;
+            if (is_ptr_data){
+                if (!(line_stream >> flag_byte)){
+                    // only fatal if the range isn't already claimed
+                    entry.m_error = "couldn't read pointer size in: " + line;
+                    entries.push_back(entry);
+                    continue;
+                }
+            }
+            if (formatted && size == 0 && is_tile_type(format))
+                entry.m_error = "couldn't read the end of the tiles in: " + line;
+            entry.m_value = formatted ? format : flag_byte;
+
+            //no label, create one
+            if (!(line_stream >> label)){
+                string prefix = "DATA_";
+                if (flag_byte == 2) prefix = "Ptrs";
+                else if (flag_byte == 3) prefix = "PtrsLong";
+                label = prefix + to_string(bank, 2) + to_string(addr, 4);
+            }
+            entry.m_text = label;
+
+            entries.push_back(entry);
+        }
+    }
+
+    void parse_comments(istream& in, const MemoryMap& map, vector<DriverFileEntry>& entries)
+    {
+        entries.push_back(DriverFileEntry(DriverFileEntry::Message, "; Reading comments"));
+        string line;
+        while (getline(in, line)){
+            if (is_comment(line)) continue;
+
+            istringstream ss(line);
+            unsigned char bank = 0;
+            unsigned int addr = 0;
+            if (!get_data_address(ss, map, &bank, &addr))
+                continue;
+
+            ss.get(); //consume space delimiter
+
+            string comment;
+            if (!getline(ss, comment)) continue;
+
+            DriverFileEntry entry = make_entry(DriverFileEntry::Comment, bank, addr);
+            entry.m_text = comment;
+            entries.push_back(entry);
+        }
+        entries.push_back(DriverFileEntry(DriverFileEntry::Message, "; Reading comments... done."));
+    }
+
+    void parse_symbols(istream& in, bool ram, vector<DriverFileEntry>& entries)
+    {
+        entries.push_back(DriverFileEntry(DriverFileEntry::Message, "; Reading symbols"));
+        string line;
+        while (getline(in, line)){
+            if (is_comment(line)) continue;
+
+            string label;
+            istringstream line_stream(line);
+
+            unsigned int addr = 0;
+            unsigned char bank = 0;
+            if (!get_raw_address(line_stream, &bank, &addr))
+                continue;
+
+            if (!(line_stream >> label)){
+                if (ram) label = "RAM_" + to_string(addr, 4);
+                else label = "CODE_" + to_string(bank, 2) + to_string(addr, 4);
+            }
+
+            DriverFileEntry entry = make_entry(DriverFileEntry::Label, bank, addr);
+            entry.m_text = label;
+            entries.push_back(entry);
+        }
+        entries.push_back(DriverFileEntry(DriverFileEntry::Message, "; Reading symbols... done."));
+    }
+
+    void parse_trace_symbols(const string& filename, DriverFile* file, const MemoryMap& map)
+    {
+        vector<DriverFileEntry>& entries = file->m_entries;
+        entries.push_back(DriverFileEntry(DriverFileEntry::Message, "using method 2"));
+        entries.push_back(DriverFileEntry(DriverFileEntry::Message, "; Reading symbols"));
+
+        // labels are produced lazily from the coverage bits
+        file->m_coverage = make_shared<CoverageMap>();
+        if (file->m_coverage->load(filename, map))
+            entries.push_back(DriverFileEntry(DriverFileEntry::Coverage));
+
+        entries.push_back(DriverFileEntry(DriverFileEntry::Message, "; Reading symbols... done."));
+    }
+
+    void parse_flags(istream& in, vector<DriverFileEntry>& entries)
+    {
+        string line;
+        while (getline(in, line)){
+            if (is_comment(line)) continue;
+            istringstream line_stream(line);
+
+            string type;
+            unsigned int fulladdr;
+            int bytes;
+            if (!(line_stream >> hex >> fulladdr >> type >> dec >> bytes)) continue;
+
+            unsigned char bank = bank_from_addr24(fulladdr);
+            unsigned int addr = addr16_from_addr24(fulladdr);
+
+            if (type == "A" || type == "AI" || type == "IA"){
+                DriverFileEntry entry = make_entry(DriverFileEntry::AccumFlag, bank, addr);
+                entry.m_value = bytes;
+                entries.push_back(entry);
+            }
+            if (type == "I" || type == "AI" || type == "IA"){
+                DriverFileEntry entry = make_entry(DriverFileEntry::IndexFlag, bank, addr);
+                entry.m_value = bytes;
+                entries.push_back(entry);
+            }
+        }
+    }
+
+    void parse_offsets(istream& in, vector<DriverFileEntry>& entries)
+    {
+        string line;
+        while (getline(in, line)){
+            if (is_comment(line)) continue;
+
+            istringstream ss(line);
+            unsigned int hex_addr;
+            if (!get_full_address(ss, &hex_addr)) continue;
+
+            int offset = 1;
+            if (!(ss >> dec >> offset)){
+                entries.push_back(DriverFileEntry(DriverFileEntry::Fatal, "couldn't read offset size in: " + line));
+                return;
+            }
+
+            DriverFileEntry entry = make_entry(DriverFileEntry::Offset,
+                bank_from_addr24(hex_addr), addr16_from_addr24(hex_addr));
+            entry.m_value = offset;
+            entry.m_text = line;
+            entries.push_back(entry);
+        }
+    }
+
+    void parse_registers(istream& in, vector<DriverFileEntry>& entries)
+    {
+        entries.push_back(DriverFileEntry(DriverFileEntry::Message, "; Reading registers"));
+        string line;
+        while (getline(in, line)){
+            if (is_comment(line)) continue;
+
+            istringstream ss(line);
+            unsigned int addr = 0;
+            if (!get_full_address(ss, &addr))
+                continue;
+            if (addr > 0xFFFF){
+                entries.push_back(DriverFileEntry(DriverFileEntry::Message, "Register address out of range: " + line));
+                continue;
+            }
+
+            string text;
+            if (!getline(ss, text)) continue;
+
+            DriverFileEntry entry = make_entry(DriverFileEntry::Register, 0, addr);
+            entry.m_text = text;
+            entries.push_back(entry);
+        }
+        entries.push_back(DriverFileEntry(DriverFileEntry::Message, "; Reading registers... done."));
+    }
+}
+
+const char* driver_file_type_name(DriverFile::Type type)
+{
+    switch (type)
+    {
+    case DriverFile::DataBank: return "data banks";
+    case DriverFile::Data: return "data";
+    case DriverFile::Pointers: return "pointers";
+    case DriverFile::Comments: return "comments";
+    case DriverFile::Symbols: return "symbols";
+    case DriverFile::RamSymbols: return "ram symbols";
+    case DriverFile::TraceSymbols: return "trace symbols";
+    case DriverFile::Flags: return "flags";
+    case DriverFile::Offsets: return "offsets";
+    case DriverFile::Registers: return "registers";
+    }
+    return "";
+}
+
+void parse_driver_file(DriverFile* file, const MemoryMap& map)
+{
+    Trace::Scope trace(driver_file_type_name(file->m_type), "parse");
+    double start = Stats::wall_time();
+    ifstream in(file->m_filename.c_str());
+    vector<DriverFileEntry>& entries = file->m_entries;
+
+    switch (file->m_type)
+    {
+    case DriverFile::DataBank: parse_data_bank(in, map, entries); break;
+    case DriverFile::Data: parse_data(in, false, map, entries); break;
+    case DriverFile::Pointers: parse_data(in, true, map, entries); break;
+    case DriverFile::Comments: parse_comments(in, map, entries); break;
+    case DriverFile::Symbols: parse_symbols(in, false, entries); break;
+    case DriverFile::RamSymbols: parse_symbols(in, true, entries); break;
+    case DriverFile::TraceSymbols: parse_trace_symbols(file->m_filename, file, map); break;
+    case DriverFile::Flags: parse_flags(in, entries); break;
+    case DriverFile::Offsets: parse_offsets(in, entries); break;
+    case DriverFile::Registers: parse_registers(in, entries); break;
+    }
+    file->m_parse_time = Stats::wall_time() - start;
+}
+
+void parse_driver_files(vector<DriverFile>* files, const MemoryMap& map)
+{
+    if (files->size() < 2){
+        for (size_t i = 0; i < files->size(); ++i){
+            parse_driver_file(&(*files)[i], map);
+        }
+        return;
+    }
+
+    unsigned int threads = thread::hardware_concurrency();
+    if (threads == 0 || threads > files->size())
+        threads = (unsigned int)files->size();
+
+    ThreadPool pool(threads);
+    vector<future<void> > results;
+    for (size_t i = 0; i < files->size(); ++i){
+        DriverFile* file = &(*files)[i];
+        const MemoryMap* memory_map = &map;
+        results.push_back(pool.submit([file, memory_map](){ parse_driver_file(file, *memory_map); }));
+    }
+    for (size_t i = 0; i < results.size(); ++i){
+        results[i].get();
+    }
+}
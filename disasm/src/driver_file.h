@@ -0,0 +1,62 @@
+#ifndef DRIVER_FILE_H
+#define DRIVER_FILE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "coverage.h"
+#include "memory_map.h"
+
+// A single record parsed out of a driver file.  Diagnostics are staged
+// alongside the records so that merging reproduces the serial output.
+struct DriverFileEntry
+{
+    enum Kind { Message, Fatal, Comment, Label, Coverage, Data, DataBank, Offset, AccumFlag, IndexFlag, Register };
+
+    DriverFileEntry(Kind kind, const std::string& text = "") :
+    m_kind(kind),
+    m_bank(0),
+    m_addr(0),
+    m_size(0),
+    m_value(0),
+    m_text(text)
+    {}
+
+    Kind m_kind;
+    unsigned char m_bank;
+    unsigned int m_addr;
+    unsigned int m_size;
+    int m_value;
+    std::string m_text;
+    std::string m_error; //fatal error to report if the entry is applied
+};
+
+struct DriverFile
+{
+    enum Type { DataBank, Data, Pointers, Comments, Symbols, RamSymbols, TraceSymbols, Flags, Offsets, Registers };
+
+    DriverFile(Type type, const std::string& filename) :
+    m_type(type),
+    m_filename(filename),
+    m_parse_time(0)
+    {}
+
+    Type m_type;
+    std::string m_filename;
+    std::vector<DriverFileEntry> m_entries;
+    std::shared_ptr<CoverageMap> m_coverage; //trace files only
+    double m_parse_time; //wall clock seconds, set by parse_driver_file
+};
+
+const char* driver_file_type_name(DriverFile::Type type);
+
+// Parsing only touches the DriverFile itself, so independent files can
+// be parsed concurrently.  Entries are applied later, in file order.
+// Data ranges are measured in ROM bytes, which depends on the mapper.  A
+// data file line may mark its range as compressed (see CompressionFormat)
+// or as tiles (see TileFormat); a compressed one that gives no end has
+// size 0 and is measured from the ROM when it is applied.
+void parse_driver_file(DriverFile* file, const MemoryMap& map);
+void parse_driver_files(std::vector<DriverFile>* files, const MemoryMap& map);
+
+#endif
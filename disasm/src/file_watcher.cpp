@@ -0,0 +1,100 @@
+#include <algorithm>
+#ifdef __linux__
+#include <errno.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+#include "file_watcher.h"
+
+using namespace std;
+
+namespace{
+#ifdef __linux__
+    const uint32_t WRITE_EVENTS = IN_CLOSE_WRITE | IN_MOVED_TO;
+#endif
+}
+
+FileWatcher::FileWatcher() :
+m_inotify(-1)
+{
+#ifdef __linux__
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+#ifdef __linux__
+    if (m_inotify >= 0)
+        close(m_inotify);
+#endif
+}
+
+size_t FileWatcher::add(const string& filename)
+{
+    filesystem::path path(filename);
+    File file;
+    file.m_filename = filename;
+    file.m_directory = path.has_parent_path() ? path.parent_path().string() : ".";
+    file.m_name = path.filename().string();
+    file.m_watch = -1;
+    stat_file(&file);
+
+#ifdef __linux__
+    // a directory is only watched once; inotify hands back the same descriptor
+    if (m_inotify >= 0)
+        file.m_watch = inotify_add_watch(m_inotify, file.m_directory.c_str(), WRITE_EVENTS);
+#endif
+    m_files.push_back(file);
+    return m_files.size() - 1;
+}
+
+vector<size_t> FileWatcher::changed()
+{
+    vector<size_t> changed;
+
+#ifdef __linux__
+    if (m_inotify >= 0){
+        alignas(inotify_event) char buffer[4096];
+        for (;;){
+            ssize_t length = read(m_inotify, buffer, sizeof(buffer));
+            if (length <= 0)
+                break;
+            for (ssize_t offset = 0; offset < length;){
+                const inotify_event* event = (const inotify_event*)(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+                if (event->len == 0)
+                    continue;
+                for (size_t i = 0; i < m_files.size(); ++i){
+                    if (m_files[i].m_watch == event->wd && m_files[i].m_name == event->name)
+                        changed.push_back(i);
+                }
+            }
+        }
+    }
+#endif
+
+    for (size_t i = 0; i < m_files.size(); ++i){
+        File& file = m_files[i];
+        if (file.m_watch >= 0)
+            continue;
+        filesystem::file_time_type time = file.m_time;
+        uintmax_t size = file.m_size;
+        stat_file(&file);
+        if (file.m_time != time || file.m_size != size)
+            changed.push_back(i);
+    }
+
+    sort(changed.begin(), changed.end());
+    changed.erase(unique(changed.begin(), changed.end()), changed.end());
+    return changed;
+}
+
+void FileWatcher::stat_file(File* file)
+{
+    error_code error;
+    file->m_time = filesystem::last_write_time(file->m_filename, error);
+    file->m_size = filesystem::file_size(file->m_filename, error);
+    if (error)
+        file->m_size = 0;
+}
@@ -0,0 +1,47 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Tells which of a set of files were written since it last asked, for
+// --watch.  Uses inotify on the files' directories where there is one, so
+// that asking costs a read() that returns at once, and falls back to
+// comparing modification times and sizes elsewhere.  Directories are
+// watched rather than files so that editors that save by renaming a new
+// file over the old one are noticed too.
+struct FileWatcher
+{
+    FileWatcher();
+    ~FileWatcher();
+
+    // returns the file's number for changed()
+    size_t add(const std::string& filename);
+
+    // the numbers of the files changed since the last call, each once
+    std::vector<size_t> changed();
+
+private:
+    FileWatcher(const FileWatcher&);
+    FileWatcher& operator=(const FileWatcher&);
+
+    struct File
+    {
+        std::string m_filename;
+        std::string m_directory;
+        std::string m_name; //within m_directory
+        int m_watch; //inotify watch descriptor, or -1
+        std::filesystem::file_time_type m_time; //when polling
+        uintmax_t m_size;
+    };
+
+    static void stat_file(File* file);
+
+    std::vector<File> m_files;
+    int m_inotify; //-1 when polling
+};
+
+#endif
@@ -1,24 +1,91 @@
 #include <cstdarg>
+#include <cstdio>
 #include <iomanip>
 #include <iostream>
+#include "arena.h"
 #include "disassembler.h"
 #include "instruction.h"
-#include "annotation_handlers.h"
+#include "instruction_handlers.h"
 #include "utils.h"
 
 using namespace std;
 
+namespace{
+    typedef void(*HandlerPtr)(DisassemblerContext*, Instruction*);
+
+    struct HandlerMode
+    {
+        HandlerPtr m_handler;
+        AddressMode m_mode;
+    };
+
+    // jumps and calls through an absolute address take it from the program
+    // bank rather than the data bank, which the walker decides by opcode
+    const HandlerMode ADDRESS_MODES[] = {
+        { &InstructionHandler::Implied, { "implied", 0, AddressMode::Fixed, AddressMode::NoTarget } },
+        { &InstructionHandler::Accumulator, { "accumulator", 0, AddressMode::Fixed, AddressMode::NoTarget } },
+        { &InstructionHandler::Immediate, { "immediate", 1, AddressMode::Accum, AddressMode::NoTarget } },
+        { &InstructionHandler::ImmediateXY, { "immediate", 1, AddressMode::Index, AddressMode::NoTarget } },
+        { &InstructionHandler::ImmediateREP, { "immediate", 1, AddressMode::Fixed, AddressMode::NoTarget } },
+        { &InstructionHandler::ImmediateSEP, { "immediate", 1, AddressMode::Fixed, AddressMode::NoTarget } },
+        { &InstructionHandler::Absolute, { "absolute", 2, AddressMode::Fixed, AddressMode::Absolute } },
+        { &InstructionHandler::AbsoluteIndexedX, { "absolute,x", 2, AddressMode::Fixed, AddressMode::Absolute } },
+        { &InstructionHandler::AbsoluteIndexedY, { "absolute,y", 2, AddressMode::Fixed, AddressMode::Absolute } },
+        { &InstructionHandler::AbsoluteLong, { "long", 3, AddressMode::Fixed, AddressMode::Long } },
+        { &InstructionHandler::AbsoluteLongIndexedX, { "long,x", 3, AddressMode::Fixed, AddressMode::Long } },
+        { &InstructionHandler::AbsoluteIndirect, { "(absolute)", 2, AddressMode::Fixed, AddressMode::NoTarget } },
+        { &InstructionHandler::AbsoluteIndirectLong, { "[absolute]", 2, AddressMode::Fixed, AddressMode::NoTarget } },
+        { &InstructionHandler::AbsoluteIndexedIndirect, { "(absolute,x)", 2, AddressMode::Fixed, AddressMode::Absolute } },
+        { &InstructionHandler::DirectPage, { "direct", 1, AddressMode::Fixed, AddressMode::NoTarget } },
+        { &InstructionHandler::DPIndexedX, { "direct,x", 1, AddressMode::Fixed, AddressMode::NoTarget } },
+        { &InstructionHandler::DPIndexedY, { "direct,y", 1, AddressMode::Fixed, AddressMode::NoTarget } },
+        { &InstructionHandler::DPIndirect, { "(direct)", 1, AddressMode::Fixed, AddressMode::NoTarget } },
+        { &InstructionHandler::DPIndirectLong, { "[direct]", 1, AddressMode::Fixed, AddressMode::NoTarget } },
+        { &InstructionHandler::DPIndirectIndexedY, { "(direct),y", 1, AddressMode::Fixed, AddressMode::NoTarget } },
+        { &InstructionHandler::DPIndirectLongIndexedY, { "[direct],y", 1, AddressMode::Fixed, AddressMode::NoTarget } },
+        { &InstructionHandler::DPIndexedIndirectX, { "(direct,x)", 1, AddressMode::Fixed, AddressMode::NoTarget } },
+        { &InstructionHandler::StackRelative, { "stack,s", 1, AddressMode::Fixed, AddressMode::NoTarget } },
+        { &InstructionHandler::SRIndirectIndexedY, { "(stack,s),y", 1, AddressMode::Fixed, AddressMode::NoTarget } },
+        { &InstructionHandler::StackDPIndirect, { "push direct", 1, AddressMode::Fixed, AddressMode::NoTarget } },
+        { &InstructionHandler::StackPCRelativeLong, { "push absolute", 2, AddressMode::Fixed, AddressMode::NoTarget } },
+        { &InstructionHandler::ProgramCounterRelative, { "relative", 1, AddressMode::Fixed, AddressMode::Relative } },
+        { &InstructionHandler::ProgramCounterRelativeLong, { "relative long", 2, AddressMode::Fixed, AddressMode::Relative } },
+        { &InstructionHandler::BlockMove, { "block move", 2, AddressMode::Fixed, AddressMode::NoTarget } },
+        { &InstructionHandler::LongPointer, { "long pointer", 3, AddressMode::Fixed, AddressMode::NoTarget } },
+    };
+
+    const AddressMode UNKNOWN_MODE = { "unknown", 0, AddressMode::Fixed, AddressMode::NoTarget };
+
+    const AddressMode* find_address_mode(HandlerPtr handler)
+    {
+        for (const HandlerMode& entry : ADDRESS_MODES){
+            if (entry.m_handler == handler)
+                return &entry.m_mode;
+        }
+        return &UNKNOWN_MODE;
+    }
+}
+
 InstructionMetadata::InstructionMetadata() :
 m_opcode(0),
-m_instruction_handler(0)
+m_instruction_handler(0),
+m_address_mode(&UNKNOWN_MODE)
 { }
 
 InstructionMetadata::InstructionMetadata(const string& internal_name, unsigned int opcode, InstructionHandlerPtr address_mode_handler) :
 m_internal_name(internal_name),
 m_opcode(opcode),
-m_instruction_handler(address_mode_handler)
+m_instruction_handler(address_mode_handler),
+m_address_mode(find_address_mode(address_mode_handler))
 { }
 
+unsigned int InstructionMetadata::length(bool accum_16, bool index_16) const
+{
+    const AddressMode& mode = *m_address_mode;
+    bool wide = (mode.m_width == AddressMode::Accum && accum_16) || (mode.m_width == AddressMode::Index && index_16);
+    return 1 + mode.m_operand_bytes + (wide ? 1 : 0);
+}
+
 bool InstructionMetadata::isBranch() const 
 {
     return 
@@ -61,15 +128,18 @@ bool InstructionMetadata::isReturn() const
         m_opcode == 0x6B;   //RTL
 }
 
-Instruction::Instruction(const InstructionMetadata& metadata, shared_ptr<InstructionNameProvider> name_provider, shared_ptr<AnnotationProvider> annotation_provider, const DisassemblerState& state, int comment_level)
+Instruction::Instruction(const InstructionMetadata& metadata, shared_ptr<InstructionNameProvider> name_provider, const DisassemblerState& state, int comment_level, Arena* arena)
 : m_metadata(metadata),
-m_name_provider(name_provider), 
-m_annotation_provider(annotation_provider),
+m_bytes_length(0),
 m_is_address_symbolic(false),
-m_comment_level(comment_level),
 m_initial_accum_16(state.is_accum_16bit()), 
-m_initial_index_16(state.is_index_16bit())
+m_initial_index_16(state.is_index_16bit()),
+m_comment_level(comment_level),
+m_name_provider(name_provider), 
+m_annotation(""),
+m_arena(arena)
 {
+    m_bytes[0] = 0;
     address[0] = 0;
     additional_instruction[0] = 0;
     if (metadata.is_snes_instruction()){
@@ -77,30 +147,33 @@ m_initial_index_16(state.is_index_16bit())
     }
 }
 
-void Instruction::addInstructionBytes(unsigned char a)
+void Instruction::add_byte(unsigned char byte)
 {
-    instruction_bytes
-        << setw(2) << setfill('0') << uppercase << hex << (int)a << " ";
+    static const char digits[] = "0123456789ABCDEF";
+    if (m_bytes_length + 3 >= (int)sizeof(m_bytes))
+        return;
+    m_bytes[m_bytes_length++] = digits[byte >> 4];
+    m_bytes[m_bytes_length++] = digits[byte & 0x0F];
+    m_bytes[m_bytes_length++] = ' ';
+    m_bytes[m_bytes_length] = 0;
 }
 
-void Instruction::addInstructionBytes(unsigned char a, unsigned char b)
+void Instruction::addInstructionBytes(unsigned char a)
 {
-    instruction_bytes
-        << setw(2) << setfill('0') << uppercase << hex << (int)a << " "
-        << setw(2) << setfill('0') << uppercase << hex << (int)b << " ";
+    add_byte(a);
 }
 
-void Instruction::addInstructionBytes(unsigned char a, unsigned char b, unsigned char c)
+void Instruction::addInstructionBytes(unsigned char a, unsigned char b)
 {
-    instruction_bytes
-        << setw(2) << setfill('0') << uppercase << hex << (int)a << " "
-        << setw(2) << setfill('0') << uppercase << hex << (int)b << " "
-        << setw(2) << setfill('0') << uppercase << hex << (int)c << " ";
+    add_byte(a);
+    add_byte(b);
 }
 
-string Instruction::getInstructionBytes() const
+void Instruction::addInstructionBytes(unsigned char a, unsigned char b, unsigned char c)
 {
-    return instruction_bytes.str();
+    add_byte(a);
+    add_byte(b);
+    add_byte(c);
 }
 
 void Instruction::setSymbolicAddress(const char *format, ...)
@@ -109,7 +182,7 @@ void Instruction::setSymbolicAddress(const char *format, ...)
 
     va_list args;
     va_start(args, format);
-    vsprintf_s(address, format, args);
+    vsnprintf(address, sizeof(address), format, args);
     va_end(args);
 }
 
@@ -119,53 +192,56 @@ void Instruction::setDirectAddress(const char *format, ...)
 
     va_list args;
     va_start(args, format);
-    vsprintf_s(address, format, args);
+    vsnprintf(address, sizeof(address), format, args);
     va_end(args);
 }
 
-string Instruction::getAddress() const
-{
-    return address;
+namespace{
+    // one entry for each combination of the four flag bits
+    struct FlagComments
+    {
+        FlagComments()
+        {
+            for (int i = 0; i < 16; ++i){
+                if (i & 1) m_text[i] += "Index (16 bit) ";
+                if (i & 2) m_text[i] += "Accum (16 bit) ";
+                if (i & 4) m_text[i] += "Index (8 bit) ";
+                if (i & 8) m_text[i] += "Accum (8 bit) ";
+            }
+        }
+
+        string m_text[16];
+    };
 }
 
-string Instruction::flag_comment(int flags) const
+const string& Instruction::flag_comment(int flags) const
 {
-    string comment;
-    if (m_comment_level > 1 && flags != 0){
-        if (flags & 0x10) comment += "Index (16 bit) ";
-        if (flags & 0x20) comment += "Accum (16 bit) ";
-        if (flags & 0x01) comment += "Index (8 bit) ";
-        if (flags & 0x02) comment += "Accum (8 bit) ";
-    }
-    return comment;
+    static const FlagComments comments;
+    if (m_comment_level <= 1)
+        return comments.m_text[0];
+    int i = ((flags & 0x10) ? 1 : 0) | ((flags & 0x20) ? 2 : 0) | ((flags & 0x01) ? 4 : 0) | ((flags & 0x02) ? 8 : 0);
+    return comments.m_text[i];
 }
 
-string Instruction::annotatedName() const
+const string& Instruction::name() const
 {
-    string name = m_name_provider ? m_name_provider->get_name(m_metadata.opcode()) 
+    return m_name_provider ? m_name_provider->get_name(m_metadata.opcode()) 
         : m_metadata.internal_name();
-    string annotation = m_annotation_provider->get_annotation(m_metadata.opcode(), m_initial_accum_16, m_initial_index_16, isAddressSymbolic());
-    return name + annotation;
 }
 
-string Instruction::toString() const
+string_view Instruction::toString() const
 {
-    return annotatedName() + " " + getAddress();
+    return m_arena->join({ name(), m_annotation, " ", address });
 }
 
 void Instruction::setAdditionalInstruction(const char* format, ...)
 {
     va_list args;
     va_start(args, format);
-    vsprintf_s(additional_instruction, format, args);
+    vsnprintf(additional_instruction, sizeof(additional_instruction), format, args);
     va_end(args);
 }
 
-string Instruction::getAdditionalInstruction() const
-{
-    return additional_instruction;
-}
-
 InstructionNameProvider::InstructionNameProvider(std::istream& input)
 {
     string line;
@@ -187,11 +263,12 @@ InstructionNameProvider::InstructionNameProvider(std::istream& input)
     }
 }
 
-string InstructionNameProvider::get_name(int opcode) const
+const string& InstructionNameProvider::get_name(int opcode) const
 {
+    static const string unknown = "???";
     auto it = m_names.find(opcode);
     if (it != m_names.end()){
         return it->second;
     }
-    return "???";
+    return unknown;
 }
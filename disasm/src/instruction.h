@@ -1,30 +1,45 @@
 #include <map>
 #include <memory>
 #include <string>
-#include <sstream>
+#include <string_view>
+#include "memory_usage.h"
 
+struct Arena;
 struct DisassemblerContext;
 struct DisassemblerState;
 struct Instruction;
-struct AnnotationProvider;
 
 struct InstructionNameProvider
 {
     InstructionNameProvider(std::istream& input);
-    std::string get_name(int opcode) const;
+    const std::string& get_name(int opcode) const;
+    size_t size_in_bytes() const { return Memory::heap_bytes(m_names); }
 
 private:
     std::map<int, std::string> m_names;
 };
 
 
+// What an address mode handler reads, so that code can be walked without
+// decoding it to text.
+struct AddressMode
+{
+    enum Width { Fixed, Accum, Index }; //the register whose 16 bit mode adds a byte
+    enum Target { NoTarget, Absolute, Long, Relative }; //the ROM address an operand can name
+
+    const char* m_name;
+    unsigned int m_operand_bytes; //with 8 bit registers
+    Width m_width;
+    Target m_target;
+};
+
 class InstructionMetadata{
     typedef void(*InstructionHandlerPtr)(DisassemblerContext*, Instruction*);
 public:
     InstructionMetadata();
     InstructionMetadata(const std::string& internal_name, unsigned int opcode, InstructionHandlerPtr address_mode_handler);
 
-    std::string internal_name() const {
+    const std::string& internal_name() const {
         return m_internal_name;
     }
 
@@ -45,37 +60,50 @@ public:
     bool isCodeBreak() const { return isReturn() || isJump(); }
 
     InstructionHandlerPtr handler() const { return m_instruction_handler; }
+    const AddressMode& address_mode() const { return *m_address_mode; }
+    // opcode and operand bytes
+    unsigned int length(bool accum_16, bool index_16) const;
 
 private:
     std::string m_internal_name;
     unsigned int m_opcode;
 
     InstructionHandlerPtr m_instruction_handler;
+    const AddressMode* m_address_mode; //static, see ADDRESS_MODES
 };
 
 struct Instruction
 {
-    Instruction(const InstructionMetadata& metadata, std::shared_ptr<InstructionNameProvider> name_provider, std::shared_ptr<AnnotationProvider> annotation_provider, const DisassemblerState& state, int comment_level);
+    // text that outlives the handlers (toString) is placed in the arena
+    Instruction(const InstructionMetadata& metadata, std::shared_ptr<InstructionNameProvider> name_provider, const DisassemblerState& state, int comment_level, Arena* arena);
     
     void addInstructionBytes(unsigned char a);
     void addInstructionBytes(unsigned char a, unsigned char b);
     void addInstructionBytes(unsigned char a, unsigned char b, unsigned char c);
-    std::string getInstructionBytes() const;
+    const char* getInstructionBytes() const { return m_bytes; }
 
     void setDirectAddress(const char *format, ...);
     void setSymbolicAddress(const char *format, ...);
-    std::string getAddress() const;
+    const char* getAddress() const { return address; }
     bool isAddressSymbolic() const { return m_is_address_symbolic;  }
 
-    std::string annotatedName() const;
-    std::string toString() const;
+    // the size suffix, a string literal from the annotation dialect's table
+    void setAnnotation(const char* annotation) { m_annotation = annotation; }
+    bool initialAccum16() const { return m_initial_accum_16; }
+    bool initialIndex16() const { return m_initial_index_16; }
+
+    const std::string& name() const;
+    std::string_view toString() const;
 
     void setAdditionalInstruction(const char* format, ...);
-    std::string getAdditionalInstruction() const;
+    const char* getAdditionalInstruction() const { return additional_instruction; }
 
-    void set_ram_comment(const std::string& ram_comment) { m_ram_comment = ram_comment; }
-    std::string ram_comment() const { return m_ram_comment; }
-    std::string flag_comment(int flags) const;
+    void set_ram_comment(std::string_view ram_comment) { m_ram_comment = ram_comment; }
+    std::string_view ram_comment() const { return m_ram_comment; }
+    // --cycles: the CycleCost::text of the instruction, in the arena
+    void set_cycles(std::string_view cycles) { m_cycles = cycles; }
+    std::string_view cycles() const { return m_cycles; }
+    const std::string& flag_comment(int flags) const;
 
     int comment_level() const { return m_comment_level; }
 
@@ -83,14 +111,19 @@ struct Instruction
 
 private:
     InstructionMetadata m_metadata;
-    std::ostringstream instruction_bytes;
+    void add_byte(unsigned char byte);
+
+    char m_bytes[16]; //"xx " for up to four bytes
+    int m_bytes_length;
     char address[80];
     bool m_is_address_symbolic;
     char additional_instruction[80];
     bool m_initial_accum_16;
     bool m_initial_index_16;
     int m_comment_level;
-    std::string m_ram_comment;
+    std::string_view m_ram_comment; //see Disassembler::get_register_comment
+    std::string_view m_cycles;
     std::shared_ptr<InstructionNameProvider> m_name_provider;
-    std::shared_ptr<AnnotationProvider> m_annotation_provider;
+    const char* m_annotation;
+    Arena* m_arena;
 };
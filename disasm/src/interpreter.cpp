@@ -0,0 +1,895 @@
+#include <cstring>
+#include <string>
+#include "instruction.h"
+#include "interpreter.h"
+#include "memory_map.h"
+#include "segment_index.h"
+#include "utils.h"
+
+using namespace std;
+using namespace Address;
+
+namespace{
+    typedef Interpreter::State State;
+
+    static_assert(sizeof(State) % 8 == 0, "states are hashed a word at a time");
+
+    const size_t INITIAL_VISITED = 1 << 16;
+
+    enum { FLAG_C = 0x01, FLAG_X = 0x10, FLAG_M = 0x20 };
+    enum Mode { OtherMode, DirectMode, AbsoluteMode };
+    enum Effect { WritesA = 0x01, WritesX = 0x02, WritesY = 0x04, WritesCarry = 0x08,
+        StoresA = 0x10, StoresX = 0x20, StoresY = 0x40, StoresZero = 0x80, Modifies = 0x100 };
+
+    struct MnemonicEffects
+    {
+        const char* m_name;
+        unsigned short m_effects;
+    };
+
+    // what the instructions without a case of their own do to the state;
+    // the shifts and INC/DEC of the accumulator write A instead
+    const MnemonicEffects EFFECTS[] = {
+        { "ADC", WritesA | WritesCarry }, { "SBC", WritesA | WritesCarry },
+        { "AND", WritesA }, { "ORA", WritesA }, { "EOR", WritesA }, { "LDA", WritesA }, { "TSC", WritesA },
+        { "LDX", WritesX }, { "TSX", WritesX }, { "LDY", WritesY },
+        { "CMP", WritesCarry }, { "CPX", WritesCarry }, { "CPY", WritesCarry },
+        { "ASL", Modifies | WritesCarry }, { "LSR", Modifies | WritesCarry },
+        { "ROL", Modifies | WritesCarry }, { "ROR", Modifies | WritesCarry },
+        { "INC", Modifies }, { "DEC", Modifies }, { "TRB", Modifies }, { "TSB", Modifies },
+        { "STA", StoresA }, { "STX", StoresX }, { "STY", StoresY }, { "STZ", StoresZero },
+    };
+
+    // the vectors at $00:FFE4-$00:FFFF, ABORT aside
+    struct Vector
+    {
+        unsigned int m_address;
+        bool m_emulation;
+    };
+
+    const Vector VECTORS[] = {
+        { 0xFFFC, true }, //RESET
+        { 0xFFEA, false }, { 0xFFEE, false }, { 0xFFE4, false }, { 0xFFE6, false }, //NMI, IRQ, COP, BRK
+        { 0xFFFA, true }, { 0xFFFE, true }, { 0xFFF4, true },
+    };
+
+    // bits that aren't known don't tell states apart, so they are cleared
+    // before states are hashed or compared
+    State masked(State state)
+    {
+        state.m_a &= state.m_a_known;
+        state.m_x &= state.m_x_known;
+        state.m_y &= state.m_y_known;
+        state.m_d &= state.m_d_known;
+        state.m_p &= state.m_p_known;
+        state.m_dbr &= state.m_dbr_known;
+        for (unsigned int i = 0; i < state.m_depth; ++i){
+            state.m_stack[i] &= state.m_stack_known[i];
+        }
+        return state;
+    }
+
+    uint64_t hash_state(const State& state)
+    {
+        uint64_t words[sizeof(State) / 8];
+        memcpy(words, &state, sizeof(words));
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (uint64_t word : words){
+            hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+            hash ^= hash >> 29;
+        }
+        return hash ? hash : 1;
+    }
+
+    // 1 for 16 bits, 0 for 8 and -1 when not known
+    int accum_16(const State& s) { return (s.m_p_known & FLAG_M) ? !(s.m_p & FLAG_M) : -1; }
+    int index_16(const State& s) { return (s.m_p_known & FLAG_X) ? !(s.m_p & FLAG_X) : -1; }
+
+    // 8 bit index registers have a high byte of 0
+    void narrow_index(State* s)
+    {
+        s->m_x &= 0xFF;
+        s->m_y &= 0xFF;
+        s->m_x_known |= 0xFF00;
+        s->m_y_known |= 0xFF00;
+    }
+
+    // writes the bits of A the accumulator width covers, B too if unknown
+    void set_accum(State* s, unsigned int value, unsigned int known)
+    {
+        int wide = accum_16(*s);
+        unsigned int mask = wide == 0 ? 0xFF : 0xFFFF;
+        if (wide < 0)
+            known = 0;
+        s->m_a = (uint16_t)((s->m_a & ~mask) | (value & mask));
+        s->m_a_known = (uint16_t)((s->m_a_known & ~mask) | (known & mask));
+    }
+
+    void set_index(const State& s, uint16_t* reg, uint16_t* reg_known, unsigned int value, unsigned int known)
+    {
+        int wide = index_16(s);
+        if (wide == 0){
+            *reg = value & 0xFF;
+            *reg_known = (uint16_t)((known & 0xFF) | 0xFF00);
+        }
+        else{
+            *reg = (uint16_t)value;
+            *reg_known = wide > 0 ? (uint16_t)known : 0;
+        }
+    }
+
+    void step_index(const State& s, uint16_t* reg, uint16_t* reg_known, int delta)
+    {
+        unsigned int mask = index_16(s) == 0 ? 0xFF : 0xFFFF;
+        if (index_16(s) >= 0 && (*reg_known & mask) == mask)
+            set_index(s, reg, reg_known, *reg + delta, 0xFFFF);
+        else
+            set_index(s, reg, reg_known, 0, 0);
+    }
+
+    void set_flags(State* s, unsigned int p, unsigned int known)
+    {
+        s->m_p = (uint8_t)p;
+        s->m_p_known = (uint8_t)known;
+        if (s->m_emulation == 1){
+            s->m_p |= FLAG_M | FLAG_X;
+            s->m_p_known |= FLAG_M | FLAG_X;
+        }
+        if (index_16(*s) == 0)
+            narrow_index(s);
+    }
+
+    // the emulation flag keeps M and X set
+    void rep(State* s, unsigned int bits)
+    {
+        if (s->m_emulation == 2)
+            s->m_p_known &= ~(bits & (FLAG_M | FLAG_X));
+        if (s->m_emulation != 0)
+            bits &= ~(FLAG_M | FLAG_X);
+        s->m_p &= ~bits;
+        s->m_p_known |= bits;
+    }
+
+    void sep(State* s, unsigned int bits)
+    {
+        s->m_p |= bits;
+        s->m_p_known |= bits;
+        if (bits & FLAG_X)
+            narrow_index(s);
+    }
+
+    void xce(State* s)
+    {
+        unsigned int emulation = (s->m_p_known & FLAG_C) ? (s->m_p & FLAG_C) : 2;
+        if (s->m_emulation != 2){
+            s->m_p = (uint8_t)((s->m_p & ~FLAG_C) | s->m_emulation);
+            s->m_p_known |= FLAG_C;
+        }
+        else{
+            s->m_p_known &= ~FLAG_C;
+        }
+        s->m_emulation = (uint8_t)emulation;
+        if (emulation == 1)
+            sep(s, FLAG_M | FLAG_X);
+    }
+
+    void push(State* s, unsigned int value, unsigned int known)
+    {
+        if (s->m_depth == State::MAX_STACK){
+            memmove(s->m_stack, s->m_stack + 1, State::MAX_STACK - 1);
+            memmove(s->m_stack_known, s->m_stack_known + 1, State::MAX_STACK - 1);
+            --s->m_depth;
+            s->m_stack_lost = 1;
+        }
+        s->m_stack[s->m_depth] = (uint8_t)value;
+        s->m_stack_known[s->m_depth] = (uint8_t)known;
+        ++s->m_depth;
+    }
+
+    void push_16(State* s, unsigned int value, unsigned int known)
+    {
+        push(s, value >> 8, known >> 8);
+        push(s, value, known);
+    }
+
+    void lose_stack(State* s)
+    {
+        memset(s->m_stack, 0, sizeof(s->m_stack));
+        memset(s->m_stack_known, 0, sizeof(s->m_stack_known));
+        s->m_depth = 0;
+        s->m_stack_lost = 1;
+    }
+
+    void forget_memory(State* s)
+    {
+        memset(s->m_memory_address, 0, sizeof(s->m_memory_address));
+        memset(s->m_memory, 0, sizeof(s->m_memory));
+        s->m_memory_count = 0;
+    }
+
+    bool load(const State& s, unsigned int address, unsigned int* value)
+    {
+        for (unsigned int i = 0; i < s.m_memory_count; ++i){
+            if (s.m_memory_address[i] == address){
+                *value = s.m_memory[i];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // the oldest byte makes room; unknown bytes are not kept
+    void store(State* s, unsigned int address, unsigned int value, bool known)
+    {
+        unsigned int count = s->m_memory_count;
+        unsigned int remove = count;
+        for (unsigned int i = 0; i < count; ++i){
+            if (s->m_memory_address[i] == address)
+                remove = i;
+        }
+        if (remove == count && known && count == State::MAX_MEMORY)
+            remove = 0;
+        if (remove < count){
+            for (unsigned int i = remove; i + 1 < count; ++i){
+                s->m_memory_address[i] = s->m_memory_address[i + 1];
+                s->m_memory[i] = s->m_memory[i + 1];
+            }
+            --count;
+            s->m_memory_address[count] = 0;
+            s->m_memory[count] = 0;
+        }
+        if (known){
+            s->m_memory_address[count] = (uint16_t)address;
+            s->m_memory[count] = (uint8_t)value;
+            ++count;
+        }
+        s->m_memory_count = (uint8_t)count;
+    }
+
+    // where a store lands in low RAM, which every bank but $40-$7D and
+    // $C0-$FF mirrors
+    bool ram_address(const State& s, unsigned int mode, unsigned int operand, unsigned int* address)
+    {
+        if (mode == DirectMode){
+            *address = (s.m_d + operand) & 0xFFFF;
+            return s.m_d_known == 0xFFFF && *address < 0x2000;
+        }
+        *address = operand;
+        return mode == AbsoluteMode && operand < 0x2000 && s.m_dbr_known == 0xFF &&
+            ((s.m_dbr & 0x7F) < 0x40 || s.m_dbr == 0x7E);
+    }
+
+    // an absolute store into registers or ROM, which leaves RAM alone
+    bool misses_ram(const State& s, unsigned int mode, unsigned int operand)
+    {
+        return mode == AbsoluteMode && operand >= 0x2000 && s.m_dbr_known == 0xFF && (s.m_dbr & 0x7F) < 0x40;
+    }
+
+    void store_operand(State* s, unsigned int mode, unsigned int operand, unsigned int effects)
+    {
+        unsigned int address;
+        if (!ram_address(*s, mode, operand, &address)){
+            if (!misses_ram(*s, mode, operand))
+                forget_memory(s);
+            return;
+        }
+
+        bool index = (effects & (StoresX | StoresY)) != 0;
+        int wide = index ? index_16(*s) : accum_16(*s);
+        unsigned int value = (effects & StoresX) ? s->m_x : (effects & StoresY) ? s->m_y : (effects & StoresA) ? s->m_a : 0;
+        unsigned int known = (effects & StoresX) ? s->m_x_known : (effects & StoresY) ? s->m_y_known :
+            (effects & StoresA) ? s->m_a_known : 0xFFFF;
+        if (effects & Modifies)
+            known = 0;
+        if (wide < 0){
+            forget_memory(s);
+            return;
+        }
+        store(s, address, value & 0xFF, (known & 0xFF) == 0xFF);
+        if (wide)
+            store(s, (address + 1) & 0xFFFF, value >> 8, (known >> 8) == 0xFF);
+    }
+
+    bool is_conditional_branch(unsigned char opcode)
+    {
+        return (opcode & 0x1F) == 0x10;
+    }
+}
+
+Interpreter::State::State()
+{
+    memset(this, 0, sizeof(*this));
+}
+
+Interpreter::Interpreter(const MemoryMap& map, const vector<unsigned char>& rom,
+    const vector<InstructionMetadata>& instructions, const SegmentIndex& segments) :
+m_ops(256),
+m_map(map),
+m_rom(rom),
+m_segments(segments),
+m_functions(1), //0 is what an entry point runs outside any call
+m_states(rom.size()),
+m_visited(INITIAL_VISITED),
+m_visited_index(INITIAL_VISITED),
+m_budget(MAX_INSTRUCTIONS)
+{
+    m_result.m_observed.resize(rom.size());
+    m_result.m_data_bank.resize(rom.size());
+
+    for (unsigned int opcode = 0; opcode < m_ops.size() && opcode < instructions.size(); ++opcode){
+        const InstructionMetadata& instruction = instructions[opcode];
+        const AddressMode& mode = instruction.address_mode();
+        Op& op = m_ops[opcode];
+        op.m_operand_bytes = (unsigned char)mode.m_operand_bytes;
+        op.m_width = (unsigned char)mode.m_width;
+        op.m_mode = strcmp(mode.m_name, "direct") == 0 ? DirectMode : strcmp(mode.m_name, "absolute") == 0 ? AbsoluteMode : OtherMode;
+        op.m_effects = 0;
+        for (const MnemonicEffects& effects : EFFECTS){
+            if (instruction.internal_name() == effects.m_name)
+                op.m_effects = effects.m_effects;
+        }
+        if ((op.m_effects & Modifies) && mode.m_operand_bytes == 0)
+            op.m_effects = (op.m_effects & ~Modifies) | WritesA;
+    }
+}
+
+void Interpreter::add_vectors()
+{
+    for (const Vector& interrupt : VECTORS){
+        int low = read_rom(interrupt.m_address);
+        int high = read_rom(interrupt.m_address + 1);
+        if (low < 0 || high < 0 || read_rom(address_16bit(low, high)) < 0)
+            continue;
+
+        State entry;
+        entry.m_pc = address_16bit(low, high);
+        entry.m_emulation = interrupt.m_emulation;
+        if (interrupt.m_emulation)
+            sep(&entry, FLAG_M | FLAG_X);
+        // the reset state: bank 0, direct page 0
+        if (interrupt.m_address == 0xFFFC){
+            entry.m_dbr_known = 0xFF;
+            entry.m_d_known = 0xFFFF;
+        }
+        m_entries.push_back(entry);
+    }
+}
+
+void Interpreter::add_entry(unsigned int address, int accum, int index)
+{
+    State entry;
+    entry.m_pc = address;
+    if (accum)
+        accum == 16 ? rep(&entry, FLAG_M) : sep(&entry, FLAG_M);
+    if (index)
+        index == 16 ? rep(&entry, FLAG_X) : sep(&entry, FLAG_X);
+    m_entries.push_back(entry);
+}
+
+void Interpreter::block(unsigned int start, unsigned int end)
+{
+    for (unsigned int i = start; i < end && i < m_states.size(); ++i){
+        m_states[i] = BLOCKED;
+    }
+}
+
+void Interpreter::run(unsigned long long max_instructions)
+{
+    m_budget = max_instructions;
+    for (size_t e = 0; e < m_entries.size() && !m_result.m_exhausted; ++e){
+        unsigned int index = m_map.rom_index(m_entries[e].m_pc);
+        if (index >= m_rom.size() || (m_result.m_observed[index] & Start))
+            continue;
+        ++m_result.m_entries;
+        m_pending.push_back(m_entries[e]);
+        drain();
+    }
+}
+
+void Interpreter::drain()
+{
+    do{
+        while (!m_pending.empty() && !m_result.m_exhausted){
+            State state = m_pending.back();
+            m_pending.pop_back();
+            explore(state);
+        }
+    } while (!m_result.m_exhausted && assume_returns());
+    m_pending.clear();
+}
+
+bool Interpreter::assume_returns()
+{
+    bool resumed = false;
+    for (size_t f = 1; f < m_functions.size(); ++f){
+        Function& function = m_functions[f];
+        if (function.m_callers.empty() || !function.m_returns.empty() || function.m_pulls_return || function.m_assume_return)
+            continue;
+        function.m_assume_return = true;
+        for (const State& caller : function.m_callers){
+            resume(caller, caller);
+            ++m_result.m_assumed_returns;
+        }
+        resumed = true;
+    }
+    return resumed;
+}
+
+bool Interpreter::visit(const State& state, unsigned int index)
+{
+    if (m_result.m_instructions >= m_budget){
+        m_result.m_exhausted = true;
+        return false;
+    }
+
+    if (2 * (m_visited_states.size() + 1) > m_visited.size()){
+        vector<uint64_t> grown(m_visited.size() * 2);
+        vector<uint32_t> grown_index(grown.size());
+        for (size_t i = 0; i < m_visited.size(); ++i){
+            uint64_t hash = m_visited[i];
+            if (!hash)
+                continue;
+            size_t slot = hash & (grown.size() - 1);
+            while (grown[slot])
+                slot = (slot + 1) & (grown.size() - 1);
+            grown[slot] = hash;
+            grown_index[slot] = m_visited_index[i];
+        }
+        m_visited.swap(grown);
+        m_visited_index.swap(grown_index);
+    }
+    // a matching hash only skips the state if the state matches too
+    const State key = masked(state);
+    uint64_t hash = hash_state(key);
+    size_t slot = hash & (m_visited.size() - 1);
+    while (m_visited[slot]){
+        if (m_visited[slot] == hash && memcmp(&m_visited_states[m_visited_index[slot]], &key, sizeof(State)) == 0)
+            return false;
+        slot = (slot + 1) & (m_visited.size() - 1);
+    }
+    if (m_states[index] >= STATES_PER_ADDRESS){
+        ++(m_states[index] == BLOCKED ? m_result.m_into_data : m_result.m_truncated);
+        return false;
+    }
+    m_visited[slot] = hash;
+    m_visited_index[slot] = (uint32_t)m_visited_states.size();
+    m_visited_states.push_back(key);
+    ++m_states[index];
+    ++m_result.m_instructions;
+
+    unsigned char& observed = m_result.m_observed[index];
+    observed |= Start;
+    int wide = accum_16(state);
+    if (wide >= 0)
+        observed |= wide ? Accum16 : Accum8;
+    wide = index_16(state);
+    if (wide >= 0)
+        observed |= wide ? Index16 : Index8;
+    if (state.m_dbr_known == 0xFF){
+        if (!(observed & DataBank)){
+            observed |= DataBank;
+            m_result.m_data_bank[index] = state.m_dbr;
+        }
+        else if (m_result.m_data_bank[index] != state.m_dbr){
+            observed |= DataBankConflict;
+        }
+    }
+    return true;
+}
+
+int Interpreter::read_rom(unsigned int address) const
+{
+    unsigned int index = m_map.rom_index(address);
+    return index < m_rom.size() ? m_rom[index] : -1;
+}
+
+// JMP ($xxxx) and JML [$xxxx] read bank 0
+bool Interpreter::read_pointer(const State& state, unsigned int address, unsigned int bytes, unsigned int* value) const
+{
+    *value = 0;
+    for (unsigned int i = 0; i < bytes; ++i){
+        unsigned int at = (address + i) & 0xFFFF;
+        unsigned int byte;
+        if (at < 0x2000){
+            if (!load(state, at, &byte))
+                return false;
+        }
+        else{
+            int rom = read_rom(at);
+            if (rom < 0)
+                return false;
+            byte = rom;
+        }
+        *value |= byte << (8 * i);
+    }
+    return true;
+}
+
+void Interpreter::pull(State* state, unsigned int* value, unsigned int* known)
+{
+    if (state->m_depth){
+        --state->m_depth;
+        *value = state->m_stack[state->m_depth];
+        *known = state->m_stack_known[state->m_depth];
+        state->m_stack[state->m_depth] = 0;
+        state->m_stack_known[state->m_depth] = 0;
+        return;
+    }
+    *value = 0;
+    *known = 0;
+    if (!state->m_stack_lost)
+        m_functions[state->m_function].m_pulls_return = true;
+    state->m_stack_lost = 1;
+}
+
+void Interpreter::call(const State& state, unsigned int target, unsigned int return_address)
+{
+    uint64_t key = (uint64_t)target << 24 | (uint64_t)(state.m_p_known & (FLAG_M | FLAG_X)) << 16 |
+        (uint64_t)(state.m_p & (FLAG_M | FLAG_X)) << 8 | state.m_emulation;
+    map<uint64_t, uint32_t>::iterator it = m_function_ids.find(key);
+    if (it == m_function_ids.end()){
+        it = m_function_ids.insert(make_pair(key, (uint32_t)m_functions.size())).first;
+        m_functions.push_back(Function());
+    }
+
+    State callee = state;
+    callee.m_pc = target;
+    callee.m_function = it->second;
+    memset(callee.m_stack, 0, sizeof(callee.m_stack));
+    memset(callee.m_stack_known, 0, sizeof(callee.m_stack_known));
+    callee.m_depth = 0;
+    callee.m_stack_lost = 0;
+    m_pending.push_back(callee);
+
+    State caller = state;
+    caller.m_pc = return_address;
+    Function& function = m_functions[it->second];
+    function.m_callers.push_back(caller);
+    for (const State& returned : function.m_returns){
+        resume(caller, returned);
+    }
+    if (function.m_assume_return){
+        resume(caller, caller);
+        ++m_result.m_assumed_returns;
+    }
+}
+
+void Interpreter::return_from(const State& state)
+{
+    if (state.m_function == 0)
+        return;
+    Function& function = m_functions[state.m_function];
+    for (const State& returned : function.m_returns){
+        if (returned.m_p == state.m_p && returned.m_p_known == state.m_p_known && returned.m_emulation == state.m_emulation &&
+            returned.m_dbr == state.m_dbr && returned.m_dbr_known == state.m_dbr_known &&
+            returned.m_d == state.m_d && returned.m_d_known == state.m_d_known)
+            return;
+    }
+    function.m_returns.push_back(state);
+    for (const State& caller : function.m_callers){
+        resume(caller, state);
+    }
+}
+
+// what a callee leaves in the registers and RAM isn't kept
+void Interpreter::resume(State caller, const State& returned)
+{
+    caller.m_p = returned.m_p;
+    caller.m_p_known = returned.m_p_known;
+    caller.m_emulation = returned.m_emulation;
+    caller.m_dbr = returned.m_dbr;
+    caller.m_dbr_known = returned.m_dbr_known;
+    caller.m_d = returned.m_d;
+    caller.m_d_known = returned.m_d_known;
+    caller.m_a_known = 0;
+    set_index(caller, &caller.m_x, &caller.m_x_known, 0, 0);
+    set_index(caller, &caller.m_y, &caller.m_y_known, 0, 0);
+    forget_memory(&caller);
+    m_pending.push_back(caller);
+}
+
+// JMP ($xxxx,X) and JSR ($xxxx,X): the entry X selects, or all of the
+// --ptr table the address starts in
+void Interpreter::jump_table(const State& state, unsigned int table, bool is_call, unsigned int return_address)
+{
+    unsigned int bank = table & 0xFF0000;
+    vector<unsigned int> targets;
+    if (state.m_x_known == 0xFFFF){
+        int low = read_rom(bank | ((table + state.m_x) & 0xFFFF));
+        int high = read_rom(bank | ((table + state.m_x + 1) & 0xFFFF));
+        if (low >= 0 && high >= 0)
+            targets.push_back(bank | address_16bit(low, high));
+    }
+    else{
+        unsigned int index = m_map.rom_index(table);
+        const SegmentIndex::Run* run = index < m_rom.size() ? m_segments.find(index) : 0;
+        for (unsigned int i = index; run && run->m_type == 2 && i + 2 <= run->m_end; i += 2){
+            targets.push_back(bank | address_16bit(m_rom[i], m_rom[i + 1]));
+        }
+    }
+
+    if (targets.empty())
+        ++m_result.m_unresolved;
+    for (unsigned int target : targets){
+        ++m_result.m_resolved;
+        if (is_call){
+            call(state, target, return_address);
+        }
+        else{
+            State next = state;
+            next.m_pc = target;
+            m_pending.push_back(next);
+        }
+    }
+}
+
+void Interpreter::explore(State s)
+{
+    for (;;){
+        unsigned int index = m_map.rom_index(s.m_pc);
+        if (index >= m_rom.size() || !visit(s, index))
+            return;
+
+        unsigned char opcode = m_rom[index];
+        const Op& op = m_ops[opcode];
+        int wide = op.m_width == AddressMode::Accum ? accum_16(s) : op.m_width == AddressMode::Index ? index_16(s) : 0;
+        if (wide < 0){
+            ++m_result.m_unknown_width;
+            return;
+        }
+
+        // operands wrap within the bank, as the program counter does
+        unsigned int length = 1 + op.m_operand_bytes + wide;
+        unsigned int bank = s.m_pc & 0xFF0000;
+        unsigned int pc = s.m_pc & 0xFFFF;
+        unsigned int operand = 0;
+        for (unsigned int i = 1; i < length; ++i){
+            int byte = read_rom(bank | ((pc + i) & 0xFFFF));
+            if (byte < 0)
+                return;
+            operand |= byte << (8 * (i - 1));
+        }
+        unsigned int next = bank | ((pc + length) & 0xFFFF);
+        unsigned int value, known, high, high_known, top, top_known;
+
+        switch (opcode)
+        {
+        case 0xC2: //REP
+            rep(&s, operand);
+            break;
+        case 0xE2: //SEP
+            sep(&s, operand);
+            break;
+        case 0x18: //CLC
+            s.m_p &= ~FLAG_C;
+            s.m_p_known |= FLAG_C;
+            break;
+        case 0x38: //SEC
+            s.m_p |= FLAG_C;
+            s.m_p_known |= FLAG_C;
+            break;
+        case 0xFB: //XCE
+            xce(&s);
+            break;
+        case 0x08: //PHP
+            push(&s, s.m_p, s.m_p_known);
+            break;
+        case 0x28: //PLP
+            pull(&s, &value, &known);
+            set_flags(&s, value, known);
+            break;
+
+        case 0x4B: //PHK
+            push(&s, bank >> 16, 0xFF);
+            break;
+        case 0x8B: //PHB
+            push(&s, s.m_dbr, s.m_dbr_known);
+            break;
+        case 0xAB: //PLB
+            pull(&s, &value, &known);
+            s.m_dbr = (uint8_t)value;
+            s.m_dbr_known = (uint8_t)known;
+            break;
+        case 0x0B: //PHD
+            push_16(&s, s.m_d, s.m_d_known);
+            break;
+        case 0x2B: //PLD
+            pull(&s, &value, &known);
+            pull(&s, &high, &high_known);
+            s.m_d = (uint16_t)(value | high << 8);
+            s.m_d_known = (uint16_t)(known | high_known << 8);
+            break;
+        case 0x5B: //TCD
+            s.m_d = s.m_a;
+            s.m_d_known = s.m_a_known;
+            break;
+        case 0x7B: //TDC
+            s.m_a = s.m_d;
+            s.m_a_known = s.m_d_known;
+            break;
+        case 0x1B: //TCS
+        case 0x9A: //TXS
+            lose_stack(&s);
+            break;
+        case 0x54: //MVN
+        case 0x44: //MVP
+            s.m_dbr = (uint8_t)operand;
+            s.m_dbr_known = 0xFF;
+            s.m_a_known = 0;
+            set_index(s, &s.m_x, &s.m_x_known, 0, 0);
+            set_index(s, &s.m_y, &s.m_y_known, 0, 0);
+            forget_memory(&s);
+            break;
+
+        case 0xA9: //LDA #
+            set_accum(&s, operand, 0xFFFF);
+            break;
+        case 0xA2: //LDX #
+            set_index(s, &s.m_x, &s.m_x_known, operand, 0xFFFF);
+            break;
+        case 0xA0: //LDY #
+            set_index(s, &s.m_y, &s.m_y_known, operand, 0xFFFF);
+            break;
+        case 0xAA: //TAX
+            set_index(s, &s.m_x, &s.m_x_known, s.m_a, s.m_a_known);
+            break;
+        case 0xA8: //TAY
+            set_index(s, &s.m_y, &s.m_y_known, s.m_a, s.m_a_known);
+            break;
+        case 0x8A: //TXA
+            set_accum(&s, s.m_x, s.m_x_known);
+            break;
+        case 0x98: //TYA
+            set_accum(&s, s.m_y, s.m_y_known);
+            break;
+        case 0x9B: //TXY
+            set_index(s, &s.m_y, &s.m_y_known, s.m_x, s.m_x_known);
+            break;
+        case 0xBB: //TYX
+            set_index(s, &s.m_x, &s.m_x_known, s.m_y, s.m_y_known);
+            break;
+        case 0xEB: //XBA
+            s.m_a = (uint16_t)(s.m_a << 8 | s.m_a >> 8);
+            s.m_a_known = (uint16_t)(s.m_a_known << 8 | s.m_a_known >> 8);
+            break;
+        case 0xE8: //INX
+            step_index(s, &s.m_x, &s.m_x_known, 1);
+            break;
+        case 0xCA: //DEX
+            step_index(s, &s.m_x, &s.m_x_known, -1);
+            break;
+        case 0xC8: //INY
+            step_index(s, &s.m_y, &s.m_y_known, 1);
+            break;
+        case 0x88: //DEY
+            step_index(s, &s.m_y, &s.m_y_known, -1);
+            break;
+
+        case 0x48: //PHA
+        case 0xDA: //PHX
+        case 0x5A: //PHY
+            wide = opcode == 0x48 ? accum_16(s) : index_16(s);
+            value = opcode == 0x48 ? s.m_a : opcode == 0xDA ? s.m_x : s.m_y;
+            known = opcode == 0x48 ? s.m_a_known : opcode == 0xDA ? s.m_x_known : s.m_y_known;
+            if (wide < 0)
+                lose_stack(&s);
+            else if (wide)
+                push_16(&s, value, known);
+            else
+                push(&s, value, known);
+            break;
+        case 0x68: //PLA
+        case 0xFA: //PLX
+        case 0x7A: //PLY
+            wide = opcode == 0x68 ? accum_16(s) : index_16(s);
+            value = known = high = high_known = 0;
+            if (wide < 0){
+                lose_stack(&s);
+            }
+            else{
+                pull(&s, &value, &known);
+                if (wide)
+                    pull(&s, &high, &high_known);
+            }
+            value |= high << 8;
+            known |= high_known << 8;
+            if (opcode == 0x68)
+                set_accum(&s, value, known);
+            else if (opcode == 0xFA)
+                set_index(s, &s.m_x, &s.m_x_known, value, known);
+            else
+                set_index(s, &s.m_y, &s.m_y_known, value, known);
+            break;
+        case 0xF4: //PEA
+            push_16(&s, operand, 0xFFFF);
+            break;
+        case 0x62: //PER
+            push_16(&s, (pc + 3 + operand) & 0xFFFF, 0xFFFF);
+            break;
+        case 0xD4: //PEI
+            value = (s.m_d + operand) & 0xFFFF;
+            top = high = 0;
+            known = s.m_d_known == 0xFFFF && value < 0x2000 && load(s, value, &top) && load(s, (value + 1) & 0xFFFF, &high);
+            push_16(&s, known ? top | high << 8 : 0, known ? 0xFFFF : 0);
+            break;
+
+        case 0x80: //BRA
+            s.m_pc = bank | ((pc + 2 + (signed char)operand) & 0xFFFF);
+            continue;
+        case 0x82: //BRL
+            s.m_pc = bank | ((pc + 3 + (short)operand) & 0xFFFF);
+            continue;
+        case 0x4C: //JMP $xxxx
+            s.m_pc = bank | operand;
+            continue;
+        case 0x5C: //JML $xxxxxx
+            s.m_pc = operand;
+            continue;
+        case 0x6C: //JMP ($xxxx)
+        case 0xDC: //JML [$xxxx]
+            if (!read_pointer(s, operand, opcode == 0x6C ? 2 : 3, &value)){
+                ++m_result.m_unresolved;
+                return;
+            }
+            ++m_result.m_resolved;
+            s.m_pc = opcode == 0x6C ? bank | value : value;
+            continue;
+        case 0x7C: //JMP ($xxxx,X)
+        case 0xFC: //JSR ($xxxx,X)
+            jump_table(s, bank | operand, opcode == 0xFC, next);
+            return;
+        case 0x20: //JSR
+            call(s, bank | operand, next);
+            return;
+        case 0x22: //JSL
+            call(s, operand, next);
+            return;
+        case 0x60: //RTS
+        case 0x6B: //RTL
+            // past what the call pushed is the return address
+            if (s.m_depth == 0 && !s.m_stack_lost){
+                return_from(s);
+                return;
+            }
+            pull(&s, &value, &known);
+            pull(&s, &high, &high_known);
+            top = bank >> 16;
+            top_known = 0xFF;
+            if (opcode == 0x6B)
+                pull(&s, &top, &top_known);
+            if (known != 0xFF || high_known != 0xFF || top_known != 0xFF){
+                ++m_result.m_unresolved;
+                return;
+            }
+            ++m_result.m_resolved;
+            s.m_pc = top << 16 | ((address_16bit(value, high) + 1) & 0xFFFF);
+            continue;
+        case 0x40: //RTI
+        case 0x00: //BRK
+        case 0x02: //COP
+        case 0x42: //WDM
+        case 0xDB: //STP
+            return;
+
+        default:
+            if (is_conditional_branch(opcode)){
+                State taken = s;
+                taken.m_pc = bank | ((pc + 2 + (signed char)operand) & 0xFFFF);
+                m_pending.push_back(taken);
+                break;
+            }
+            if (op.m_effects & WritesA)
+                set_accum(&s, 0, 0);
+            if (op.m_effects & WritesX)
+                set_index(s, &s.m_x, &s.m_x_known, 0, 0);
+            if (op.m_effects & WritesY)
+                set_index(s, &s.m_y, &s.m_y_known, 0, 0);
+            if (op.m_effects & WritesCarry)
+                s.m_p_known &= ~FLAG_C;
+            if (op.m_effects & (StoresA | StoresX | StoresY | StoresZero | Modifies))
+                store_operand(&s, op.m_mode, operand, op.m_effects);
+            break;
+        }
+        s.m_pc = next;
+    }
+}
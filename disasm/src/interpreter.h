@@ -0,0 +1,156 @@
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <vector>
+
+class InstructionMetadata;
+struct MemoryMap;
+struct SegmentIndex;
+
+// Abstract interpreter for the 65816.  Follows every path from its entry
+// points with what is known of P, the emulation flag, DBR, D, A, X, Y, the
+// top of the stack and a few bytes of low RAM, each bit either known or
+// not, so that
+//
+//   - REP/SEP, PHP/PLP and XCE give each instruction its register widths
+//   - PHK/PLB, LDA #/PHA/PLB and MVN/MVP give it its data bank
+//   - PEA/RTS dispatch, JMP ($xxxx) and JML [$xxxx] through RAM the code
+//     just wrote, and JMP ($xxxx,X) into a --ptr table, are followed
+//
+// Calls are summarized: a callee is walked once for each state it is
+// entered with, and what it returns with (its P, DBR and D) resumes every
+// caller waiting on it.  A callee that never returns is assumed to keep P
+// unless it pulled its own return address, as dispatchers that read the
+// table after the JSR do.
+//
+// The walk is bounded: a (address, state) pair is only walked once, an
+// address in at most a few states, and the whole run in a fixed number of
+// instructions.
+struct Interpreter
+{
+    // what was seen of each ROM byte, by file offset
+    enum Observed { Start = 0x01, Accum8 = 0x02, Accum16 = 0x04, Index8 = 0x08, Index16 = 0x10,
+        DataBank = 0x20, DataBankConflict = 0x40 };
+
+    struct Result
+    {
+        Result() :
+        m_entries(0), m_instructions(0), m_resolved(0), m_unresolved(0), m_unknown_width(0),
+        m_truncated(0), m_into_data(0), m_assumed_returns(0), m_exhausted(false)
+        {}
+
+        std::vector<unsigned char> m_observed;
+        std::vector<unsigned char> m_data_bank; //where DataBank is set
+
+        unsigned long long m_entries; //entry points not already reached
+        unsigned long long m_instructions; //walked, counting each state
+        unsigned long long m_resolved; //indirect jumps and returns to pushed addresses followed
+        unsigned long long m_unresolved; //indirect jumps whose target wasn't known
+        unsigned long long m_unknown_width; //paths stopped at an immediate of unknown size
+        unsigned long long m_truncated; //paths stopped at an address walked in too many states
+        unsigned long long m_into_data; //paths stopped at a blocked byte
+        unsigned long long m_assumed_returns; //callers resumed without a return from the callee
+        bool m_exhausted; //the instruction budget ran out
+    };
+
+    // Each value bit is only meaningful where its known bit is set.  The
+    // layout has no padding, as states are hashed and compared as raw words.
+    struct State
+    {
+        enum { MAX_STACK = 16, MAX_MEMORY = 8 };
+
+        State();
+
+        uint32_t m_pc;
+        uint32_t m_function; //the call the state is in, see Function
+        uint16_t m_a, m_a_known;
+        uint16_t m_x, m_x_known;
+        uint16_t m_y, m_y_known;
+        uint16_t m_d, m_d_known;
+        uint16_t m_memory_address[MAX_MEMORY]; //low RAM, $0000-$1FFF
+        uint8_t m_memory[MAX_MEMORY];
+        uint8_t m_stack[MAX_STACK]; //pushed since the call, the top last
+        uint8_t m_stack_known[MAX_STACK];
+        uint8_t m_p, m_p_known;
+        uint8_t m_emulation; //0, 1 or 2 when not known
+        uint8_t m_dbr, m_dbr_known;
+        uint8_t m_depth;
+        uint8_t m_memory_count;
+        uint8_t m_stack_lost; //the stack pointer moved by an unknown amount
+    };
+
+    Interpreter(const MemoryMap& map, const std::vector<unsigned char>& rom,
+        const std::vector<InstructionMetadata>& instructions, const SegmentIndex& segments);
+
+    // The reset and emulation mode vectors start with 8 bit registers, the
+    // native mode ones with any.  Those outside ROM are skipped.
+    void add_vectors();
+    // In native mode; accum and index are 8, 16 or 0 for not known, as for
+    // ByteProperties::reset_accum_to.
+    void add_entry(unsigned int address, int accum, int index);
+    // file offsets no path may run into, such as what the data files type
+    void block(unsigned int start, unsigned int end);
+
+    void run(unsigned long long max_instructions = MAX_INSTRUCTIONS);
+
+    const Result& result() const { return m_result; }
+
+    enum { MAX_INSTRUCTIONS = 64 * 1024 * 1024, STATES_PER_ADDRESS = 8, BLOCKED = 0xFF };
+
+private:
+    struct Op
+    {
+        unsigned char m_operand_bytes;
+        unsigned char m_width; //AddressMode::Width
+        unsigned char m_mode; //Mode
+        unsigned short m_effects; //Effect
+    };
+
+    // a callee, by its address and the widths it is entered with
+    struct Function
+    {
+        Function() : m_pulls_return(false), m_assume_return(false) {}
+
+        std::vector<State> m_callers; //each at its return address
+        std::vector<State> m_returns; //what P, DBR and D it returned with
+        bool m_pulls_return;
+        bool m_assume_return;
+    };
+
+    void explore(State state);
+    void drain();
+    bool assume_returns();
+
+    void call(const State& state, unsigned int target, unsigned int return_address);
+    void return_from(const State& state);
+    void resume(State caller, const State& returned);
+    void jump_table(const State& state, unsigned int table, bool is_call, unsigned int return_address);
+
+    // a byte of the stack, or of the caller's past the top of a call
+    void pull(State* state, unsigned int* value, unsigned int* known);
+    int read_rom(unsigned int address) const; //-1 outside ROM
+    bool read_pointer(const State& state, unsigned int address, unsigned int bytes, unsigned int* value) const;
+    bool visit(const State& state, unsigned int index);
+
+    std::vector<Op> m_ops;
+    const MemoryMap& m_map;
+    const std::vector<unsigned char>& m_rom;
+    const SegmentIndex& m_segments;
+
+    std::vector<State> m_entries;
+    std::vector<State> m_pending;
+    std::vector<Function> m_functions;
+    std::map<uint64_t, uint32_t> m_function_ids; //by address and widths, see call
+    std::vector<unsigned char> m_states; //per ROM byte, up to STATES_PER_ADDRESS or BLOCKED
+    std::vector<uint64_t> m_visited; //open addressed hashes of walked states, 0 is empty
+    std::vector<uint32_t> m_visited_index; //where each slot of m_visited keeps its state
+    std::deque<State> m_visited_states; //walked states, compared when the hashes match
+    unsigned long long m_budget;
+    Result m_result;
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <cctype>
+#include "label_index.h"
+#include "memory_usage.h"
+
+using namespace std;
+
+namespace{
+    // the address in a CODE_ or ADDR_ label, which are made up as they
+    // are printed rather than loaded
+    bool generated_address(const string& name, unsigned int* full_address)
+    {
+        if (name.size() != 11 || (name.compare(0, 5, "CODE_") != 0 && name.compare(0, 5, "ADDR_") != 0))
+            return false;
+        for (size_t i = 5; i < name.size(); ++i){
+            if (!isxdigit((unsigned char)name[i]))
+                return false;
+        }
+        *full_address = (unsigned int)stoul(name.substr(5), 0, 16);
+        return true;
+    }
+}
+
+void LabelIndex::add(const string& name, unsigned int full_address)
+{
+    pair<unordered_map<string, unsigned int>::iterator, bool> result = m_addresses.try_emplace(name, full_address);
+    if (!result.second)
+        return;
+    m_names.push_back(&*result.first);
+    m_sorted = false;
+}
+
+void LabelIndex::remove(const string& name, unsigned int full_address)
+{
+    unordered_map<string, unsigned int>::iterator it = m_addresses.find(name);
+    if (it == m_addresses.end() || it->second != full_address)
+        return;
+    m_names.erase(std::find(m_names.begin(), m_names.end(), &*it));
+    m_addresses.erase(it);
+}
+
+bool LabelIndex::find(const string& name, unsigned int* full_address) const
+{
+    unordered_map<string, unsigned int>::const_iterator it = m_addresses.find(name);
+    if (it == m_addresses.end())
+        return generated_address(name, full_address);
+    *full_address = it->second;
+    return true;
+}
+
+void LabelIndex::complete(const string& prefix, vector<const Entry*>* matches) const
+{
+    vector<const Entry*>::const_iterator it = lower_bound(m_names.begin(), m_names.end(), prefix,
+        [](const Entry* entry, const string& value){ return entry->first < value; });
+    for (; it != m_names.end() && (*it)->first.compare(0, prefix.size(), prefix) == 0; ++it){
+        matches->push_back(*it);
+    }
+}
+
+void LabelIndex::sort()
+{
+    if (m_sorted)
+        return;
+    std::sort(m_names.begin(), m_names.end(), [](const Entry* a, const Entry* b){ return a->first < b->first; });
+    m_sorted = true;
+}
+
+size_t LabelIndex::size_in_bytes() const
+{
+    // a node and a bucket per name, as in Memory::heap_bytes for maps
+    size_t bytes = m_addresses.size() * (sizeof(Entry) + Memory::MAP_NODE_OVERHEAD) +
+        m_addresses.bucket_count() * sizeof(void*) + m_names.capacity() * sizeof(const Entry*);
+    for (const Entry* entry : m_names){
+        bytes += Memory::heap_bytes(entry->first);
+    }
+    return bytes;
+}
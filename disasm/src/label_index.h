@@ -0,0 +1,39 @@
+#ifndef LABEL_INDEX_H
+#define LABEL_INDEX_H
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Addresses of the loaded labels by name, so that requests can name a
+// label instead of an address: a hash for exact names and a sorted array
+// of the names for prefixes.  The first label with a name wins.
+struct LabelIndex
+{
+    typedef std::pair<const std::string, unsigned int> Entry;
+
+    LabelIndex() : m_sorted(true) {}
+
+    void add(const std::string& name, unsigned int full_address);
+    void remove(const std::string& name, unsigned int full_address);
+
+    // also takes the names of generated labels, CODE_xxxxxx and ADDR_xxxxxx
+    bool find(const std::string& name, unsigned int* full_address) const;
+    // the labels whose names start with prefix, in name order
+    void complete(const std::string& prefix, std::vector<const Entry*>* matches) const;
+
+    // sorts the names added since the last call; complete needs them sorted
+    void sort();
+
+    size_t size() const { return m_addresses.size(); }
+    size_t size_in_bytes() const;
+
+private:
+    std::unordered_map<std::string, unsigned int> m_addresses;
+    std::vector<const Entry*> m_names; //into m_addresses
+    bool m_sorted;
+};
+
+#endif
@@ -5,83 +5,239 @@
 #include <iostream>
 #include <iomanip>
 #include <map>
+#include <memory>
+#include <sstream>
+#include <vector>
+#include "batch.h"
 #include "disassembler.h"
+#include "file_watcher.h"
+#include "options.h"
 #include "request.h"
+#include "rom_diff.h"
+#include "coverage.h"
+#include "server.h"
+#include "trace_events.h"
+#include "trace_ingest.h"
 
 using namespace std;
 
 namespace{
-    const char* HELP = "disasm.exe ROM_FILENAME\n";
+    const char* HELP =
+        "disasm.exe [--serve SOCKET_PATH | --watch] [--interpret] [--extract-dir DIR] [--stats] [--stats-json FILE] [--trace-out FILE] ROM_FILENAME\n"
+        "disasm.exe --convert-trace TRACE_FILE COVERAGE_FILE [--map lorom|hirom|exhirom]\n"
+        "disasm.exe --ingest-trace EMULATOR_LOG COVERAGE_FILE FLAGS_FILE [--map lorom|hirom|exhirom]\n"
+        "disasm.exe --batch JOB_FILE [--jobs THREADS]\n"
+        "disasm.exe --diff OLD_ROM NEW_ROM [OPTIONS]\n";
+
+    // the addresses of a text trace are placed with map
+    int convert_trace(const char* trace_file, const char* coverage_file, const MemoryMap& map)
+    {
+        CoverageMap coverage;
+        if (!coverage.load(trace_file, map)){
+            printf("Could not read %s.\n", trace_file);
+            return -1;
+        }
+        if (!coverage.save(coverage_file)){
+            printf("Could not write %s.\n", coverage_file);
+            return -1;
+        }
+        cerr << "; " << coverage.count() << " instruction starts written to " << coverage_file << endl;
+        return 0;
+    }
+
+    // --watch: driver files saved since the last request are read again
+    // and only what changed in them is applied
+    void reload_changed(FileWatcher& watcher, Disassembler& disasm, vector<DriverFile>& driver_files)
+    {
+        for (size_t i : watcher.changed()){
+            DriverFile file(driver_files[i].m_type, driver_files[i].m_filename);
+            parse_driver_file(&file, disasm.memory_map());
+            disasm.reload_driver_file(driver_files[i], file);
+            driver_files[i] = file;
+        }
+    }
 }
 
-void main (int argc, char *argv[])
+int main (int argc, char *argv[])
 {
     if (argc < 2 || string(argv[1]) == "--help"){
         printf(HELP);
         exit(-1);
     }  
 
-    FILE *srcfile;
-    if (fopen_s(&srcfile, argv[--argc], "rb") != 0){
+    if (string(argv[1]) == "--convert-trace"){
+        MemoryMap::Mapper mapper = MemoryMap::LoRom;
+        bool has_map = argc == 6 && string(argv[4]) == "--map";
+        if ((argc != 4 && !has_map) || (has_map && !MemoryMap::parse(argv[5], &mapper))){
+            printf(HELP);
+            exit(-1);
+        }
+        exit(convert_trace(argv[2], argv[3], MemoryMap::get(mapper)));
+    }
+
+    if (string(argv[1]) == "--ingest-trace"){
+        MemoryMap::Mapper mapper = MemoryMap::LoRom;
+        bool has_map = argc == 7 && string(argv[5]) == "--map";
+        if ((argc != 5 && !has_map) || (has_map && !MemoryMap::parse(argv[6], &mapper))){
+            printf(HELP);
+            exit(-1);
+        }
+        exit(ingest_trace(argv[2], argv[3], argv[4], MemoryMap::get(mapper)));
+    }
+
+    if (string(argv[1]) == "--batch"){
+        bool has_jobs = argc == 5 && string(argv[3]) == "--jobs";
+        if (argc != 3 && !has_jobs){
+            printf(HELP);
+            exit(-1);
+        }
+        exit(run_batch(argv[2], has_jobs ? atoi(argv[4]) : 0));
+    }
+
+    // the driver files describe the old ROM and are used for both
+    if (string(argv[1]) == "--diff"){
+        if (argc < 4){
+            printf(HELP);
+            exit(-1);
+        }
+        FILE* old_file = fopen(argv[2], "rb");
+        if (!old_file){
+            printf("Could not open %s for reading.\n", argv[2]);
+            exit(-1);
+        }
+        Disassembler base(old_file);
+        vector<DriverFile> driver_files;
+        vector<string> args(argv, argv + argc);
+        string error;
+        for (size_t i = 4; i < args.size() && error.empty(); ++i){
+            if (!parse_disassembler_option(base, args, &i, &driver_files, &error))
+                cerr << "Ignoring " << args[i] << endl;
+        }
+        if (!error.empty()){
+            cerr << error << endl;
+            exit(-1);
+        }
+        if (!base.load_driver_files(driver_files))
+            exit(-1);
+        int result = run_diff(base, argv[2], argv[3]);
+        fclose(old_file);
+        exit(result);
+    }
+
+    FILE *srcfile = fopen(argv[--argc], "rb");
+    if (!srcfile){
         printf("Could not open %s for reading.\n", argv[argc]);
         exit(-1);
     }
 
+    string rom_filename = argv[argc];
     Disassembler disasm(srcfile);
-    //process arguments
-    for(int i = 1; i < argc; ++i){
+    vector<DriverFile> driver_files;
+    string socket_path;
+    string stats_file;
+    string trace_file;
+    string extract_dir;
+    bool watch = false;
+    bool interpret = false;
+
+    // before anything else so that every load is timed
+    for (int i = 1; i < argc; ++i){
         string current(argv[i]);
-        if (current == "--instr" && ++i < argc)
-            disasm.load_instruction_names(argv[i]);
-        else if (current == "--output" && ++i < argc)
-            disasm.set_output_format(argv[i]);
-        else if (current == "--annotate" && ++i < argc)
-            disasm.set_annotation_format(argv[i]);
-        else if (current == "--dbank" && ++i < argc)
-            disasm.load_data_bank(argv[i]);
-        else if (current == "--data" && ++i < argc)
-            disasm.load_data(argv[i]);
-        else if (current == "--ptr" && ++i < argc)
-            disasm.load_data(argv[i], true);
-        else if (current == "--sym" && ++i < argc)
-            disasm.load_symbols(argv[i]);
-        else if (current == "--ram" && ++i < argc)
-            disasm.load_symbols(argv[i], true);
-        else if (current == "--sym2" && ++i < argc)
-            disasm.load_symbols2(argv[i]);
-        else if (current == "--comment" && ++i < argc)
-            disasm.load_comments(argv[i]);
-		else if (current == "--offsets" && ++i < argc)
-			disasm.load_offsets(argv[i]);
-		else if (current == "--accum" && ++i < argc) //todo: rename
-            disasm.load_accum_bytes(argv[i], true);
-        else if (current == "--index" && ++i < argc)
-            disasm.load_accum_bytes(argv[i], false);
-        else if (current == "--hirom")
-            disasm.hirom(true);
-        else if (current == "--quiet")
-            disasm.quiet(true);
-        else if (current == "--noheader")
-            disasm.header_size(0);
-        else if (current == "--2pass")
-            disasm.passes(2);
+        if (current == "--stats-json" && i + 1 < argc)
+            stats_file = argv[i + 1];
+        if (current == "--trace-out" && i + 1 < argc && trace_file.empty()){
+            trace_file = argv[i + 1];
+            Trace::start();
+        }
+        if (current == "--stats" || current == "--stats-json"){
+            if (!disasm.stats())
+                disasm.collect_stats();
+        }
+    }
+
+    //process arguments
+    vector<string> args(argv, argv + argc);
+    for (size_t i = 1; i < args.size(); ++i){
+        string error;
+        if (parse_disassembler_option(disasm, args, &i, &driver_files, &error)){
+            if (!error.empty()){
+                cerr << error << endl;
+                exit(-1);
+            }
+            continue;
+        }
+        if (args[i] == "--serve" && i + 1 < args.size())
+            socket_path = args[++i];
+        else if (args[i] == "--watch")
+            watch = true;
+        else if (args[i] == "--interpret")
+            interpret = true;
+        else if (args[i] == "--extract-dir" && i + 1 < args.size())
+            extract_dir = args[++i];
+        else if (args[i] == "--stats-json" || args[i] == "--trace-out")
+            ++i;
+    }
 
+    // sessions of --serve share the driver data, so only the prompt reloads
+    // it; watching starts first so that nothing saved while loading is missed
+    unique_ptr<FileWatcher> watcher;
+    if (watch && socket_path.empty()){
+        watcher.reset(new FileWatcher());
+        for (size_t i = 0; i < driver_files.size(); ++i){
+            watcher->add(driver_files[i].m_filename);
+        }
+    }
+
+    // driver files are parsed in parallel, then merged in command line order
+    if (!disasm.load_driver_files(driver_files))
+        exit(-1);
+    if (interpret)
+        disasm.interpret();
+    if (!extract_dir.empty())
+        disasm.extract_assets(extract_dir);
+
+    if (!socket_path.empty()){
+        int result = serve(disasm, rom_filename, socket_path);
+        if (!trace_file.empty() && !Trace::write(trace_file))
+            cerr << "Could not write " << trace_file << endl;
+        exit(result);
     }
 
     if (!disasm.quiet()){
         cout << "Ready to disassemble..." << endl;
     }
 
-    while(1){
+    string line;
+    while(getline(cin, line)){
+        if (watcher)
+            reload_changed(*watcher, disasm, driver_files);
+
+        istringstream in(line);
         Request request;
-        if (!request.get(cin, disasm.hirom()))
+        // a wrong line was reported, and the next one is read
+        if (!request.get(in, disasm.hirom(), cout, &disasm.label_index())){
+            if (request.m_error)
+                continue;
             break;
+        }
         if (request.m_quit)
             break;
         disasm.handleRequest(request);
 
+        Trace::Scope trace("flush", "writer");
         cout << endl;
     }
-}
 
+    if (disasm.stats()){
+        MemoryUsage memory;
+        disasm.memory_usage(&memory);
+        disasm.stats()->print(cerr, &memory);
+        if (!stats_file.empty() && !disasm.stats()->save_json(stats_file, &memory))
+            cerr << "Could not write " << stats_file << endl;
+    }
+
+    if (!trace_file.empty() && !Trace::write(trace_file))
+        cerr << "Could not write " << trace_file << endl;
 
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() :
+m_data(0),
+m_size(0),
+m_file(INVALID_HANDLE_VALUE),
+m_mapping(0)
+{ }
+
+bool MappedFile::open(const string& filename)
+{
+    close();
+
+    m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (m_file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0){
+        close();
+        return false;
+    }
+
+    m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!m_mapping){
+        close();
+        return false;
+    }
+
+    m_data = (const unsigned char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!m_data){
+        close();
+        return false;
+    }
+    m_size = (size_t)size.QuadPart;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mapping) CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+
+    m_data = 0;
+    m_size = 0;
+    m_mapping = 0;
+    m_file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+MappedFile::MappedFile() :
+m_data(0),
+m_size(0),
+m_fd(-1)
+{ }
+
+bool MappedFile::open(const string& filename)
+{
+    close();
+
+    m_fd = ::open(filename.c_str(), O_RDONLY);
+    if (m_fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(m_fd, &info) != 0 || info.st_size == 0){
+        close();
+        return false;
+    }
+
+    void* data = mmap(0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if (data == MAP_FAILED){
+        close();
+        return false;
+    }
+
+    m_data = (const unsigned char*)data;
+    m_size = (size_t)info.st_size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data) munmap((void*)m_data, m_size);
+    if (m_fd >= 0) ::close(m_fd);
+
+    m_data = 0;
+    m_size = 0;
+    m_fd = -1;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
@@ -0,0 +1,136 @@
+#include "memory_map.h"
+
+using namespace std;
+
+namespace{
+    unsigned int page_address(unsigned int bank, unsigned int page)
+    {
+        return bank << 16 | page << 12;
+    }
+}
+
+const MemoryMap& MemoryMap::get(Mapper mapper)
+{
+    // built once, then shared read only by every instance and thread
+    static const MemoryMap lorom(LoRom);
+    static const MemoryMap hirom(HiRom);
+    static const MemoryMap exhirom(ExHiRom);
+    return mapper == HiRom ? hirom : mapper == ExHiRom ? exhirom : lorom;
+}
+
+bool MemoryMap::parse(const string& name, Mapper* mapper)
+{
+    if (name == "lorom")
+        *mapper = LoRom;
+    else if (name == "hirom")
+        *mapper = HiRom;
+    else if (name == "exhirom")
+        *mapper = ExHiRom;
+    else
+        return false;
+    return true;
+}
+
+MemoryMap::MemoryMap(Mapper mapper) :
+m_mapper(mapper),
+m_rom_capacity(mapper == ExHiRom ? 0x800000 : 0x400000),
+m_rom_pages(m_rom_capacity >> 12, 0)
+{
+    for (unsigned int bank = 0; bank < 0x100; ++bank){
+        unsigned int low = bank & 0x7F; //the bank without the FastROM bit
+        for (unsigned int page = 0; page < 0x10; ++page){
+            unsigned int address = page_address(bank, page);
+
+            if (bank == 0x7E || bank == 0x7F){
+                map(bank, page, Wram, (bank - 0x7E) << 16 | page << 12, address);
+                continue;
+            }
+
+            if (mapper == LoRom){
+                // $FE and $FF keep their bank so as not to fold onto WRAM
+                unsigned int canonical_bank = low < 0x7E ? low : bank;
+                if (page >= 8)
+                    map(bank, page, Rom, low * 0x8000 + (page - 8) * 0x1000, page_address(canonical_bank, page));
+                else if (low < 0x40)
+                    map_system_page(bank, page);
+                else if (low >= 0x70)
+                    map(bank, page, Sram, (low - 0x70) * 0x8000 + page * 0x1000, page_address(canonical_bank, page));
+                else
+                    map(bank, page, Unmapped, 0, address);
+                continue;
+            }
+
+            unsigned int rom_bank = bank & 0x3F;
+            bool upper = (bank >= 0xC0) || (bank >= 0x80 && page >= 8);
+            if (low >= 0x40 || page >= 8){
+                if (mapper == HiRom || upper)
+                    map(bank, page, Rom, rom_bank << 16 | page << 12, page_address(0xC0 | rom_bank, page));
+                else if (bank >= 0x3E && bank < 0x40)
+                    map(bank, page, Rom, 0x400000 | rom_bank << 16 | page << 12, address); //$7E and $7F are WRAM
+                else
+                    map(bank, page, Rom, 0x400000 | rom_bank << 16 | page << 12, page_address(0x40 | rom_bank, page));
+            }
+            else if (page < 6)
+                map_system_page(bank, page);
+            else if (low >= 0x20)
+                map(bank, page, Sram, (low - 0x20) * 0x2000 + (page - 6) * 0x1000, page_address(low, page));
+            else
+                map(bank, page, Unmapped, 0, address);
+        }
+    }
+
+    for (unsigned int bank = 0; bank < 0x100; ++bank){
+        m_bank_start[bank] = 0x8000;
+        for (unsigned int page = 0; page < 0x10; ++page){
+            if (m_pages[bank << 4 | page].m_region == Rom){
+                m_bank_start[bank] = page << 12;
+                break;
+            }
+        }
+    }
+}
+
+void MemoryMap::contiguous_range(unsigned int* start, unsigned int* end) const
+{
+    unsigned int bank = *start >> 16;
+    if (!is_rom(*start) || m_bank_start[bank] == 0 || *end <= (bank + 1) << 16)
+        return;
+
+    unsigned int new_start = canonical(*start);
+    unsigned int last = *end - 1;
+    unsigned int last_bank = (last & 0xFF0000) | 0x8000;
+    if (m_bank_start[new_start >> 16] != 0 || !is_rom(last_bank))
+        return;
+
+    unsigned int new_last = (canonical(last_bank) & 0xFF0000) | (last & 0xFFFF);
+    if (new_last < new_start || m_bank_start[new_last >> 16] != 0)
+        return;
+    unsigned int new_end = new_last < 0xFFFFFF ? new_last + 1 : new_last;
+    *start = new_start;
+    *end = new_end;
+}
+
+// the low 8KB of WRAM, the registers and an unmapped expansion area, as
+// in banks $00-$3F and $80-$BF of every mapper
+void MemoryMap::map_system_page(unsigned int bank, unsigned int page)
+{
+    if (page < 2)
+        map(bank, page, Wram, page << 12, page_address(0x7E, page));
+    else if (page < 6)
+        map(bank, page, Io, (page - 2) << 12, page_address(0x00, page));
+    else
+        map(bank, page, Unmapped, 0, page_address(bank, page));
+}
+
+void MemoryMap::map(unsigned int bank, unsigned int page, Region region, unsigned int offset, unsigned int canonical)
+{
+    Page& entry = m_pages[bank << 4 | page];
+    entry.m_region = (unsigned char)region;
+    entry.m_offset = offset;
+    entry.m_canonical = canonical;
+    entry.m_index = region == Rom ? offset : m_rom_capacity;
+    entry.m_index_mask = region == Rom ? 0xFFF : 0;
+
+    if (region == Rom && canonical == page_address(bank, page))
+        m_rom_pages[offset >> 12] = canonical;
+}
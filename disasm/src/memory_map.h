@@ -0,0 +1,116 @@
+#ifndef MEMORY_MAP_H
+#define MEMORY_MAP_H
+
+#include <string>
+#include <vector>
+
+// Where the 24 bit addresses of the SNES bus go for a cartridge mapper.
+//
+// The map is a table of the 4096 4KB pages of the address space, so
+// resolving an address is one indexed load and an add, whatever the
+// mapper.  The maps are built once and shared (see get).
+//
+// Every address has a canonical form that labels and byte properties are
+// kept under, so that mirrors find the same symbol:
+//   ROM   the slow ROM bank for LoROM ($00-$7D:8000-FFFF) and $C0-$FF
+//         for HiROM; the FastROM mirrors in $80-$FF fold onto them
+//   WRAM  $7E:0000-FFFF and $7F:0000-FFFF; the low 8KB of the system
+//         banks mirror $7E:0000-1FFF
+//   IO    $00:2000-5FFF
+//   SRAM  $70-$7D:0000-7FFF for LoROM, $20-$3F:6000-7FFF for HiROM
+// anything else is left as it is.
+struct MemoryMap
+{
+    enum Mapper { LoRom, HiRom, ExHiRom };
+    enum Region { Unmapped, Rom, Wram, Io, Sram };
+
+    struct Location
+    {
+        Region m_region;
+        unsigned int m_offset; //file offset past the header for ROM, offset in the region otherwise
+        unsigned int m_canonical;
+    };
+
+    static const MemoryMap& get(Mapper mapper);
+    static bool parse(const std::string& name, Mapper* mapper); //"lorom", "hirom" or "exhirom"
+
+    Mapper mapper() const { return m_mapper; }
+
+    // how many bytes of ROM the mapper can address
+    unsigned int rom_capacity() const { return m_rom_capacity; }
+    // how many bytes of ROM one bank holds
+    unsigned int rom_bank_size() const { return m_mapper == LoRom ? 0x8000 : 0x10000; }
+
+    Location resolve(unsigned int address) const
+    {
+        const Page& page = m_pages[(address >> 12) & 0xFFF];
+        Location location = { (Region)page.m_region, page.m_offset + (address & 0xFFF), page.m_canonical + (address & 0xFFF) };
+        return location;
+    }
+
+    unsigned int canonical(unsigned int address) const
+    {
+        const Page& page = m_pages[(address >> 12) & 0xFFF];
+        return page.m_canonical + (address & 0xFFF);
+    }
+
+    // The file offset of a ROM address, and rom_capacity() for anything
+    // else, so that it can index a table of rom_capacity() + 1 entries
+    // without checking the region first.
+    unsigned int rom_index(unsigned int address) const
+    {
+        const Page& page = m_pages[(address >> 12) & 0xFFF];
+        return page.m_index + (address & page.m_index_mask);
+    }
+
+    bool is_rom(unsigned int address) const { return m_pages[(address >> 12) & 0xFFF].m_region == Rom; }
+
+    // the canonical address of a file offset
+    unsigned int rom_address(unsigned int offset) const
+    {
+        return offset < m_rom_capacity ? m_rom_pages[offset >> 12] + (offset & 0xFFF) : 0;
+    }
+
+    // Steps to the next byte of ROM.  Past the end of a bank that is the
+    // first ROM page of the next one, $xx:8000 for LoROM.
+    void increment(unsigned char* bank, unsigned int* pc) const
+    {
+        if (++*pc > 0xFFFF){
+            ++*bank;
+            *pc = m_bank_start[*bank];
+        }
+    }
+
+    // the address where the ROM in bank starts, $8000 if it has none
+    unsigned int bank_start(unsigned char bank) const { return m_bank_start[bank]; }
+
+    // A range of full addresses, the end exclusive, that starts in a bank
+    // holding only 32KB of a 64KB ROM bank ($00-$3F and $80-$BF for HiROM)
+    // and runs past $xx:FFFF is moved to the banks that map all 64KB.  It
+    // then takes the ROM in file order instead of skipping the lower half
+    // of the next bank: $00:FFF0-$01:8010 becomes $C0:FFF0-$C1:8010.  Any
+    // other range, and every LoROM one, is left as it is.
+    void contiguous_range(unsigned int* start, unsigned int* end) const;
+
+private:
+    struct Page
+    {
+        unsigned char m_region;
+        unsigned int m_offset;
+        unsigned int m_canonical;
+        unsigned int m_index;
+        unsigned int m_index_mask; //0xFFF for ROM, 0 otherwise
+    };
+
+    MemoryMap(Mapper mapper);
+    void map(unsigned int bank, unsigned int page, Region region, unsigned int offset, unsigned int canonical);
+    void map_system_page(unsigned int bank, unsigned int page);
+
+    Mapper m_mapper;
+    unsigned int m_rom_capacity;
+    Page m_pages[256 * 16];
+    unsigned int m_bank_start[256];
+    std::vector<unsigned int> m_rom_pages; //canonical address of each 4KB of ROM
+};
+
+#endif
@@ -0,0 +1,115 @@
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include "memory_usage.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace{
+    string megabytes(size_t bytes)
+    {
+        ostringstream ss;
+        ss << fixed << setprecision(2) << bytes / (1024.0 * 1024.0);
+        return ss.str();
+    }
+}
+
+size_t Memory::resident_bytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.WorkingSetSize;
+#else
+    // second field of statm: resident pages
+    ifstream statm("/proc/self/statm");
+    size_t total = 0, resident = 0;
+    if (!(statm >> total >> resident))
+        return 0;
+    return resident * (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+size_t Memory::peak_resident_bytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss; //bytes
+#else
+    return (size_t)usage.ru_maxrss * 1024; //kilobytes
+#endif
+#endif
+}
+
+MemoryUsage::MemoryUsage() :
+m_resident(Memory::resident_bytes()),
+m_peak_resident(Memory::peak_resident_bytes())
+{ }
+
+void MemoryUsage::add(const string& name, size_t bytes, size_t items)
+{
+    Entry entry;
+    entry.m_name = name;
+    entry.m_bytes = bytes;
+    entry.m_items = items;
+    m_entries.push_back(entry);
+}
+
+size_t MemoryUsage::total() const
+{
+    size_t total = 0;
+    for (size_t i = 0; i < m_entries.size(); ++i){
+        total += m_entries[i].m_bytes;
+    }
+    return total;
+}
+
+void MemoryUsage::print(ostream& out) const
+{
+    out << "; " << left << setw(28) << "memory" << right << setw(10) << "items"
+        << setw(12) << "MB" << endl;
+    for (size_t i = 0; i < m_entries.size(); ++i){
+        const Entry& e = m_entries[i];
+        out << "; " << left << setw(28) << e.m_name << right << setw(10) << e.m_items
+            << setw(12) << megabytes(e.m_bytes) << endl;
+    }
+    out << "; " << left << setw(28) << "total accounted" << right << setw(22) << megabytes(total()) << endl;
+    out << "; " << left << setw(28) << "resident" << right << setw(22) << megabytes(m_resident) << endl;
+    out << "; " << left << setw(28) << "peak resident" << right << setw(22) << megabytes(m_peak_resident) << endl;
+}
+
+void MemoryUsage::write_json(ostream& out, const string& indent) const
+{
+    out << "{";
+    for (size_t i = 0; i < m_entries.size(); ++i){
+        string key = m_entries[i].m_name;
+        for (size_t c = 0; c < key.size(); ++c){
+            if (key[c] == ' ')
+                key[c] = '_';
+        }
+        out << (i ? "," : "") << endl << indent << "  \"" << key << "\": { \"bytes\": " << m_entries[i].m_bytes
+            << ", \"items\": " << m_entries[i].m_items << " }";
+    }
+    out << "," << endl << indent << "  \"total_accounted\": " << total()
+        << "," << endl << indent << "  \"resident\": " << m_resident
+        << "," << endl << indent << "  \"peak_resident\": " << m_peak_resident
+        << endl << indent << "}";
+}
@@ -0,0 +1,65 @@
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Byte accounting for --stats and the memstats command.  Each structure
+// reports what it holds through a size hook; these are estimates: strings
+// only count storage beyond their inline buffer and map nodes are charged
+// a typical red-black tree node header.
+namespace Memory
+{
+    const size_t MAP_NODE_OVERHEAD = 4 * sizeof(void*);
+
+    inline size_t heap_bytes(const std::string& s)
+    {
+        static const size_t inline_capacity = std::string().capacity();
+        return s.capacity() > inline_capacity ? s.capacity() + 1 : 0;
+    }
+
+    template <typename T>
+    size_t heap_bytes(const T&)
+    {
+        return 0;
+    }
+
+    template <typename K, typename V>
+    size_t heap_bytes(const std::map<K, V>& m)
+    {
+        size_t bytes = m.size() * (sizeof(typename std::map<K, V>::value_type) + MAP_NODE_OVERHEAD);
+        for (typename std::map<K, V>::const_iterator it = m.begin(); it != m.end(); ++it){
+            bytes += heap_bytes(it->first) + heap_bytes(it->second);
+        }
+        return bytes;
+    }
+
+    size_t resident_bytes(); //0 where unknown
+    size_t peak_resident_bytes();
+}
+
+struct MemoryUsage
+{
+    struct Entry
+    {
+        std::string m_name;
+        size_t m_bytes;
+        size_t m_items;
+    };
+
+    MemoryUsage();
+
+    void add(const std::string& name, size_t bytes, size_t items = 0);
+    size_t total() const;
+
+    void print(std::ostream& out) const;
+    void write_json(std::ostream& out, const std::string& indent) const;
+
+    std::vector<Entry> m_entries;
+    size_t m_resident; //sampled when the report is made
+    size_t m_peak_resident;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#include "disassembler.h"
+#include "options.h"
+
+using namespace std;
+
+namespace{
+    struct DriverFileOption
+    {
+        const char* m_name;
+        DriverFile::Type m_type;
+    };
+
+    const DriverFileOption DRIVER_FILE_OPTIONS[] = {
+        { "--dbank", DriverFile::DataBank },
+        { "--data", DriverFile::Data },
+        { "--ptr", DriverFile::Pointers },
+        { "--sym", DriverFile::Symbols },
+        { "--ram", DriverFile::RamSymbols },
+        { "--sym2", DriverFile::TraceSymbols },
+        { "--comment", DriverFile::Comments },
+        { "--offsets", DriverFile::Offsets },
+        { "--registers", DriverFile::Registers },
+        { "--accum", DriverFile::Flags }, //todo: rename
+        { "--index", DriverFile::Flags },
+    };
+}
+
+string join_path(const string& dir, const string& name)
+{
+    if (dir.empty() || name.empty() || name[0] == '/' || name[0] == '\\' || (name.size() > 1 && name[1] == ':'))
+        return name;
+    char last = dir[dir.size() - 1];
+    return (last == '/' || last == '\\') ? dir + name : dir + "/" + name;
+}
+
+bool parse_disassembler_option(Disassembler& disasm, const vector<string>& args, size_t* i,
+    vector<DriverFile>* driver_files, string* error, const string& dir)
+{
+    const string& current = args[*i];
+    bool has_value = *i + 1 < args.size();
+
+    for (const DriverFileOption& option : DRIVER_FILE_OPTIONS){
+        if (current == option.m_name && has_value){
+            driver_files->push_back(DriverFile(option.m_type, join_path(dir, args[++*i])));
+            return true;
+        }
+    }
+
+    if (current == "--instr" && has_value)
+        disasm.load_instruction_names(join_path(dir, args[++*i]).c_str());
+    else if (current == "--output" && has_value)
+        disasm.set_output_format(args[++*i].c_str());
+    else if (current == "--annotate" && has_value)
+        disasm.set_annotation_format(args[++*i].c_str());
+    else if (current == "--hirom")
+        disasm.hirom(true);
+    else if (current == "--map" && has_value){
+        MemoryMap::Mapper mapper;
+        if (!MemoryMap::parse(args[++*i], &mapper))
+            *error = "Unknown memory map " + args[*i] + ", expected lorom, hirom or exhirom";
+        else
+            disasm.memory_map(mapper);
+    }
+    else if (current == "--quiet")
+        disasm.quiet(true);
+    else if (current == "--noheader")
+        disasm.header_size(0);
+    else if (current == "--2pass")
+        disasm.passes(2);
+    else if (current == "--cycles")
+        disasm.cycles(true);
+    else
+        return false;
+    return true;
+}
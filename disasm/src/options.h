@@ -0,0 +1,23 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <string>
+#include <vector>
+#include "driver_file.h"
+
+struct Disassembler;
+
+// The options that set up a Disassembler: driver files, formats and ROM
+// layout.  Shared by the command line and --batch jobs.
+//
+// If args[*i] is one of them it is applied (driver files are only
+// collected, see Disassembler::load_driver_files) and *i is left on its
+// last argument.  Relative file names are taken from dir, if given.  If
+// its value is bad, *error says why and nothing is applied.
+bool parse_disassembler_option(Disassembler& disasm, const std::vector<std::string>& args, size_t* i,
+    std::vector<DriverFile>* driver_files, std::string* error, const std::string& dir = "");
+
+// dir/name, unless name is absolute or dir is empty
+std::string join_path(const std::string& dir, const std::string& name);
+
+#endif
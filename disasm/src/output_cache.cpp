@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include "output_cache.h"
+#include "disassembler.h"
+#include "mapped_file.h"
+#include "utils.h"
+
+using namespace std;
+
+namespace{
+    const char* MAGIC = "disasm-cache";
+
+    string executable_path()
+    {
+#ifdef _WIN32
+        char path[MAX_PATH];
+        DWORD length = GetModuleFileNameA(NULL, path, MAX_PATH);
+        return length > 0 && length < MAX_PATH ? string(path, length) : "";
+#else
+        return "/proc/self/exe";
+#endif
+    }
+
+    string hex(uint64_t value)
+    {
+        char text[17];
+        snprintf(text, sizeof(text), "%016llX", (unsigned long long)value);
+        return text;
+    }
+
+    bool read_file(const string& filename, string* text)
+    {
+        ifstream in(filename.c_str(), ios::binary);
+        if (!in)
+            return false;
+        ostringstream ss;
+        ss << in.rdbuf();
+        *text = ss.str();
+        return true;
+    }
+}
+
+OutputCache::OutputCache(const string& directory) :
+m_directory(directory)
+{
+    error_code error;
+    filesystem::create_directories(m_directory, error);
+}
+
+string OutputCache::filename(uint64_t key) const
+{
+    return (filesystem::path(m_directory) / (hex(key) + ".lst")).string();
+}
+
+bool OutputCache::lookup(uint64_t key, const Disassembler& disasm, string* listing) const
+{
+    string text;
+    if (!read_file(filename(key), &text))
+        return false;
+
+    istringstream in(text);
+    string line;
+    if (!getline(in, line) || line != string(MAGIC) + " " + hex(key))
+        return false;
+
+    while (getline(in, line)){
+        if (line == "listing"){
+            *listing = text.substr((size_t)in.tellg());
+            return true;
+        }
+        size_t space = line.find(' ');
+        unsigned int address = (unsigned int)strtoul(line.substr(0, space).c_str(), 0, 16);
+        string label = space == string::npos ? "" : line.substr(space + 1);
+        if (disasm.symbol_at(address) != label)
+            return false;
+    }
+    return false;
+}
+
+bool OutputCache::store(uint64_t key, const Disassembler& disasm, vector<unsigned int> extern_labels, const string& listing) const
+{
+    sort(extern_labels.begin(), extern_labels.end());
+    extern_labels.erase(unique(extern_labels.begin(), extern_labels.end()), extern_labels.end());
+
+    ostringstream text;
+    text << MAGIC << " " << hex(key) << "\n";
+    for (unsigned int address : extern_labels){
+        string label = disasm.symbol_at(address);
+        text << Address::to_string(address, 6) << (label.empty() ? "" : " ") << label << "\n";
+    }
+    text << "listing\n" << listing;
+
+    // jobs on other threads may store the same key
+    ostringstream temporary;
+    temporary << filename(key) << "." << hash<thread::id>()(this_thread::get_id()) << ".tmp";
+    {
+        ofstream out(temporary.str().c_str(), ios::binary);
+        if (!(out << text.str()))
+            return false;
+    }
+    error_code error;
+    filesystem::rename(temporary.str(), filename(key), error);
+    if (error){
+        filesystem::remove(temporary.str(), error);
+        return false;
+    }
+    return true;
+}
+
+uint64_t OutputCache::tool_version()
+{
+    static const uint64_t version = [](){
+        ContentHash hash;
+        MappedFile executable;
+        if (executable.open(executable_path()))
+            hash.add(executable.data(), executable.size());
+        else
+            hash.add(string_view(__DATE__ " " __TIME__));
+        return hash.value();
+    }();
+    return version;
+}
+
+bool write_if_changed(const string& filename, const string& text, bool* changed)
+{
+    if (changed)
+        *changed = false;
+
+    string current;
+    if (read_file(filename, &current) && current == text)
+        return true;
+
+    ofstream out(filename.c_str(), ios::binary);
+    if (!(out << text))
+        return false;
+    if (changed)
+        *changed = true;
+    return true;
+}
@@ -0,0 +1,67 @@
+#ifndef OUTPUT_CACHE_H
+#define OUTPUT_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct Disassembler;
+
+// 64 bit FNV-1a of everything added to it.  Strings are added with their
+// length so that "ab" + "c" and "a" + "bc" differ.
+struct ContentHash
+{
+    ContentHash() : m_value(0xCBF29CE484222325ull) {}
+
+    void add(const void* data, size_t size)
+    {
+        const unsigned char* bytes = (const unsigned char*)data;
+        for (size_t i = 0; i < size; ++i){
+            m_value = (m_value ^ bytes[i]) * 0x100000001B3ull;
+        }
+    }
+    void add(std::string_view text) { add(text.size()); add(text.data(), text.size()); }
+    void add(uint64_t value) { add(&value, sizeof(value)); }
+
+    uint64_t value() const { return m_value; }
+
+private:
+    uint64_t m_value;
+};
+
+// Listings of --batch jobs, kept in a directory by the hash of what they
+// are made from: the tool itself, the options, the ROM bytes and byte
+// properties of the requested ranges (see Disassembler::hash_request_inputs).
+// Labels outside the ranges aren't known until the listing is made, so an
+// entry also keeps the ones it used and is only reused while they are
+// unchanged.
+//
+// An entry is a text file, <key>.lst:
+//   disasm-cache <key>
+//   <address> <label>     for each label from outside the ranges
+//   listing
+//   <the listing>
+struct OutputCache
+{
+    OutputCache(const std::string& directory);
+
+    bool lookup(uint64_t key, const Disassembler& disasm, std::string* listing) const;
+    bool store(uint64_t key, const Disassembler& disasm, std::vector<unsigned int> extern_labels, const std::string& listing) const;
+
+    // a hash of the running executable, so that a rebuilt tool starts over
+    static uint64_t tool_version();
+
+private:
+    std::string filename(uint64_t key) const;
+
+    std::string m_directory;
+};
+
+// Writes text to filename unless the file already holds exactly that, so
+// that an unchanged listing keeps its timestamp.  changed is set if the
+// file was written.
+bool write_if_changed(const std::string& filename, const std::string& text, bool* changed = 0);
+
+#endif
@@ -7,234 +7,141 @@
 
 using namespace std;
 
-
-std::shared_ptr<OutputHandler> CreateOutputHandler(const std::string& type)
-{
-    if (type == "smas")
-        return make_shared<SmasOutput>();
-    return make_shared<DefaultOutput>();
-}
-
-
-void DefaultOutput::PrintData(const vector<unsigned char>& bytes, const string& label, const string& comment, bool print_bytes, bool end_of_chunk)
-{
-    if (!label.empty()){
-        cout << left << setw(20) << label + ":";
-    }
-    else {
-        cout << setw(20) << "";
-    }
-
-    if (print_bytes) cout << string(14, ' ');
-    cout << ".db ";
-
-    for (int i = 0; i < bytes.size(); ++i){
-        printf("$%.2X", bytes[i]);
-        if (i + 1 < bytes.size())
-        {
-            cout << ",";
-        }
-    }
-
-    if (!comment.empty())
-        cout << "     ; " << comment;
-    cout << endl;
-    if (end_of_chunk)
-        cout << endl;
-}
-
-void DefaultOutput::PrintInstruction(const Instruction& instr, const string& label, const string& user_comment, bool print_bytes, int flags)
-{
-    if (!label.empty()){
-        cout << left << setw(20) << label + ":";
-    }
-    else {
-        cout << left << setw(20) << "";
-    }
-
-    if (print_bytes){
-        cout << setw(14) << instr.getInstructionBytes();
-    }
-
-    string comment = user_comment;
-
-    string flag_comment = instr.flag_comment(flags);
-    if (!flag_comment.empty()){
-        if (!comment.empty()){
-            comment += " ; ";
+namespace{
+    void write_hex_byte(ostream& out, unsigned char byte)
+    {
+        static const char digits[] = "0123456789ABCDEF";
+        char text[3] = { '$', digits[byte >> 4], digits[byte & 0x0F] };
+        out.write(text, 3);
+    }
+
+    // "label:" in a 20 column field
+    void write_label(ostream& out, string_view label)
+    {
+        if (label.empty()){
+            out << setw(20) << "";
+            return;
         }
-        comment += flag_comment;
-    }
-
-    string ram_comment = instr.ram_comment();
-    if (!ram_comment.empty()){
-        if (!comment.empty()){
-            comment += " ; ";
+        out << left << label << ':';
+        if (label.size() + 1 < 20)
+            out << setw(20 - label.size() - 1) << "";
+    }
+
+    // the comments that are present, separated by " ; "
+    void write_comment(ostream& out, const char* prefix, string_view user_comment, string_view flag_comment, string_view ram_comment)
+    {
+        bool first = true;
+        for (string_view part : { user_comment, flag_comment, ram_comment }){
+            if (part.empty())
+                continue;
+            out << (first ? prefix : " ; ") << part;
+            first = false;
         }
-        comment += ram_comment;
     }
-
-    cout << setw(26) << instr.toString() << (comment.empty() ? "" : "; ") << comment << endl;
-
-    string additional_instruction = instr.getAdditionalInstruction();
-    if (!additional_instruction.empty()){
-        cout << setw(print_bytes ? 34 : 20) << "" << additional_instruction << endl;
-    }
-
-    if (instr.metadata().isCodeBreak()){
-        cout << endl;
-    }
-}
-
-void DefaultOutput::BankStart(int bank)
-{
-    cout << ".BANK " << bank << endl;
-}
-
-void DefaultOutput::PassStart()
-{
-    cout << ".INCLUDE \"snes.cfg\"" << endl;
 }
 
-void DefaultOutput::CodeBlockStart()
+std::shared_ptr<OutputHandler> CreateOutputHandler(const std::string& type, std::ostream& out)
 {
-
-}
-
-void DefaultOutput::CodeBlockEnd()
-{
-
-}
-
-void DefaultOutput::PtrBlockStart()
-{
-    cout << endl;
-}
-
-void DefaultOutput::PtrBlockEnd()
-{
-    cout << endl;
-}
-
-void DefaultOutput::DataBlockStart()
-{
-
+    if (type == "smas")
+        return make_shared<SmasOutput>(out);
+    if (type == "none")
+        return make_shared<NoOutput>();
+    return make_shared<DefaultOutput>(out);
 }
 
-void DefaultOutput::DataBlockEnd()
-{
-
-}
 
-void SmasOutput::PrintData(const vector<unsigned char>& bytes, const string& label, const string& comment, bool print_bytes, bool end_of_chunk)
+template<class Format>
+void DialectOutput<Format>::PrintData(const vector<unsigned char>& bytes, string_view label, string_view comment, bool print_bytes, bool end_of_chunk)
 {
-    if (!label.empty()){
-        cout << left << setw(20) << label + ":";
-    }
-    else {
-        cout << setw(20) << "";
-    }
+    write_label(out(), label);
 
-    cout << "db ";
+    if (Format::data_bytes_column && print_bytes) out() << string(14, ' ');
+    out() << Format::data_directive;
 
     for (int i = 0; i < bytes.size(); ++i){
-        printf("$%.2X", bytes[i]);
+        write_hex_byte(out(), bytes[i]);
         if (i + 1 < bytes.size())
         {
-            cout << ",";
+            out() << ",";
         }
     }
 
     if (!comment.empty())
-        cout << "     ;" << comment;
-    cout << endl;
+        out() << Format::data_comment_prefix << comment;
+    out() << endl;
     if (end_of_chunk)
-        cout << endl;
+        out() << endl;
 }
 
-void SmasOutput::PrintInstruction(const Instruction& instr, const string& label, const string& user_comment, bool print_bytes, int flags)
+template<class Format>
+void DialectOutput<Format>::PrintInstruction(const Instruction& instr, string_view label, string_view user_comment, bool print_bytes, int flags)
 {
-    if (!label.empty()){
-        cout << left << setw(20) << label + ":";
-    }
-    else {
-        cout << left << setw(20) << "";
-    }
-
-    if (print_bytes && instr.metadata().is_snes_instruction()){
-        cout << setw(14) << instr.getInstructionBytes();
-    }
-
-    string comment = user_comment;
+    out() << left;
+    write_label(out(), label);
 
-    string flag_comment = instr.flag_comment(flags);
-    if (!flag_comment.empty()){
-        if (!comment.empty()){
-            comment += " ; ";
-        }
-        comment += flag_comment;
+    if (print_bytes && (Format::pseudo_instruction_bytes || instr.metadata().is_snes_instruction())){
+        out() << setw(14) << instr.getInstructionBytes();
     }
 
-    string ram_comment = instr.ram_comment();
-    if (!ram_comment.empty()){
-        if (!comment.empty()){
-            comment += " ; ";
-        }
-        comment += ram_comment;
+    out() << setw(26) << instr.toString();
+    if (!instr.cycles().empty())
+        out() << setw(14) << instr.cycles();
+    if (instr.comment_level() >= Format::min_comment_level){
+        write_comment(out(), Format::comment_prefix, user_comment, instr.flag_comment(flags), instr.ram_comment());
     }
+    out() << endl;
 
-    cout << setw(26) << instr.toString();
-    if (instr.comment_level() > 0){
-        cout << (comment.empty() ? "" : ";") << comment;
-        //cout << ";" << comment;
-    }
-    cout << endl;
-
-    string additional_instruction = instr.getAdditionalInstruction();
-    if (!additional_instruction.empty()){
-        cout << setw(print_bytes ? 34 : 20) << "" << additional_instruction << endl;
+    const char* additional_instruction = instr.getAdditionalInstruction();
+    if (*additional_instruction){
+        out() << setw(print_bytes ? 34 : 20) << "" << additional_instruction << endl;
     }
 
     if (instr.metadata().isCodeBreak()){
-        cout << endl;
+        out() << endl;
     }
 }
 
-void SmasOutput::BankStart(int bank)
-{
-    cout << ".BANK " << bank << endl;
-}
-
-void SmasOutput::PassStart()
+template<class Format>
+void DialectOutput<Format>::PrintIncbin(string_view filename, unsigned int skip, unsigned int length, string_view label, string_view comment, bool print_bytes)
 {
-    cout << ".INCLUDE \"snes.cfg\"" << endl;
-}
+    write_label(out(), label);
 
-void SmasOutput::CodeBlockStart()
-{
+    if (Format::data_bytes_column && print_bytes) out() << string(14, ' ');
+    out() << Format::incbin_directive << '"' << filename << '"' << dec;
+    if (skip)
+        out() << " SKIP " << skip;
+    if (length)
+        out() << " READ " << length;
 
+    if (!comment.empty())
+        out() << Format::data_comment_prefix << comment;
+    out() << endl << endl;
 }
 
-void SmasOutput::CodeBlockEnd()
+template<class Format>
+void DialectOutput<Format>::BankStart(int bank)
 {
-
+    out() << ".BANK " << bank << endl;
 }
 
-void SmasOutput::PtrBlockStart()
+template<class Format>
+void DialectOutput<Format>::PassStart()
 {
+    out() << ".INCLUDE \"snes.cfg\"" << endl;
 }
 
-void SmasOutput::PtrBlockEnd()
+template<class Format>
+void DialectOutput<Format>::PtrBlockStart()
 {
-    cout << endl;
+    if (Format::blank_before_pointers)
+        out() << endl;
 }
 
-void SmasOutput::DataBlockStart()
+template<class Format>
+void DialectOutput<Format>::PtrBlockEnd()
 {
-
+    out() << endl;
 }
 
-void SmasOutput::DataBlockEnd()
-{
-
-}
+template struct DialectOutput<DefaultFormat>;
+template struct DialectOutput<SmasFormat>;
@@ -1,12 +1,23 @@
+#ifndef OUTPUT_HANDLERS_H
+#define OUTPUT_HANDLERS_H
+
+#include <iostream>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 struct Instruction;
 
 struct OutputHandler{
-    virtual void PrintData(const std::vector<unsigned char>& bytes, const std::string& label, const std::string& comment, bool print_bytes, bool end_of_chunk) = 0;
-    virtual void PrintInstruction(const Instruction& instr, const std::string& label, const std::string& comment, bool print_bytes, int flags) = 0;
+    explicit OutputHandler(std::ostream& out) : m_out(&out) {}
+    virtual ~OutputHandler() {}
+
+    virtual void PrintData(const std::vector<unsigned char>& bytes, std::string_view label, std::string_view comment, bool print_bytes, bool end_of_chunk) = 0;
+    virtual void PrintInstruction(const Instruction& instr, std::string_view label, std::string_view comment, bool print_bytes, int flags) = 0;
+    // bytes of an extracted asset file in place of .db lines; skip and
+    // length are 0 for the start and the rest of the file
+    virtual void PrintIncbin(std::string_view filename, unsigned int skip, unsigned int length, std::string_view label, std::string_view comment, bool print_bytes) = 0;
     virtual void BankStart(int bank) = 0;
     virtual void PassStart() = 0;
     virtual void CodeBlockStart() = 0;
@@ -15,40 +26,66 @@ struct OutputHandler{
     virtual void PtrBlockEnd() = 0;
     virtual void DataBlockStart() = 0;
     virtual void DataBlockEnd() = 0;
+
+protected:
+    std::ostream& out() const { return *m_out; }
+
+private:
+    std::ostream* m_out;
 };
 
-struct DefaultOutput : public OutputHandler
+// What sets the output dialects apart.  DialectOutput is instantiated
+// once for each, so the formatting has no runtime checks on the dialect.
+struct DefaultFormat
 {
-    virtual void PrintData(const std::vector<unsigned char>& bytes, const std::string& label, const std::string& comment, bool print_bytes, bool end_of_chunk);
-    virtual void PrintInstruction(const Instruction& instr, const std::string& label, const std::string& comment, bool print_bytes, int flags);
-    virtual void BankStart(int bank);
-    virtual void PassStart();
-    virtual void CodeBlockStart();
-    virtual void CodeBlockEnd();
-    virtual void PtrBlockStart();
-    virtual void PtrBlockEnd();
-    virtual void DataBlockStart();
-    virtual void DataBlockEnd();
+    static constexpr const char* data_directive = ".db ";
+    static constexpr const char* incbin_directive = ".INCBIN ";
+    static constexpr const char* data_comment_prefix = "     ; ";
+    static constexpr const char* comment_prefix = "; ";
+    static constexpr bool data_bytes_column = true; //blank space where instructions print their bytes
+    static constexpr bool pseudo_instruction_bytes = true;
+    static constexpr int min_comment_level = 0;
+    static constexpr bool blank_before_pointers = true;
 };
 
-struct SmasOutput : public OutputHandler
+struct SmasFormat
 {
-    virtual void PrintData(const std::vector<unsigned char>& bytes, const std::string& label, const std::string& comment, bool print_bytes, bool end_of_chunk);
-    virtual void PrintInstruction(const Instruction& instr, const std::string& label, const std::string& comment, bool print_bytes, int flags);
+    static constexpr const char* data_directive = "db ";
+    static constexpr const char* incbin_directive = "incbin ";
+    static constexpr const char* data_comment_prefix = "     ;";
+    static constexpr const char* comment_prefix = ";";
+    static constexpr bool data_bytes_column = false;
+    static constexpr bool pseudo_instruction_bytes = false;
+    static constexpr int min_comment_level = 1;
+    static constexpr bool blank_before_pointers = false;
+};
+
+template<class Format>
+struct DialectOutput : public OutputHandler
+{
+    explicit DialectOutput(std::ostream& out) : OutputHandler(out) {}
+    virtual void PrintData(const std::vector<unsigned char>& bytes, std::string_view label, std::string_view comment, bool print_bytes, bool end_of_chunk);
+    virtual void PrintInstruction(const Instruction& instr, std::string_view label, std::string_view comment, bool print_bytes, int flags);
+    virtual void PrintIncbin(std::string_view filename, unsigned int skip, unsigned int length, std::string_view label, std::string_view comment, bool print_bytes);
     virtual void BankStart(int bank);
     virtual void PassStart();
-    virtual void CodeBlockStart();
-    virtual void CodeBlockEnd();
+    virtual void CodeBlockStart() {}
+    virtual void CodeBlockEnd() {}
     virtual void PtrBlockStart();
     virtual void PtrBlockEnd();
-    virtual void DataBlockStart();
-    virtual void DataBlockEnd();
+    virtual void DataBlockStart() {}
+    virtual void DataBlockEnd() {}
 };
 
+typedef DialectOutput<DefaultFormat> DefaultOutput;
+typedef DialectOutput<SmasFormat> SmasOutput;
+
 struct NoOutput : public OutputHandler
 {
-    virtual void PrintData(const std::vector<unsigned char>& bytes, const std::string& label, const std::string& comment, bool print_bytes, bool end_of_chunk) {}
-    virtual void PrintInstruction(const Instruction& instr, const std::string& label, const std::string& comment, bool print_bytes, int flags) {}
+    NoOutput() : OutputHandler(std::cout) {}
+    virtual void PrintData(const std::vector<unsigned char>& bytes, std::string_view label, std::string_view comment, bool print_bytes, bool end_of_chunk) {}
+    virtual void PrintInstruction(const Instruction& instr, std::string_view label, std::string_view comment, bool print_bytes, int flags) {}
+    virtual void PrintIncbin(std::string_view filename, unsigned int skip, unsigned int length, std::string_view label, std::string_view comment, bool print_bytes) {}
     virtual void BankStart(int bank) {}
     virtual void PassStart() {}
     virtual void CodeBlockStart() {}
@@ -59,4 +96,6 @@ struct NoOutput : public OutputHandler
     virtual void DataBlockEnd() {}
 };
 
-std::shared_ptr<OutputHandler> CreateOutputHandler(const std::string& type);
+std::shared_ptr<OutputHandler> CreateOutputHandler(const std::string& type, std::ostream& out);
+
+#endif
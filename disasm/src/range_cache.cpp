@@ -0,0 +1,278 @@
+#include <memory>
+#include "disassembler.h"
+#include "range_cache.h"
+#include "utils.h"
+
+using namespace std;
+
+RangeCacheEntry::RangeCacheEntry(const Request& request) :
+m_request(request),
+m_end(request.m_properties.full_end_address()),
+m_arena(4 * 1024),
+m_bytes(sizeof(RangeCacheEntry))
+{ }
+
+void RangeCacheEntry::add_unit(Unit::Kind kind, unsigned int begin, string_view text)
+{
+    Unit unit;
+    unit.m_kind = kind;
+    unit.m_begin = begin;
+    unit.m_text = m_arena.copy(text);
+    unit.m_labels = store(&m_labels);
+    unit.m_used = store(&m_used);
+
+    // the text and labels are in m_arena
+    m_bytes += sizeof(Unit);
+    m_units.push_back(unit);
+}
+
+RangeCacheEntry::LabelRange RangeCacheEntry::store(vector<Label>* labels)
+{
+    LabelRange range;
+    range.m_size = labels->size();
+    range.m_data = 0;
+    if (!labels->empty()){
+        Label* data = (Label*)m_arena.allocate(labels->size() * sizeof(Label), alignof(Label));
+        uninitialized_copy(labels->begin(), labels->end(), data);
+        range.m_data = data;
+        labels->clear();
+    }
+    return range;
+}
+
+
+RangeCache::RangeCache(size_t max_bytes) :
+m_max_bytes(max_bytes),
+m_bytes(0),
+m_hits(0),
+m_misses(0)
+{ }
+
+RangeCache::RangeCache(const RangeCache& other) :
+m_max_bytes(other.m_max_bytes),
+m_bytes(0),
+m_hits(0),
+m_misses(0)
+{ }
+
+RangeCache& RangeCache::operator=(const RangeCache& other)
+{
+    clear();
+    m_max_bytes = other.m_max_bytes;
+    return *this;
+}
+
+bool RangeCache::is_cacheable(const Request& request)
+{
+    // the second pass depends on every label used by the first, so
+    // multi-pass requests are always decoded in full
+    const DisassemblerProperties& p = request.m_properties;
+    return !request.m_quit && p.m_passes == 1 &&
+        p.full_end_address() > Address::full_address(p.m_start_bank, p.m_start_addr);
+}
+
+string RangeCache::key(const Request& request)
+{
+    const DisassemblerProperties& p = request.m_properties;
+    ostringstream ss;
+    ss << request.m_type << ' ' << Address::full_address(p.m_start_bank, p.m_start_addr) << ' '
+        << p.m_start_w_accum_16 << p.m_start_w_index_16 << ' ' << p.m_comment_level << ' '
+        << p.m_use_extern_symbols << p.m_quiet << p.m_stop_at_rts;
+    return ss.str();
+}
+
+bool RangeCache::lookup(const Request& request, vector<const RangeCacheEntry::Unit*>* units)
+{
+    map<string, EntryList::iterator>::iterator it = m_index.find(key(request));
+    if (it == m_index.end() || !slice(**it->second, request, units)){
+        ++m_misses;
+        return false;
+    }
+
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    ++m_hits;
+    return true;
+}
+
+// A fresh decode of a shorter range only differs from the cached one in
+// where it stops: code segments simply stop earlier, data segments would
+// be chunked differently so they have to be complete, and labels past
+// the new end are no longer in range unless extern symbols are allowed.
+bool RangeCache::slice(const RangeCacheEntry& entry, const Request& request, vector<const RangeCacheEntry::Unit*>* units)
+{
+    typedef RangeCacheEntry::Unit Unit;
+
+    unsigned int end = request.m_properties.full_end_address();
+    if (end > entry.m_end)
+        return false;
+
+    units->clear();
+    bool in_code = false;
+    for (size_t i = 0; i < entry.m_units.size(); ++i){
+        const Unit& unit = entry.m_units[i];
+
+        if (unit.m_kind == Unit::CodeStart || unit.m_kind == Unit::DataStart){
+            if (unit.m_begin >= end)
+                break;
+
+            in_code = (unit.m_kind == Unit::CodeStart);
+            if (!in_code){
+                unsigned int segment_end = entry.m_end;
+                for (size_t j = i + 1; j < entry.m_units.size(); ++j){
+                    if (entry.m_units[j].m_kind == Unit::CodeStart || entry.m_units[j].m_kind == Unit::DataStart){
+                        segment_end = entry.m_units[j].m_begin;
+                        break;
+                    }
+                }
+                if (segment_end > end)
+                    return false;
+            }
+        }
+        else if (unit.m_kind != Unit::BlockEnd && in_code && unit.m_begin >= end){
+            continue;
+        }
+
+        if (!request.m_properties.m_use_extern_symbols){
+            for (size_t l = 0; l < unit.m_labels.size(); ++l){
+                if ((unsigned int)unit.m_labels[l].first > end)
+                    return false;
+            }
+        }
+        units->push_back(&unit);
+    }
+    return true;
+}
+
+void RangeCache::insert(const shared_ptr<RangeCacheEntry>& entry)
+{
+    if (entry->size_in_bytes() > m_max_bytes)
+        return;
+
+    string k = key(entry->m_request);
+    map<string, EntryList::iterator>::iterator it = m_index.find(k);
+    if (it != m_index.end()){
+        m_bytes -= (*it->second)->size_in_bytes();
+        m_entries.erase(it->second);
+        m_index.erase(it);
+    }
+
+    evict(entry->size_in_bytes());
+    m_entries.push_front(entry);
+    m_index[k] = m_entries.begin();
+    m_bytes += entry->size_in_bytes();
+}
+
+void RangeCache::evict(size_t needed)
+{
+    while (!m_entries.empty() && m_bytes + needed > m_max_bytes){
+        const shared_ptr<RangeCacheEntry>& oldest = m_entries.back();
+        m_bytes -= oldest->size_in_bytes();
+        m_index.erase(key(oldest->m_request));
+        m_entries.pop_back();
+    }
+}
+
+void RangeCache::clear()
+{
+    m_entries.clear();
+    m_index.clear();
+    m_bytes = 0;
+}
+
+void RangeCache::remove_if(const function<bool(const RangeCacheEntry&)>& stale)
+{
+    for (EntryList::iterator it = m_entries.begin(); it != m_entries.end();){
+        if (!stale(**it)){
+            ++it;
+            continue;
+        }
+        m_bytes -= (*it)->size_in_bytes();
+        m_index.erase(key((*it)->m_request));
+        it = m_entries.erase(it);
+    }
+}
+
+
+RecordingOutput::RecordingOutput(const string& output_format, const DisassemblerState* state, RangeCacheEntry* entry) :
+OutputHandler(m_stream),
+m_stream(&m_text),
+m_state(state),
+m_entry(entry),
+m_last_end(state->get_current_address())
+{
+    m_inner = CreateOutputHandler(output_format, m_stream);
+}
+
+void RecordingOutput::add_unit(RangeCacheEntry::Unit::Kind kind, bool starts_here)
+{
+    unsigned int current = m_state->get_current_address();
+    m_entry->add_unit(kind, starts_here ? current : m_last_end, m_text.text());
+    m_text.clear();
+    m_last_end = current;
+}
+
+void RecordingOutput::PrintData(const vector<unsigned char>& bytes, string_view label, string_view comment, bool print_bytes, bool end_of_chunk)
+{
+    m_inner->PrintData(bytes, label, comment, print_bytes, end_of_chunk);
+    add_unit(RangeCacheEntry::Unit::Line, false);
+}
+
+void RecordingOutput::PrintInstruction(const Instruction& instr, string_view label, string_view comment, bool print_bytes, int flags)
+{
+    m_inner->PrintInstruction(instr, label, comment, print_bytes, flags);
+    add_unit(RangeCacheEntry::Unit::Line, false);
+}
+
+void RecordingOutput::PrintIncbin(string_view filename, unsigned int skip, unsigned int length, string_view label, string_view comment, bool print_bytes)
+{
+    m_inner->PrintIncbin(filename, skip, length, label, comment, print_bytes);
+    add_unit(RangeCacheEntry::Unit::Line, false);
+}
+
+void RecordingOutput::BankStart(int bank)
+{
+    m_inner->BankStart(bank);
+    add_unit(RangeCacheEntry::Unit::Marker, true);
+}
+
+void RecordingOutput::PassStart()
+{
+    m_inner->PassStart();
+    add_unit(RangeCacheEntry::Unit::Marker, true);
+}
+
+void RecordingOutput::CodeBlockStart()
+{
+    m_inner->CodeBlockStart();
+    add_unit(RangeCacheEntry::Unit::CodeStart, true);
+}
+
+void RecordingOutput::CodeBlockEnd()
+{
+    m_inner->CodeBlockEnd();
+    add_unit(RangeCacheEntry::Unit::BlockEnd, true);
+}
+
+void RecordingOutput::PtrBlockStart()
+{
+    m_inner->PtrBlockStart();
+    add_unit(RangeCacheEntry::Unit::DataStart, true);
+}
+
+void RecordingOutput::PtrBlockEnd()
+{
+    m_inner->PtrBlockEnd();
+    add_unit(RangeCacheEntry::Unit::BlockEnd, true);
+}
+
+void RecordingOutput::DataBlockStart()
+{
+    m_inner->DataBlockStart();
+    add_unit(RangeCacheEntry::Unit::DataStart, true);
+}
+
+void RecordingOutput::DataBlockEnd()
+{
+    m_inner->DataBlockEnd();
+    add_unit(RangeCacheEntry::Unit::BlockEnd, true);
+}
@@ -0,0 +1,173 @@
+#ifndef RANGE_CACHE_H
+#define RANGE_CACHE_H
+
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "arena.h"
+#include "memory_usage.h"
+#include "output_handlers.h"
+#include "request.h"
+
+struct DisassemblerState;
+
+// The output of a single pass request, split into the pieces that the
+// output handler produced, so that a later request with the same start
+// and a shorter (or equal) range can be answered by slicing it instead
+// of decoding again.  The text of an entry lives in its own arena and is
+// released with it.
+struct RangeCacheEntry
+{
+    typedef std::pair<int, std::string_view> Label;
+
+    struct LabelRange
+    {
+        size_t size() const { return m_size; }
+        const Label& operator[](size_t i) const { return m_data[i]; }
+
+        const Label* m_data;
+        size_t m_size;
+    };
+
+    struct Unit
+    {
+        enum Kind { Line, Marker, CodeStart, DataStart, BlockEnd };
+
+        Kind m_kind;
+        unsigned int m_begin; //address the unit starts at
+        std::string_view m_text;
+        LabelRange m_labels; //labels resolved while producing this unit
+        LabelRange m_used; //labels marked as used while producing this unit
+    };
+
+    RangeCacheEntry(const Request& request);
+    RangeCacheEntry(const RangeCacheEntry&) = delete; //units point into m_arena
+    RangeCacheEntry& operator=(const RangeCacheEntry&) = delete;
+
+    void add_unit(Unit::Kind kind, unsigned int begin, std::string_view text);
+    void note_label(int key, std::string_view label) { m_labels.push_back(std::make_pair(key, m_arena.copy(label))); }
+    void note_used(int key, std::string_view label) { m_used.push_back(std::make_pair(key, m_arena.copy(label))); }
+
+    size_t size_in_bytes() const { return m_bytes + m_arena.size_in_bytes(); }
+
+    Request m_request;
+    unsigned int m_end;
+    std::vector<Unit> m_units;
+
+private:
+    LabelRange store(std::vector<Label>* labels);
+
+    Arena m_arena;
+    std::vector<Label> m_labels; //noted since the last unit
+    std::vector<Label> m_used;
+    size_t m_bytes;
+};
+
+// Least recently used set of RangeCacheEntry, keyed by the request with
+// its end address left out.  Anything that changes the annotations or
+// the output format must clear it.
+struct RangeCache
+{
+    RangeCache(size_t max_bytes = 16 * 1024 * 1024);
+
+    // entries are not shared between copies (sessions start out empty)
+    RangeCache(const RangeCache& other);
+    RangeCache& operator=(const RangeCache& other);
+
+    static bool is_cacheable(const Request& request);
+
+    // fills units with the slice of a cached entry that reproduces request
+    bool lookup(const Request& request, std::vector<const RangeCacheEntry::Unit*>* units);
+    void insert(const std::shared_ptr<RangeCacheEntry>& entry);
+    void clear();
+    // drops the entries that stale picks, for changes to a few addresses
+    void remove_if(const std::function<bool(const RangeCacheEntry&)>& stale);
+
+    unsigned int hits() const { return m_hits; }
+    unsigned int misses() const { return m_misses; }
+
+    size_t entries() const { return m_entries.size(); }
+    size_t size_in_bytes() const
+    {
+        return m_bytes + Memory::heap_bytes(m_index) + m_entries.size() * (sizeof(EntryList::value_type) + 2 * sizeof(void*));
+    }
+
+private:
+    typedef std::list<std::shared_ptr<RangeCacheEntry> > EntryList;
+
+    static std::string key(const Request& request);
+    static bool slice(const RangeCacheEntry& entry, const Request& request, std::vector<const RangeCacheEntry::Unit*>* units);
+    void evict(size_t needed);
+
+    size_t m_max_bytes;
+    size_t m_bytes;
+    EntryList m_entries; //most recently used first
+    std::map<std::string, EntryList::iterator> m_index;
+    unsigned int m_hits;
+    unsigned int m_misses;
+};
+
+// Forwards to a real output handler writing into a private stream and
+// cuts what it writes into units for a RangeCacheEntry.
+struct RecordingOutput : public OutputHandler
+{
+    RecordingOutput(const std::string& output_format, const DisassemblerState* state, RangeCacheEntry* entry);
+
+    virtual void PrintData(const std::vector<unsigned char>& bytes, std::string_view label, std::string_view comment, bool print_bytes, bool end_of_chunk);
+    virtual void PrintInstruction(const Instruction& instr, std::string_view label, std::string_view comment, bool print_bytes, int flags);
+    virtual void PrintIncbin(std::string_view filename, unsigned int skip, unsigned int length, std::string_view label, std::string_view comment, bool print_bytes);
+    virtual void BankStart(int bank);
+    virtual void PassStart();
+    virtual void CodeBlockStart();
+    virtual void CodeBlockEnd();
+    virtual void PtrBlockStart();
+    virtual void PtrBlockEnd();
+    virtual void DataBlockStart();
+    virtual void DataBlockEnd();
+
+    std::ostream& stream() { return m_stream; }
+    std::string_view pending_text() const { return m_text.text(); } //written since the last unit
+
+private:
+    // Appends to a string that is kept between units, unlike ostringstream
+    // whose str() hands out a copy.
+    struct TextBuffer : public std::streambuf
+    {
+        std::string_view text() const { return m_text; }
+        void clear() { m_text.clear(); }
+
+    protected:
+        virtual int_type overflow(int_type c)
+        {
+            if (c != traits_type::eof())
+                m_text.push_back((char)c);
+            return traits_type::not_eof(c);
+        }
+
+        virtual std::streamsize xsputn(const char* s, std::streamsize n)
+        {
+            m_text.append(s, (size_t)n);
+            return n;
+        }
+
+    private:
+        std::string m_text;
+    };
+
+    void add_unit(RangeCacheEntry::Unit::Kind kind, bool starts_here);
+
+    TextBuffer m_text;
+    std::ostream m_stream;
+    std::shared_ptr<OutputHandler> m_inner;
+    const DisassemblerState* m_state;
+    RangeCacheEntry* m_entry;
+    unsigned int m_last_end;
+};
+
+#endif
@@ -0,0 +1,265 @@
+#include <algorithm>
+#include <cctype>
+#include "memory_usage.h"
+#include "registers.h"
+
+using namespace std;
+
+namespace{
+    // count registers, stride apart, share the name and legend (DMA channels)
+    struct BuiltinRegister
+    {
+        unsigned int m_address;
+        int m_count;
+        int m_stride;
+        const char* m_name;
+        const char* m_legend[2];
+    };
+
+    constexpr BuiltinRegister BUILTIN[] = {
+        { 0x2100, 1, 0, "Screen Display Register", { "a000bbbb a: 0=screen on, 1=screen off  b = brightness" } },
+        { 0x2101, 1, 0, "OAM Size and Data Area Designation", { "aaabbccc a = Size  b = Name Selection  c = Base Selection" } },
+        { 0x2102, 1, 0, "Address for Accessing OAM", {} },
+        { 0x2104, 1, 0, "OAM Data Write", {} },
+        { 0x2105, 1, 0, "BG Mode and Tile Size Setting", { "abcdefff abcd = BG tile size (4321), 0 = 8x8, 1 = 16x16", "e = BG 3 High Priority  f = BG Mode" } },
+        { 0x2106, 1, 0, "Mosaic Size and BG Enable", { "aaaabbbb a = Mosaic Size  b = Mosaic BG Enable" } },
+        { 0x2107, 1, 0, "BG 1 Address and Size", { "aaaaaabb a = Screen Base Address (Upper 6-bit)  b = Screen Size" } },
+        { 0x2108, 1, 0, "BG 2 Address and Size", { "aaaaaabb a = Screen Base Address (Upper 6-bit)  b = Screen Size" } },
+        { 0x2109, 1, 0, "BG 3 Address and Size", { "aaaaaabb a = Screen Base Address (Upper 6-bit)  b = Screen Size" } },
+        { 0x210A, 1, 0, "BG 4 Address and Size", { "aaaaaabb a = Screen Base Address (Upper 6-bit)  b = Screen Size" } },
+        { 0x210B, 1, 0, "BG 1 & 2 Tile Data Designation", { "aaaabbbb a = BG 2 Tile Base Address  b = BG 1 Tile Base Address" } },
+        { 0x210C, 1, 0, "BG 3 & 4 Tile Data Designation", { "aaaabbbb a = BG 4 Tile Base Address  b = BG 3 Tile Base Address" } },
+        { 0x210D, 1, 0, "BG 1 Horizontal Scroll Offset", {} },
+        { 0x210E, 1, 0, "BG 1 Vertical Scroll Offset", {} },
+        { 0x210F, 1, 0, "BG 2 Horizontal Scroll Offset", {} },
+        { 0x2110, 1, 0, "BG 2 Vertical Scroll Offset", {} },
+        { 0x2111, 1, 0, "BG 3 Horizontal Scroll Offset", {} },
+        { 0x2112, 1, 0, "BG 3 Vertical Scroll Offset", {} },
+        { 0x2113, 1, 0, "BG 4 Horizontal Scroll Offset", {} },
+        { 0x2114, 1, 0, "BG 4 Vertical Scroll Offset", {} },
+        { 0x2115, 1, 0, "VRAM Address Increment Value", {} },
+        { 0x2116, 1, 0, "Address for VRAM Read/Write (Low Byte)", {} },
+        { 0x2117, 1, 0, "Address for VRAM Read/Write (High Byte)", {} },
+        { 0x2118, 1, 0, "Data for VRAM Write (Low Byte)", {} },
+        { 0x2119, 1, 0, "Data for VRAM Write (High Byte)", {} },
+        { 0x211A, 1, 0, "Initial Setting for Mode 7", { "aa0000bc a = Screen Over  b = Vertical Flip  c = Horizontal Flip" } },
+        { 0x211B, 1, 0, "Mode 7 Matrix Parameter A", {} },
+        { 0x211C, 1, 0, "Mode 7 Matrix Parameter B", {} },
+        { 0x211D, 1, 0, "Mode 7 Matrix Parameter C", {} },
+        { 0x211E, 1, 0, "Mode 7 Matrix Parameter D", {} },
+        { 0x211F, 1, 0, "Mode 7 Center Position X", {} },
+        { 0x2120, 1, 0, "Mode 7 Center Position Y", {} },
+        { 0x2121, 1, 0, "Address for CG-RAM Write", {} },
+        { 0x2122, 1, 0, "Data for CG-RAM Write", {} },
+        { 0x2123, 1, 0, "BG 1 and 2 Window Mask Settings", { "aaaabbbb a = BG 2 Window Settings  b = BG 1 Window Settings" } },
+        { 0x2124, 1, 0, "BG 3 and 4 Window Mask Settings", { "aaaabbbb a = BG 4 Window Settings  b = BG 3 Window Settings" } },
+        { 0x2125, 1, 0, "OBJ and Color Window Settings", { "aaaabbbb a = Color Window Settings  b = OBJ Window Settings" } },
+        { 0x2126, 1, 0, "Window 1 Left Position Designation", {} },
+        { 0x2127, 1, 0, "Window 1 Right Position Designation", {} },
+        { 0x2128, 1, 0, "Window 2 Left Position Designation", {} },
+        { 0x2129, 1, 0, "Window 2 Right Position Designation", {} },
+        { 0x212A, 1, 0, "BG 1, 2, 3 and 4 Window Logic Settings", { "aabbccdd a = BG 4  b = BG 3  c = BG 2  d = BG 1" } },
+        { 0x212B, 1, 0, "Color and OBJ Window Logic Settings", { "0000aabb a = Color Window  b = OBJ Window" } },
+        { 0x212C, 1, 0, "Background and Object Enable", { "000abcde a = Object  b = BG 4  c = BG 3  d = BG 2  e = BG 1" } },
+        { 0x212D, 1, 0, "Sub Screen Designation", { "000abcde a = Object  b = BG 4  c = BG 3  d = BG 2  e = BG 1" } },
+        { 0x212E, 1, 0, "Window Mask Designation for Main Screen", { "000abcde a = Object  b = BG 4  c = BG 3  d = BG 2  e = BG 1" } },
+        { 0x212F, 1, 0, "Window Mask Designation for Sub Screen", { "000abcde a = Object  b = BG 4  c = BG 3  d = BG 2  e = BG 1" } },
+        { 0x2130, 1, 0, "Initial Settings for Color Addition", { "aabb00cd a = Main Color Window On/Off b = Sub Color Window On/Off", "c = Fixed Color Add/Subtract Enable  d = Direct Select" } },
+        { 0x2131, 1, 0, "Add/Subtract Select and Enable", { "abcdefgh  a = 0 = Addition, 1 = Subtraction  b = 1/2 Enable", "cdefgh = Enables  c = Back, d = Object, efgh = BG 4, 3, 2, 1" } },
+        { 0x2132, 1, 0, "Fixed Color Data", { "abcddddd a = Blue  b = Green  c = Red  dddd = Color Data" } },
+        { 0x2133, 1, 0, "Screen Initial Settings", { "ab00cdef a = External Sync  b = ExtBG Mode  c = Pseudo 512 Mode", "d = Vertical Size  e = Object-V Select  f = Interlace" } },
+        { 0x2134, 1, 0, "Multiplication Result (Low Byte)", {} },
+        { 0x2135, 1, 0, "Multiplication Result (Mid Byte)", {} },
+        { 0x2136, 1, 0, "Multiplication Result (High Byte)", {} },
+        { 0x2137, 1, 0, "Software Latch for H/V Counter", {} },
+        { 0x2138, 1, 0, "Read Data from OAM (Low-High)", {} },
+        { 0x2139, 1, 0, "Read Data from VRAM (Low)", {} },
+        { 0x213A, 1, 0, "Read Data from VRAM (High)", {} },
+        { 0x213B, 1, 0, "Read Data from CG-RAM (Low-High)", {} },
+        { 0x213C, 1, 0, "H-Counter Data", {} },
+        { 0x213D, 1, 0, "V-Counter Data", {} },
+        { 0x213E, 2, 1, "PPU Status Flag", {} },
+        { 0x2140, 4, 1, "APU I/O Port", {} },
+        { 0x4200, 1, 0, "NMI, V/H Count, and Joypad Enable", { "a0bc000d a = NMI  b = V-Count  c = H-Count  d = Joypad" } },
+        { 0x4201, 1, 0, "Programmable I/O Port Output", {} },
+        { 0x4202, 1, 0, "Multiplicand A", {} },
+        { 0x4203, 1, 0, "Multiplier B", {} },
+        { 0x4204, 1, 0, "Dividend (Low Byte)", {} },
+        { 0x4205, 1, 0, "Dividend (High-Byte)", {} },
+        { 0x4206, 1, 0, "Divisor B", {} },
+        { 0x4207, 1, 0, "H-Count Timer (Upper 8 Bits)", {} },
+        { 0x4208, 1, 0, "H-Count Timer MSB (Bit 0)", {} },
+        { 0x4209, 1, 0, "V-Count Timer (Upper 8 Bits)", {} },
+        { 0x420A, 1, 0, "V-Count Timer MSB (Bit 0)", {} },
+        { 0x420B, 1, 0, "Regular DMA Channel Enable", { "abcdefgh  a = Channel 7 .. h = Channel 0: 0 = Enable  1 = Disable" } },
+        { 0x420C, 1, 0, "H-DMA Channel Enable", { "abcdefgh  a = Channel 7 .. h = Channel 0: 0 = Enable  1 = Disable" } },
+        { 0x420D, 1, 0, "Cycle Speed Designation", { "0000000a a: 0 = 2.68 MHz, 1 = 3.58 MHz" } },
+        { 0x4210, 1, 0, "NMI Enable", { "a0000000 a: 0 = Disabled, 1 = Enabled" } },
+        { 0x4211, 1, 0, "IRQ Flag By H/V Count Timer", { "a0000000 a: 0 = H/V Timer Disabled, 1 = H/V Timer is Time Up" } },
+        { 0x4212, 1, 0, "H/V Blank Flags and Joypad Status", { "ab00000c a = V Blank  b = H Blank  c = Joypad Ready to Be Read" } },
+        { 0x4213, 1, 0, "Programmable I/O Port Input", {} },
+        { 0x4214, 1, 0, "Quotient of Divide Result (Low Byte)", {} },
+        { 0x4215, 1, 0, "Quotient of Divide Result (High Byte)", {} },
+        { 0x4216, 1, 0, "Product/Remainder Result (Low Byte)", {} },
+        { 0x4217, 1, 0, "Product/Remainder Result (High Byte)", {} },
+        { 0x4218, 1, 0, "Joypad 1 Data (Low Byte)", { "abcd0000 a = Button A  b = X  c = L  d = R" } },
+        { 0x4219, 1, 0, "Joypad 1 Data (High Byte)", { "abcdefgh a = B b = Y c = Select d = Start efgh = Up/Dn/Lt/Rt" } },
+        { 0x421A, 1, 0, "Joypad 2 Data (Low Byte)", { "abcd0000 a = Button A  b = X  c = L  d = R" } },
+        { 0x421B, 1, 0, "Joypad 2 Data (High Byte)", { "abcdefgh a = B b = Y c = Select d = Start efgh = Up/Dn/Lt/Rt" } },
+        { 0x421C, 1, 0, "Joypad 3 Data (Low Byte)", { "abcd0000 a = Button A  b = X  c = L  d = R" } },
+        { 0x421D, 1, 0, "Joypad 3 Data (High Byte)", { "abcdefgh a = B b = Y c = Select d = Start efgh = Up/Dn/Lt/Rt" } },
+        { 0x421E, 1, 0, "Joypad 4 Data (Low Byte)", { "abcd0000 a = Button A  b = X  c = L  d = R" } },
+        { 0x421F, 1, 0, "Joypad 4 Data (High Byte)", { "abcdefgh a = B b = Y c = Select d = Start efgh = Up/Dn/Lt/Rt" } },
+        { 0x4300, 8, 0x10, "Parameters for DMA Transfer", { "ab0cdeee a = Direction  b = Type  c = Inc/Dec  d = Auto/Fixed", "e = Word Size Select" } },
+        { 0x4301, 8, 0x10, "B Address", {} },
+        { 0x4302, 8, 0x10, "A Address (Low Byte)", {} },
+        { 0x4303, 8, 0x10, "A Address (High Byte)", {} },
+        { 0x4304, 8, 0x10, "A Address Bank", {} },
+        { 0x4305, 8, 0x10, "Number Bytes to Transfer (Low Byte) (DMA)", {} },
+        { 0x4306, 8, 0x10, "Number Bytes to Transfer (High Byte) (DMA)", {} },
+        { 0x4307, 8, 0x10, "Data Bank (H-DMA)", {} },
+        { 0x4308, 8, 0x10, "A2 Table Address (Low Byte)", {} },
+        { 0x4309, 8, 0x10, "A2 Table Address (High Byte)", {} },
+        { 0x430A, 8, 0x10, "Number of Lines to Transfer (H-DMA)", {} },
+    };
+
+    // legend lines go below the instruction, lined up past the label column
+    const char LEGEND_LINE[] = "\n          ;";
+
+    // the leading word of the legend, if it describes all 8 bits
+    string bit_fields(string_view legend)
+    {
+        string_view word = legend.substr(0, legend.find(' '));
+        if (word.size() != 8)
+            return "";
+        for (char c : word){
+            if (c != '0' && c != '1' && (c < 'a' || c > 'z'))
+                return "";
+        }
+        return string(word);
+    }
+
+    string_view trim(string_view text)
+    {
+        while (!text.empty() && isspace((unsigned char)text.front())) text.remove_prefix(1);
+        while (!text.empty() && isspace((unsigned char)text.back())) text.remove_suffix(1);
+        return text;
+    }
+}
+
+string Register::decode(unsigned int value) const
+{
+    string text;
+    for (size_t i = 0; i < m_fields.size(); ++i){
+        char field = m_fields[i];
+        if (field == '0' || field == '1' || m_fields.find(field) != i)
+            continue;
+
+        unsigned int field_value = 0;
+        for (size_t bit = i; bit < m_fields.size(); ++bit){
+            if (m_fields[bit] == field)
+                field_value = (field_value << 1) | ((value >> (7 - bit)) & 1);
+        }
+
+        if (!text.empty())
+            text += "  ";
+        text += field;
+        text += " = ";
+        text += std::to_string(field_value);
+    }
+    return text;
+}
+
+RegisterDatabase::RegisterDatabase()
+{
+    vector<string_view> legend;
+    for (const BuiltinRegister& row : BUILTIN){
+        legend.clear();
+        for (const char* line : row.m_legend){
+            if (line)
+                legend.push_back(line);
+        }
+        for (int i = 0; i < row.m_count; ++i){
+            add(row.m_address + i * row.m_stride, row.m_name, legend);
+        }
+    }
+    index();
+}
+
+const shared_ptr<const RegisterDatabase>& RegisterDatabase::builtin()
+{
+    static const shared_ptr<const RegisterDatabase> registers = make_shared<RegisterDatabase>();
+    return registers;
+}
+
+void RegisterDatabase::add(unsigned int address, const string& text)
+{
+    string_view rest = text;
+    size_t end = rest.find(';');
+    string_view name = trim(rest.substr(0, end));
+
+    vector<string_view> legend;
+    while (end != string_view::npos){
+        rest.remove_prefix(end + 1);
+        end = rest.find(';');
+        legend.push_back(trim(rest.substr(0, end)));
+    }
+
+    add(address, name, legend);
+    index();
+}
+
+void RegisterDatabase::add(unsigned int address, string_view name, const vector<string_view>& legend)
+{
+    Register reg;
+    reg.m_address = address;
+    reg.m_name = name;
+    reg.m_detail = name;
+    for (string_view line : legend){
+        reg.m_detail += LEGEND_LINE;
+        reg.m_detail += line;
+    }
+    if (!legend.empty())
+        reg.m_fields = bit_fields(legend[0]);
+
+    auto it = lower_bound(m_registers.begin(), m_registers.end(), address,
+        [](const Register& r, unsigned int a){ return r.m_address < a; });
+    if (it != m_registers.end() && it->m_address == address)
+        *it = move(reg);
+    else
+        m_registers.insert(it, move(reg));
+}
+
+void RegisterDatabase::index()
+{
+    fill(m_pages, m_pages + 256, -1);
+    m_slots.clear();
+    for (size_t i = 0; i < m_registers.size(); ++i){
+        unsigned int address = m_registers[i].m_address;
+        int& page = m_pages[address >> 8];
+        if (page < 0){
+            page = (int)m_slots.size();
+            m_slots.resize(m_slots.size() + 256, -1);
+        }
+        m_slots[page + (address & 0xFF)] = (int)i;
+    }
+}
+
+string_view RegisterDatabase::comment(unsigned int address, int comment_level) const
+{
+    if (comment_level <= 2)
+        return string_view();
+    const Register* reg = find(address);
+    if (!reg)
+        return string_view();
+    return comment_level > 3 ? reg->m_detail : reg->m_name;
+}
+
+size_t RegisterDatabase::size_in_bytes() const
+{
+    size_t bytes = m_registers.capacity() * sizeof(Register) + m_slots.capacity() * sizeof(int);
+    for (const Register& reg : m_registers){
+        bytes += Memory::heap_bytes(reg.m_name) + Memory::heap_bytes(reg.m_detail) + Memory::heap_bytes(reg.m_fields);
+    }
+    return bytes;
+}
@@ -0,0 +1,66 @@
+#ifndef REGISTERS_H
+#define REGISTERS_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A memory mapped hardware register and the comments shown on operands
+// that address it.
+struct Register
+{
+    unsigned int m_address;
+    std::string m_name;   //comment level 3
+    std::string m_detail; //comment level 4, the name followed by the bit field legend
+    std::string m_fields; //one letter per bit field, high bit first ("a000bbbb"), empty if there are none
+
+    // "a = 1  b = 15" for each field of value, in the order of m_fields
+    std::string decode(unsigned int value) const;
+};
+
+// The PPU, CPU and DMA registers, built from a constexpr table and
+// extended or overridden by --registers files.
+//
+// A file has one register per line: the hex address, the name and
+// optionally the legend lines, each introduced by a ';'.  The first word
+// of the legend gives the bit fields.
+//
+//   2100 Screen Display Register ;a000bbbb a = Screen Off  b = Brightness
+//
+// Registers are kept sorted by address.  Lookups go through a page table
+// indexed by the high byte of the address, which only has slots for the
+// pages that have registers, so they take constant time.
+struct RegisterDatabase
+{
+    RegisterDatabase();
+
+    // one instance of the built in registers, shared by every Disassembler
+    static const std::shared_ptr<const RegisterDatabase>& builtin();
+
+    void add(unsigned int address, const std::string& text);
+
+    const Register* find(unsigned int address) const
+    {
+        if (address > 0xFFFF || m_pages[address >> 8] < 0)
+            return 0;
+        int slot = m_slots[m_pages[address >> 8] + (address & 0xFF)];
+        return slot < 0 ? 0 : &m_registers[slot];
+    }
+
+    // empty below comment level 3
+    std::string_view comment(unsigned int address, int comment_level) const;
+
+    size_t size() const { return m_registers.size(); }
+    size_t size_in_bytes() const;
+
+private:
+    void add(unsigned int address, std::string_view name, const std::vector<std::string_view>& legend);
+    void index();
+
+    std::vector<Register> m_registers;
+    std::vector<int> m_slots; //256 for each page with registers, -1 where there is none
+    int m_pages[256]; //start of the page's slots, or -1
+};
+
+#endif
@@ -1,6 +1,8 @@
+#include <cstdlib>
 #include <sstream>
 #include <iomanip>
 #include "request.h"
+#include "label_index.h"
 #include "utils.h"
 
 using namespace std;
@@ -28,6 +30,21 @@ namespace{
         ss >> std::hex >> total;
         return total;
     }
+
+    // hex, or else the name of a label
+    bool get_address(const string& s, const LabelIndex* labels, unsigned int* full, ostream& out)
+    {
+        char* end;
+        unsigned long value = strtoul(s.c_str(), &end, 16);
+        if (*end == 0){
+            *full = (unsigned int)value;
+            return true;
+        }
+        if (labels && labels->find(s, full))
+            return true;
+        out << "unknown label " << s << endl << endl;
+        return false;
+    }
 }
 
 unsigned int DisassemblerProperties::full_end_address() const
@@ -35,7 +52,7 @@ unsigned int DisassemblerProperties::full_end_address() const
     return Address::full_address(m_end_bank, m_end_addr);
 }
 
-bool Request::get(istream & in, bool hirom)
+bool Request::get(istream & in, bool hirom, ostream & out, const LabelIndex* labels)
 {
     string line;
     if (!getline(in, line))
@@ -81,30 +98,67 @@ bool Request::get(istream & in, bool hirom)
             m_quit = true;
             return true;
         }
+        else if (current == "memstats"){
+            m_memstats = true;
+            return true;
+        }
+        else if (current == "analytics")
+            m_analytics = true;
+        else if (current == "json" && m_analytics)
+            m_json = true;
+        else if (current == "cost")
+            m_cost = true;
+        else if (current == "find"){
+            if (!(ss >> m_find)){
+                out << "bad usage" << endl << endl;
+                m_error = true;
+                return false;
+            }
+            return true;
+        }
         else if(current.length() > 2 && current[0] == '-' && current[1] == 'c'){
             const char* s = &(current.c_str()[2]);  
             m_properties.m_comment_level = hex(s);
         }
         else if(address_count == 0){
-            int full = hex(current.c_str());
+            unsigned int full;
+            if (!get_address(current, labels, &full, out)){
+                m_error = true;
+                return false;
+            }
             pc = addr16_from_addr24(full);
             bank = bank_from_addr24(full);
             address_count++;
         }
         else if(address_count == 1){
-            int full = hex(current.c_str());
+            unsigned int full;
+            if (current.size() > 1 && current[0] == '+')
+                full = full_address(bank, pc) + hex(&current.c_str()[1]);
+            else if (!get_address(current, labels, &full, out)){
+                m_error = true;
+                return false;
+            }
             m_properties.m_end_addr = addr16_from_addr24(full);
             m_properties.m_end_bank = bank_from_addr24(full);
             address_count++;
         }
         else if(address_count > 1){
-            cout << "bad usage" << endl << endl;
+            out << "bad usage" << endl << endl;
+            m_error = true;
             return false;
         }
     } while(ss >> current);
 
-    if (address_count == 0){
-        cout << "bad usage" << endl << endl;
+    if (address_count == 0 && m_analytics){
+        m_properties.m_start_bank = 0;
+        m_properties.m_start_addr = 0;
+        m_properties.m_end_bank = 0xFF;
+        m_properties.m_end_addr = 0xFFFF;
+        return true;
+    }
+    else if (address_count == 0){
+        out << "bad usage" << endl << endl;
+        m_error = true;
         return false;
     }
     else if(address_count == 1){
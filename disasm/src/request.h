@@ -2,6 +2,9 @@
 #define REQUEST_H
 
 #include <iostream>
+#include <string>
+
+struct LabelIndex;
 
 struct DisassemblerProperties{
   DisassemblerProperties() :
@@ -40,16 +43,34 @@ struct DisassemblerProperties{
 struct Request{
     Request(DisassemblerProperties properties = DisassemblerProperties()) : 
     m_type(Smart),
-    m_properties(properties),
-    m_quit(false)
+    m_quit(false),
+    m_error(false),
+    m_memstats(false),
+    m_analytics(false),
+    m_json(false),
+    m_cost(false),
+    m_properties(properties)
   {}
 
-  enum Type { Asm, Dcb, Ptr, PtrLong, Smart};
+  enum Type { Asm, Dcb, Ptr, PtrLong, Smart, Incbin}; //Incbin is only picked by Smart
 
-  bool get(std::istream & in, bool hirom);
+  // Addresses are hex or, given labels, the name of a label.  The end may
+  // be given as a length, +hex.  "analytics [json] [START END]" leaves the
+  // range at 000000-FFFFFF when none is given.  "cost [-a] [-i] START"
+  // takes the start as the routine's entry.  A HiROM range that starts in
+  // $00-$3F and runs past $xx:FFFF is listed at $C0-$FF, see
+  // MemoryMap::contiguous_range.  False at the end of the input, or with
+  // m_error set when the line was wrong, which is then printed to out.
+  bool get(std::istream & in, bool hirom, std::ostream & out = std::cout, const LabelIndex* labels = 0);
 
   Type m_type;
   bool m_quit;
+  bool m_error; //see get
+  bool m_memstats; //report memory use instead of disassembling
+  std::string m_find; //list the labels matching this, a name or prefix*, instead
+  bool m_analytics; //report what is known about the range, or the whole ROM without one, instead
+  bool m_json; //the analytics report as JSON
+  bool m_cost; //report the cycles the routine at the start takes instead, see CostReport
   DisassemblerProperties m_properties;
 };
 
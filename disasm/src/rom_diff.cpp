@@ -0,0 +1,463 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ROM_DIFF_SSE2
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include "rom_diff.h"
+#include "byte_properties.h"
+#include "disassembler.h"
+#include "mapped_file.h"
+#include "request.h"
+#include "utils.h"
+
+using namespace std;
+using namespace Address;
+
+namespace{
+    const size_t BLOCK_SIZE = 32;
+    const uint32_t HASH_MULTIPLIER = 0x01000193;
+    const int MAX_CANDIDATES = 8; //blocks of padding all hash alike
+    const unsigned int CONTEXT = 0x100; //how far a segment is widened when there is no label
+    const size_t MAX_DIFF_CELLS = 1 << 22; //larger listings are shown whole instead of line by line
+
+    unsigned int first_set_bit(unsigned int mask)
+    {
+#ifdef _MSC_VER
+        unsigned long bit;
+        _BitScanForward(&bit, mask);
+        return bit;
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+    // number of equal bytes at the start of a and b
+    size_t common_prefix(const unsigned char* a, const unsigned char* b, size_t size)
+    {
+        size_t i = 0;
+#ifdef ROM_DIFF_SSE2
+        for (; i + 16 <= size; i += 16){
+            __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+            __m128i y = _mm_loadu_si128((const __m128i*)(b + i));
+            unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) ^ 0xFFFF;
+            if (mask)
+                return i + first_set_bit(mask);
+        }
+#endif
+        while (i < size && a[i] == b[i])
+            ++i;
+        return i;
+    }
+
+    uint32_t block_hash(const unsigned char* data)
+    {
+        uint32_t hash = 0;
+        for (size_t i = 0; i < BLOCK_SIZE; ++i){
+            hash = hash * HASH_MULTIPLIER + data[i];
+        }
+        return hash;
+    }
+
+    // hash and offset of each aligned block of the old image, sorted
+    typedef vector<pair<uint32_t, uint32_t> > BlockIndex;
+
+    BlockIndex index_blocks(const unsigned char* data, size_t size)
+    {
+        BlockIndex index;
+        index.reserve(size / BLOCK_SIZE);
+        for (size_t offset = 0; offset + BLOCK_SIZE <= size; offset += BLOCK_SIZE){
+            index.push_back(make_pair(block_hash(data + offset), (uint32_t)offset));
+        }
+        sort(index.begin(), index.end());
+        return index;
+    }
+
+    struct Images
+    {
+        const unsigned char* m_old;
+        size_t m_old_size;
+        const unsigned char* m_new;
+        size_t m_new_size;
+        BlockIndex m_index;
+
+        bool blocks_match(size_t old_offset, size_t new_offset) const
+        {
+            return old_offset + BLOCK_SIZE <= m_old_size && new_offset + BLOCK_SIZE <= m_new_size &&
+                m_old[old_offset] == m_new[new_offset] &&
+                memcmp(m_old + old_offset, m_new + new_offset, BLOCK_SIZE) == 0;
+        }
+
+        // The first block of the new image at or after *new_offset that is
+        // also in the old image at or after *old_offset.  Returns false if
+        // the images never agree again.
+        bool resync(size_t* old_offset, size_t* new_offset) const
+        {
+            size_t p = *new_offset;
+            size_t o = *old_offset;
+            if (p + BLOCK_SIZE > m_new_size)
+                return false;
+
+            uint32_t hash = block_hash(m_new + p);
+            uint32_t outgoing = 1; //HASH_MULTIPLIER ^ (BLOCK_SIZE - 1)
+            for (size_t i = 1; i < BLOCK_SIZE; ++i){
+                outgoing *= HASH_MULTIPLIER;
+            }
+
+            for (size_t q = p; ; ++q){
+                // edited in place
+                if (blocks_match(o + (q - p), q)){
+                    *old_offset = o + (q - p);
+                    *new_offset = q;
+                    return true;
+                }
+
+                // moved: the nearest block further along the old image
+                BlockIndex::const_iterator it = lower_bound(m_index.begin(), m_index.end(), make_pair(hash, (uint32_t)o));
+                for (int tries = 0; it != m_index.end() && it->first == hash && tries < MAX_CANDIDATES; ++it, ++tries){
+                    if (blocks_match(it->second, q)){
+                        *old_offset = it->second;
+                        *new_offset = q;
+                        return true;
+                    }
+                }
+
+                if (q + BLOCK_SIZE >= m_new_size)
+                    return false;
+                hash = (hash - m_new[q] * outgoing) * HASH_MULTIPLIER + m_new[q + BLOCK_SIZE];
+            }
+        }
+    };
+
+    // where a file offset is in the SNES address space; the end of the
+    // ROM is just past its last byte
+    unsigned int offset_full_address(unsigned int offset, const MemoryMap& map)
+    {
+        if (offset < map.rom_capacity() || offset == 0)
+            return map.rom_address(offset);
+        return map.rom_address(offset - 1) + 1;
+    }
+
+    void offset_address(unsigned int offset, const MemoryMap& map, unsigned char* bank, unsigned int* pc)
+    {
+        unsigned int address = offset_full_address(offset, map);
+        *bank = bank_from_addr24(address);
+        *pc = address & 0xFFFF;
+    }
+
+    struct Segment
+    {
+        unsigned int m_start;
+        unsigned int m_end;
+    };
+
+    struct DiffRegion
+    {
+        RomChange m_change;
+        Segment m_old;
+        Segment m_new;
+    };
+
+    // The driver data is by address, so both images are read through it.
+    struct SegmentMap
+    {
+        SegmentMap(const Disassembler& disasm) : m_disasm(disasm) {}
+
+        const ByteProperties* properties(unsigned int offset) const
+        {
+            return m_disasm.properties(offset);
+        }
+
+        int type(unsigned int offset) const
+        {
+            const ByteProperties* properties = this->properties(offset);
+            return properties ? properties->type() : 0;
+        }
+
+        // where a listing may start: a label, a change of segment type or
+        // a traced instruction
+        bool is_boundary(unsigned int offset) const
+        {
+            const ByteProperties* properties = this->properties(offset);
+            if (properties && properties->has_label())
+                return true;
+            if (offset > 0 && type(offset - 1) != type(offset))
+                return true;
+            return m_disasm.coverage().is_instruction_start(offset);
+        }
+
+        Segment enclosing(unsigned int start, unsigned int end, size_t size) const
+        {
+            unsigned int bank_size = m_disasm.memory_map().rom_bank_size();
+
+            Segment segment;
+            segment.m_start = min(start, (unsigned int)size);
+            unsigned int bank_start = segment.m_start & ~(bank_size - 1);
+            while (segment.m_start > bank_start && start - segment.m_start < CONTEXT && !is_boundary(segment.m_start))
+                --segment.m_start;
+
+            segment.m_end = max(min(end, (unsigned int)size), segment.m_start);
+            unsigned int bank_end = min((size_t)(segment.m_start & ~(bank_size - 1)) + bank_size, size);
+            while (segment.m_end < bank_end && segment.m_end - end < CONTEXT &&
+                (segment.m_end == segment.m_start || !is_boundary(segment.m_end)))
+                ++segment.m_end;
+            return segment;
+        }
+
+        const Disassembler& m_disasm;
+    };
+
+    string describe(const RomChange& change, const MemoryMap& memory_map)
+    {
+        unsigned int removed = change.m_old_end - change.m_old_start;
+        unsigned int added = change.m_new_end - change.m_new_start;
+
+        ostringstream ss;
+        ss << "; $" << to_string(offset_full_address(change.m_new_start, memory_map), 6) << ": ";
+        if (removed == added)
+            ss << added << " bytes changed";
+        else if (removed == 0)
+            ss << added << " bytes inserted";
+        else if (added == 0)
+            ss << removed << " bytes deleted";
+        else
+            ss << removed << " bytes replaced by " << added;
+
+        if (change.m_old_start != change.m_new_start)
+            ss << " (old $" << to_string(offset_full_address(change.m_old_start, memory_map), 6) << ")";
+        return ss.str();
+    }
+
+    // Asm, Dcb and Ptr requests for the runs of one type in the segment,
+    // as in Disassembler::doSmart
+    string decode(Disassembler& session, ostringstream& text, const SegmentMap& map, const Segment& segment)
+    {
+        text.str("");
+        for (unsigned int offset = segment.m_start; offset < segment.m_end;){
+            int type = map.type(offset);
+            unsigned int end = offset + 1;
+            while (end < segment.m_end && map.type(end) == type)
+                ++end;
+
+            Request request;
+            switch (type){
+            case 1: request.m_type = Request::Dcb; break;
+            case 2: request.m_type = Request::Ptr; break;
+            case 3: request.m_type = Request::PtrLong; break;
+            default: request.m_type = Request::Asm; break;
+            }
+            offset_address(offset, session.memory_map(), &request.m_properties.m_start_bank, &request.m_properties.m_start_addr);
+            offset_address(end, session.memory_map(), &request.m_properties.m_end_bank, &request.m_properties.m_end_addr);
+            session.handleRequest(request);
+            offset = end;
+        }
+        return text.str();
+    }
+
+    vector<string> split_lines(const string& text)
+    {
+        vector<string> lines;
+        istringstream ss(text);
+        string line;
+        while (getline(ss, line)){
+            if (!line.empty())
+                lines.push_back(line);
+        }
+        return lines;
+    }
+
+    // unified diff of two listings, by longest common subsequence
+    void print_line_diff(const vector<string>& a, const vector<string>& b, ostream& out)
+    {
+        if ((a.size() + 1) * (b.size() + 1) > MAX_DIFF_CELLS){
+            for (size_t i = 0; i < a.size(); ++i) out << "-" << a[i] << "\n";
+            for (size_t j = 0; j < b.size(); ++j) out << "+" << b[j] << "\n";
+            return;
+        }
+
+        size_t columns = b.size() + 1;
+        vector<unsigned int> common((a.size() + 1) * columns, 0);
+        for (size_t i = a.size(); i-- > 0;){
+            for (size_t j = b.size(); j-- > 0;){
+                common[i * columns + j] = a[i] == b[j] ? common[(i + 1) * columns + j + 1] + 1 :
+                    max(common[(i + 1) * columns + j], common[i * columns + j + 1]);
+            }
+        }
+
+        size_t i = 0, j = 0;
+        while (i < a.size() || j < b.size()){
+            if (i < a.size() && j < b.size() && a[i] == b[j]){
+                out << " " << a[i++] << "\n";
+                ++j;
+            }
+            else if (j == b.size() || (i < a.size() && common[(i + 1) * columns + j] >= common[i * columns + j + 1]))
+                out << "-" << a[i++] << "\n";
+            else
+                out << "+" << b[j++] << "\n";
+        }
+    }
+}
+
+vector<RomChange> diff_images(const unsigned char* old_data, size_t old_size,
+    const unsigned char* new_data, size_t new_size)
+{
+    Images images;
+    images.m_old = old_data;
+    images.m_old_size = old_size;
+    images.m_new = new_data;
+    images.m_new_size = new_size;
+
+    vector<RomChange> changes;
+    size_t o = 0, p = 0;
+    while (o < old_size && p < new_size){
+        size_t equal = common_prefix(old_data + o, new_data + p, min(old_size - o, new_size - p));
+        o += equal;
+        p += equal;
+        if (o == old_size || p == new_size)
+            break;
+
+        // only built once the images differ
+        if (images.m_index.empty())
+            images.m_index = index_blocks(old_data, old_size);
+
+        size_t old_match = o, new_match = p;
+        if (!images.resync(&old_match, &new_match))
+            break;
+
+        // the block match is aligned in the old image, so the images may
+        // agree from before it
+        while (new_match > p && old_match > o && new_data[new_match - 1] == old_data[old_match - 1]){
+            --new_match;
+            --old_match;
+        }
+
+        RomChange change = { (unsigned int)o, (unsigned int)old_match, (unsigned int)p, (unsigned int)new_match };
+        changes.push_back(change);
+        o = old_match;
+        p = new_match;
+    }
+
+    if (o < old_size || p < new_size){
+        RomChange change = { (unsigned int)o, (unsigned int)old_size, (unsigned int)p, (unsigned int)new_size };
+        changes.push_back(change);
+    }
+    return changes;
+}
+
+int run_diff(const Disassembler& base, const string& old_rom, const string& new_rom, ostream& out)
+{
+    MappedFile old_image, new_image;
+    if (!old_image.open(old_rom)){
+        cerr << "Could not open " << old_rom << " for reading." << endl;
+        return -1;
+    }
+    if (!new_image.open(new_rom)){
+        cerr << "Could not open " << new_rom << " for reading." << endl;
+        return -1;
+    }
+
+    size_t header = base.header_size();
+    size_t old_size = old_image.size() > header ? old_image.size() - header : 0;
+    size_t new_size = new_image.size() > header ? new_image.size() - header : 0;
+    vector<RomChange> changes = diff_images(old_image.data() + header, old_size, new_image.data() + header, new_size);
+
+    // changes whose segments overlap are listed together
+    SegmentMap map(base);
+    vector<DiffRegion> regions;
+    unsigned int changed = 0, inserted = 0, deleted = 0;
+    for (size_t i = 0; i < changes.size(); ++i){
+        const RomChange& change = changes[i];
+        unsigned int removed = change.m_old_end - change.m_old_start;
+        unsigned int added = change.m_new_end - change.m_new_start;
+        changed += min(removed, added);
+        inserted += added > removed ? added - removed : 0;
+        deleted += removed > added ? removed - added : 0;
+
+        // the driver files describe the old image, so the new segment
+        // takes the same context around the change
+        Segment old_segment = map.enclosing(change.m_old_start, change.m_old_end, old_size);
+        Segment new_segment;
+        new_segment.m_start = change.m_new_start - min(change.m_new_start, change.m_old_start - old_segment.m_start);
+        new_segment.m_end = (unsigned int)min((size_t)change.m_new_end + (old_segment.m_end - change.m_old_end), new_size);
+        if (!regions.empty() && old_segment.m_start <= regions.back().m_old.m_end &&
+            new_segment.m_start <= regions.back().m_new.m_end){
+            DiffRegion& last = regions.back();
+            last.m_old.m_end = max(last.m_old.m_end, old_segment.m_end);
+            last.m_new.m_end = max(last.m_new.m_end, new_segment.m_end);
+            continue;
+        }
+        DiffRegion region = { change, old_segment, new_segment };
+        regions.push_back(region);
+    }
+
+    out << "; " << old_rom << " -> " << new_rom << ": " << changes.size() << " changes, "
+        << changed << " bytes changed, " << inserted << " inserted, " << deleted << " deleted" << endl;
+    if (changes.empty())
+        return 0;
+
+    FILE* old_file = fopen(old_rom.c_str(), "rb");
+    FILE* new_file = fopen(new_rom.c_str(), "rb");
+    if (!old_file || !new_file){
+        cerr << "Could not open " << (old_file ? new_rom : old_rom) << " for reading." << endl;
+        if (old_file) fclose(old_file);
+        if (new_file) fclose(new_file);
+        return -1;
+    }
+
+    ostringstream old_text, new_text;
+    Disassembler old_session(base, old_file, old_text);
+    Disassembler new_session(base, new_file, new_text);
+    const MemoryMap& memory_map = base.memory_map();
+
+    // past an insertion or deletion the new image is read through the
+    // driver data of where its bytes were in the old one; inserted bytes
+    // have none
+    bool shifted = false;
+    for (const RomChange& change : changes){
+        shifted |= change.m_old_end - change.m_old_start != change.m_new_end - change.m_new_start;
+    }
+    if (shifted){
+        new_session.remap_properties([&](unsigned int offset){
+            vector<RomChange>::const_iterator it = upper_bound(changes.begin(), changes.end(), offset,
+                [](unsigned int offset, const RomChange& change){ return offset < change.m_new_start; });
+            if (it == changes.begin())
+                return offset;
+            --it;
+            if (offset >= it->m_new_end)
+                return offset - it->m_new_end + it->m_old_end;
+            unsigned int old_offset = it->m_old_start + (offset - it->m_new_start);
+            return old_offset < it->m_old_end ? old_offset : memory_map.rom_capacity();
+        });
+    }
+    SegmentMap new_map(new_session);
+
+    size_t next_change = 0;
+    for (size_t i = 0; i < regions.size(); ++i){
+        const DiffRegion& region = regions[i];
+        out << endl;
+        for (; next_change < changes.size() && changes[next_change].m_new_start < region.m_new.m_end; ++next_change){
+            out << describe(changes[next_change], memory_map) << endl;
+        }
+        out << "--- " << old_rom << " $" << to_string(offset_full_address(region.m_old.m_start, memory_map), 6)
+            << "-$" << to_string(offset_full_address(region.m_old.m_end, memory_map), 6) << endl;
+        out << "+++ " << new_rom << " $" << to_string(offset_full_address(region.m_new.m_start, memory_map), 6)
+            << "-$" << to_string(offset_full_address(region.m_new.m_end, memory_map), 6) << endl;
+
+        vector<string> old_lines = split_lines(decode(old_session, old_text, map, region.m_old));
+        vector<string> new_lines = split_lines(decode(new_session, new_text, new_map, region.m_new));
+        print_line_diff(old_lines, new_lines, out);
+    }
+
+    fclose(old_file);
+    fclose(new_file);
+    return 0;
+}
@@ -0,0 +1,42 @@
+#ifndef ROM_DIFF_H
+#define ROM_DIFF_H
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct Disassembler;
+
+// A range of file offsets (past the copier header) that differs between
+// two ROM images.  Either side may be empty: bytes inserted into or
+// deleted from the new image.
+struct RomChange
+{
+    unsigned int m_old_start;
+    unsigned int m_old_end;
+    unsigned int m_new_start;
+    unsigned int m_new_end;
+};
+
+// The changes that turn old_data into new_data.
+//
+// Runs of equal bytes are skipped with a 16 byte wide compare.  At a
+// mismatch the new image is scanned with a rolling hash over 32 byte
+// blocks, looked up in a table of the old image's aligned blocks, until
+// the two agree again.  A match at the same distance is taken first, so an
+// edit in place is one change, and a match further along either image is
+// an insertion or deletion that shifts everything after it.  The work is
+// proportional to the size of the images where they are equal and to the
+// size of the changes where they are not.
+std::vector<RomChange> diff_images(const unsigned char* old_data, size_t old_size,
+    const unsigned char* new_data, size_t new_size);
+
+// --diff: decodes only the segments of the two ROMs that enclose a change,
+// with the driver files loaded into base, and prints them as a unified
+// diff of the listings.  A segment runs from the nearest label or segment
+// type change before the change to the next one after it.
+int run_diff(const Disassembler& base, const std::string& old_rom, const std::string& new_rom,
+    std::ostream& out = std::cout);
+
+#endif
@@ -0,0 +1,70 @@
+#include <algorithm>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SEGMENT_INDEX_SSE2
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include "segment_index.h"
+#include "byte_properties.h"
+
+using namespace std;
+
+namespace{
+    unsigned int first_set_bit(unsigned int mask)
+    {
+#ifdef _MSC_VER
+        unsigned long bit;
+        _BitScanForward(&bit, mask);
+        return bit;
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+    // the first byte from start on that isn't type, or size
+    size_t run_end(const unsigned char* types, size_t start, size_t size, unsigned char type)
+    {
+        size_t i = start;
+#ifdef SEGMENT_INDEX_SSE2
+        __m128i expected = _mm_set1_epi8((char)type);
+        for (; i + 16 <= size; i += 16){
+            __m128i x = _mm_loadu_si128((const __m128i*)(types + i));
+            unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(x, expected)) ^ 0xFFFF;
+            if (mask)
+                return i + first_set_bit(mask);
+        }
+#endif
+        while (i < size && types[i] == type)
+            ++i;
+        return i;
+    }
+}
+
+SegmentIndex::SegmentIndex(const ByteProperties* data, unsigned int size)
+{
+    // the properties are large structs, so gather the types first
+    vector<unsigned char> types(size);
+    for (unsigned int i = 0; i < size; ++i){
+        types[i] = data[i].type();
+    }
+
+    for (unsigned int start = 0; start < size;){
+        Run run;
+        run.m_start = start;
+        run.m_type = types[start];
+        run.m_end = (unsigned int)run_end(types.data(), start + 1, size, run.m_type);
+        m_runs.push_back(run);
+        start = run.m_end;
+    }
+}
+
+const SegmentIndex::Run* SegmentIndex::find(unsigned int offset) const
+{
+    vector<Run>::const_iterator it = upper_bound(m_runs.begin(), m_runs.end(), offset,
+        [](unsigned int value, const Run& run){ return value < run.m_start; });
+    if (it == m_runs.begin() || offset >= (it - 1)->m_end)
+        return 0;
+    return &*(it - 1);
+}
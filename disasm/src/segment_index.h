@@ -0,0 +1,34 @@
+#ifndef SEGMENT_INDEX_H
+#define SEGMENT_INDEX_H
+
+#include <cstddef>
+#include <vector>
+
+struct ByteProperties;
+
+// The ROM as runs of bytes of one type (code, data, pointers or long
+// pointers, see ByteProperties::type), by file offset.  Built once the
+// driver files are applied so that doSmart steps from run to run instead
+// of testing every byte.
+struct SegmentIndex
+{
+    struct Run
+    {
+        unsigned int m_start;
+        unsigned int m_end;
+        unsigned char m_type;
+    };
+
+    SegmentIndex(const ByteProperties* data, unsigned int size);
+
+    // the run holding offset, 0 past the end of the ROM
+    const Run* find(unsigned int offset) const;
+
+    size_t size() const { return m_runs.size(); }
+    size_t size_in_bytes() const { return m_runs.capacity() * sizeof(Run); }
+
+private:
+    std::vector<Run> m_runs;
+};
+
+#endif
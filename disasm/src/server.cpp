@@ -0,0 +1,208 @@
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "disassembler.h"
+#include "request.h"
+#include "server.h"
+
+using namespace std;
+
+#ifdef _WIN32
+
+int serve(const Disassembler& disasm, const string& rom_file, const string& socket_path)
+{
+    cerr << "--serve is not supported on this platform." << endl;
+    return -1;
+}
+
+#else
+
+#include <atomic>
+#include <csignal>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace{
+    volatile sig_atomic_t g_stop = 0;
+
+    void on_signal(int)
+    {
+        g_stop = 1;
+    }
+
+    struct Client
+    {
+        int m_fd;
+        std::thread m_worker;
+        std::shared_ptr<std::atomic<bool> > m_finished;
+    };
+
+    bool send_all(int fd, const char* data, size_t length)
+    {
+        while (length > 0){
+            ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+            if (sent < 0){
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            data += sent;
+            length -= sent;
+        }
+        return true;
+    }
+
+    bool send_reply(int fd, const string& text)
+    {
+        unsigned int length = (unsigned int)text.size();
+        char header[4] = { char(length >> 24), char(length >> 16), char(length >> 8), char(length) };
+        return send_all(fd, header, 4) && send_all(fd, text.data(), text.size());
+    }
+
+    void run_session(const Disassembler* base, const string& rom_file, int fd)
+    {
+        FILE* rom = fopen(rom_file.c_str(), "rb");
+        if (!rom){
+            send_reply(fd, "Could not open " + rom_file + " for reading.\n");
+            return;
+        }
+
+        // the stream lives as long as the session, like cout does for the
+        // interactive prompt, so formatting state carries over the same way
+        ostringstream out;
+        Disassembler session(*base, rom, out);
+
+        string pending;
+        char buffer[4096];
+        bool done = false;
+        while (!done){
+            ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+            if (received < 0 && errno == EINTR)
+                continue;
+            if (received <= 0)
+                break;
+            pending.append(buffer, received);
+
+            size_t start = 0, eol;
+            while (!done && (eol = pending.find('\n', start)) != string::npos){
+                istringstream in(pending.substr(start, eol - start));
+                start = eol + 1;
+
+                out.str("");
+                Request request;
+                if (request.get(in, session.hirom(), out, &session.label_index())){
+                    if (request.m_quit){
+                        done = true;
+                        break;
+                    }
+                    session.handleRequest(request);
+                    out << endl;
+                }
+                // every line gets a reply, even if it is empty
+                if (!send_reply(fd, out.str()))
+                    done = true;
+            }
+            pending.erase(0, start);
+        }
+        fclose(rom);
+    }
+
+    void finish(Client& client)
+    {
+        shutdown(client.m_fd, SHUT_RDWR);
+        client.m_worker.join();
+        close(client.m_fd);
+    }
+
+    void reap_finished(vector<Client>& clients)
+    {
+        for (size_t i = 0; i < clients.size();){
+            if (*clients[i].m_finished){
+                finish(clients[i]);
+                clients.erase(clients.begin() + i);
+            }
+            else{
+                ++i;
+            }
+        }
+    }
+}
+
+int serve(const Disassembler& disasm, const string& rom_file, const string& socket_path)
+{
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)){
+        cerr << "Socket path too long: " << socket_path << endl;
+        return -1;
+    }
+    strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+    // clear out a socket left behind by a previous run, but nothing else
+    struct stat info;
+    if (stat(socket_path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode))
+        unlink(socket_path.c_str());
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 || bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listener, 16) != 0){
+        cerr << "Could not listen on " << socket_path << ": " << strerror(errno) << endl;
+        if (listener >= 0)
+            close(listener);
+        return -1;
+    }
+
+    // no SA_RESTART, so a signal wakes up poll()
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = &on_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, 0);
+    sigaction(SIGTERM, &action, 0);
+
+    cerr << "; Serving requests on " << socket_path << endl;
+
+    vector<Client> clients;
+    while (!g_stop){
+        pollfd listening = { listener, POLLIN, 0 };
+        int ready = poll(&listening, 1, 500);
+        reap_finished(clients);
+        if (ready <= 0)
+            continue;
+
+        int fd = accept(listener, 0, 0);
+        if (fd < 0)
+            continue;
+
+        Client client;
+        client.m_fd = fd;
+        client.m_finished = std::make_shared<std::atomic<bool> >(false);
+        std::shared_ptr<std::atomic<bool> > finished = client.m_finished;
+        const Disassembler* base = &disasm;
+        client.m_worker = std::thread([base, rom_file, fd, finished](){
+            run_session(base, rom_file, fd);
+            *finished = true;
+        });
+        clients.push_back(std::move(client));
+    }
+
+    close(listener);
+    unlink(socket_path.c_str());
+
+    for (size_t i = 0; i < clients.size(); ++i){
+        finish(clients[i]);
+    }
+    cerr << "; Server stopped." << endl;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <string>
+
+struct Disassembler;
+
+// Serves requests over a local (unix domain) socket so that editors and
+// scripts can query a ROM without paying for the driver file load each
+// time.  Every connection gets its own session sharing the data loaded
+// into disasm.  A client writes request lines in the same syntax as the
+// interactive prompt and gets one reply per line: a 4 byte big endian
+// length followed by that much listing text.  "quit" closes the
+// connection; SIGINT/SIGTERM stop the server.
+int serve(const Disassembler& disasm, const std::string& rom_file, const std::string& socket_path);
+
+#endif
@@ -0,0 +1,287 @@
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include "stats.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+using namespace std;
+
+namespace{
+    const char* COUNTER_NAMES[] = { "requests", "cache replays", "instructions", "pointers", "data bytes",
+        "bytes emitted", "extern lookups skipped", "extern symbols", "generated labels" };
+    const char* TABLE_NAMES[] = { "symbols", "coverage", "ram symbols", "used labels" };
+
+    string json_key(const string& name)
+    {
+        string key = name;
+        for (size_t i = 0; i < key.size(); ++i){
+            if (key[i] == ' ')
+                key[i] = '_';
+        }
+        return json_string(key);
+    }
+
+    string milliseconds(double seconds)
+    {
+        ostringstream ss;
+        ss << fixed << setprecision(3) << seconds * 1000;
+        return ss.str();
+    }
+}
+
+struct Stats::CountingBuffer : public streambuf
+{
+    CountingBuffer(streambuf* target, unsigned long long* count) :
+    m_target(target),
+    m_count(count)
+    {}
+
+protected:
+    virtual int_type overflow(int_type c)
+    {
+        if (traits_type::eq_int_type(c, traits_type::eof()))
+            return traits_type::not_eof(c);
+        ++*m_count;
+        return m_target->sputc(traits_type::to_char_type(c));
+    }
+
+    virtual streamsize xsputn(const char* s, streamsize n)
+    {
+        streamsize written = m_target->sputn(s, n);
+        *m_count += written;
+        return written;
+    }
+
+    virtual int sync()
+    {
+        return m_target->pubsync();
+    }
+
+private:
+    streambuf* m_target;
+    unsigned long long* m_count;
+};
+
+Stats::Stats()
+{
+    for (int i = 0; i < CounterCount; ++i){
+        m_counters[i] = 0;
+    }
+    for (int i = 0; i < TableCount; ++i){
+        m_lookups[i] = 0;
+        m_hits[i] = 0;
+    }
+}
+
+size_t Stats::phase(const string& name, bool has_cpu)
+{
+    map<string, size_t>::iterator it = m_phase_index.find(name);
+    if (it != m_phase_index.end())
+        return it->second;
+
+    m_phases.push_back(Phase(name, has_cpu));
+    m_phase_index[name] = m_phases.size() - 1;
+    return m_phases.size() - 1;
+}
+
+void Stats::add_time(size_t phase, double wall, double cpu)
+{
+    Phase& p = m_phases[phase];
+    ++p.m_calls;
+    p.m_wall += wall;
+    p.m_cpu += cpu;
+}
+
+ostream& Stats::counted(ostream& out)
+{
+    shared_ptr<streambuf> buffer(new CountingBuffer(out.rdbuf(), &m_counters[BytesEmitted]));
+    shared_ptr<ostream> stream(new ostream(buffer.get()));
+    m_buffers.push_back(buffer);
+    m_streams.push_back(stream);
+    return *stream;
+}
+
+void Stats::print(ostream& out, const MemoryUsage* memory) const
+{
+    out << "; " << left << setw(28) << "phase" << right << setw(10) << "calls"
+        << setw(12) << "wall ms" << setw(12) << "cpu ms" << endl;
+    for (size_t i = 0; i < m_phases.size(); ++i){
+        const Phase& p = m_phases[i];
+        out << "; " << left << setw(28) << p.m_name << right << setw(10) << p.m_calls
+            << setw(12) << milliseconds(p.m_wall)
+            << setw(12) << (p.m_has_cpu ? milliseconds(p.m_cpu) : "-") << endl;
+    }
+
+    out << ";" << endl;
+    for (int i = 0; i < CounterCount; ++i){
+        out << "; " << left << setw(28) << COUNTER_NAMES[i] << right << setw(10) << m_counters[i] << endl;
+    }
+
+    out << ";" << endl;
+    out << "; " << left << setw(28) << "label lookups" << right << setw(10) << "lookups"
+        << setw(12) << "hits" << setw(12) << "hit rate" << endl;
+    for (int i = 0; i < TableCount; ++i){
+        double rate = m_lookups[i] ? 100.0 * m_hits[i] / m_lookups[i] : 0;
+        out << "; " << left << setw(28) << TABLE_NAMES[i] << right << setw(10) << m_lookups[i]
+            << setw(12) << m_hits[i] << setw(11) << fixed << setprecision(1) << rate << "%" << endl;
+    }
+
+    if (memory){
+        out << ";" << endl;
+        memory->print(out);
+    }
+}
+
+bool Stats::save_json(const string& filename, const MemoryUsage* memory) const
+{
+    ofstream out(filename.c_str());
+    if (!out)
+        return false;
+
+    out << "{" << endl << "  \"phases\": [";
+    for (size_t i = 0; i < m_phases.size(); ++i){
+        const Phase& p = m_phases[i];
+        out << (i ? "," : "") << endl << "    { \"name\": " << json_string(p.m_name)
+            << ", \"calls\": " << p.m_calls << ", \"wall_ms\": " << milliseconds(p.m_wall);
+        if (p.m_has_cpu)
+            out << ", \"cpu_ms\": " << milliseconds(p.m_cpu);
+        out << " }";
+    }
+    out << endl << "  ]," << endl << "  \"counters\": {";
+    for (int i = 0; i < CounterCount; ++i){
+        out << (i ? "," : "") << endl << "    " << json_key(COUNTER_NAMES[i]) << ": " << m_counters[i];
+    }
+    out << endl << "  }," << endl << "  \"label_lookups\": {";
+    for (int i = 0; i < TableCount; ++i){
+        out << (i ? "," : "") << endl << "    " << json_key(TABLE_NAMES[i])
+            << ": { \"lookups\": " << m_lookups[i] << ", \"hits\": " << m_hits[i] << " }";
+    }
+    out << endl << "  }";
+    if (memory){
+        out << "," << endl << "  \"memory\": ";
+        memory->write_json(out, "  ");
+    }
+    out << endl << "}" << endl;
+    return out.good();
+}
+
+string json_string(const string& text)
+{
+    string result = "\"";
+    for (size_t i = 0; i < text.size(); ++i){
+        if (text[i] == '"' || text[i] == '\\')
+            result += '\\';
+        result += text[i];
+    }
+    return result + "\"";
+}
+
+double Stats::wall_time()
+{
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double Stats::cpu_time()
+{
+#ifdef _WIN32
+    // clock() is wall time on Windows
+    FILETIME creation, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exited, &kernel, &user))
+        return 0;
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return (k.QuadPart + u.QuadPart) / 1e7;
+#else
+    return double(clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+
+TimedOutput::TimedOutput(const shared_ptr<OutputHandler>& inner, Stats* stats) :
+OutputHandler(cout),
+m_inner(inner),
+m_stats(stats),
+m_phase(NO_PHASE)
+{ }
+
+// registered on first use so that the summary lists phases in the order they ran
+size_t TimedOutput::phase()
+{
+    if (m_phase == NO_PHASE)
+        m_phase = m_stats->phase("output", false);
+    return m_phase;
+}
+
+void TimedOutput::PrintData(const vector<unsigned char>& bytes, string_view label, string_view comment, bool print_bytes, bool end_of_chunk)
+{
+    ScopedPhase timer(m_stats, phase());
+    m_inner->PrintData(bytes, label, comment, print_bytes, end_of_chunk);
+}
+
+void TimedOutput::PrintInstruction(const Instruction& instr, string_view label, string_view comment, bool print_bytes, int flags)
+{
+    ScopedPhase timer(m_stats, phase());
+    m_inner->PrintInstruction(instr, label, comment, print_bytes, flags);
+}
+
+void TimedOutput::PrintIncbin(string_view filename, unsigned int skip, unsigned int length, string_view label, string_view comment, bool print_bytes)
+{
+    ScopedPhase timer(m_stats, phase());
+    m_inner->PrintIncbin(filename, skip, length, label, comment, print_bytes);
+}
+
+void TimedOutput::BankStart(int bank)
+{
+    ScopedPhase timer(m_stats, phase());
+    m_inner->BankStart(bank);
+}
+
+void TimedOutput::PassStart()
+{
+    ScopedPhase timer(m_stats, phase());
+    m_inner->PassStart();
+}
+
+void TimedOutput::CodeBlockStart()
+{
+    ScopedPhase timer(m_stats, phase());
+    m_inner->CodeBlockStart();
+}
+
+void TimedOutput::CodeBlockEnd()
+{
+    ScopedPhase timer(m_stats, phase());
+    m_inner->CodeBlockEnd();
+}
+
+void TimedOutput::PtrBlockStart()
+{
+    ScopedPhase timer(m_stats, phase());
+    m_inner->PtrBlockStart();
+}
+
+void TimedOutput::PtrBlockEnd()
+{
+    ScopedPhase timer(m_stats, phase());
+    m_inner->PtrBlockEnd();
+}
+
+void TimedOutput::DataBlockStart()
+{
+    ScopedPhase timer(m_stats, phase());
+    m_inner->DataBlockStart();
+}
+
+void TimedOutput::DataBlockEnd()
+{
+    ScopedPhase timer(m_stats, phase());
+    m_inner->DataBlockEnd();
+}
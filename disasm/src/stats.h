@@ -0,0 +1,144 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "memory_usage.h"
+#include "output_handlers.h"
+
+// Phase timers and throughput counters, collected only when --stats is
+// given.  Everything that records into it holds a possibly null pointer,
+// so the cost when disabled is a pointer test.  Phases nest (an output
+// call happens inside a segment, inside a pass), so their times overlap.
+struct Stats
+{
+    enum Counter { Requests, CacheReplays, Instructions, Pointers, DataBytes, BytesEmitted,
+        ExternSkipped, ExternSymbols, GeneratedLabels, CounterCount };
+    enum Table { Symbols, Coverage, RamSymbols, UsedLabels, TableCount };
+
+    struct Phase
+    {
+        Phase(const std::string& name, bool has_cpu) :
+        m_name(name),
+        m_calls(0),
+        m_wall(0),
+        m_cpu(0),
+        m_has_cpu(has_cpu)
+        {}
+
+        std::string m_name;
+        unsigned long long m_calls;
+        double m_wall; //seconds
+        double m_cpu;  //seconds, process wide
+        bool m_has_cpu; //too fine grained to afford a CPU clock read
+    };
+
+    Stats();
+
+    size_t phase(const std::string& name, bool has_cpu = true); //registered on first use
+    void add_time(size_t phase, double wall, double cpu);
+    bool has_cpu(size_t phase) const { return m_phases[phase].m_has_cpu; }
+
+    void count(Counter counter, unsigned long long n = 1) { m_counters[counter] += n; }
+    void lookup(Table table, bool hit)
+    {
+        ++m_lookups[table];
+        if (hit)
+            ++m_hits[table];
+    }
+
+    // Returns a stream that forwards to out and counts what goes through it.
+    std::ostream& counted(std::ostream& out);
+
+    void print(std::ostream& out, const MemoryUsage* memory = 0) const;
+    bool save_json(const std::string& filename, const MemoryUsage* memory = 0) const;
+
+    static double wall_time();
+    static double cpu_time();
+
+private:
+    struct CountingBuffer;
+
+    std::vector<Phase> m_phases;
+    std::map<std::string, size_t> m_phase_index;
+    unsigned long long m_counters[CounterCount];
+    unsigned long long m_lookups[TableCount];
+    unsigned long long m_hits[TableCount];
+    std::vector<std::shared_ptr<std::streambuf> > m_buffers;
+    std::vector<std::shared_ptr<std::ostream> > m_streams;
+};
+
+// Times its own lifetime into a phase; does nothing without stats.
+struct ScopedPhase
+{
+    ScopedPhase(Stats* stats, size_t phase) :
+    m_stats(stats),
+    m_phase(phase)
+    {
+        start();
+    }
+
+    ScopedPhase(Stats* stats, const char* name) :
+    m_stats(stats),
+    m_phase(stats ? stats->phase(name) : 0)
+    {
+        start();
+    }
+
+    ~ScopedPhase()
+    {
+        if (m_stats){
+            double cpu = m_stats->has_cpu(m_phase) ? Stats::cpu_time() - m_cpu : 0;
+            m_stats->add_time(m_phase, Stats::wall_time() - m_wall, cpu);
+        }
+    }
+
+private:
+    void start()
+    {
+        if (m_stats){
+            m_wall = Stats::wall_time();
+            m_cpu = m_stats->has_cpu(m_phase) ? Stats::cpu_time() : 0;
+        }
+    }
+
+    Stats* m_stats;
+    size_t m_phase;
+    double m_wall;
+    double m_cpu;
+};
+
+// Charges the time spent formatting and writing to the "output" phase.
+struct TimedOutput : public OutputHandler
+{
+    TimedOutput(const std::shared_ptr<OutputHandler>& inner, Stats* stats);
+
+    virtual void PrintData(const std::vector<unsigned char>& bytes, std::string_view label, std::string_view comment, bool print_bytes, bool end_of_chunk);
+    virtual void PrintInstruction(const Instruction& instr, std::string_view label, std::string_view comment, bool print_bytes, int flags);
+    virtual void PrintIncbin(std::string_view filename, unsigned int skip, unsigned int length, std::string_view label, std::string_view comment, bool print_bytes);
+    virtual void BankStart(int bank);
+    virtual void PassStart();
+    virtual void CodeBlockStart();
+    virtual void CodeBlockEnd();
+    virtual void PtrBlockStart();
+    virtual void PtrBlockEnd();
+    virtual void DataBlockStart();
+    virtual void DataBlockEnd();
+
+private:
+    static const size_t NO_PHASE = ~size_t(0);
+
+    size_t phase();
+
+    std::shared_ptr<OutputHandler> m_inner;
+    Stats* m_stats;
+    size_t m_phase;
+};
+
+// text as a quoted JSON string, for the JSON reports
+std::string json_string(const std::string& text);
+
+#endif
@@ -0,0 +1,48 @@
+#include "thread_pool.h"
+
+using namespace std;
+
+ThreadPool::ThreadPool(unsigned int threads) :
+m_stopping(false)
+{
+    if (threads == 0)
+        threads = thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 2;
+
+    for (unsigned int i = 0; i < threads; ++i){
+        m_workers.push_back(thread(&ThreadPool::worker, this));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_ready.notify_all();
+
+    for (size_t i = 0; i < m_workers.size(); ++i){
+        m_workers[i].join();
+    }
+}
+
+void ThreadPool::worker()
+{
+    while (1){
+        function<void()> task;
+        {
+            unique_lock<mutex> lock(m_mutex);
+            while (!m_stopping && m_tasks.empty()){
+                m_ready.wait(lock);
+            }
+            if (m_tasks.empty())
+                return;
+
+            task = m_tasks.front();
+            m_tasks.pop();
+        }
+        task();
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Fixed set of worker threads pulling tasks from a shared queue.
+// Destroying the pool finishes the queued tasks and joins the workers.
+struct ThreadPool
+{
+    explicit ThreadPool(unsigned int threads = 0);
+    ~ThreadPool();
+
+    template <typename F>
+    std::future<decltype(std::declval<F>()())> submit(F task)
+    {
+        typedef decltype(std::declval<F>()()) result_type;
+        auto packaged = std::make_shared<std::packaged_task<result_type()> >(task);
+        std::future<result_type> result = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push([packaged](){ (*packaged)(); });
+        }
+        m_ready.notify_one();
+        return result;
+    }
+
+    unsigned int size() const { return (unsigned int)m_workers.size(); }
+
+private:
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+    void worker();
+
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()> > m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    bool m_stopping;
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TILES_SSE2
+#endif
+#include "tiles.h"
+
+using namespace std;
+
+namespace{
+    const unsigned int TILE_SIZE = 8;
+
+#ifdef TILES_SSE2
+    void decode_tile(const unsigned char* tile, unsigned int planes, unsigned char* out, size_t stride)
+    {
+        // the bit of each lane's pixel, leftmost first, for two planes
+        const __m128i pixel_bits = _mm_set_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+
+        __m128i rows[TILE_SIZE];
+        for (unsigned int r = 0; r < TILE_SIZE; ++r){
+            rows[r] = _mm_setzero_si128();
+        }
+
+        for (unsigned int pair = 0; pair < planes / 2; ++pair){
+            char low_weight = (char)(1 << (2 * pair));
+            char high_weight = (char)(1 << (2 * pair + 1));
+            __m128i weight = _mm_unpacklo_epi64(_mm_set1_epi8(low_weight), _mm_set1_epi8(high_weight));
+
+            // the planes' bytes doubled, then doubled again until each row
+            // is the even plane in the low 8 lanes and the odd one above
+            __m128i v = _mm_loadu_si128((const __m128i*)(tile + 16 * pair));
+            __m128i low = _mm_unpacklo_epi8(v, v);
+            __m128i high = _mm_unpackhi_epi8(v, v);
+            __m128i quads[4] = { _mm_unpacklo_epi16(low, low), _mm_unpackhi_epi16(low, low),
+                _mm_unpacklo_epi16(high, high), _mm_unpackhi_epi16(high, high) };
+            for (unsigned int q = 0; q < 4; ++q){
+                __m128i even = _mm_unpacklo_epi32(quads[q], quads[q]);
+                __m128i odd = _mm_unpackhi_epi32(quads[q], quads[q]);
+                even = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(even, pixel_bits), pixel_bits), weight);
+                odd = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(odd, pixel_bits), pixel_bits), weight);
+                rows[2 * q] = _mm_or_si128(rows[2 * q], even);
+                rows[2 * q + 1] = _mm_or_si128(rows[2 * q + 1], odd);
+            }
+        }
+
+        for (unsigned int r = 0; r < TILE_SIZE; ++r){
+            __m128i row = _mm_or_si128(rows[r], _mm_srli_si128(rows[r], 8));
+            _mm_storel_epi64((__m128i*)(out + r * stride), row);
+        }
+    }
+#else
+    // a plane byte as 8 pixels of 0 or 1, in the byte order of a uint64_t
+    struct SpreadBits
+    {
+        SpreadBits()
+        {
+            for (int i = 0; i < 256; ++i){
+                unsigned char pixels[TILE_SIZE];
+                for (unsigned int x = 0; x < TILE_SIZE; ++x){
+                    pixels[x] = (i >> (7 - x)) & 1;
+                }
+                memcpy(&m_pixels[i], pixels, sizeof(pixels));
+            }
+        }
+
+        uint64_t m_pixels[256];
+    };
+
+    const SpreadBits SPREAD_BITS;
+
+    void decode_tile(const unsigned char* tile, unsigned int planes, unsigned char* out, size_t stride)
+    {
+        for (unsigned int r = 0; r < TILE_SIZE; ++r){
+            uint64_t row = 0;
+            for (unsigned int p = 0; p < planes; ++p){
+                row |= SPREAD_BITS.m_pixels[tile[(p / 2) * 16 + r * 2 + (p & 1)]] << p;
+            }
+            memcpy(out + r * stride, &row, TILE_SIZE);
+        }
+    }
+#endif
+}
+
+void decode_tiles(TileFormat format, const unsigned char* data, size_t tiles, unsigned char* pixels, unsigned int tiles_per_row)
+{
+    unsigned int planes = bits_per_pixel(format);
+    unsigned int bytes = tile_bytes(format);
+    size_t stride = (size_t)tiles_per_row * TILE_SIZE;
+    for (size_t t = 0; t < tiles; ++t){
+        unsigned char* out = pixels + (t / tiles_per_row) * TILE_SIZE * stride + (t % tiles_per_row) * TILE_SIZE;
+        decode_tile(data + t * bytes, planes, out, stride);
+    }
+}
+
+bool write_pgm(const string& filename, const unsigned char* pixels, unsigned int width, unsigned int height, TileFormat format)
+{
+    ofstream out(filename, ios::binary);
+    out << "P5\n" << width << " " << height << "\n" << (1 << bits_per_pixel(format)) - 1 << "\n";
+    out.write((const char*)pixels, (streamsize)width * height);
+    return (bool)out;
+}
+
+bool is_tile_type(int type)
+{
+    return type == GFX_2BPP || type == GFX_4BPP || type == GFX_8BPP;
+}
+
+unsigned int bits_per_pixel(TileFormat format)
+{
+    return format == GFX_2BPP ? 2 : format == GFX_4BPP ? 4 : 8;
+}
+
+unsigned int tile_bytes(TileFormat format)
+{
+    return bits_per_pixel(format) * TILE_SIZE;
+}
+
+const char* tile_format_name(TileFormat format)
+{
+    return format == GFX_2BPP ? "GFX2" : format == GFX_4BPP ? "GFX4" : "GFX8";
+}
+
+bool parse_tile_format(const string& name, TileFormat* format)
+{
+    if (name == "GFX2")
+        *format = GFX_2BPP;
+    else if (name == "GFX4")
+        *format = GFX_4BPP;
+    else if (name == "GFX8")
+        *format = GFX_8BPP;
+    else
+        return false;
+    return true;
+}
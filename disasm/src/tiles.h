@@ -0,0 +1,33 @@
+#ifndef TILES_H
+#define TILES_H
+
+#include <cstddef>
+#include <string>
+
+// SNES background and sprite tiles, 8x8 pixels of 2, 4 or 8 bitplanes.
+// Each row is stored as a byte per plane with the leftmost pixel in the
+// top bit: planes 0 and 1 interleaved row by row, then 2 and 3, and so
+// on, 16 bytes a pair.  The values are the ByteProperties::type a data
+// file gives a run of tiles, after the compressed types.
+enum TileFormat { GFX_2BPP = 6, GFX_4BPP = 7, GFX_8BPP = 8 };
+
+// Converts tiles to one byte per pixel, the colour index, laid out as a
+// sheet tiles_per_row tiles wide.  Unlike ROM data the sheet is written
+// a tile row at a time, so pixels needs room for whole rows of tiles.
+//
+// The bitplanes are transposed with SSE2 where there is SSE2: each row's
+// plane bytes are spread over the lanes of a register, compared against
+// the bit of each lane's pixel and masked to the plane's weight, so a row
+// of 8 pixels costs a few instructions per pair of planes.
+void decode_tiles(TileFormat format, const unsigned char* data, size_t tiles, unsigned char* pixels, unsigned int tiles_per_row);
+
+// a sheet as a binary PGM whose grey levels are the colour indexes
+bool write_pgm(const std::string& filename, const unsigned char* pixels, unsigned int width, unsigned int height, TileFormat format);
+
+bool is_tile_type(int type);
+unsigned int bits_per_pixel(TileFormat format);
+unsigned int tile_bytes(TileFormat format); //8 bytes a plane
+const char* tile_format_name(TileFormat format);
+bool parse_tile_format(const std::string& name, TileFormat* format); //"GFX2", "GFX4" or "GFX8"
+
+#endif
@@ -0,0 +1,154 @@
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "trace_events.h"
+
+using namespace std;
+
+namespace Trace
+{
+    bool g_enabled = false;
+}
+
+namespace{
+    struct Event
+    {
+        const char* m_name;
+        const char* m_category;
+        const char* m_arg_name;
+        long long m_arg;
+        long long m_begin; //nanoseconds
+        long long m_duration;
+    };
+
+    struct ThreadBuffer
+    {
+        ThreadBuffer(unsigned int id, size_t capacity) :
+        m_id(id),
+        m_capacity(capacity),
+        m_next(0),
+        m_dropped(0)
+        {}
+
+        void push(const Event& e)
+        {
+            if (m_events.size() < m_capacity){
+                m_events.push_back(e);
+                return;
+            }
+            m_events[m_next] = e;
+            m_next = (m_next + 1) % m_capacity;
+            ++m_dropped;
+        }
+
+        unsigned int m_id;
+        size_t m_capacity;
+        vector<Event> m_events;
+        size_t m_next; //oldest event once the buffer has wrapped
+        unsigned long long m_dropped;
+    };
+
+    chrono::steady_clock::time_point g_start;
+    unsigned int g_capacity = 0;
+    mutex g_buffers_mutex;
+    vector<shared_ptr<ThreadBuffer> > g_buffers; //outlive their threads
+    thread_local ThreadBuffer* t_buffer = 0;
+
+    ThreadBuffer* thread_buffer()
+    {
+        if (!t_buffer){
+            lock_guard<mutex> lock(g_buffers_mutex);
+            g_buffers.push_back(make_shared<ThreadBuffer>((unsigned int)g_buffers.size() + 1, g_capacity));
+            t_buffer = g_buffers.back().get();
+        }
+        return t_buffer;
+    }
+
+    void write_string(ostream& out, const char* text)
+    {
+        out << '"';
+        for (const char* c = text; *c; ++c){
+            if (*c == '"' || *c == '\\')
+                out << '\\';
+            out << *c;
+        }
+        out << '"';
+    }
+
+    void write_event(ostream& out, const Event& e, unsigned int tid)
+    {
+        out << "{\"name\":";
+        write_string(out, e.m_name);
+        out << ",\"cat\":";
+        write_string(out, e.m_category);
+        out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+            << ",\"ts\":" << e.m_begin / 1000.0 << ",\"dur\":" << e.m_duration / 1000.0;
+        if (e.m_arg_name){
+            out << ",\"args\":{";
+            write_string(out, e.m_arg_name);
+            out << ":" << e.m_arg << "}";
+        }
+        out << "}";
+    }
+}
+
+void Trace::start(unsigned int events_per_thread)
+{
+    g_start = chrono::steady_clock::now();
+    g_capacity = events_per_thread ? events_per_thread : 1;
+    g_enabled = true;
+    thread_buffer(); //the calling thread is shown first, as "main"
+}
+
+long long Trace::now()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - g_start).count();
+}
+
+void Trace::record(const char* name, const char* category, long long begin, const char* arg_name, long long arg)
+{
+    Event e;
+    e.m_name = name;
+    e.m_category = category;
+    e.m_arg_name = arg_name;
+    e.m_arg = arg;
+    e.m_begin = begin;
+    e.m_duration = now() - begin;
+    thread_buffer()->push(e);
+}
+
+bool Trace::write(const string& filename)
+{
+    ofstream out(filename.c_str());
+    if (!out)
+        return false;
+
+    lock_guard<mutex> lock(g_buffers_mutex);
+    out << fixed << setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << endl;
+
+    unsigned long long dropped = 0;
+    bool first = true;
+    for (size_t b = 0; b < g_buffers.size(); ++b){
+        const ThreadBuffer& buffer = *g_buffers[b];
+        dropped += buffer.m_dropped;
+
+        string thread_name = (buffer.m_id == 1) ? "main" : "thread " + to_string(buffer.m_id);
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer.m_id
+            << ",\"args\":{\"name\":";
+        write_string(out, thread_name.c_str());
+        out << "}}";
+        first = false;
+
+        for (size_t i = 0; i < buffer.m_events.size(); ++i){
+            out << ",\n";
+            write_event(out, buffer.m_events[(buffer.m_next + i) % buffer.m_events.size()], buffer.m_id);
+        }
+    }
+
+    out << endl << "],\"otherData\":{\"dropped_events\":" << dropped << "}}" << endl;
+    return out.good();
+}
@@ -0,0 +1,48 @@
+#ifndef TRACE_EVENTS_H
+#define TRACE_EVENTS_H
+
+#include <string>
+
+// Timeline of scoped events for --trace-out, written as Chrome trace-event
+// JSON (chrome://tracing, ui.perfetto.dev).  Each thread records into its
+// own ring buffer, so recording takes no lock; once a buffer is full the
+// oldest events are overwritten.  Names, categories and argument names
+// must be string literals.
+namespace Trace
+{
+    extern bool g_enabled; //set once, before any worker thread starts
+
+    inline bool enabled() { return g_enabled; }
+
+    void start(unsigned int events_per_thread = 1 << 20);
+    bool write(const std::string& filename); //call once the other threads are idle
+
+    long long now(); //nanoseconds since start()
+    void record(const char* name, const char* category, long long begin, const char* arg_name = 0, long long arg = 0);
+
+    struct Scope
+    {
+        Scope(const char* name, const char* category, const char* arg_name = 0, long long arg = 0) :
+        m_begin(g_enabled ? now() : 0),
+        m_name(name),
+        m_category(category),
+        m_arg_name(arg_name),
+        m_arg(arg)
+        {}
+
+        ~Scope()
+        {
+            if (g_enabled)
+                record(m_name, m_category, m_begin, m_arg_name, m_arg);
+        }
+
+    private:
+        long long m_begin;
+        const char* m_name;
+        const char* m_category;
+        const char* m_arg_name;
+        long long m_arg;
+    };
+}
+
+#endif
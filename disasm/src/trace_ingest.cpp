@@ -0,0 +1,363 @@
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "coverage.h"
+#include "memory_map.h"
+#include "thread_pool.h"
+#include "trace_ingest.h"
+#include "utils.h"
+
+using namespace std;
+using namespace Address;
+
+namespace{
+    const size_t CHUNK_SIZE = 64 * 1024 * 1024;
+
+    // Bitset that many threads may set concurrently.  Each 32KB of ROM gets
+    // its own shard, and a bit is only written if it isn't already set, so
+    // the common case of re-executing known code never dirties a cache line.
+    struct ShardedBitset
+    {
+        enum { SHARD_SHIFT = 15, SHARD_BITS = 1 << SHARD_SHIFT, SHARD_WORDS = SHARD_BITS / 64 };
+
+        explicit ShardedBitset(unsigned int bits) :
+        m_bits(bits)
+        {
+            for (unsigned int i = 0; i < bits; i += SHARD_BITS){
+                unique_ptr<atomic<uint64_t>[]> shard(new atomic<uint64_t>[SHARD_WORDS]);
+                for (int w = 0; w < SHARD_WORDS; ++w){
+                    shard[w].store(0, memory_order_relaxed);
+                }
+                m_shards.push_back(move(shard));
+            }
+        }
+
+        void set(unsigned int index)
+        {
+            atomic<uint64_t>& word = m_shards[index >> SHARD_SHIFT][(index & (SHARD_BITS - 1)) >> 6];
+            uint64_t bit = uint64_t(1) << (index & 63);
+            if (!(word.load(memory_order_relaxed) & bit))
+                word.fetch_or(bit, memory_order_relaxed);
+        }
+
+        bool test(unsigned int index) const
+        {
+            const atomic<uint64_t>& word = m_shards[index >> SHARD_SHIFT][(index & (SHARD_BITS - 1)) >> 6];
+            return (word.load(memory_order_relaxed) >> (index & 63)) & 1;
+        }
+
+        unsigned int size() const { return m_bits; }
+
+    private:
+        unsigned int m_bits;
+        vector<unique_ptr<atomic<uint64_t>[]> > m_shards;
+    };
+
+    struct Observations
+    {
+        explicit Observations(const MemoryMap& memory_map) :
+        map(memory_map),
+        starts(map.rom_capacity()), accum_8(map.rom_capacity()), accum_16(map.rom_capacity()),
+        index_8(map.rom_capacity()), index_16(map.rom_capacity()),
+        lines(0), skipped(0), outside_rom(0)
+        {}
+
+        const MemoryMap& map;
+
+        ShardedBitset starts;
+        ShardedBitset accum_8;
+        ShardedBitset accum_16;
+        ShardedBitset index_8;
+        ShardedBitset index_16;
+
+        atomic<unsigned long long> lines;
+        atomic<unsigned long long> skipped;
+        atomic<unsigned long long> outside_rom;
+    };
+
+    inline int hex_digit(char c)
+    {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    // "008000", "$00/8000" or "00:8000"
+    bool parse_pc(const char* p, const char* end, unsigned int* pc)
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '$')) ++p;
+
+        unsigned int value = 0;
+        int digits = 0;
+        while (p < end && digits < 6){
+            int d = hex_digit(*p);
+            if (d < 0){
+                if (digits == 2 && (*p == '/' || *p == ':')){
+                    ++p;
+                    continue;
+                }
+                break;
+            }
+            value = (value << 4) | d;
+            ++digits;
+            ++p;
+        }
+        *pc = value;
+        return digits == 6;
+    }
+
+    // "nvmxdizc" with upper case for set flags, optionally preceded by the
+    // emulation flag as in Snes9x's "envMXdIzc"
+    bool parse_flag_letters(const char* p, const char* end, bool* accum_16, bool* index_16)
+    {
+        static const char order[] = "nvmxdizc";
+
+        bool emulation = false;
+        if (end - p >= 9 && (p[0] == 'e' || p[0] == 'E') && tolower(p[1]) == 'n'){
+            emulation = (p[0] == 'E');
+            ++p;
+        }
+        if (end - p < 8)
+            return false;
+        for (int i = 0; i < 8; ++i){
+            if (tolower(p[i]) != order[i] && p[i] != '.')
+                return false;
+        }
+        if (end - p > 8 && isalnum((unsigned char)p[8]))
+            return false;
+
+        *accum_16 = !emulation && p[2] != 'M';
+        *index_16 = !emulation && p[3] != 'X';
+        return true;
+    }
+
+    bool parse_flags(const char* p, const char* end, bool* accum_16, bool* index_16)
+    {
+        for (const char* s = p; s + 3 < end; ++s){
+            if (s[0] != 'P' || s[1] != ':' || (s > p && isalnum((unsigned char)s[-1])))
+                continue;
+
+            const char* v = s + 2;
+            int hi = hex_digit(v[0]);
+            int lo = (v + 1 < end) ? hex_digit(v[1]) : -1;
+            if (hi >= 0 && lo >= 0 && (v + 2 == end || !isalnum((unsigned char)v[2]))){
+                int flags = (hi << 4) | lo;
+                *accum_16 = !(flags & 0x20);
+                *index_16 = !(flags & 0x10);
+                return true;
+            }
+            return parse_flag_letters(v, end, accum_16, index_16);
+        }
+
+        // bsnes prints the flags as a bare token
+        for (const char* s = p; s < end; ++s){
+            if ((s == p || s[-1] == ' ') && (*s == 'n' || *s == 'N' || *s == '.') &&
+                parse_flag_letters(s, end, accum_16, index_16))
+                return true;
+        }
+        return false;
+    }
+
+    void parse_lines(const char* begin, const char* end, Observations* obs)
+    {
+        unsigned long long lines = 0, skipped = 0, outside_rom = 0;
+
+        for (const char* line = begin; line < end;){
+            const char* eol = line;
+            while (eol < end && *eol != '\n') ++eol;
+            const char* next = eol + 1;
+            if (eol > line && eol[-1] == '\r') --eol;
+
+            if (eol > line){
+                ++lines;
+
+                unsigned int pc;
+                bool accum_16, index_16;
+                if (!parse_pc(line, eol, &pc) || !parse_flags(line, eol, &accum_16, &index_16)){
+                    ++skipped;
+                }
+                else if (!obs->map.is_rom(pc)){
+                    ++outside_rom;
+                }
+                else{
+                    unsigned int index = obs->map.rom_index(pc);
+                    obs->starts.set(index);
+                    if (accum_16) obs->accum_16.set(index); else obs->accum_8.set(index);
+                    if (index_16) obs->index_16.set(index); else obs->index_8.set(index);
+                }
+            }
+            line = next;
+        }
+
+        obs->lines += lines;
+        obs->skipped += skipped;
+        obs->outside_rom += outside_rom;
+    }
+
+    // parse one buffer of whole lines, split across the pool at line breaks
+    vector<future<void> > parse_chunk(ThreadPool& pool, const vector<char>& chunk, size_t length, Observations* obs)
+    {
+        vector<future<void> > results;
+        size_t slices = pool.size() * 4;
+        size_t slice_size = length / slices + 1;
+
+        const char* data = chunk.data();
+        size_t start = 0;
+        while (start < length){
+            size_t stop = min(length, start + slice_size);
+            while (stop < length && data[stop - 1] != '\n') ++stop;
+
+            const char* b = data + start;
+            const char* e = data + stop;
+            results.push_back(pool.submit([b, e, obs](){ parse_lines(b, e, obs); }));
+            start = stop;
+        }
+        return results;
+    }
+
+    void write_flag(ostream& out, const MemoryMap& map, unsigned int index, const char* type, int bits)
+    {
+        unsigned int address = map.rom_address(index);
+        out << to_string(address, 6) << " " << left << setw(2) << type << " " << bits << endl;
+    }
+
+    // Emit a reset wherever the observed width differs from what a linear
+    // sweep would be carrying at that point.  Each bank starts out 8 bit,
+    // as a fresh request does.
+    unsigned int write_flags(ostream& out, const Observations& obs)
+    {
+        unsigned int conflicts = 0;
+        int accum = 8, index = 8;
+
+        out << "; generated by --ingest-trace" << endl;
+        for (unsigned int i = 0; i < obs.map.rom_capacity(); ++i){
+            if (i % obs.map.rom_bank_size() == 0){
+                accum = 8;
+                index = 8;
+            }
+            if (!obs.starts.test(i))
+                continue;
+
+            bool accum_conflict = obs.accum_8.test(i) && obs.accum_16.test(i);
+            bool index_conflict = obs.index_8.test(i) && obs.index_16.test(i);
+            if (accum_conflict || index_conflict){
+                unsigned int address = obs.map.rom_address(i);
+                out << "; " << to_string(address, 6) << " executed with"
+                    << (accum_conflict ? " 8 and 16 bit accum" : "")
+                    << (accum_conflict && index_conflict ? " and" : "")
+                    << (index_conflict ? " 8 and 16 bit index" : "") << endl;
+                cerr << "conflicting register widths at " << to_string(address, 6) << endl;
+                ++conflicts;
+            }
+
+            int new_accum = accum_conflict ? accum : (obs.accum_16.test(i) ? 16 : 8);
+            int new_index = index_conflict ? index : (obs.index_16.test(i) ? 16 : 8);
+
+            if (new_accum != accum && new_index != index && new_accum == new_index){
+                write_flag(out, obs.map, i, "AI", new_accum);
+            }
+            else{
+                if (new_accum != accum) write_flag(out, obs.map, i, "A", new_accum);
+                if (new_index != index) write_flag(out, obs.map, i, "I", new_index);
+            }
+            accum = new_accum;
+            index = new_index;
+        }
+        return conflicts;
+    }
+}
+
+int ingest_trace(const string& log_file, const string& coverage_file, const string& flags_file, const MemoryMap& map)
+{
+    FILE* log = fopen(log_file.c_str(), "rb");
+    if (!log){
+        cerr << "Could not open " << log_file << " for reading." << endl;
+        return -1;
+    }
+
+    cerr << "; Reading trace log" << endl;
+
+    Observations obs(map);
+    {
+        ThreadPool pool;
+
+        // double buffered: the next chunk is read while the last one parses
+        vector<char> buffers[2] = { vector<char>(CHUNK_SIZE), vector<char>(CHUNK_SIZE) };
+        vector<future<void> > pending;
+        size_t carry = 0;
+        int current = 0;
+
+        while (1){
+            vector<char>& buffer = buffers[current];
+            size_t length = carry + fread(buffer.data() + carry, 1, CHUNK_SIZE - carry, log);
+            bool at_end = (length < CHUNK_SIZE);
+
+            // wait for the other buffer before it is reused for the carry
+            for (size_t i = 0; i < pending.size(); ++i){
+                pending[i].get();
+            }
+            pending.clear();
+
+            size_t usable = length;
+            if (!at_end){
+                while (usable > 0 && buffer[usable - 1] != '\n') --usable;
+                if (usable == 0){
+                    cerr << "Line too long in " << log_file << endl;
+                    fclose(log);
+                    return -1;
+                }
+            }
+
+            vector<char>& next = buffers[1 - current];
+            carry = length - usable;
+            copy(buffer.begin() + usable, buffer.begin() + length, next.begin());
+
+            pending = parse_chunk(pool, buffer, usable, &obs);
+            current = 1 - current;
+
+            if (at_end)
+                break;
+        }
+        for (size_t i = 0; i < pending.size(); ++i){
+            pending[i].get();
+        }
+    }
+    fclose(log);
+
+    CoverageMap coverage;
+    coverage.reset(map.rom_capacity(), true);
+    for (unsigned int i = 0; i < map.rom_capacity(); ++i){
+        if (!obs.starts.test(i))
+            continue;
+        coverage.mark_instruction_start(i);
+        coverage.mark_register_widths(i,
+            obs.accum_16.test(i) && !obs.accum_8.test(i),
+            obs.index_16.test(i) && !obs.index_8.test(i));
+    }
+    if (!coverage.save(coverage_file)){
+        cerr << "Could not write " << coverage_file << endl;
+        return -1;
+    }
+
+    ofstream flags(flags_file.c_str());
+    if (!flags){
+        cerr << "Could not write " << flags_file << endl;
+        return -1;
+    }
+    unsigned int conflicts = write_flags(flags, obs);
+
+    cerr << "; " << obs.lines << " lines, " << obs.skipped << " unrecognized, "
+        << obs.outside_rom << " outside ROM" << endl;
+    cerr << "; " << coverage.count() << " instruction starts, "
+        << conflicts << " addresses with conflicting widths" << endl;
+    cerr << "; Reading trace log... done." << endl;
+    return 0;
+}
@@ -0,0 +1,20 @@
+#ifndef TRACE_INGEST_H
+#define TRACE_INGEST_H
+
+#include <string>
+
+struct MemoryMap;
+
+// Reduces an emulator CPU log (one executed instruction per line, with
+// its PC and P register) to a coverage file for --sym2 and a flags file
+// for --accum.  Understands the bsnes, Snes9x and Mesen log layouts:
+//
+//   008000 sei        A:0000 X:0000 Y:0000 S:01ff D:0000 B:00 nvMXdIzc
+//   $00/8000 78    SEI  A:0000 X:0000 Y:0000 D:0000 DB:00 S:01FF P:envMXdIzc
+//   00:8000 sei       A:0000 X:0000 Y:0000 S:01FF D:0000 DB:00 P:34
+//
+// map places the logged addresses in the ROM, and the flags file is
+// written with its canonical addresses.
+int ingest_trace(const std::string& log_file, const std::string& coverage_file, const std::string& flags_file, const MemoryMap& map);
+
+#endif
@@ -1,23 +1,25 @@
-#include <iomanip>
+#include <cstdio>
 #include <string>
-#include <sstream>
 #include "utils.h"
 
 using namespace std;
 
 namespace Address
 {
+    // zero padded like setfill('0') << setw(length), without a stream
     string to_string(int i, int length, bool in_hex)
     {
-        ostringstream ss;
-        ss.setf(ios::uppercase);
-
-        if (in_hex)
-            ss << hex << setfill('0') << setw(length) << i;
-        else
-            ss << dec << setfill('0') << setw(length) << i;
-
-        return ss.str();
+        char text[32];
+        if (in_hex){
+            snprintf(text, sizeof(text), "%0*X", length, (unsigned int)i);
+        }
+        else{
+            snprintf(text, sizeof(text), "%*d", length, i);
+            for (char* c = text; *c == ' '; ++c){
+                *c = '0';
+            }
+        }
+        return text;
     }
 }
 
@@ -29,6 +29,7 @@ namespace Address
         return (a & 0x0FFFF);
     }
 
+    // LoROM only, for the trace tools; the disassembler goes through its MemoryMap
     inline unsigned int get_index(unsigned char bank, unsigned int pc)
     {
         return bank * BANK_SIZE + pc - 0x08000;